@@ -11202,6 +11202,35 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
 
         return current_log_filepath
 
+    def test_replay_parallel_cores_bit(self):
+        '''flies with the EKF3 cores updated in parallel; replayed with
+        them updated one after the other the cores' output must be
+        identical'''
+        self.set_parameters({
+            "LOG_REPLAY": 1,
+            "LOG_DISARMED": 1,
+            "EK3_ENABLE": 1,
+            "SIM_IMU_COUNT": 3,
+            "EK3_IMU_MASK": 7,  # a core per IMU, two of them on worker threads
+            "EK3_OPTIONS": 8,  # ParallelCores
+        })
+        self.reboot_sitl()
+
+        self.wait_sensor_state(mavutil.mavlink.MAV_SYS_STATUS_LOGGING, True, True, True)
+
+        current_log_filepath = self.current_onboard_log_filepath()
+        self.progress("Current log path: %s" % str(current_log_filepath))
+
+        self.change_mode("LOITER")
+        self.wait_ready_to_arm(require_absolute=True)
+        self.arm_vehicle()
+        self.takeoffAndMoveAway()
+        self.do_RTL()
+
+        self.reboot_sitl()
+
+        return current_log_filepath
+
     def test_replay_beacon_bit(self):
         self.set_parameters({
             "LOG_REPLAY": 1,
@@ -11641,7 +11670,13 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
             self.start_subtest("%s" % name)
             self.test_replay_bit(func)
 
-    def test_replay_bit(self, bit):
+        self.start_subtest("ParallelCores")
+        self.test_replay_bit(
+            self.test_replay_parallel_cores_bit,
+            replay_args=["--parm", "EK3_OPTIONS=0"],
+        )
+
+    def test_replay_bit(self, bit, replay_args=None):
 
         self.context_push()
         current_log_filepath = bit()
@@ -11651,7 +11686,7 @@ class AutoTestCopter(vehicle_test_suite.TestSuite):
         ))
 
         self.zero_throttle()
-        self.run_replay(current_log_filepath)
+        self.run_replay(current_log_filepath, replay_args=replay_args)
 
         replay_log_filepath = self.current_onboard_log_filepath()
 
@@ -1060,6 +1060,12 @@ if __name__ == "__main__":
     elif opts.no_debug is not None:
         opts.debug = not opts.no_debug
 
+    if opts.speedup is not None and opts.speedup <= 0:
+        # tests scale their wall-clock timeouts by the speedup, so the
+        # simulator's as-fast-as-possible mode (zero) can't be used
+        print("--speedup must be positive")
+        sys.exit(1)
+
     if opts.timeout is None:
         opts.timeout = 5400
         # adjust if we're running in a regime which may slow us down e.g. Valgrind
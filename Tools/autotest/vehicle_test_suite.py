@@ -14484,10 +14484,12 @@ switch value'''
         # heading seemingly indefinitely.
         self.reboot_sitl()
 
-    def run_replay(self, filepath):
+    def run_replay(self, filepath, replay_args=None):
         '''runs replay in filepath, returns filepath to Replay logfile'''
+        if replay_args is None:
+            replay_args = []
         util.run_cmd(
-            ['build/sitl/tool/Replay', filepath],
+            ['build/sitl/tool/Replay'] + replay_args + [filepath],
             directory=util.topdir(),
             checkfail=True,
             show=True,
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+
+'''
+measure MAVLink FTP download throughput, using BurstReadFile or the
+windowed BurstReadFileWindow extension, over one or more sessions at
+once. For SITL over a loopback UDP link, start the vehicle with
+   sim_vehicle.py -v ArduCopter --no-mavproxy -A "--serial0 udpclient:127.0.0.1:14550"
+and run
+   mavftp_throughput.py --sessions 2 --mode window logs/00000001.BIN
+
+AP_FLAKE8_CLEAN
+'''
+
+import struct
+import time
+
+from argparse import ArgumentParser
+from pymavlink import mavutil
+
+OP_TerminateSession = 1
+OP_ResetSessions = 2
+OP_OpenFileRO = 4
+OP_BurstReadFile = 15
+OP_BurstReadFileWindow = 255  # ArduPilot extension
+OP_Ack = 128
+OP_Nack = 129
+
+ERR_EndOfFile = 6
+
+MAX_DATA = 239
+
+
+class Download(object):
+    '''one file being read on one session'''
+
+    def __init__(self, ftp, session, mode, window, packet_size):
+        self.ftp = ftp
+        self.session = session
+        self.mode = mode
+        self.window = window
+        self.packet_size = packet_size
+        self.size = None
+        self.blocks = {}
+        self.acked = 0
+        self.highest = 0
+        self.last_acked = 0
+        self.last_request = 0
+        self.last_rx = 0
+        self.done = False
+
+    def first_missing(self):
+        '''offset of the first data not received'''
+        while self.acked in self.blocks:
+            self.acked += len(self.blocks[self.acked])
+        return self.acked
+
+    def request(self):
+        '''ask for more data, from the first missing offset'''
+        offset = self.first_missing()
+        if self.mode == 'burst':
+            self.ftp.send(self.session, OP_BurstReadFile, offset=offset, size=self.packet_size)
+        else:
+            # ask again for lost packets, which are gaps before the
+            # highest packet received
+            bitmap = bytearray(32)
+            nbytes = 0
+            for i in range(len(bitmap) * 8):
+                ofs = offset + i * self.packet_size
+                if ofs >= self.highest:
+                    break
+                if ofs not in self.blocks:
+                    bitmap[i // 8] |= 1 << (i % 8)
+                    nbytes = i // 8 + 1
+            data = struct.pack('<IB', self.window, self.packet_size) + bytes(bitmap[:nbytes])
+            self.ftp.send(self.session, OP_BurstReadFileWindow, offset=offset, data=data)
+        self.last_acked = offset
+        self.last_request = time.time()
+
+    def handle(self, opcode, offset, burst_complete, data):
+        self.last_rx = time.time()
+        if opcode == OP_Nack:
+            if data[0] == ERR_EndOfFile and self.first_missing() >= self.size:
+                self.done = True
+            else:
+                self.request()
+            return
+        if offset not in self.blocks:
+            self.blocks[offset] = data
+        self.highest = max(self.highest, offset + len(data))
+        if self.first_missing() >= self.size:
+            self.done = True
+            return
+        if self.mode == 'burst':
+            if burst_complete:
+                self.request()
+        elif self.first_missing() - self.last_acked >= self.window // 4:
+            # move the window on well before it is used up
+            self.request()
+        elif (self.highest - self.last_acked >= self.window * 3 // 4 and
+              time.time() - self.last_request > 0.05):
+            # the window is held up by lost packets
+            self.request()
+
+    def request_if_stalled(self, now, timeout):
+        if now - max(self.last_request, self.last_rx) > timeout:
+            self.request()
+
+
+class FTP(object):
+    '''just enough of the FTP protocol to download files'''
+
+    def __init__(self, master):
+        self.master = master
+        self.seq = 0
+
+    def send(self, session, opcode, offset=0, size=None, data=b''):
+        if size is None:
+            size = len(data)
+        payload = struct.pack('<HBBBBBxI', self.seq, session, opcode, size, 0, 0, offset) + data
+        payload = payload + bytes(251 - len(payload))
+        self.master.mav.file_transfer_protocol_send(0, self.master.target_system,
+                                                    self.master.target_component, payload)
+        self.seq = (self.seq + 1) % 65536
+
+    def recv(self, timeout):
+        m = self.master.recv_match(type='FILE_TRANSFER_PROTOCOL', blocking=True, timeout=timeout)
+        if m is None:
+            return None
+        payload = bytes(m.payload)
+        (seq, session, opcode, size, req_opcode, burst_complete, offset) = struct.unpack('<HBBBBBxI', payload[:12])
+        return (session, opcode, req_opcode, burst_complete, offset, payload[12:12+size])
+
+    def open(self, session, path):
+        '''open a file for reading, returning its size'''
+        for attempt in range(5):
+            self.send(session, OP_OpenFileRO, data=path.encode('utf-8'))
+            deadline = time.time() + 1
+            while time.time() < deadline:
+                r = self.recv(0.2)
+                if r is None or r[0] != session or r[2] != OP_OpenFileRO:
+                    continue
+                if r[1] != OP_Ack:
+                    raise Exception("open of %s failed on session %u" % (path, session))
+                return struct.unpack('<I', r[5][:4])[0]
+        raise Exception("no reply to open on session %u" % session)
+
+
+def main():
+    parser = ArgumentParser(description=__doc__)
+    parser.add_argument("--connection", default="udpin:127.0.0.1:14550", help="MAVLink connection")
+    parser.add_argument("--sessions", type=int, default=1, help="number of sessions reading the file at once")
+    parser.add_argument("--mode", choices=['burst', 'window'], default='burst', help="burst read protocol")
+    parser.add_argument("--window", type=int, default=64*MAX_DATA, help="window size in bytes")
+    parser.add_argument("--packet-size", type=int, default=MAX_DATA, help="data bytes per packet")
+    parser.add_argument("--timeout", type=float, default=0.5, help="time without data before asking again")
+    parser.add_argument("path", help="file on the vehicle to download")
+    args = parser.parse_args()
+
+    master = mavutil.mavlink_connection(args.connection, source_system=250)
+    print("Waiting for heartbeat")
+    master.wait_heartbeat()
+
+    ftp = FTP(master)
+    ftp.send(0, OP_ResetSessions)
+
+    downloads = {}
+    for session in range(args.sessions):
+        d = Download(ftp, session, args.mode, args.window, args.packet_size)
+        d.size = ftp.open(session, args.path)
+        downloads[session] = d
+    size = downloads[0].size
+    print("Reading %u bytes on %u sessions with %s" % (size, args.sessions, args.mode))
+
+    tstart = time.time()
+    for d in downloads.values():
+        d.request()
+    while not all(d.done for d in downloads.values()):
+        r = ftp.recv(0.05)
+        if r is not None:
+            (session, opcode, req_opcode, burst_complete, offset, data) = r
+            d = downloads.get(session)
+            if d is not None and not d.done and req_opcode in (OP_BurstReadFile, OP_BurstReadFileWindow):
+                d.handle(opcode, offset, burst_complete, data)
+        now = time.time()
+        for d in downloads.values():
+            if not d.done:
+                d.request_if_stalled(now, args.timeout)
+    elapsed = time.time() - tstart
+
+    for session in downloads:
+        ftp.send(session, OP_TerminateSession)
+
+    contents = [b''.join(d.blocks[ofs] for ofs in sorted(d.blocks)) for d in downloads.values()]
+    if any(len(c) != size or c != contents[0] for c in contents):
+        print("Sessions read different data")
+    total = size * args.sessions
+    print("%u bytes in %.2fs: %.1f kB/s" % (total, elapsed, total / elapsed / 1024))
+
+
+if __name__ == '__main__':
+    main()
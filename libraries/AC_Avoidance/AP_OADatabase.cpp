@@ -18,6 +18,7 @@
 #include "AP_OADatabase.h"
 
 #include <AP_AHRS/AP_AHRS.h>
+#include <AP_Common/LocationProjection.h>
 #include <GCS_MAVLink/GCS.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
@@ -40,6 +41,13 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_DISTANCE_FROM_HOME 3
 #endif
 
+#ifndef AP_OADATABASE_INDEX_CELL_SIZE
+    #define AP_OADATABASE_INDEX_CELL_SIZE 1.0f  // size in meters of the grid cells used to index objects
+#endif
+
+// allowance in meters for rounding when searching the index
+#define AP_OADATABASE_INDEX_MARGIN 0.1f
+
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: SIZE
@@ -146,7 +154,7 @@ void AP_OADatabase::update()
     }
 
     process_queue();
-    database_items_remove_all_expired();
+    database_items_remove_all_expired(AP_HAL::millis());
 }
 
 // Push an object into the database. Pos is the offset in meters from the EKF origin, measurement timestamp in ms, distance in meters
@@ -222,6 +230,10 @@ void AP_OADatabase::init_database()
     }
 
     _database.items = NEW_NOTHROW OA_DbItem[_database.size];
+    if (_database.items != nullptr) {
+        // without the index the database still works, but is slower
+        _index.init(_database.size, AP_OADATABASE_INDEX_CELL_SIZE);
+    }
 }
 
 // get bitmask of gcs channels item should be sent to based on its importance
@@ -303,21 +315,109 @@ bool AP_OADatabase::process_queue()
 
         item.send_to_gcs = get_send_to_gcs_flags(item.importance);
 
-        // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
-        for (uint16_t i=0; i<_database.count; i++) {
-            if (item_match(_database.items[i], item)) {
-                database_item_refresh(_database.items[i], item);
-                found = true;
+        // if found a similar item in the database, update the existing, else add it as a new one
+        const int32_t index = database_item_find(item);
+        if (index >= 0) {
+            database_item_refresh(index, item);
+        } else {
+            database_item_add(item);
+        }
+    }
+    return (_queue.items->available() > 0);
+}
+
+// returns the lowest index of an item in the database matching item, or -1 if there is none
+int32_t AP_OADatabase::database_item_find(const OA_DbItem &item) const
+{
+    if (_index.initialised()) {
+        // the lowest index of the candidates, to match the first found by checking every item
+        int32_t found = -1;
+        auto check = [&](uint16_t i) {
+            if ((found < 0 || i < found) && item_match(_database.items[i], item)) {
+                found = i;
+            }
+        };
+
+        switch (item.source) {
+        case OA_DbItem::Source::AIS:
+            _index.other_foreach(check);
+            return found;
+
+        case OA_DbItem::Source::proximity: {
+            // a match is closer than the larger of the two radii
+            float radius;
+            if (!_index.grid_max_radius(radius)) {
+                break;
+            }
+            radius = MAX(radius, item.radius) + AP_OADATABASE_INDEX_MARGIN;
+            const Vector2f min = item.pos.xy() - Vector2f{radius, radius};
+            const Vector2f max = item.pos.xy() + Vector2f{radius, radius};
+            if (_index.grid_cell_count(min, max) >= _database.count) {
+                // quicker to check every item
                 break;
             }
+            _index.grid_foreach(min, max, check);
+            return found;
+        }
         }
+    }
 
-        if (!found) {
-            database_item_add(item);
+    for (uint16_t i=0; i<_database.count; i++) {
+        if (item_match(_database.items[i], item)) {
+            return i;
         }
     }
-    return (_queue.items->available() > 0);
+    return -1;
+}
+
+// smallest distance in meters from the line segment between start and
+// end, as offsets in cm from the EKF origin, to the edge of any object.
+// Returns false if the database is empty
+bool AP_OADatabase::get_closest_margin(const Vector3f &start_cm, const Vector3f &end_cm, float &margin) const
+{
+    if (!healthy() || _database.count == 0) {
+        return false;
+    }
+
+    float smallest_margin = FLT_MAX;
+    auto check = [&](uint16_t i) {
+        const OA_DbItem &item = _database.items[i];
+        const float m = Vector3f::closest_distance_between_line_and_point(start_cm, end_cm, item.pos * 100.0f) * 0.01f - item.radius;
+        if (m < smallest_margin) {
+            smallest_margin = m;
+        }
+    };
+
+    float max_radius;
+    if (_index.initialised() && _index.grid_max_radius(max_radius)) {
+        _index.other_foreach(check);
+
+        // search ever larger boxes around the segment until the closest
+        // object found is closer than anything outside the box could be
+        const Vector2f start = start_cm.xy() * 0.01f;
+        const Vector2f end = end_cm.xy() * 0.01f;
+        const Vector2f lower{MIN(start.x, end.x), MIN(start.y, end.y)};
+        const Vector2f upper{MAX(start.x, end.x), MAX(start.y, end.y)};
+        for (float range = _index.cell_size(); ; range *= 2) {
+            const Vector2f min = lower - Vector2f{range, range};
+            const Vector2f max = upper + Vector2f{range, range};
+            if (_index.grid_cell_count(min, max) >= _database.count) {
+                // quicker to check every item
+                break;
+            }
+            _index.grid_foreach(min, max, check);
+            if (smallest_margin <= range - max_radius - AP_OADATABASE_INDEX_MARGIN) {
+                margin = smallest_margin;
+                return true;
+            }
+        }
+    }
+
+    for (uint16_t i=0; i<_database.count; i++) {
+        check(i);
+    }
+    margin = smallest_margin;
+    return true;
 }
 
 void AP_OADatabase::database_item_add(const OA_DbItem &item)
@@ -325,9 +425,32 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     if (_database.count >= _database.size) {
         return;
     }
-    _database.items[_database.count] = item;
-    _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
+    const uint16_t index = _database.count;
+    _database.items[index] = item;
+    _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
     _database.count++;
+
+    if (_index.initialised()) {
+        if (item.source == OA_DbItem::Source::proximity) {
+            _index.insert_grid(index, item.pos.xy(), item.radius);
+        } else {
+            _index.insert_other(index);
+        }
+        index_insert_age(index);
+    }
+}
+
+// add an item to the index's list sorted by age. New items are almost
+// always the newest so this rarely walks the list
+void AP_OADatabase::index_insert_age(const uint16_t index)
+{
+    const uint32_t timestamp_ms = _database.items[index].timestamp_ms;
+    uint16_t older = _index.newest();
+    while (older != AP_OADatabase_Index::NONE &&
+           int32_t(_database.items[older].timestamp_ms - timestamp_ms) > 0) {
+        older = _index.older(older);
+    }
+    _index.insert_age(index, older);
 }
 
 void AP_OADatabase::database_item_remove(const uint16_t index)
@@ -341,6 +464,10 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
 
+    if (_index.initialised()) {
+        _index.remove(index);
+    }
+
     _database.count--;
     if (_database.count == 0) {
         return;
@@ -350,11 +477,15 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         // copy last object in array over expired object
         _database.items[index] = _database.items[_database.count];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+        if (_index.initialised()) {
+            _index.move(_database.count, index);
+        }
     }
 }
 
-void AP_OADatabase::database_item_refresh(OA_DbItem &current_item, const OA_DbItem &new_item) const
+void AP_OADatabase::database_item_refresh(const uint16_t index, const OA_DbItem &new_item)
 {
+    OA_DbItem &current_item = _database.items[index];
     const bool is_different =
             (!is_equal(current_item.radius, new_item.radius)) ||
             (new_item.timestamp_ms - current_item.timestamp_ms >= 500);
@@ -370,10 +501,16 @@ void AP_OADatabase::database_item_refresh(OA_DbItem &current_item, const OA_DbIt
             // Update position for AIS items, these tend to be large and update slowly
             current_item.pos = new_item.pos;
         }
+
+        if (_index.initialised()) {
+            _index.set_radius(index, current_item.radius);
+            _index.remove_age(index);
+            index_insert_age(index);
+        }
     }
 }
 
-void AP_OADatabase::database_items_remove_all_expired()
+void AP_OADatabase::database_items_remove_all_expired(const uint32_t now_ms)
 {
     // calculate age of all items in the _database
 
@@ -383,8 +520,39 @@ void AP_OADatabase::database_items_remove_all_expired()
         return;
     }
 
-    const uint32_t now_ms = AP_HAL::millis();
     const uint32_t expiry_ms = (uint32_t)_database_expiry_seconds * 1000;
+
+    if (_index.initialised()) {
+        // mark expired items, checking from the oldest until one has
+        // not expired, and from the newest any with a timestamp ahead
+        // of now
+        for (uint16_t i = _index.oldest(); i != AP_OADatabase_Index::NONE; i = _index.newer(i)) {
+            if (now_ms - _database.items[i].timestamp_ms <= expiry_ms) {
+                break;
+            }
+            _index.set_mark(i);
+        }
+        for (uint16_t i = _index.newest(); i != AP_OADatabase_Index::NONE; i = _index.older(i)) {
+            if (int32_t(_database.items[i].timestamp_ms - now_ms) <= 0) {
+                break;
+            }
+            if (now_ms - _database.items[i].timestamp_ms > expiry_ms) {
+                _index.set_mark(i);
+            }
+        }
+
+        // remove them in the order a check of every item would, so the
+        // remaining items are left at the same indexes
+        uint16_t index = _index.next_marked(0);
+        while (index < _database.count) {
+            while (index < _database.count && _index.marked(index)) {
+                database_item_remove(index);
+            }
+            index = _index.next_marked(index + 1);
+        }
+        return;
+    }
+
     uint16_t index = 0;
     while (index < _database.count) {
         if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
@@ -407,6 +575,13 @@ void AP_OADatabase::send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_
         return;
     }
 
+    // object positions are offsets from the EKF origin
+    Location ekf_origin;
+    if (!AP::ahrs().get_origin(ekf_origin)) {
+        return;
+    }
+    const LocationProjection projection{ekf_origin};
+
     const uint8_t chan_as_bitmask = 1 << chan;
     const char callsign[9] = "OA_DB";
 
@@ -440,7 +615,8 @@ void AP_OADatabase::send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_
         }
 
         // convert object's position as an offset from EKF origin to Location
-        const Location item_loc(Vector3f{_database.items[idx].pos.x * 100.0f, _database.items[idx].pos.y * 100.0f, _database.items[idx].pos.z * 100.0f}, Location::AltFrame::ABOVE_ORIGIN);
+        Location item_loc = projection.get_location(_database.items[idx].pos.xy());
+        item_loc.set_alt_cm(_database.items[idx].pos.z * 100.0f, Location::AltFrame::ABOVE_ORIGIN);
 
         mavlink_msg_adsb_vehicle_send(chan,
             idx,
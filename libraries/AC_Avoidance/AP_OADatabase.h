@@ -8,8 +8,10 @@
 #include <AP_Math/AP_Math.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Param/AP_Param.h>
+#include "AP_OADatabase_Index.h"
 
 class AP_OADatabase {
+    friend class AP_OADatabase_Test;
 public:
 
     AP_OADatabase();
@@ -64,6 +66,11 @@ public:
     // empty queue and try and put into database. Return true if there's more work to do
     bool process_queue();
 
+    // smallest distance in meters from the line segment between start
+    // and end, as offsets in cm from the EKF origin, to the edge of any
+    // object. Returns false if the database is empty
+    bool get_closest_margin(const Vector3f &start_cm, const Vector3f &end_cm, float &margin) const;
+
     // send ADSB_VEHICLE mavlink messages
     void send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms);
 
@@ -76,10 +83,12 @@ private:
     void init_database();
 
     // database item management
+    int32_t database_item_find(const OA_DbItem &item) const;
     void database_item_add(const OA_DbItem &item);
-    void database_item_refresh(OA_DbItem &current_item, const OA_DbItem &new_item) const;
+    void database_item_refresh(const uint16_t index, const OA_DbItem &new_item);
     void database_item_remove(const uint16_t index);
-    void database_items_remove_all_expired();
+    void database_items_remove_all_expired(const uint32_t now_ms);
+    void index_insert_age(const uint16_t index);
 
     // get bitmask of gcs channels item should be sent to based on its importance
     // returns 0xFF (send to all channels) if should be sent or 0 if it should not be sent
@@ -119,6 +128,10 @@ private:
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
     } _database;
 
+    // spatial and age index over _database.items, searches fall back
+    // to checking every item if it could not be allocated
+    AP_OADatabase_Index _index;
+
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
     uint16_t _highest_index_sent[MAVLINK_COMM_NUM_BUFFERS]; // highest index in _database sent to GCS
     uint32_t _last_send_to_gcs_ms[MAVLINK_COMM_NUM_BUFFERS];// system time that send_adsb_vehicle was last called
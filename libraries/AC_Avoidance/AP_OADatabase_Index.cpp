@@ -0,0 +1,234 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_OADatabase_Index.h"
+
+#if AP_OADATABASE_ENABLED
+
+#include <AP_Common/AP_Common.h>
+
+AP_OADatabase_Index::~AP_OADatabase_Index()
+{
+    delete[] _slots;
+    delete[] _heads;
+    delete[] _marks;
+}
+
+bool AP_OADatabase_Index::init(uint16_t size, float cell_size_m)
+{
+    if (size == 0 || size == NONE || !is_positive(cell_size_m)) {
+        return false;
+    }
+
+    // about one item per bucket when full
+    uint32_t num_buckets = 16;
+    while (num_buckets < size) {
+        num_buckets *= 2;
+    }
+
+    Slot *slots = NEW_NOTHROW Slot[size];
+    uint16_t *heads = NEW_NOTHROW uint16_t[num_buckets + 1];
+    uint32_t *marks = NEW_NOTHROW uint32_t[(size + 31) / 32];
+    if (slots == nullptr || heads == nullptr || marks == nullptr) {
+        delete[] slots;
+        delete[] heads;
+        delete[] marks;
+        return false;
+    }
+    for (uint32_t i = 0; i <= num_buckets; i++) {
+        heads[i] = NONE;
+    }
+
+    _size = size;
+    _num_buckets = num_buckets;
+    _cell_size = cell_size_m;
+    _cell_size_inv = 1.0f / cell_size_m;
+    _heads = heads;
+    _marks = marks;
+    _slots = slots;
+    return true;
+}
+
+uint8_t AP_OADatabase_Index::radius_class(float radius) const
+{
+    const float cells = ceilf(MAX(radius, 0) * _cell_size_inv);
+    if (cells > max_radius_cells) {
+        return max_radius_cells + 1;
+    }
+    return uint8_t(cells);
+}
+
+void AP_OADatabase_Index::insert_chain(uint16_t idx, uint16_t chain)
+{
+    Slot &s = _slots[idx];
+    s.chain = chain;
+    s.prev = NONE;
+    s.next = _heads[chain];
+    if (s.next != NONE) {
+        _slots[s.next].prev = idx;
+    }
+    _heads[chain] = idx;
+}
+
+void AP_OADatabase_Index::insert_grid(uint16_t idx, const Vector2f &pos, float radius)
+{
+    insert_chain(idx, bucket(cell(pos.x), cell(pos.y)));
+    _slots[idx].radius_class = radius_class(radius);
+    _radius_count[_slots[idx].radius_class]++;
+}
+
+void AP_OADatabase_Index::insert_other(uint16_t idx)
+{
+    insert_chain(idx, _num_buckets);
+    _slots[idx].radius_class = radius_class_none;
+}
+
+void AP_OADatabase_Index::set_radius(uint16_t idx, float radius)
+{
+    Slot &s = _slots[idx];
+    if (s.radius_class == radius_class_none) {
+        return;
+    }
+    _radius_count[s.radius_class]--;
+    s.radius_class = radius_class(radius);
+    _radius_count[s.radius_class]++;
+}
+
+void AP_OADatabase_Index::insert_age(uint16_t idx, uint16_t older)
+{
+    Slot &s = _slots[idx];
+    s.older = older;
+    if (older == NONE) {
+        s.newer = _oldest;
+        _oldest = idx;
+    } else {
+        s.newer = _slots[older].newer;
+        _slots[older].newer = idx;
+    }
+    if (s.newer == NONE) {
+        _newest = idx;
+    } else {
+        _slots[s.newer].older = idx;
+    }
+}
+
+void AP_OADatabase_Index::remove_age(uint16_t idx)
+{
+    const Slot &s = _slots[idx];
+    if (s.older == NONE) {
+        _oldest = s.newer;
+    } else {
+        _slots[s.older].newer = s.newer;
+    }
+    if (s.newer == NONE) {
+        _newest = s.older;
+    } else {
+        _slots[s.newer].older = s.older;
+    }
+}
+
+void AP_OADatabase_Index::remove(uint16_t idx)
+{
+    const Slot &s = _slots[idx];
+    if (s.prev == NONE) {
+        _heads[s.chain] = s.next;
+    } else {
+        _slots[s.prev].next = s.next;
+    }
+    if (s.next != NONE) {
+        _slots[s.next].prev = s.prev;
+    }
+    if (s.radius_class != radius_class_none) {
+        _radius_count[s.radius_class]--;
+    }
+    remove_age(idx);
+    _marks[idx/32] &= ~(1U<<(idx%32));
+}
+
+void AP_OADatabase_Index::move(uint16_t from, uint16_t to)
+{
+    const Slot &s = _slots[from];
+    _slots[to] = s;
+
+    // point the neighbours at the new slot
+    if (s.prev == NONE) {
+        _heads[s.chain] = to;
+    } else {
+        _slots[s.prev].next = to;
+    }
+    if (s.next != NONE) {
+        _slots[s.next].prev = to;
+    }
+    if (s.older == NONE) {
+        _oldest = to;
+    } else {
+        _slots[s.older].newer = to;
+    }
+    if (s.newer == NONE) {
+        _newest = to;
+    } else {
+        _slots[s.newer].older = to;
+    }
+
+    if (marked(from)) {
+        _marks[to/32] |= 1U<<(to%32);
+        _marks[from/32] &= ~(1U<<(from%32));
+    }
+}
+
+void AP_OADatabase_Index::set_mark(uint16_t idx)
+{
+    _marks[idx/32] |= 1U<<(idx%32);
+}
+
+uint16_t AP_OADatabase_Index::next_marked(uint16_t idx) const
+{
+    for (uint16_t w = idx/32; w < (_size + 31) / 32; w++) {
+        uint32_t bits = _marks[w];
+        if (w == idx/32) {
+            // ignore slots below idx
+            bits &= ~((1U<<(idx%32)) - 1);
+        }
+        if (bits != 0) {
+            return w * 32 + __builtin_ctz(bits);
+        }
+    }
+    return NONE;
+}
+
+bool AP_OADatabase_Index::grid_max_radius(float &radius) const
+{
+    for (int8_t c = max_radius_cells + 1; c >= 0; c--) {
+        if (_radius_count[c] == 0) {
+            continue;
+        }
+        if (c > max_radius_cells) {
+            return false;
+        }
+        radius = c * _cell_size;
+        return true;
+    }
+    radius = 0;
+    return true;
+}
+
+uint32_t AP_OADatabase_Index::grid_cell_count(const Vector2f &min, const Vector2f &max) const
+{
+    const uint64_t nx = int64_t(cell(max.x)) - cell(min.x) + 1;
+    const uint64_t ny = int64_t(cell(max.y)) - cell(min.y) + 1;
+    return MIN(nx * ny, uint64_t(UINT32_MAX));
+}
+
+#endif  // AP_OADATABASE_ENABLED
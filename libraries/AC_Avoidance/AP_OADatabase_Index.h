@@ -0,0 +1,146 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  index over the slots of the OADatabase item array
+
+  Items located by position are linked into a hash of square grid
+  cells on their horizontal position, so the items near a point or
+  line can be found without visiting the whole database. Other items
+  (e.g. AIS, which are matched by ID) are kept on a separate list.
+  Every item is also on a list sorted oldest first, so expired items
+  are found without checking the age of every item.
+
+  The index holds no copy of the items, the database tells it when a
+  slot is filled, changed, emptied or moved.
+ */
+#pragma once
+
+#include "AC_Avoidance_config.h"
+
+#if AP_OADATABASE_ENABLED
+
+#include <AP_Math/AP_Math.h>
+
+class AP_OADatabase_Index {
+public:
+    static constexpr uint16_t NONE = UINT16_MAX;
+
+    ~AP_OADatabase_Index();
+
+    // allocate for up to size items, returns false on failure
+    bool init(uint16_t size, float cell_size_m);
+    bool initialised() const { return _slots != nullptr; }
+
+    float cell_size() const { return _cell_size; }
+
+    // add the item in slot idx to the grid at a horizontal position
+    void insert_grid(uint16_t idx, const Vector2f &pos, float radius);
+    // add the item in slot idx to the list of items not on the grid
+    void insert_other(uint16_t idx);
+    // record a change of the radius of a grid item
+    void set_radius(uint16_t idx, float radius);
+    // remove the item in slot idx from the index
+    void remove(uint16_t idx);
+    // the item in slot from has been copied to the empty slot to
+    void move(uint16_t from, uint16_t to);
+
+    // list of items sorted by age, oldest first
+    uint16_t oldest() const { return _oldest; }
+    uint16_t newest() const { return _newest; }
+    uint16_t older(uint16_t idx) const { return _slots[idx].older; }
+    uint16_t newer(uint16_t idx) const { return _slots[idx].newer; }
+    // add slot idx to the age list just newer than slot older, or as
+    // the oldest if older is NONE
+    void insert_age(uint16_t idx, uint16_t older);
+    // remove slot idx from the age list, e.g. before reinserting it
+    // after its timestamp changes
+    void remove_age(uint16_t idx);
+
+    // mark slots, e.g. for removal. Marks move with their item
+    void set_mark(uint16_t idx);
+    bool marked(uint16_t idx) const { return (_marks[idx/32] & (1U<<(idx%32))) != 0; }
+    // lowest marked slot at or above idx, NONE if there is none
+    uint16_t next_marked(uint16_t idx) const;
+
+    // upper bound on the radius of grid items. Returns false if some
+    // are too large to bound, and the grid cannot be used for searches
+    bool grid_max_radius(float &radius) const;
+
+    // number of grid cells overlapping a box
+    uint32_t grid_cell_count(const Vector2f &min, const Vector2f &max) const;
+
+    // call fn(idx) for each grid item in cells overlapping a box. An
+    // item may be visited more than once
+    template <typename F>
+    void grid_foreach(const Vector2f &min, const Vector2f &max, F fn) const {
+        const int32_t x0 = cell(min.x), x1 = cell(max.x);
+        const int32_t y0 = cell(min.y), y1 = cell(max.y);
+        for (int32_t x = x0; x <= x1; x++) {
+            for (int32_t y = y0; y <= y1; y++) {
+                for (uint16_t i = _heads[bucket(x, y)]; i != NONE; i = _slots[i].next) {
+                    fn(i);
+                }
+            }
+        }
+    }
+
+    // call fn(idx) for each item not on the grid
+    template <typename F>
+    void other_foreach(F fn) const {
+        for (uint16_t i = _heads[_num_buckets]; i != NONE; i = _slots[i].next) {
+            fn(i);
+        }
+    }
+
+private:
+    // grid items with a radius of up to this many cells can be searched for
+    static constexpr uint8_t max_radius_cells = 15;
+    static constexpr uint8_t radius_class_none = 0xFF;
+
+    struct Slot {
+        uint16_t chain;         // hash bucket, or _num_buckets for items not on the grid
+        uint16_t next;          // next and previous in the chain
+        uint16_t prev;
+        uint16_t older;         // neighbours in the age list
+        uint16_t newer;
+        uint8_t radius_class;   // radius in whole cells rounded up, radius_class_none if not on the grid
+    };
+
+    int32_t cell(float pos) const {
+        return int32_t(floorf(constrain_float(pos * _cell_size_inv, -1.0e6, 1.0e6)));
+    }
+    uint16_t bucket(int32_t x, int32_t y) const {
+        return ((uint32_t(x) * 73856093U) ^ (uint32_t(y) * 19349663U)) & (_num_buckets - 1);
+    }
+    uint8_t radius_class(float radius) const;
+
+    void insert_chain(uint16_t idx, uint16_t chain);
+
+    Slot *_slots = nullptr;
+    uint16_t *_heads = nullptr; // first item in each bucket, then the head of the list of other items
+    uint32_t *_marks = nullptr;
+    uint16_t _size = 0;
+    uint16_t _num_buckets = 0;
+    float _cell_size = 1;
+    float _cell_size_inv = 1;
+    uint16_t _oldest = NONE;
+    uint16_t _newest = NONE;
+
+    // number of grid items in each radius class, the last counts
+    // everything larger
+    uint16_t _radius_count[max_radius_cells + 2] {};
+};
+
+#endif  // AP_OADATABASE_ENABLED
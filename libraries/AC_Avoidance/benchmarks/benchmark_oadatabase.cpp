@@ -0,0 +1,120 @@
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OADatabase.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_OADATABASE_ENABLED
+
+static const uint16_t num_points = 5000;
+static const uint16_t batch_size = 50;
+
+static uint32_t seed = 1;
+static float rand_float(float min, float max)
+{
+    seed = seed * 1103515245U + 12345U;
+    return min + (max - min) * ((seed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+// lidar returns scattered over a 200m square
+static Vector3f rand_point()
+{
+    return Vector3f{rand_float(-100, 100), rand_float(-100, 100), rand_float(-20, 0)};
+}
+
+// a database filled with num_points objects
+static AP_OADatabase &get_database()
+{
+    static AP_OADatabase db;
+    static bool initialised;
+    if (!initialised) {
+        initialised = true;
+        AP_Param::set_object_value(&db, AP_OADatabase::var_info, "SIZE", num_points);
+        AP_Param::set_object_value(&db, AP_OADatabase::var_info, "EXPIRE", 0);
+        db.init();
+        while (db.database_count() < num_points) {
+            for (uint16_t i = 0; i < batch_size; i++) {
+                db.queue_push(rand_point(), 0, 0, 0.2, AP_OADatabase::OA_DbItem::Source::proximity);
+            }
+            while (db.process_queue()) {}
+        }
+    }
+    return db;
+}
+
+// new lidar returns checked against the database for a match
+static void BM_OADatabaseInsert(benchmark::State& state)
+{
+    AP_OADatabase &db = get_database();
+
+    while (state.KeepRunning()) {
+        for (uint16_t i = 0; i < batch_size; i++) {
+            db.queue_push(rand_point(), 0, 0, 0.2, AP_OADatabase::OA_DbItem::Source::proximity);
+        }
+        db.process_queue();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * batch_size);
+}
+
+// the same check of every object as the database did before it was indexed
+static void BM_OADatabaseInsertLinear(benchmark::State& state)
+{
+    AP_OADatabase &db = get_database();
+
+    while (state.KeepRunning()) {
+        uint16_t matches = 0;
+        for (uint16_t i = 0; i < batch_size; i++) {
+            const Vector3f pos = rand_point();
+            for (uint16_t j = 0; j < db.database_count(); j++) {
+                const AP_OADatabase::OA_DbItem &item = db.get_item(j);
+                if ((item.pos - pos).length_squared() < sq(MAX(item.radius, 0.2f))) {
+                    matches++;
+                    break;
+                }
+            }
+        }
+        gbenchmark_escape(&matches);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * batch_size);
+}
+
+// BendyRuler's margin from a 15m probe
+static void BM_OADatabaseClosestMargin(benchmark::State& state)
+{
+    AP_OADatabase &db = get_database();
+
+    while (state.KeepRunning()) {
+        const Vector3f start = rand_point() * 100;
+        const Vector3f end = start + Vector3f{1500, 0, 0};
+        float margin;
+        bool ret = db.get_closest_margin(start, end, margin);
+        gbenchmark_escape(&ret);
+        gbenchmark_escape(&margin);
+    }
+}
+
+static void BM_OADatabaseClosestMarginLinear(benchmark::State& state)
+{
+    AP_OADatabase &db = get_database();
+
+    while (state.KeepRunning()) {
+        const Vector3f start = rand_point() * 100;
+        const Vector3f end = start + Vector3f{1500, 0, 0};
+        float margin = FLT_MAX;
+        for (uint16_t j = 0; j < db.database_count(); j++) {
+            const AP_OADatabase::OA_DbItem &item = db.get_item(j);
+            const float m = Vector3f::closest_distance_between_line_and_point(start, end, item.pos * 100.0f) * 0.01f - item.radius;
+            margin = MIN(margin, m);
+        }
+        gbenchmark_escape(&margin);
+    }
+}
+
+BENCHMARK(BM_OADatabaseInsert);
+BENCHMARK(BM_OADatabaseInsertLinear);
+BENCHMARK(BM_OADatabaseClosestMargin);
+BENCHMARK(BM_OADatabaseClosestMarginLinear);
+
+#endif  // AP_OADATABASE_ENABLED
+
+BENCHMARK_MAIN();
@@ -0,0 +1,177 @@
+#include <AP_gtest.h>
+
+/*
+  tests for the AP_OADatabase index, comparing the database against
+  one which checks every item as the database did before it was indexed
+ */
+
+#include <AC_Avoidance/AP_OADatabase.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_OADATABASE_ENABLED
+
+using OA_DbItem = AP_OADatabase::OA_DbItem;
+
+static const uint16_t db_size = 6000;
+static const uint32_t expiry_ms = 10000;
+
+class AP_OADatabase_Test
+{
+public:
+    AP_OADatabase_Test() {
+        db._database_size_param.set(db_size);
+        db._queue_size_param.set(200);
+        db._database_expiry_seconds.set(expiry_ms / 1000);
+        db.init();
+    }
+
+    bool index_initialised() const { return db._index.initialised(); }
+
+    // put an item through the queue into both databases
+    void push(const Vector3f &pos, uint32_t timestamp_ms, float radius, OA_DbItem::Source source, uint32_t id) {
+        db.queue_push(pos, timestamp_ms, 0, radius, source, id);
+        db.process_queue();
+
+        const OA_DbItem item {pos, timestamp_ms, MAX(radius, db._radius_min.get()), id, 0, AP_OADatabase::OA_DbItemImportance::Normal, source};
+        for (uint16_t i=0; i<ref_count; i++) {
+            if (db.item_match(ref[i], item)) {
+                ref_refresh(ref[i], item);
+                return;
+            }
+        }
+        if (ref_count < db_size) {
+            ref[ref_count++] = item;
+        }
+    }
+
+    void expire(uint32_t now_ms) {
+        db.database_items_remove_all_expired(now_ms);
+
+        uint16_t index = 0;
+        while (index < ref_count) {
+            if (now_ms - ref[index].timestamp_ms > expiry_ms) {
+                ref[index] = ref[--ref_count];
+            } else {
+                index++;
+            }
+        }
+    }
+
+    // check the databases hold the same items in the same order
+    void check_items() const {
+        ASSERT_EQ(ref_count, db.database_count());
+        for (uint16_t i=0; i<ref_count; i++) {
+            const OA_DbItem &a = ref[i];
+            const OA_DbItem &b = db.get_item(i);
+            ASSERT_EQ(a.pos, b.pos);
+            ASSERT_EQ(a.timestamp_ms, b.timestamp_ms);
+            ASSERT_EQ(a.radius, b.radius);
+            ASSERT_EQ(a.id, b.id);
+            ASSERT_EQ(a.source, b.source);
+        }
+    }
+
+    // check BendyRuler's margin from a segment is unchanged
+    void check_margin(const Vector3f &start_cm, const Vector3f &end_cm) const {
+        float expected = FLT_MAX;
+        for (uint16_t i=0; i<ref_count; i++) {
+            const float m = Vector3f::closest_distance_between_line_and_point(start_cm, end_cm, ref[i].pos * 100.0f) * 0.01f - ref[i].radius;
+            if (m < expected) {
+                expected = m;
+            }
+        }
+        float margin;
+        ASSERT_EQ(ref_count > 0, db.get_closest_margin(start_cm, end_cm, margin));
+        if (ref_count > 0) {
+            ASSERT_EQ(expected, margin);
+        }
+    }
+
+    uint16_t count() const { return ref_count; }
+
+private:
+    // database_item_refresh() as it was
+    static void ref_refresh(OA_DbItem &current_item, const OA_DbItem &new_item) {
+        if (!is_equal(current_item.radius, new_item.radius) ||
+            (new_item.timestamp_ms - current_item.timestamp_ms >= 500)) {
+            current_item.timestamp_ms = new_item.timestamp_ms;
+            current_item.radius = new_item.radius;
+            if (current_item.source == OA_DbItem::Source::AIS) {
+                current_item.pos = new_item.pos;
+            }
+        }
+    }
+
+    AP_OADatabase db;
+    OA_DbItem ref[db_size];
+    uint16_t ref_count;
+};
+
+static uint32_t seed = 1;
+static float rand_float(float min, float max)
+{
+    seed = seed * 1103515245U + 12345U;
+    return min + (max - min) * ((seed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+/*
+  a 3D lidar on a vehicle flying past a random set of obstacles,
+  with a few AIS vessels and occasional large objects
+ */
+TEST(AP_OADatabase, MatchesLinearDatabase)
+{
+    static AP_OADatabase_Test test;
+    ASSERT_TRUE(test.index_initialised());
+
+    Vector3f obstacles[400];
+    for (auto &o : obstacles) {
+        o = Vector3f{rand_float(-200, 200), rand_float(-40, 40), rand_float(-20, 0)};
+    }
+
+    uint16_t max_count = 0;
+    for (uint32_t now_ms = 1000; now_ms < 60000; now_ms += 50) {
+        const Vector3f vehicle{-150 + now_ms * 0.005f, 0, -10};
+
+        for (uint16_t p=0; p<200; p++) {
+            const Vector3f &o = obstacles[unsigned(rand_float(0, ARRAY_SIZE(obstacles) - 1))];
+            const Vector3f pos = o + Vector3f{rand_float(-3, 3), rand_float(-3, 3), rand_float(-3, 3)};
+            const float distance = (pos - vehicle).length();
+            if (distance > 40) {
+                continue;
+            }
+            // radius from a 1 degree lidar beam width
+            test.push(pos, now_ms, distance * 0.0175f, OA_DbItem::Source::proximity, 0);
+        }
+        if (now_ms % 20000 == 0) {
+            // an object too large for the index to search for
+            test.push(Vector3f{0, 500, 0}, now_ms, 20, OA_DbItem::Source::proximity, 0);
+        }
+        if (now_ms % 1000 == 0) {
+            for (uint8_t v=0; v<5; v++) {
+                const Vector3f pos{rand_float(-300, 300), rand_float(-300, 300), 0};
+                test.push(pos, now_ms - v * 1500, 20, OA_DbItem::Source::AIS, 100 + v);
+            }
+            test.expire(now_ms);
+            test.check_items();
+
+            // BendyRuler probes from the vehicle
+            for (uint8_t b=0; b<8; b++) {
+                const float bearing = radians(b * 45);
+                const Vector3f end = vehicle + Vector3f{cosf(bearing), sinf(bearing), 0} * 15;
+                test.check_margin(vehicle * 100, end * 100);
+            }
+        }
+        max_count = MAX(max_count, test.count());
+    }
+    EXPECT_GT(max_count, 5000);
+
+    // everything expires
+    test.expire(80000);
+    test.check_items();
+    test.check_margin(Vector3f{}, Vector3f{100, 0, 0});
+}
+
+#endif  // AP_OADATABASE_ENABLED
+
+AP_GTEST_MAIN()
@@ -235,11 +235,11 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
         return false;
     }
 
-    Vector2f scaled_pos;
+    // local copy as this may be called from more than one thread
+    const LocationProjection projection = loaded_projection;
+
+    const Vector2f scaled_pos = projection.get_distance_NE(loc) * 100.0f;
     Vector2l pos { loc.lat, loc.lng };
-    if (!scale_latlon_from_origin(loaded_origin, pos, scaled_pos)) {
-        return false;
-    }
 
     const uint16_t num_inclusion = _num_loaded_circle_inclusion_boundaries + _num_loaded_inclusion_boundaries;
     uint16_t num_inclusion_outside = 0;
@@ -286,7 +286,7 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
         Location circle_center;
         circle_center.lat = circle.point.x;
         circle_center.lng = circle.point.y;
-        const float diff_cm = loc.get_distance(circle_center)*100.0f;
+        const float diff_cm = projection.get_distance(loc, circle_center)*100.0f;
         distance_outside_fence = MAX(distance_outside_fence, circle.radius - diff_cm*0.01f);
         if (diff_cm < circle.radius * 100.0f) {
             return true;
@@ -298,7 +298,7 @@ bool AC_PolyFence_loader::breached(const Location& loc, float& distance_outside_
         Location circle_center;
         circle_center.lat = circle.point.x;
         circle_center.lng = circle.point.y;
-        const float diff_cm = loc.get_distance(circle_center)*100.0f;
+        const float diff_cm = projection.get_distance(loc, circle_center)*100.0f;
         distance_outside_fence = MAX(distance_outside_fence, diff_cm*0.01f - circle.radius);
         if (diff_cm > circle.radius * 100.0f) {
             num_inclusion_outside++;
@@ -355,30 +355,29 @@ bool AC_PolyFence_loader::format()
     return write_eos_to_storage(offset);
 }
 
-bool AC_PolyFence_loader::scale_latlon_from_origin(const Location &origin, const Vector2l &point, Vector2f &pos_cm) const
+bool AC_PolyFence_loader::scale_latlon_from_origin(const Vector2l &point, Vector2f &pos_cm) const
 {
-    Location tmp_loc;
-    tmp_loc.lat = point.x;
-    tmp_loc.lng = point.y;
-    pos_cm = origin.get_distance_NE(tmp_loc) * 100.0f;
+    loaded_projection.get_distance_NE(&point, &pos_cm, 1);
+    pos_cm *= 100.0f;
     return true;
 }
 
-bool AC_PolyFence_loader::read_polygon_from_storage(const Location &origin, uint16_t &read_offset, const uint8_t vertex_count, Vector2f *&next_storage_point, Vector2l *&next_storage_point_lla)
+bool AC_PolyFence_loader::read_polygon_from_storage(uint16_t &read_offset, const uint8_t vertex_count, Vector2f *&next_storage_point, Vector2l *&next_storage_point_lla)
 {
+    // read from storage to lat/lon
     for (uint8_t i=0; i<vertex_count; i++) {
-        // read from storage to lat/lon
-        if (!read_latlon_from_storage(read_offset, *next_storage_point_lla)) {
-            return false;
-        }
-        // convert lat/lon to position in cm from origin
-        if (!scale_latlon_from_origin(origin, *next_storage_point_lla, *next_storage_point)) {
+        if (!read_latlon_from_storage(read_offset, next_storage_point_lla[i])) {
             return false;
         }
-        
-        next_storage_point_lla++;
-        next_storage_point++;
     }
+
+    // convert lat/lon to position in cm from origin
+    loaded_projection.get_distance_NE(next_storage_point_lla, next_storage_point, vertex_count);
+    for (uint8_t i=0; i<vertex_count; i++) {
+        next_storage_point[i] *= 100.0f;
+    }
+    next_storage_point_lla += vertex_count;
+    next_storage_point += vertex_count;
     return true;
 }
 
@@ -661,6 +660,7 @@ bool AC_PolyFence_loader::load_from_storage()
 //        Debug("fence load requires origin");
         return false;
     }
+    loaded_projection.set_origin(loaded_origin);
 
     // find indexes of each fence:
     if (!get_loaded_fence_semaphore().take_nonblocking()) {
@@ -777,7 +777,7 @@ bool AC_PolyFence_loader::load_from_storage()
                 break;
             }
             storage_offset += 1; // skip vertex count
-            if (!read_polygon_from_storage(loaded_origin, storage_offset, index.count, next_storage_point, next_storage_point_lla)) {
+            if (!read_polygon_from_storage(storage_offset, index.count, next_storage_point, next_storage_point_lla)) {
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AC_Fence: polygon read failed");
                 storage_valid = false;
                 break;
@@ -796,7 +796,7 @@ bool AC_PolyFence_loader::load_from_storage()
                 break;
             }
             storage_offset += 1; // skip vertex count
-            if (!read_polygon_from_storage(loaded_origin, storage_offset, index.count, next_storage_point, next_storage_point_lla)) {
+            if (!read_polygon_from_storage(storage_offset, index.count, next_storage_point, next_storage_point_lla)) {
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AC_Fence: polygon read failed");
                 storage_valid = false;
                 break;
@@ -814,7 +814,7 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
-            if (!scale_latlon_from_origin(loaded_origin, circle.point, circle.pos_cm)) {
+            if (!scale_latlon_from_origin(circle.point, circle.pos_cm)) {
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AC_Fence: latlon read failed");
                 storage_valid = false;
                 break;
@@ -846,7 +846,7 @@ bool AC_PolyFence_loader::load_from_storage()
                 storage_valid = false;
                 break;
             }
-            if (!scale_latlon_from_origin(loaded_origin, circle.point, circle.pos_cm)){
+            if (!scale_latlon_from_origin(circle.point, circle.pos_cm)){
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "AC_Fence: latlon read failed");
                 storage_valid = false;
                 break;
@@ -887,7 +887,7 @@ bool AC_PolyFence_loader::load_from_storage()
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "PolyFence: latlon read failed");
                 break;
             }
-            if (!scale_latlon_from_origin(loaded_origin, *next_storage_point_lla, *next_storage_point)) {
+            if (!scale_latlon_from_origin(*next_storage_point_lla, *next_storage_point)) {
                 storage_valid = false;
                 GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "PolyFence: latlon read failed");
                 break;
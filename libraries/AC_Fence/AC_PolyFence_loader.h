@@ -50,6 +50,7 @@ public:
 
 #include <AP_Common/AP_Common.h>
 #include <AP_Common/Location.h>
+#include <AP_Common/LocationProjection.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 
 class AC_PolyFence_loader
@@ -329,6 +330,7 @@ private:
     Vector2f *_loaded_offsets_from_origin;
     Vector2l *_loaded_points_lla;
     Location loaded_origin; // origin at the time the boundary was loaded
+    LocationProjection loaded_projection; // projection about loaded_origin
 
     class ExclusionCircle {
     public:
@@ -362,16 +364,14 @@ private:
     // scale_latlon_from_origin - given a latitude/longitude
     // transforms the point to an offset-from-origin and deposits
     // the result into pos_cm.
-    bool scale_latlon_from_origin(const Location &origin,
-                                  const Vector2l &point,
+    bool scale_latlon_from_origin(const Vector2l &point,
                                   Vector2f &pos_cm) const WARN_IF_UNUSED;
    
     // read_polygon_from_storage - reads vertex_count
     // latitude/longitude points from offset in permanent storage,
     // transforms them into an offset-from-origin and deposits the
     // results into next_storage_point.
-    bool read_polygon_from_storage(const Location &origin,
-                                   uint16_t &read_offset,
+    bool read_polygon_from_storage(uint16_t &read_offset,
                                    const uint8_t vertex_count,
                                    Vector2f *&next_storage_point,
                                    Vector2l *&next_storage_point_lla) WARN_IF_UNUSED;
@@ -287,9 +287,16 @@ float closest_approach_NE_m(const Location &loc,
                           const Vector3f &obstacle_vel_ned_ms,
                           const uint8_t time_horizon_s)
 {
+    return closest_approach_NE_m(obstacle_loc.get_distance_NE(loc), vel_ned_ms, obstacle_vel_ned_ms, time_horizon_s);
+}
+
+float closest_approach_NE_m(const Vector2f &delta_pos_ne_m,
+                          const Vector3f &vel_ned_ms,
+                          const Vector3f &obstacle_vel_ned_ms,
+                          const uint8_t time_horizon_s)
+{
 
     Vector2f delta_vel_ne_ms = Vector2f(obstacle_vel_ned_ms[0] - vel_ned_ms[0], obstacle_vel_ned_ms[1] - vel_ned_ms[1]);
-    const Vector2f delta_pos_ne_m = obstacle_loc.get_distance_NE(loc);
 
     Vector2f line_segment_ne_m = delta_vel_ne_ms * time_horizon_s;
 
@@ -344,12 +351,15 @@ void AP_Avoidance::update_threat_level(const Location &loc,
 
     obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
 
+    // offset from the obstacle to us
+    const Vector2f delta_pos_ne_m = _projection.get_distance_NE(obstacle_loc, loc);
+
     const uint32_t obstacle_age_ms = AP_HAL::millis() - obstacle.timestamp_ms;
-    float closest_ne_m = closest_approach_NE_m(loc, vel_ned_ms, obstacle_loc, obstacle_vel_ned_ms, _fail_time_horizon_s + obstacle_age_ms/1000);
+    float closest_ne_m = closest_approach_NE_m(delta_pos_ne_m, vel_ned_ms, obstacle_vel_ned_ms, _fail_time_horizon_s + obstacle_age_ms/1000);
     if (closest_ne_m < _fail_distance_ne_m) {
         obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_HIGH;
     } else {
-        closest_ne_m = closest_approach_NE_m(loc, vel_ned_ms, obstacle_loc, obstacle_vel_ned_ms, _warn_time_horizon_s + obstacle_age_ms/1000);
+        closest_ne_m = closest_approach_NE_m(delta_pos_ne_m, vel_ned_ms, obstacle_vel_ned_ms, _warn_time_horizon_s + obstacle_age_ms/1000);
         if (closest_ne_m < _warn_distance_ne_m) {
             obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_LOW;
         }
@@ -378,7 +388,7 @@ void AP_Avoidance::update_threat_level(const Location &loc,
     // level is none - but only *once the GCS has been informed*!
     obstacle.closest_approach_ne_m = closest_ne_m;
     obstacle.closest_approach_d_m = closest_d_m;
-    float current_distance_ne_m = loc.get_distance(obstacle_loc);
+    float current_distance_ne_m = delta_pos_ne_m.length();
     obstacle.distance_to_closest_approach_ned_m = current_distance_ne_m - closest_ne_m;
     Vector2f net_velocity_ne_ms = Vector2f(vel_ned_ms[0] - obstacle_vel_ned_ms[0], vel_ned_ms[1] - obstacle_vel_ned_ms[1]);
     obstacle.time_to_closest_approach_s = 0.0f;
@@ -475,6 +485,9 @@ void AP_Avoidance::check_for_threats()
         return;
     }
 
+    // obstacles are all near us, so share one longitude scale
+    _projection.set_origin(loc);
+
     // we always check all obstacles to see if they are threats since it
     // is most likely our own position and/or velocity have changed
     // determine the current most-serious-threat
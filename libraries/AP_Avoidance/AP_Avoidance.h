@@ -30,6 +30,7 @@
 #if AP_ADSB_AVOIDANCE_ENABLED
 
 #include <AP_ADSB/AP_ADSB.h>
+#include <AP_Common/LocationProjection.h>
 
 #define AP_AVOIDANCE_STATE_RECOVERY_TIME_MS                 2000    // we will not downgrade state any faster than this (2 seconds)
 
@@ -209,6 +210,10 @@ private:
     AP_Float    _warn_distance_ne_m;
     AP_Float    _warn_distance_d_m;
 
+    // projection about our location for obstacle distances, only
+    // used from check_for_threats()
+    LocationProjection _projection;
+
     // multi-thread support for avoidance
     HAL_Semaphore _rsem;
 
@@ -220,6 +225,10 @@ float closest_approach_NE_m(const Location &my_loc,
                           const Location &obstacle_loc,
                           const Vector3f &obstacle_vel,
                           uint8_t time_horizon);
+float closest_approach_NE_m(const Vector2f &delta_pos_ne_m,
+                          const Vector3f &my_vel,
+                          const Vector3f &obstacle_vel,
+                          uint8_t time_horizon);
 
 float closest_approach_D_m(const Location &my_loc,
                          const Vector3f &my_vel,
@@ -0,0 +1,68 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LocationProjection.h"
+
+#ifndef HAL_BOOTLOADER_BUILD
+
+void LocationProjection::set_scale_tolerance(float tolerance)
+{
+    _tolerance = constrain_float(tolerance, 0, 0.01);
+    // force recalculation of the margin
+    _scale_lat_margin = -1;
+}
+
+void LocationProjection::update_scale(int32_t lat) const
+{
+    _scale_lat = lat;
+    _scale = Location::longitude_scale(lat);
+
+    /*
+      moving d radians from latitude lat changes the scale by a factor
+      of cos(d) - tan(lat)*sin(d), which differs from one by at most
+      tan(lat)*d + d^2/2. Solve for the d where that reaches the
+      tolerance, in a form which is stable for large tan(lat)
+     */
+    const ftype t = fabsF(tanF(lat * (1.0e-7 * DEG_TO_RAD)));
+    const ftype margin_rad = 2 * _tolerance / (t + sqrtF(t*t + 2 * _tolerance));
+    _scale_lat_margin = MIN(margin_rad * (RAD_TO_DEG * 1.0e7), ftype(INT32_MAX / 2));
+}
+
+void LocationProjection::get_distance_NE(const Location *locs, Vector2f *ne, uint16_t count) const
+{
+    for (uint16_t i=0; i<count; i++) {
+        ne[i] = get_distance_NE(locs[i]);
+    }
+}
+
+void LocationProjection::get_distance_NE(const Vector2l *latlng, Vector2f *ne, uint16_t count) const
+{
+    for (uint16_t i=0; i<count; i++) {
+        ne[i] = distance_NE(_origin.lat, _origin.lng, latlng[i].x, latlng[i].y);
+    }
+}
+
+Location LocationProjection::get_location(const Vector2f &ofs_ne) const
+{
+    // same as Location::offset_latlng()
+    Location loc = _origin;
+    const int32_t dlat = ftype(ofs_ne.x) * float(LATLON_TO_M_INV);
+    const int64_t dlng = (ftype(ofs_ne.y) * float(LATLON_TO_M_INV)) / longitude_scale(_origin.lat + dlat/2);
+    loc.lat = Location::limit_lattitude(_origin.lat + dlat);
+    loc.lng = Location::wrap_longitude(dlng + _origin.lng);
+    return loc;
+}
+
+#endif // HAL_BOOTLOADER_BUILD
@@ -0,0 +1,100 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  local tangent plane projection about an origin
+
+  Location::get_distance_NE() calculates the longitude scale, a
+  cosine, on every call. This caches the scale and only recalculates
+  it when the mid latitude of a conversion has moved far enough from
+  the cached one that the scale would be out by more than the scale
+  tolerance, so converting many points near the origin costs a few
+  multiplies each. Results match the Location methods to within the
+  tolerance.
+
+  The cache is updated from const methods, so an instance must not be
+  shared between threads.
+ */
+#pragma once
+
+#include "Location.h"
+
+class LocationProjection {
+public:
+    // default relative error allowed in the cached longitude scale,
+    // 1cm in every 100m of easting
+    static constexpr float DEFAULT_SCALE_TOLERANCE = 1.0e-4f;
+
+    LocationProjection() {}
+    explicit LocationProjection(const Location &origin) { set_origin(origin); }
+
+    // change the origin, keeping the cached scale if it is still in tolerance
+    void set_origin(const Location &origin) { _origin = origin; }
+    const Location &get_origin() const { return _origin; }
+
+    // relative error allowed in the longitude scale. Zero recalculates
+    // the scale whenever the latitude changes, giving the same results
+    // as Location
+    void set_scale_tolerance(float tolerance);
+
+    // distance in metres in North/East plane from the origin to loc
+    Vector2f get_distance_NE(const Location &loc) const {
+        return distance_NE(_origin.lat, _origin.lng, loc.lat, loc.lng);
+    }
+    ftype get_distance(const Location &loc) const {
+        return get_distance_NE(loc).length();
+    }
+
+    // distance in metres in North/East plane between two locations
+    // near the origin, as from.get_distance_NE(to)
+    Vector2f get_distance_NE(const Location &from, const Location &to) const {
+        return distance_NE(from.lat, from.lng, to.lat, to.lng);
+    }
+    ftype get_distance(const Location &from, const Location &to) const {
+        return get_distance_NE(from, to).length();
+    }
+
+    // convert count locations to distances in metres from the origin
+    void get_distance_NE(const Location *locs, Vector2f *ne, uint16_t count) const;
+    // as above for latitude/longitude pairs in 1e-7 degrees
+    void get_distance_NE(const Vector2l *latlng, Vector2f *ne, uint16_t count) const;
+
+    // location at an offset in metres North/East of the origin, the
+    // inverse of get_distance_NE(). The altitude is that of the origin
+    Location get_location(const Vector2f &ofs_ne) const;
+
+private:
+    Vector2f distance_NE(int32_t lat1, int32_t lng1, int32_t lat2, int32_t lng2) const {
+        return Vector2f((lat2 - lat1) * float(LATLON_TO_M),
+                        Location::diff_longitude(lng2, lng1) * float(LATLON_TO_M) * longitude_scale((lat1 + lat2) / 2));
+    }
+
+    // Location::longitude_scale(lat), from the cache when in tolerance
+    ftype longitude_scale(int32_t lat) const {
+        if (abs(lat - _scale_lat) > _scale_lat_margin) {
+            update_scale(lat);
+        }
+        return _scale;
+    }
+    void update_scale(int32_t lat) const;
+
+    Location _origin;
+    float _tolerance = DEFAULT_SCALE_TOLERANCE;
+
+    // latitude the cached scale was calculated at and how far from it
+    // in 1e-7 degrees the scale may be reused, negative when invalid
+    mutable int32_t _scale_lat = 0;
+    mutable int32_t _scale_lat_margin = -1;
+    mutable ftype _scale = 1;
+};
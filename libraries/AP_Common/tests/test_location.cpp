@@ -1,5 +1,6 @@
 #include <AP_gtest.h>
 #include <AP_Common/Location.h>
+#include <AP_Common/LocationProjection.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_Terrain/AP_Terrain.h>
@@ -468,4 +469,38 @@ TEST(Location, London_distance)
 }
 
 
+TEST(Location, Projection)
+{
+    const Location origin{-353632620, 1491652370, 0, Location::AltFrame::ABSOLUTE};
+    Location locs[16];
+    Vector2f ne[16];
+    for (uint8_t i=0; i<ARRAY_SIZE(locs); i++) {
+        locs[i] = origin;
+        locs[i].offset(1000.0 * (i - 8), 2500.0 * (i % 5) - 5000.0);
+    }
+
+    // a zero tolerance gives the same answers as Location
+    LocationProjection exact{origin};
+    exact.set_scale_tolerance(0);
+    exact.get_distance_NE(locs, ne, ARRAY_SIZE(locs));
+    for (uint8_t i=0; i<ARRAY_SIZE(locs); i++) {
+        EXPECT_VECTOR2F_EQ(ne[i], origin.get_distance_NE(locs[i]));
+        EXPECT_FLOAT_EQ(exact.get_distance(locs[i], origin), locs[i].get_distance(origin));
+        const Location loc = exact.get_location(ne[i]);
+        Location expected = origin;
+        expected.offset(ne[i].x, ne[i].y);
+        EXPECT_EQ(loc.lat, expected.lat);
+        EXPECT_EQ(loc.lng, expected.lng);
+    }
+
+    // the default is within tolerance of Location
+    const LocationProjection projection{origin};
+    projection.get_distance_NE(locs, ne, ARRAY_SIZE(locs));
+    for (uint8_t i=0; i<ARRAY_SIZE(locs); i++) {
+        const Vector2f expected = origin.get_distance_NE(locs[i]);
+        EXPECT_FLOAT_EQ(ne[i].x, expected.x);
+        EXPECT_NEAR(ne[i].y, expected.y, fabsf(expected.y) * LocationProjection::DEFAULT_SCALE_TOLERANCE);
+    }
+}
+
 AP_GTEST_MAIN()
@@ -208,11 +208,12 @@ void CompassCalibrator::update()
                 set_status(Status::RUNNING_STEP_TWO);
             }
         } else {
-            if (_fit_step == 0) {
+            if (_fit_step == 0 && lm_idle()) {
                 calc_initial_offset();
             }
-            run_sphere_fit();
-            _fit_step++;
+            if (run_sphere_fit()) {
+                _fit_step++;
+            }
         }
     } else if (_status == Status::RUNNING_STEP_TWO) {
         if (_fit_step >= 35) {
@@ -222,11 +223,13 @@ void CompassCalibrator::update()
                 set_status(Status::FAILED);
             }
         } else if (_fit_step < 15) {
-            run_sphere_fit();
-            _fit_step++;
+            if (run_sphere_fit()) {
+                _fit_step++;
+            }
         } else {
-            run_ellipsoid_fit();
-            _fit_step++;
+            if (run_ellipsoid_fit()) {
+                _fit_step++;
+            }
         }
     }
 }
@@ -365,6 +368,8 @@ void CompassCalibrator::initialize_fit()
     _sphere_lambda = 1.0f;
     _ellipsoid_lambda = 1.0f;
     _fit_step = 0;
+    _lm.fitness_pass = false;
+    _lm.next_sample = 0;
 }
 
 void CompassCalibrator::reset_state()
@@ -604,7 +609,7 @@ void CompassCalibrator::calc_initial_offset()
     _params.offset /= _samples_collected;
 }
 
-void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const
+float CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const
 {
     const Vector3f &offset = params.offset;
     const Vector3f &diag = params.diag;
@@ -626,96 +631,18 @@ void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t&
     ret[1] = -1.0f * (((diag.x    * A) + (offdiag.x * B) + (offdiag.y * C))/length);
     ret[2] = -1.0f * (((offdiag.x * A) + (diag.y    * B) + (offdiag.z * C))/length);
     ret[3] = -1.0f * (((offdiag.y * A) + (offdiag.z * B) + (diag.z    * C))/length);
+
+    // same as calc_residual()
+    return params.radius - length;
 }
 
 // run sphere fit to calculate diagonals and offdiagonals
-void CompassCalibrator::run_sphere_fit()
+bool CompassCalibrator::run_sphere_fit()
 {
-    if (_sample_buffer == nullptr) {
-        return;
-    }
-
-    const float lma_damping = 10.0f;
-
-    // take backup of fitness and parameters so we can determine later if this fit has improved the calibration
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
-
-    float JTJ[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS] = { };
-    float JTJ2[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS] = { };
-    float JTFI[COMPASS_CAL_NUM_SPHERE_PARAMS] = { };
-
-    // Gauss Newton Part common for all kind of extensions including LM
-    for (uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
-
-        float sphere_jacob[COMPASS_CAL_NUM_SPHERE_PARAMS];
-
-        calc_sphere_jacob(sample, fit1_params, sphere_jacob);
-
-        for (uint8_t i = 0;i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-            // compute JTJ
-            for (uint8_t j = 0; j < COMPASS_CAL_NUM_SPHERE_PARAMS; j++) {
-                JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];   //a backup JTJ for LM
-            }
-            // compute JTFI
-            JTFI[i] += sphere_jacob[i] * calc_residual(sample, fit1_params);
-        }
-    }
-
-    //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
-    // refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for (uint8_t i = 0; i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda/lma_damping;
-    }
-
-    if (!mat_inverse(JTJ, JTJ, 4)) {
-        return;
-    }
-
-    if (!mat_inverse(JTJ2, JTJ2, 4)) {
-        return;
-    }
-
-    // extract radius, offset, diagonals and offdiagonal parameters
-    for (uint8_t row=0; row < COMPASS_CAL_NUM_SPHERE_PARAMS; row++) {
-        for (uint8_t col=0; col < COMPASS_CAL_NUM_SPHERE_PARAMS; col++) {
-            fit1_params.get_sphere_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-            fit2_params.get_sphere_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-        }
-    }
-
-    // calculate fitness of two possible sets of parameters
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
-
-    // decide which of the two sets of parameters is best and store in fit1_params
-    if (fit1 > _fitness && fit2 > _fitness) {
-        // if neither set of parameters provided better results, increase lambda
-        _sphere_lambda *= lma_damping;
-    } else if (fit2 < _fitness && fit2 < fit1) {
-        // if fit2 was better we will use it. decrease lambda
-        _sphere_lambda /= lma_damping;
-        fit1_params = fit2_params;
-        fitness = fit2;
-    } else if (fit1 < _fitness) {
-        fitness = fit1;
-    }
-    //--------------------Levenberg-Marquardt-part-ends-here--------------------------------//
-
-    // store new parameters and update fitness
-    if (!isnan(fitness) && fitness < _fitness) {
-        _fitness = fitness;
-        _params = fit1_params;
-        update_completion_mask();
-    }
+    return run_lm_fit(false, COMPASS_CAL_SAMPLES_PER_UPDATE);
 }
 
-void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const
+float CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const
 {
     const Vector3f &offset = params.offset;
     const Vector3f &diag = params.diag;
@@ -743,92 +670,132 @@ void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param
     ret[6] = -1.0f * (((sample.y + offset.y) * A) + ((sample.x + offset.x) * B))/length;
     ret[7] = -1.0f * (((sample.z + offset.z) * A) + ((sample.x + offset.x) * C))/length;
     ret[8] = -1.0f * (((sample.z + offset.z) * B) + ((sample.y + offset.y) * C))/length;
+
+    // same as calc_residual()
+    return params.radius - length;
 }
 
-void CompassCalibrator::run_ellipsoid_fit()
+bool CompassCalibrator::run_ellipsoid_fit()
+{
+    return run_lm_fit(true, COMPASS_CAL_SAMPLES_PER_UPDATE);
+}
+
+bool CompassCalibrator::run_lm_fit(bool ellipsoid, uint16_t max_samples)
 {
     if (_sample_buffer == nullptr) {
-        return;
+        return true;
     }
 
     const float lma_damping = 10.0f;
+    const uint8_t n = ellipsoid ? COMPASS_CAL_NUM_ELLIPSOID_PARAMS : COMPASS_CAL_NUM_SPHERE_PARAMS;
+    float &lambda = ellipsoid ? _ellipsoid_lambda : _sphere_lambda;
+    const uint16_t end = MIN(uint32_t(_lm.next_sample) + max_samples, uint32_t(_samples_collected));
+
+    if (!_lm.fitness_pass) {
+        if (_lm.next_sample == 0) {
+            // start from the current parameters
+            memset(_lm.JTJ, 0, sizeof(_lm.JTJ));
+            memset(_lm.JTFI, 0, sizeof(_lm.JTFI));
+            _lm.fit1_params = _lm.fit2_params = _params;
+        }
 
-    // take backup of fitness and parameters so we can determine later if this fit has improved the calibration
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
-
-    float JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
-    float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
-    float JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
+        // Gauss Newton Part common for all kind of extensions including LM
+        for (uint16_t k = _lm.next_sample; k < end; k++) {
+            const Vector3f sample = _sample_buffer[k].get();
+
+            float jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+            const float residual = ellipsoid ?
+                calc_ellipsoid_jacob(sample, _lm.fit1_params, jacob) :
+                calc_sphere_jacob(sample, _lm.fit1_params, jacob);
+
+            for (uint8_t i = 0; i < n; i++) {
+                // compute JTJ, which is symmetric so only the upper triangle is needed
+                for (uint8_t j = i; j < n; j++) {
+                    _lm.JTJ[i*n+j] += jacob[i] * jacob[j];
+                }
+                // compute JTFI
+                _lm.JTFI[i] += jacob[i] * residual;
+            }
+        }
+        _lm.next_sample = end;
+        if (end < _samples_collected) {
+            return false;
+        }
 
-    // Gauss Newton Part common for all kind of extensions including LM
-    for (uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
+        float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+        for (uint8_t i = 1; i < n; i++) {
+            for (uint8_t j = 0; j < i; j++) {
+                _lm.JTJ[i*n+j] = _lm.JTJ[j*n+i];
+            }
+        }
+        memcpy(JTJ2, _lm.JTJ, sizeof(float)*n*n);   // a backup JTJ for LM
 
-        float ellipsoid_jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+        //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
+        // refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
+        for (uint8_t i = 0; i < n; i++) {
+            _lm.JTJ[i*n+i] += lambda;
+            JTJ2[i*n+i] += lambda/lma_damping;
+        }
 
-        calc_ellipsoid_jacob(sample, fit1_params, ellipsoid_jacob);
+        _lm.next_sample = 0;
+        if (!mat_inverse(_lm.JTJ, _lm.JTJ, n) || !mat_inverse(JTJ2, JTJ2, n)) {
+            return true;
+        }
 
-        for (uint8_t i = 0;i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-            // compute JTJ
-            for (uint8_t j = 0; j < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; j++) {
-                JTJ [i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
+        // extract radius, offset, diagonals and offdiagonal parameters
+        float *fit1 = ellipsoid ? _lm.fit1_params.get_ellipsoid_params() : _lm.fit1_params.get_sphere_params();
+        float *fit2 = ellipsoid ? _lm.fit2_params.get_ellipsoid_params() : _lm.fit2_params.get_sphere_params();
+        for (uint8_t row=0; row < n; row++) {
+            for (uint8_t col=0; col < n; col++) {
+                fit1[row] -= _lm.JTFI[col] * _lm.JTJ[row*n+col];
+                fit2[row] -= _lm.JTFI[col] * JTJ2[row*n+col];
             }
-            // compute JTFI
-            JTFI[i] += ellipsoid_jacob[i] * calc_residual(sample, fit1_params);
         }
-    }
-
-    //------------------------Levenberg-Marquardt-part-starts-here---------------------------------//
-    //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for (uint8_t i = 0; i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda/lma_damping;
-    }
 
-    if (!mat_inverse(JTJ, JTJ, 9)) {
-        return;
+        _lm.fitness_pass = true;
+        _lm.fit1_sum = 0;
+        _lm.fit2_sum = 0;
+        return false;
     }
 
-    if (!mat_inverse(JTJ2, JTJ2, 9)) {
-        return;
+    // calculate fitness of two possible sets of parameters
+    for (uint16_t k = _lm.next_sample; k < end; k++) {
+        const Vector3f sample = _sample_buffer[k].get();
+        _lm.fit1_sum += sq(calc_residual(sample, _lm.fit1_params));
+        _lm.fit2_sum += sq(calc_residual(sample, _lm.fit2_params));
     }
-
-    // extract radius, offset, diagonals and offdiagonal parameters
-    for (uint8_t row=0; row < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; row++) {
-        for (uint8_t col=0; col < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; col++) {
-            fit1_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-            fit2_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-        }
+    _lm.next_sample = end;
+    if (end < _samples_collected) {
+        return false;
     }
+    _lm.fitness_pass = false;
+    _lm.next_sample = 0;
 
-    // calculate fitness of two possible sets of parameters
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
+    const float fit1 = _lm.fit1_sum / _samples_collected;
+    const float fit2 = _lm.fit2_sum / _samples_collected;
+    float fitness = _fitness;
 
     // decide which of the two sets of parameters is best and store in fit1_params
     if (fit1 > _fitness && fit2 > _fitness) {
         // if neither set of parameters provided better results, increase lambda
-        _ellipsoid_lambda *= lma_damping;
+        lambda *= lma_damping;
     } else if (fit2 < _fitness && fit2 < fit1) {
         // if fit2 was better we will use it. decrease lambda
-        _ellipsoid_lambda /= lma_damping;
-        fit1_params = fit2_params;
+        lambda /= lma_damping;
+        _lm.fit1_params = _lm.fit2_params;
         fitness = fit2;
     } else if (fit1 < _fitness) {
         fitness = fit1;
     }
-    //--------------------Levenberg-part-ends-here--------------------------------//
+    //--------------------Levenberg-Marquardt-part-ends-here--------------------------------//
 
     // store new parameters and update fitness
-    if (fitness < _fitness) {
+    if (!isnan(fitness) && fitness < _fitness) {
         _fitness = fitness;
-        _params = fit1_params;
+        _params = _lm.fit1_params;
         update_completion_mask();
     }
+    return true;
 }
 
 
@@ -1063,8 +1030,8 @@ bool CompassCalibrator::calculate_orientation(void)
     // re-run the fit to get the diagonals and off-diagonals for the
     // new orientation
     initialize_fit();
-    run_sphere_fit();
-    run_ellipsoid_fit();
+    while (!run_lm_fit(false, COMPASS_CAL_NUM_SAMPLES)) {}
+    while (!run_lm_fit(true, COMPASS_CAL_NUM_SAMPLES)) {}
 
     return fit_acceptable();
 }
@@ -9,8 +9,10 @@
 #define COMPASS_CAL_NUM_SPHERE_PARAMS       4
 #define COMPASS_CAL_NUM_ELLIPSOID_PARAMS    9
 #define COMPASS_CAL_NUM_SAMPLES             300     // number of samples required before fitting begins
+#define COMPASS_CAL_SAMPLES_PER_UPDATE      100     // samples processed per update() call while fitting
 
 class CompassCalibrator {
+    friend class CompassCalibrator_Test;
 public:
     CompassCalibrator();
 
@@ -182,12 +184,20 @@ private:
     void calc_initial_offset();
 
     // run sphere fit to calculate diagonals and offdiagonals
-    void calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
-    void run_sphere_fit();
+    // the jacobian functions return the residual of the sample
+    float calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
+    bool run_sphere_fit();
 
     // run ellipsoid fit to calculate diagonals and offdiagonals
-    void calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
-    void run_ellipsoid_fit();
+    float calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
+    bool run_ellipsoid_fit();
+
+    // advance the current Levenberg-Marquardt iteration by up to
+    // max_samples samples, returns true when the iteration is complete
+    bool run_lm_fit(bool ellipsoid, uint16_t max_samples);
+
+    // true if no Levenberg-Marquardt iteration is part way through
+    bool lm_idle() const { return !_lm.fitness_pass && _lm.next_sample == 0; }
 
     // update the completion mask based on a single sample
     void update_completion_mask(const Vector3f& sample);
@@ -235,6 +245,22 @@ private:
     float _sphere_lambda;                   // sphere fit's lambda
     float _ellipsoid_lambda;                // ellipsoid fit's lambda
 
+    // Levenberg-Marquardt iteration in progress. An iteration makes two
+    // passes over the samples, the first accumulating the normal
+    // equations and the second evaluating the fitness of the two
+    // candidate solutions. Passes are split over update() calls so
+    // that calibrating several compasses at once shares the thread
+    struct {
+        bool fitness_pass;                  // true for the second pass
+        uint16_t next_sample;               // next sample for the current pass
+        float JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+        float JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+        param_t fit1_params;                // candidate with full damping
+        param_t fit2_params;                // candidate with reduced damping
+        float fit1_sum;                     // sums of squared residuals of the candidates
+        float fit2_sum;
+    } _lm;
+
     // variables for orientation checking
     enum Rotation _orientation;             // latest detected orientation
     enum Rotation _orig_orientation;        // original orientation provided by caller
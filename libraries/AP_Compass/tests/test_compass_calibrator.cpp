@@ -0,0 +1,233 @@
+#include <AP_gtest.h>
+
+/*
+  tests for the compass calibration fits. The Levenberg-Marquardt
+  iterations are split across update() calls and accumulate the normal
+  equations differently from the original fits, which are kept here
+  as the reference. Both are run on the same fixed sample sets and
+  must agree exactly after every fit step
+ */
+
+#include <AP_Compass/CompassCalibrator.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if COMPASS_CAL_ENABLED
+
+#include <vector>
+
+class CompassCalibrator_Test
+{
+public:
+    CompassCalibrator_Test() :
+        cal(NEW_NOTHROW CompassCalibrator()),
+        ref(NEW_NOTHROW CompassCalibrator())
+    {}
+
+    ~CompassCalibrator_Test() {
+        for (CompassCalibrator *c : { cal, ref }) {
+            c->set_status(CompassCalibrator::Status::NOT_STARTED);
+            delete c;
+        }
+    }
+
+    // fill both calibrators with the samples and start fitting as
+    // update() does at the start of step one
+    void load(const std::vector<Vector3f> &samples) {
+        ASSERT_EQ(samples.size(), COMPASS_CAL_NUM_SAMPLES);
+        for (CompassCalibrator *c : { cal, ref }) {
+            c->_sample_buffer = (CompassCalibrator::CompassSample *)calloc(COMPASS_CAL_NUM_SAMPLES, sizeof(CompassCalibrator::CompassSample));
+            ASSERT_NE(c->_sample_buffer, nullptr);
+            for (uint16_t i=0; i<samples.size(); i++) {
+                c->_sample_buffer[i].set(samples[i]);
+            }
+            c->_samples_collected = samples.size();
+            c->initialize_fit();
+            c->calc_initial_offset();
+        }
+    }
+
+    // run one fit step on both calibrators and check they agree,
+    // returns the number of calls the time-sliced fit needed
+    uint32_t step(bool ellipsoid) {
+        reference_fit(*ref, ellipsoid);
+        uint32_t calls = 1;
+        while (!(ellipsoid ? cal->run_ellipsoid_fit() : cal->run_sphere_fit())) {
+            calls++;
+        }
+        EXPECT_TRUE(cal->lm_idle());
+        EXPECT_EQ(ref->_fitness, cal->_fitness);
+        EXPECT_EQ(ref->_sphere_lambda, cal->_sphere_lambda);
+        EXPECT_EQ(ref->_ellipsoid_lambda, cal->_ellipsoid_lambda);
+        EXPECT_EQ(ref->_params.radius, cal->_params.radius);
+        expect_identical(ref->_params.offset, cal->_params.offset);
+        expect_identical(ref->_params.diag, cal->_params.diag);
+        expect_identical(ref->_params.offdiag, cal->_params.offdiag);
+        return calls;
+    }
+
+    // Vector3f's == allows for rounding, the fits must match exactly
+    static void expect_identical(const Vector3f &a, const Vector3f &b) {
+        EXPECT_EQ(a.x, b.x);
+        EXPECT_EQ(a.y, b.y);
+        EXPECT_EQ(a.z, b.z);
+    }
+
+    // the sphere and ellipsoid fits as they were before being split
+    // across update() calls
+    static void reference_fit(CompassCalibrator &c, bool ellipsoid) {
+        const float lma_damping = 10.0f;
+        const uint8_t n = ellipsoid ? COMPASS_CAL_NUM_ELLIPSOID_PARAMS : COMPASS_CAL_NUM_SPHERE_PARAMS;
+        float &lambda = ellipsoid ? c._ellipsoid_lambda : c._sphere_lambda;
+
+        float fitness = c._fitness;
+        float fit1, fit2;
+        CompassCalibrator::param_t fit1_params, fit2_params;
+        fit1_params = fit2_params = c._params;
+
+        float JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
+        float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
+        float JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS] = { };
+
+        for (uint16_t k = 0; k<c._samples_collected; k++) {
+            Vector3f sample = c._sample_buffer[k].get();
+            float jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+            if (ellipsoid) {
+                c.calc_ellipsoid_jacob(sample, fit1_params, jacob);
+            } else {
+                c.calc_sphere_jacob(sample, fit1_params, jacob);
+            }
+            for (uint8_t i = 0; i < n; i++) {
+                for (uint8_t j = 0; j < n; j++) {
+                    JTJ[i*n+j] += jacob[i] * jacob[j];
+                    JTJ2[i*n+j] += jacob[i] * jacob[j];
+                }
+                JTFI[i] += jacob[i] * c.calc_residual(sample, fit1_params);
+            }
+        }
+
+        for (uint8_t i = 0; i < n; i++) {
+            JTJ[i*n+i] += lambda;
+            JTJ2[i*n+i] += lambda/lma_damping;
+        }
+        if (!mat_inverse(JTJ, JTJ, n) || !mat_inverse(JTJ2, JTJ2, n)) {
+            return;
+        }
+
+        float *p1 = ellipsoid ? fit1_params.get_ellipsoid_params() : fit1_params.get_sphere_params();
+        float *p2 = ellipsoid ? fit2_params.get_ellipsoid_params() : fit2_params.get_sphere_params();
+        for (uint8_t row=0; row < n; row++) {
+            for (uint8_t col=0; col < n; col++) {
+                p1[row] -= JTFI[col] * JTJ[row*n+col];
+                p2[row] -= JTFI[col] * JTJ2[row*n+col];
+            }
+        }
+
+        fit1 = c.calc_mean_squared_residuals(fit1_params);
+        fit2 = c.calc_mean_squared_residuals(fit2_params);
+
+        if (fit1 > c._fitness && fit2 > c._fitness) {
+            lambda *= lma_damping;
+        } else if (fit2 < c._fitness && fit2 < fit1) {
+            lambda /= lma_damping;
+            fit1_params = fit2_params;
+            fitness = fit2;
+        } else if (fit1 < c._fitness) {
+            fitness = fit1;
+        }
+
+        if (!isnan(fitness) && fitness < c._fitness) {
+            c._fitness = fitness;
+            c._params = fit1_params;
+            c.update_completion_mask();
+        }
+    }
+
+    // results of the time-sliced fit
+    float radius() const { return cal->_params.radius; }
+    const Vector3f &offset() const { return cal->_params.offset; }
+    float fitness() const { return cal->_fitness; }
+
+private:
+    CompassCalibrator *cal;
+    CompassCalibrator *ref;
+};
+
+/*
+  samples of a field of the given strength measured through a
+  soft-iron matrix and offset. Directions cover the sphere evenly, or
+  only the upper half of it to give a poorly conditioned fit. Noise
+  comes from a fixed LCG so the sets are the same on every platform
+ */
+static std::vector<Vector3f> make_samples(float radius, const Matrix3f &softiron, const Vector3f &offset, float noise, bool half)
+{
+    Matrix3f inv;
+    EXPECT_TRUE(softiron.inverse(inv));
+    uint32_t seed = 12345;
+    auto rand_pm1 = [&seed]() {
+        seed = seed * 1103515245U + 12345U;
+        return ((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+    };
+    std::vector<Vector3f> samples;
+    const float golden_angle = M_PI * (3 - sqrtf(5));
+    for (uint16_t i=0; i<COMPASS_CAL_NUM_SAMPLES; i++) {
+        const float z = half ? 1 - (i + 0.5f) / COMPASS_CAL_NUM_SAMPLES : 1 - 2 * (i + 0.5f) / COMPASS_CAL_NUM_SAMPLES;
+        const float r = sqrtf(1 - z*z);
+        const Vector3f dir { r * cosf(golden_angle * i), r * sinf(golden_angle * i), z };
+        const Vector3f n { rand_pm1(), rand_pm1(), rand_pm1() };
+        samples.push_back(inv * (dir * radius) - offset + n * noise);
+    }
+    return samples;
+}
+
+// number of calls a fit step takes when split across update() calls
+static const uint32_t calls_per_step = 2 * ((COMPASS_CAL_NUM_SAMPLES + COMPASS_CAL_SAMPLES_PER_UPDATE - 1) / COMPASS_CAL_SAMPLES_PER_UPDATE);
+
+// run the fit steps of a calibration, 10 sphere fits in step one
+// then 15 sphere and 20 ellipsoid fits in step two
+static void run_fits(CompassCalibrator_Test &t)
+{
+    for (uint8_t i=0; i<35; i++) {
+        EXPECT_EQ(t.step(i >= 25), calls_per_step);
+    }
+}
+
+TEST(CompassCalibrator, sphere)
+{
+    CompassCalibrator_Test t;
+    t.load(make_samples(450, Matrix3f(1,0,0, 0,1,0, 0,0,1), Vector3f(120, -80, 35), 0, false));
+    run_fits(t);
+    EXPECT_NEAR(t.radius(), 450, 1);
+    EXPECT_NEAR(t.offset().x, 120, 1);
+    EXPECT_NEAR(t.offset().y, -80, 1);
+    EXPECT_NEAR(t.offset().z, 35, 1);
+}
+
+TEST(CompassCalibrator, ellipsoid)
+{
+    CompassCalibrator_Test t;
+    const Matrix3f softiron { 1.1, 0.05, -0.03,
+                              0.05, 0.9, 0.02,
+                              -0.03, 0.02, 1.05 };
+    t.load(make_samples(400, softiron, Vector3f(-200, 150, 60), 4, false));
+    run_fits(t);
+    EXPECT_LT(t.fitness(), sq(5));
+    EXPECT_NEAR(t.offset().x, -200, 5);
+    EXPECT_NEAR(t.offset().y, 150, 5);
+    EXPECT_NEAR(t.offset().z, 60, 5);
+}
+
+TEST(CompassCalibrator, half_sphere)
+{
+    // poorly conditioned, exercises the damping as well as the solution
+    CompassCalibrator_Test t;
+    const Matrix3f softiron { 0.8, 0.1, 0,
+                              0.1, 1.2, -0.1,
+                              0, -0.1, 1 };
+    t.load(make_samples(300, softiron, Vector3f(50, 50, -300), 8, true));
+    run_fits(t);
+}
+
+#endif  // COMPASS_CAL_ENABLED
+
+AP_GTEST_MAIN()
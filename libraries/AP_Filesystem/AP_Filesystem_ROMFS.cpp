@@ -25,6 +25,7 @@
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_ROMFS/AP_ROMFS.h>
+#include <AP_ROMFS/AP_ROMFS_Stream.h>
 
 int AP_Filesystem_ROMFS::open(const char *fname, int flags, bool allow_absolute_paths)
 {
@@ -36,7 +37,7 @@ int AP_Filesystem_ROMFS::open(const char *fname, int flags, bool allow_absolute_
     WITH_SEMAPHORE(record_sem); // search for free file record
     uint8_t idx;
     for (idx=0; idx<max_open_file; idx++) {
-        if (file[idx].data == nullptr) {
+        if (file[idx] == nullptr) {
             break;
         }
     }
@@ -44,41 +45,39 @@ int AP_Filesystem_ROMFS::open(const char *fname, int flags, bool allow_absolute_
         errno = ENFILE;
         return -1;
     }
-    file[idx].data = AP_ROMFS::find_decompress(fname, file[idx].size);
-    if (file[idx].data == nullptr) {
+    // cache the files, as web pages and fonts may be read many times
+    file[idx] = AP_ROMFS::open_stream(fname, true);
+    if (file[idx] == nullptr) {
         errno = ENOENT;
         return -1;
     }
-    file[idx].ofs = 0;
     return idx;
 }
 
 int AP_Filesystem_ROMFS::close(int fd)
 {
-    if (fd < 0 || fd >= max_open_file || file[fd].data == nullptr) {
+    if (fd < 0 || fd >= max_open_file || file[fd] == nullptr) {
         errno = EBADF;
         return -1;
     }
 
     WITH_SEMAPHORE(record_sem); // release file record
-    AP_ROMFS::free(file[fd].data);
-    file[fd].data = nullptr;
+    delete file[fd];
+    file[fd] = nullptr;
     return 0;
 }
 
 int32_t AP_Filesystem_ROMFS::read(int fd, void *buf, uint32_t count)
 {
-    if (fd < 0 || fd >= max_open_file || file[fd].data == nullptr) {
+    if (fd < 0 || fd >= max_open_file || file[fd] == nullptr) {
         errno = EBADF;
         return -1;
     }
-    count = MIN(file[fd].size - file[fd].ofs, count);
-    if (count == 0) {
-        return 0;
+    const int32_t ret = file[fd]->read(buf, count);
+    if (ret < 0) {
+        errno = EIO;
     }
-    memcpy(buf, &file[fd].data[file[fd].ofs], count);
-    file[fd].ofs += count;
-    return count;
+    return ret;
 }
 
 int32_t AP_Filesystem_ROMFS::write(int fd, const void *buf, uint32_t count)
@@ -94,26 +93,27 @@ int AP_Filesystem_ROMFS::fsync(int fd)
 
 int32_t AP_Filesystem_ROMFS::lseek(int fd, int32_t offset, int seek_from)
 {
-    if (fd < 0 || fd >= max_open_file || file[fd].data == nullptr) {
+    if (fd < 0 || fd >= max_open_file || file[fd] == nullptr) {
         errno = EBADF;
         return -1;
     }
+    AP_ROMFS_Stream &stream = *file[fd];
     switch (seek_from) {
     case SEEK_SET:
         if (offset < 0) {
             errno = EINVAL;
             return -1;
         }
-        file[fd].ofs = MIN(file[fd].size, (uint32_t)offset);
+        stream.seek(offset);
         break;
     case SEEK_CUR:
-        file[fd].ofs = MIN(file[fd].size, offset+file[fd].ofs);
+        stream.seek(offset+stream.tell());
         break;
     case SEEK_END:
-        file[fd].ofs = file[fd].size;
+        stream.seek(stream.size());
         break;
     }
-    return file[fd].ofs;
+    return stream.tell();
 }
 
 int AP_Filesystem_ROMFS::stat(const char *name, struct stat *stbuf)
@@ -23,6 +23,8 @@
 
 #include "AP_Filesystem_backend.h"
 
+class AP_ROMFS_Stream;
+
 class AP_Filesystem_ROMFS : public AP_Filesystem_Backend
 {
 public:
@@ -61,14 +63,11 @@ private:
     // protect searching for free file/dir records when opening/closing
     HAL_Semaphore record_sem;
 
-    // only allow up to 4 files at a time
+    // only allow up to 4 files at a time. Files are decompressed as
+    // they are read, so they don't need a buffer the size of the file
     static constexpr uint8_t max_open_file = 4;
     static constexpr uint8_t max_open_dir = 4;
-    struct rfile {
-        const uint8_t *data;
-        uint32_t size;
-        uint32_t ofs;
-    } file[max_open_file];
+    AP_ROMFS_Stream *file[max_open_file];
 
     // allow up to 4 directory opens
     struct rdir {
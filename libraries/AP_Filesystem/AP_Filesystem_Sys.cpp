@@ -26,6 +26,8 @@
 #include <AP_CANManager/AP_CANManager.h>
 #include <AP_Scheduler/AP_Scheduler.h>
 #include <AP_Common/ExpandingString.h>
+#include <AP_Scripting/AP_Scripting.h>
+#include <AP_GPS/AP_GPS.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -52,9 +54,16 @@ static const SysFileList sysfs_file_list[] = {
 #endif
     {"crash_dump.bin"},
     {"storage.bin"},
+    {"storage.txt"},
 #if AP_FILESYSTEM_SYS_FLASH_ENABLED
     {"flash.bin"},
 #endif
+#if AP_SCRIPTING_PROFILE_ENABLED
+    {"scripting_profile.txt"},
+#endif
+#if AP_GPS_ENABLED && AP_GPS_RTCM_DECODE_ENABLED
+    {"rtcm.txt"},
+#endif
 };
 
 int8_t AP_Filesystem_Sys::file_in_sysfs(const char *fname) {
@@ -155,6 +164,9 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
             r.str->set_buffer((char*)ptr, size, size);
         }
     }
+    if (strcmp(fname, "storage.txt") == 0) {
+        hal.storage->storage_info(*r.str);
+    }
 #if AP_FILESYSTEM_SYS_FLASH_ENABLED
     if (strcmp(fname, "flash.bin") == 0) {
         void *ptr = (void*)0x08000000;
@@ -162,6 +174,19 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
         r.str->set_buffer((char*)ptr, size, size);
     }
 #endif
+#if AP_SCRIPTING_PROFILE_ENABLED
+    if (strcmp(fname, "scripting_profile.txt") == 0) {
+        AP_Scripting *scripting = AP::scripting();
+        if (scripting != nullptr) {
+            scripting->profile_info(*r.str);
+        }
+    }
+#endif
+#if AP_GPS_ENABLED && AP_GPS_RTCM_DECODE_ENABLED
+    if (strcmp(fname, "rtcm.txt") == 0) {
+        AP::gps().rtcm_info(*r.str);
+    }
+#endif
     
     if (r.str->get_length() == 0) {
         errno = r.str->has_failed_allocation()?ENOMEM:ENOENT;
@@ -42,6 +42,7 @@
 #include "AP_GPS_MSP.h"
 #include "AP_GPS_ExternalAHRS.h"
 #include "GPS_Backend.h"
+#include "RTCM3_Pipeline.h"
 #if AP_SIM_GPS_ENABLED
 #include "AP_GPS_SITL.h"
 #endif
@@ -1076,6 +1077,10 @@ void AP_GPS::update(void)
 #endif  // HAL_LOGING_ENABLED
 #endif  // GPS_MAX_RECEIVERS > 1
 
+#if AP_GPS_RTCM_DECODE_ENABLED
+    inject_rtcm_queue();
+#endif
+
 #ifndef HAL_BUILD_AP_PERIPH
     // update notify with gps status. We always base this on the primary_instance
     AP_Notify::flags.gps_status = state[primary_instance].status;
@@ -1619,70 +1624,71 @@ void AP_GPS::handle_gps_rtcm_data(mavlink_channel_t chan, const mavlink_message_
 #if AP_GPS_RTCM_DECODE_ENABLED
 /*
   fully parse RTCM data coming in from a MAVLink channel, when we have
-  a full message inject it to the GPS. This approach allows for 2 or
+  a full message queue it for the GPS. This approach allows for 2 or
   more MAVLink channels to be used for the same RTCM data, allowing
   for redundent transports for maximum reliability at the cost of some
-  extra CPU and a bit of re-assembly lag
+  extra CPU and a bit of re-assembly lag. The parsing is done on the
+  IO thread, see RTCM3_Pipeline
  */
 bool AP_GPS::parse_rtcm_injection(mavlink_channel_t chan, const mavlink_gps_rtcm_data_t &pkt)
 {
-    if (static_cast<int>(chan) >= MAVLINK_COMM_NUM_BUFFERS) {
-        return false;
-    }
-    if (rtcm.parsers[chan] == nullptr) {
-        rtcm.parsers[chan] = NEW_NOTHROW RTCM3_Parser();
-        if (rtcm.parsers[chan] == nullptr) {
+    if (rtcm.pipeline == nullptr) {
+        RTCM3_Pipeline *pipeline = NEW_NOTHROW RTCM3_Pipeline();
+        if (pipeline == nullptr) {
             return false;
         }
-        GCS_SEND_TEXT(MAV_SEVERITY_INFO, "GPS: RTCM parsing for chan %u", unsigned(chan));
+        if (!pipeline->init()) {
+            delete pipeline;
+            return false;
+        }
+        rtcm.pipeline = pipeline;
     }
-    for (uint16_t i=0; i<pkt.len; i++) {
-        if (rtcm.parsers[chan]->read(pkt.data[i])) {
-            // we have a full message, inject it
-            const uint8_t *buf = nullptr;
-            uint16_t len = rtcm.parsers[chan]->get_len(buf);
-
-            // see if we have already sent it. This prevents
-            // duplicates from multiple sources
-            const uint32_t crc = crc_crc32(0, buf, len);
+    return rtcm.pipeline->handle_data(chan, pkt.data, pkt.len);
+}
 
-#if HAL_LOGGING_ENABLED
-// @LoggerMessage: RTCM
-// @Description: GPS atmospheric perturbation data
-// @Field: TimeUS: Time since system startup
-// @Field: Chan: mavlink channel number this data was received on
-// @Field: RTCMId: ID field from RTCM packet
-// @Field: Len: RTCM packet length
-// @Field: CRC: calculated crc32 for the packet
-            AP::logger().WriteStreaming("RTCM", "TimeUS,Chan,RTCMId,Len,CRC", "s#---", "F----", "QBHHI",
-                                        AP_HAL::micros64(),
-                                        uint8_t(chan),
-                                        rtcm.parsers[chan]->get_id(),
-                                        len,
-                                        crc);
-#endif
-            
-            bool already_seen = false;
-            for (uint8_t c=0; c<ARRAY_SIZE(rtcm.sent_crc); c++) {
-                if (rtcm.sent_crc[c] == crc) {
-                    // we have already sent this message
-                    already_seen = true;
-                    break;
-                }
-            }
-            if (already_seen) {
-                continue;
-            }
-            rtcm.sent_crc[rtcm.sent_idx] = crc;
-            rtcm.sent_idx = (rtcm.sent_idx+1) % ARRAY_SIZE(rtcm.sent_crc);
+/*
+  send queued RTCM messages to the GPS, as much as fits in its UART
+ */
+void AP_GPS::inject_rtcm_queue(void)
+{
+    if (rtcm.pipeline == nullptr) {
+        return;
+    }
+    uint32_t space = inject_space();
+    const uint8_t *bytes;
+    uint16_t len;
+    while ((len = rtcm.pipeline->pop(space, bytes)) > 0) {
+        inject_data(bytes, len);
+        space -= len;
+    }
+}
 
-            if (buf != nullptr && len > 0) {
-                inject_data(buf, len);
-            }
-            rtcm.parsers[chan]->reset();
+/*
+  number of bytes inject_data() can currently send to every GPS it
+  would send to
+ */
+uint32_t AP_GPS::inject_space(void)
+{
+    uint32_t space = UINT32_MAX;
+    for (uint8_t i=0; i<GPS_MAX_RECEIVERS; i++) {
+        if (_inject_to != GPS_RTK_INJECT_TO_ALL && _inject_to != i) {
+            continue;
+        }
+        if (_inject_to == GPS_RTK_INJECT_TO_ALL && is_rtk_rover(i)) {
+            continue;
+        }
+        if (drivers[i] != nullptr) {
+            space = MIN(space, drivers[i]->inject_space());
         }
     }
-    return true;
+    return space;
+}
+
+void AP_GPS::rtcm_info(ExpandingString &str)
+{
+    if (rtcm.pipeline != nullptr) {
+        rtcm.pipeline->info(str);
+    }
 }
 #endif // AP_GPS_RTCM_DECODE_ENABLED
 
@@ -46,7 +46,8 @@
 #endif // GPS_MOVING_BASELINE
 
 class AP_GPS_Backend;
-class RTCM3_Parser;
+class RTCM3_Pipeline;
+class ExpandingString;
 
 /// @class AP_GPS
 /// GPS driver main class
@@ -600,6 +601,11 @@ public:
     // Inject a packet of raw binary to a GPS
     void inject_data(const uint8_t *data, uint16_t len);
 
+#if AP_GPS_RTCM_DECODE_ENABLED
+    // per message type statistics for RTCM decoded from mavlink
+    void rtcm_info(ExpandingString &str);
+#endif
+
 protected:
 
     // configuration parameters
@@ -793,16 +799,16 @@ private:
 
 #if AP_GPS_RTCM_DECODE_ENABLED
     /*
-      per mavlink channel RTCM decoder, enabled with RTCM decode
-       option in GPS_DRV_OPTIONS
+      per mavlink channel RTCM decoding, de-duplication and pacing,
+      enabled with RTCM decode option in GPS_DRV_OPTIONS
     */
     struct {
-        RTCM3_Parser *parsers[MAVLINK_COMM_NUM_BUFFERS];
-        uint32_t sent_crc[32];
-        uint8_t sent_idx;
+        RTCM3_Pipeline *pipeline;
         uint16_t seen_mav_channels;
     } rtcm;
     bool parse_rtcm_injection(mavlink_channel_t chan, const mavlink_gps_rtcm_data_t &pkt);
+    void inject_rtcm_queue(void);
+    uint32_t inject_space(void);
 #endif
 
     void convert_parameters();
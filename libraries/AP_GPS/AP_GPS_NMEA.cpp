@@ -30,6 +30,7 @@
 
 #include <AP_Common/AP_Common.h>
 #include <AP_Common/NMEA.h>
+#include <AP_HAL/utility/UARTSpanReader.h>
 #include <GCS_MAVLink/GCS.h>
 #include <AP_Logger/AP_Logger.h>
 
@@ -58,21 +59,20 @@ extern const AP_HAL::HAL& hal;
 
 bool AP_GPS_NMEA::read(void)
 {
-    int16_t numc;
     bool parsed = false;
 
     send_config();
 
-    numc = port->available();
-    while (numc--) {
-        char c = port->read();
+    UARTSpanReader::read_all(*port, port->available(), [&](const uint8_t *span, uint16_t len) {
 #if AP_GPS_DEBUG_LOGGING_ENABLED
-        log_data((const uint8_t *)&c, 1);
+        log_data(span, len);
 #endif
-        if (_decode(c)) {
-            parsed = true;
+        for (uint16_t i = 0; i < len; i++) {
+            if (_decode(char(span[i]))) {
+                parsed = true;
+            }
         }
-    }
+    });
     return parsed;
 }
 
@@ -22,6 +22,7 @@
 #include "AP_GPS_SBF.h"
 #include <GCS_MAVLink/GCS.h>
 #include <AP_InternalError/AP_InternalError.h>
+#include <AP_HAL/utility/UARTSpanReader.h>
 #include <stdio.h>
 #include <ctype.h>
 
@@ -88,14 +89,14 @@ bool
 AP_GPS_SBF::read(void)
 {
     bool ret = false;
-    uint32_t available_bytes = port->available();
-    for (uint32_t i = 0; i < available_bytes; i++) {
-        uint8_t temp = port->read();
+    UARTSpanReader::read_all(*port, port->available(), [&](const uint8_t *span, uint16_t len) {
 #if AP_GPS_DEBUG_LOGGING_ENABLED
-        log_data(&temp, 1);
+        log_data(span, len);
 #endif
-        ret |= parse(temp);
-    }
+        for (uint16_t i = 0; i < len; i++) {
+            ret |= parse(span[i]);
+        }
+    });
 
     const uint32_t now = AP_HAL::millis();
     if (gps._auto_config != AP_GPS::GPS_AUTO_CONFIG_DISABLE) {
@@ -684,17 +684,22 @@ AP_GPS_UBLOX::read(void)
         }
     }
 
-    const uint16_t numc = MIN(port->available(), 8192U);
-    for (uint16_t i = 0; i < numc; i++) {        // Process bytes received
+    span_reader.read(*port, 8192U, [&](const uint8_t *span, uint16_t &len) {
+        return parse_span(span, len, parsed);
+    });
+    return parsed;
+}
 
-        // read the next byte
-        uint8_t data;
-        if (!port->read(data)) {
-            break;
-        }
-#if AP_GPS_DEBUG_LOGGING_ENABLED
-        log_data(&data, 1);
-#endif
+/*
+  run the parser over a span of received bytes. len is set to the
+  number of bytes consumed, returns false if parsing should stop
+ */
+bool AP_GPS_UBLOX::parse_span(const uint8_t *span, uint16_t &len, bool &parsed)
+{
+    bool more = true;
+    uint16_t i;
+    for (i = 0; i < len; i++) {
+        const uint8_t data = span[i];
 
 #if GPS_MOVING_BASELINE
         if (rtcm3_parser) {
@@ -705,6 +710,8 @@ AP_GPS_UBLOX::read(void)
                 // chance to send the RTCMv3 packet to another (rover)
                 // GPS
                 _step = 0;
+                i++;
+                more = false;
                 break;
             }
         }
@@ -818,7 +825,11 @@ AP_GPS_UBLOX::read(void)
             break;
         }
     }
-    return parsed;
+    len = i;
+#if AP_GPS_DEBUG_LOGGING_ENABLED
+    log_data(span, len);
+#endif
+    return more;
 }
 
 // Private Methods /////////////////////////////////////////////////////////////
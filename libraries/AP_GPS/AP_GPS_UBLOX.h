@@ -28,6 +28,7 @@
 #include "GPS_Backend.h"
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/UARTSpanReader.h>
 
 /*
  *  try to put a UBlox into binary mode. This is in two parts. 
@@ -772,6 +773,10 @@ private:
     uint16_t        _payload_length;
     uint16_t        _payload_counter;
 
+    // bulk reads from the port, holds bytes left unparsed when
+    // parsing stops early for an RTCMv3 packet
+    UARTSpanReader  span_reader;
+
     uint8_t         _class;
     bool            _cfg_saved;
 
@@ -806,6 +811,7 @@ private:
 
     // Buffer parse & GPS state update
     bool        _parse_gps();
+    bool        parse_span(const uint8_t *span, uint16_t &len, bool &parsed);
 
     // used to update fix between status and position packets
     AP_GPS::GPS_Status next_fix { AP_GPS::NO_FIX };
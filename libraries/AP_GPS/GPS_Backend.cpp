@@ -130,6 +130,18 @@ AP_GPS_Backend::inject_data(const uint8_t *data, uint16_t len)
     }
 }
 
+uint32_t
+AP_GPS_Backend::inject_space(void)
+{
+    if (port == nullptr) {
+        // inject_data() is either overridden or discards the data
+        return UINT32_MAX;
+    }
+    // inject_data() needs more space than the data length
+    const uint32_t space = port->txspace();
+    return space > 0 ? space - 1 : 0;
+}
+
 void AP_GPS_Backend::_detection_message(char *buffer, const uint8_t buflen) const
 {
     const uint8_t instance = state.instance;
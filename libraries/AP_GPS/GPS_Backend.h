@@ -67,6 +67,8 @@ public:
     virtual bool is_configured(void) const { return true; }
 
     virtual void inject_data(const uint8_t *data, uint16_t len);
+    // number of bytes inject_data() can currently accept
+    virtual uint32_t inject_space(void);
 
 #if HAL_GCS_ENABLED
     //MAVLink methods
@@ -64,6 +64,16 @@ uint16_t RTCM3_Parser::get_id(void) const
     return (pkt[3]<<8 | pkt[4]) >> 4;
 }
 
+// return CRC of found packet
+uint32_t RTCM3_Parser::get_crc(void) const
+{
+    if (found_len == 0) {
+        return 0;
+    }
+    const uint8_t *parity = &pkt[found_len-3];
+    return (parity[0] << 16) | (parity[1] << 8) | parity[2];
+}
+
 // look for preamble to try to resync
 void RTCM3_Parser::resync(void)
 {
@@ -39,6 +39,9 @@ public:
 
     // return ID of found packet
     uint16_t get_id(void) const;
+
+    // return the 24 bit CRC of found packet
+    uint32_t get_crc(void) const;
     
 private:
     const uint8_t RTCMv3_PREAMBLE = 0xD3;
@@ -0,0 +1,263 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RTCM3_Pipeline.h"
+
+#if AP_GPS_RTCM_DECODE_ENABLED
+
+#include <AP_Logger/AP_Logger.h>
+#include <AP_Math/AP_Math.h>
+#include <GCS_MAVLink/GCS.h>
+
+extern const AP_HAL::HAL& hal;
+
+bool RTCM3_Pipeline::init(void)
+{
+    if (high_queue.get_size() == 0 || low_queue.get_size() == 0) {
+        return false;
+    }
+    start_ms = AP_HAL::millis();
+    hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&RTCM3_Pipeline::update, void));
+    return true;
+}
+
+bool RTCM3_Pipeline::handle_data(uint8_t chan, const uint8_t *data, uint8_t len)
+{
+    if (chan >= ARRAY_SIZE(chans)) {
+        return false;
+    }
+    ByteBuffer *in = chans[chan].in;
+    if (in == nullptr) {
+        in = NEW_NOTHROW ByteBuffer(input_buffer_size);
+        if (in == nullptr || in->get_size() == 0) {
+            delete in;
+            return false;
+        }
+        WITH_SEMAPHORE(sem);
+        chans[chan].in = in;
+        GCS_SEND_TEXT(MAV_SEVERITY_INFO, "GPS: RTCM parsing for chan %u", unsigned(chan));
+    }
+    if (in->space() < len) {
+        // the IO thread has fallen behind, the parser will resync
+        chans[chan].overflow_bytes += len;
+        return true;
+    }
+    in->write(data, len);
+    return true;
+}
+
+/*
+  run each channel's data through its parser, called on the IO thread
+ */
+void RTCM3_Pipeline::update(void)
+{
+    for (uint8_t c=0; c<ARRAY_SIZE(chans); c++) {
+        ByteBuffer *in;
+        {
+            WITH_SEMAPHORE(sem);
+            in = chans[c].in;
+        }
+        if (in == nullptr) {
+            continue;
+        }
+        RTCM3_Parser *&parser = chans[c].parser;
+        if (parser == nullptr) {
+            parser = NEW_NOTHROW RTCM3_Parser();
+            if (parser == nullptr) {
+                continue;
+            }
+        }
+        uint32_t n;
+        const uint8_t *p;
+        while ((p = in->readptr(n)) != nullptr && n > 0) {
+            for (uint32_t i=0; i<n; i++) {
+                if (!parser->read(p[i])) {
+                    continue;
+                }
+                const uint8_t *buf = nullptr;
+                const uint16_t len = parser->get_len(buf);
+                if (buf != nullptr && len > 0) {
+                    handle_message(c, buf, len, parser->get_id(), parser->get_crc());
+                }
+                parser->reset();
+            }
+            in->advance(n);
+        }
+    }
+}
+
+void RTCM3_Pipeline::handle_message(uint8_t chan, const uint8_t *buf, uint16_t len, uint16_t id, uint32_t crc)
+{
+#if HAL_LOGGING_ENABLED
+// @LoggerMessage: RTCM
+// @Description: GPS atmospheric perturbation data
+// @Field: TimeUS: Time since system startup
+// @Field: Chan: mavlink channel number this data was received on
+// @Field: RTCMId: ID field from RTCM packet
+// @Field: Len: RTCM packet length
+// @Field: CRC: CRC24 from the RTCM packet
+    AP::logger().WriteStreaming("RTCM", "TimeUS,Chan,RTCMId,Len,CRC", "s#---", "F----", "QBHHI",
+                                AP_HAL::micros64(),
+                                chan,
+                                id,
+                                len,
+                                crc);
+#endif
+
+    WITH_SEMAPHORE(sem);
+    type_stats *s = find_stats(id);
+    if (is_duplicate(len, crc)) {
+        // already queued from another channel
+        s->duplicates++;
+        return;
+    }
+    s->received++;
+
+    if (is_high_priority(id)) {
+        // observations are only useful while fresh, so make way for
+        // new ones by discarding the oldest
+        push(high_queue, true, buf, len, id);
+    } else {
+        push(low_queue, false, buf, len, id);
+    }
+}
+
+bool RTCM3_Pipeline::is_duplicate(uint16_t len, uint32_t crc)
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(recent); i++) {
+        if (recent[i].crc == crc && recent[i].len == len) {
+            return true;
+        }
+    }
+    recent[recent_idx].crc = crc;
+    recent[recent_idx].len = len;
+    recent_idx = (recent_idx+1) % ARRAY_SIZE(recent);
+    return false;
+}
+
+/*
+  observations and station data needed for an RTK fix, as opposed to
+  ephemeris and other slowly changing data
+ */
+bool RTCM3_Pipeline::is_high_priority(uint16_t id)
+{
+    return (id >= 1001 && id <= 1012) ||  // legacy observations and station position
+           id == 1033 ||                  // receiver and antenna description
+           (id >= 1071 && id <= 1137) ||  // MSM observations
+           id == 1230;                    // GLONASS code-phase biases
+}
+
+// length and ID of the message at the head of a queue, zero length if empty
+uint16_t RTCM3_Pipeline::peek_message(ByteBuffer &queue, uint16_t &id)
+{
+    uint8_t hdr[5];
+    if (queue.peekbytes(hdr, sizeof(hdr)) != sizeof(hdr)) {
+        return 0;
+    }
+    id = (hdr[3]<<8 | hdr[4]) >> 4;
+    return ((hdr[1]<<8 | hdr[2]) & 0x3ff) + 6;
+}
+
+void RTCM3_Pipeline::push(ByteBuffer &queue, bool drop_oldest, const uint8_t *buf, uint16_t len, uint16_t id)
+{
+    while (drop_oldest && queue.space() < len) {
+        uint16_t old_id;
+        const uint16_t old_len = peek_message(queue, old_id);
+        if (old_len == 0) {
+            break;
+        }
+        queue.advance(old_len);
+        find_stats(old_id)->dropped++;
+    }
+    if (queue.space() < len) {
+        find_stats(id)->dropped++;
+        return;
+    }
+    queue.write(buf, len);
+}
+
+uint16_t RTCM3_Pipeline::pop(uint32_t max_len, const uint8_t *&bytes)
+{
+    WITH_SEMAPHORE(sem);
+    ByteBuffer *queues[] { &high_queue, &low_queue };
+    for (ByteBuffer *queue : queues) {
+        uint16_t id;
+        const uint16_t len = peek_message(*queue, id);
+        if (len == 0) {
+            continue;
+        }
+        if (len > max_len) {
+            // wait for space rather than let lower priority data
+            // take it
+            return 0;
+        }
+        queue->read(out_buf, len);
+        type_stats *s = find_stats(id);
+        s->sent++;
+        s->sent_bytes += len;
+        bytes = out_buf;
+        return len;
+    }
+    return 0;
+}
+
+// caller must hold sem
+RTCM3_Pipeline::type_stats *RTCM3_Pipeline::find_stats(uint16_t id)
+{
+    for (uint8_t i=0; i<num_types; i++) {
+        if (stats[i].id == id) {
+            return &stats[i];
+        }
+    }
+    if (num_types < max_types-1) {
+        stats[num_types].id = id;
+        return &stats[num_types++];
+    }
+    return &stats[max_types-1];
+}
+
+void RTCM3_Pipeline::info(ExpandingString &str)
+{
+    // a header to allow for machine parsers to determine format
+    str.printf("RTCMV1\n");
+
+    WITH_SEMAPHORE(sem);
+    const float dt = MAX(AP_HAL::millis() - start_ms, 1U) * 0.001f;
+    str.printf("%-6s %8s %6s %6s %8s %8s\n", "Type", "Recv", "Dup", "Drop", "Sent", "Bytes/s");
+    for (uint8_t i=0; i<max_types; i++) {
+        const type_stats &s = stats[i];
+        if (s.received + s.duplicates == 0) {
+            continue;
+        }
+        if (i == max_types-1) {
+            str.printf("%-6s", "other");
+        } else {
+            str.printf("%-6u", unsigned(s.id));
+        }
+        str.printf(" %8u %6u %6u %8u %8.0f\n",
+                   unsigned(s.received),
+                   unsigned(s.duplicates),
+                   unsigned(s.dropped),
+                   unsigned(s.sent),
+                   double(s.sent_bytes / dt));
+    }
+    for (uint8_t c=0; c<ARRAY_SIZE(chans); c++) {
+        if (chans[c].overflow_bytes != 0) {
+            str.printf("chan %u overflow %u bytes\n", unsigned(c), unsigned(chans[c].overflow_bytes));
+        }
+    }
+}
+
+#endif // AP_GPS_RTCM_DECODE_ENABLED
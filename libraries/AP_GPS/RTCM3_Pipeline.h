@@ -0,0 +1,110 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  RTCM3 correction pipeline for data arriving on more than one mavlink
+  channel, e.g. over redundant telemetry radios.
+
+  The mavlink handler only copies GPS_RTCM_DATA payloads into a per
+  channel buffer. On the IO thread each channel is run through its own
+  RTCM3_Parser, and complete messages already seen on another channel
+  are dropped by their CRC. The rest are queued by priority:
+  observations and station data ahead of ephemeris, which changes
+  slowly and is repeated by the base. AP_GPS takes messages from the
+  queue only when the receiver UART has room for them, so a burst of
+  corrections is paced rather than overflowing the port.
+ */
+#pragma once
+
+#include "AP_GPS_config.h"
+
+#if AP_GPS_RTCM_DECODE_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
+#include <AP_Common/ExpandingString.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+
+#include "RTCM3_Parser.h"
+
+class RTCM3_Pipeline {
+    friend class RTCM3_Pipeline_Test;
+public:
+    // check buffers and start the IO thread task, returns false on
+    // allocation failure
+    bool init(void);
+
+    // queue a GPS_RTCM_DATA payload from a mavlink channel. Returns
+    // false if the channel could not be set up
+    bool handle_data(uint8_t chan, const uint8_t *data, uint8_t len);
+
+    // take the next message to inject if it is no longer than
+    // max_len, highest priority first. Returns its length, or zero if
+    // there is nothing which fits. bytes is valid until the next call
+    uint16_t pop(uint32_t max_len, const uint8_t *&bytes);
+
+    // per message type statistics
+    void info(ExpandingString &str);
+
+private:
+    static constexpr uint16_t input_buffer_size = 512;
+    static constexpr uint16_t high_queue_size = 2048;
+    static constexpr uint16_t low_queue_size = 1024;
+    static constexpr uint8_t max_types = 16;
+
+    // IO thread task
+    void update(void);
+
+    void handle_message(uint8_t chan, const uint8_t *buf, uint16_t len, uint16_t id, uint32_t crc);
+    bool is_duplicate(uint16_t len, uint32_t crc);
+    void push(ByteBuffer &queue, bool drop_oldest, const uint8_t *buf, uint16_t len, uint16_t id);
+    static uint16_t peek_message(ByteBuffer &queue, uint16_t &id);
+    static bool is_high_priority(uint16_t id);
+
+    struct type_stats {
+        uint16_t id;
+        uint32_t received;
+        uint32_t duplicates;
+        uint32_t dropped;       // discarded for lack of queue space
+        uint32_t sent;
+        uint32_t sent_bytes;
+    };
+    type_stats *find_stats(uint16_t id);
+
+    struct {
+        ByteBuffer *in;
+        RTCM3_Parser *parser;
+        uint32_t overflow_bytes;
+    } chans[MAVLINK_COMM_NUM_BUFFERS];
+
+    // recently queued messages, for de-duplication
+    struct {
+        uint32_t crc;
+        uint16_t len;
+    } recent[32];
+    uint8_t recent_idx;
+
+    ByteBuffer high_queue{high_queue_size};
+    ByteBuffer low_queue{low_queue_size};
+    uint8_t out_buf[RTCM3_MAX_PACKET_LEN];
+
+    // the last entry collects types once the table is full
+    type_stats stats[max_types];
+    uint8_t num_types;
+    uint32_t start_ms;
+
+    HAL_Semaphore sem;
+};
+
+#endif // AP_GPS_RTCM_DECODE_ENABLED
@@ -0,0 +1,224 @@
+#include <AP_gtest.h>
+
+/*
+  tests for the RTCM3 pipeline: de-duplication of messages arriving on
+  more than one channel, priority of observations over ephemeris, and
+  pacing of the output to the space in the receiver's UART
+ */
+
+#include <AP_GPS/RTCM3_Pipeline.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Logger/AP_Logger.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_GPS_RTCM_DECODE_ENABLED
+
+#include <vector>
+
+#if HAL_LOGGING_ENABLED
+static AP_Logger logger;
+#endif
+#if HAL_GCS_ENABLED
+GCS_Dummy _gcs;
+#endif
+
+class RTCM3_Pipeline_Test
+{
+public:
+    RTCM3_Pipeline_Test() :
+        pipeline(NEW_NOTHROW RTCM3_Pipeline())
+    {}
+
+    ~RTCM3_Pipeline_Test() {
+        delete pipeline;
+    }
+
+    // an RTCM3 frame of the given message type with len bytes of
+    // payload, seed makes the content and so the CRC unique
+    static std::vector<uint8_t> message(uint16_t id, uint16_t len, uint8_t seed) {
+        std::vector<uint8_t> m { 0xD3, uint8_t(len >> 8), uint8_t(len & 0xFF),
+                                 uint8_t(id >> 4), uint8_t((id & 0xF) << 4) };
+        for (uint16_t i=2; i<len; i++) {
+            m.push_back(uint8_t(seed + i));
+        }
+        const uint32_t crc = crc_crc24(m.data(), m.size());
+        m.push_back(crc >> 16);
+        m.push_back(crc >> 8);
+        m.push_back(crc);
+        return m;
+    }
+
+    // feed a message in as mavlink fragments, running the IO thread
+    // task after each as it would keep up with the link
+    void receive(uint8_t chan, const std::vector<uint8_t> &m) {
+        for (uint16_t ofs=0; ofs<m.size(); ofs += MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN) {
+            const uint8_t n = MIN(m.size() - ofs, MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN);
+            ASSERT_TRUE(pipeline->handle_data(chan, &m[ofs], n));
+            pipeline->update();
+        }
+    }
+
+    // take the next message as AP_GPS would with max_len bytes of
+    // UART space, returns its type or zero if nothing was sent
+    uint16_t pop(uint32_t max_len, uint16_t *len=nullptr, uint8_t *seed=nullptr) {
+        const uint8_t *bytes = nullptr;
+        const uint16_t n = pipeline->pop(max_len, bytes);
+        if (len != nullptr) {
+            *len = n;
+        }
+        if (n == 0) {
+            return 0;
+        }
+        EXPECT_NE(bytes, nullptr);
+        EXPECT_LE(n, max_len);
+        EXPECT_EQ(bytes[0], 0xD3);
+        EXPECT_EQ(crc_crc24(bytes, n), 0U);
+        if (seed != nullptr) {
+            *seed = bytes[5] - 2;
+        }
+        return (bytes[3] << 8 | bytes[4]) >> 4;
+    }
+
+    bool is_duplicate(uint16_t len, uint32_t crc) {
+        return pipeline->is_duplicate(len, crc);
+    }
+
+    uint32_t duplicates(uint16_t id) { return pipeline->find_stats(id)->duplicates; }
+    uint32_t dropped(uint16_t id) { return pipeline->find_stats(id)->dropped; }
+    uint32_t sent(uint16_t id) { return pipeline->find_stats(id)->sent; }
+
+private:
+    RTCM3_Pipeline *pipeline;
+};
+
+TEST(RTCM3_Pipeline, duplicates)
+{
+    RTCM3_Pipeline_Test t;
+
+    // the same message on two channels is only sent once
+    const std::vector<uint8_t> msm = RTCM3_Pipeline_Test::message(1077, 300, 1);
+    t.receive(0, msm);
+    t.receive(1, msm);
+    EXPECT_EQ(t.pop(UINT32_MAX), 1077);
+    EXPECT_EQ(t.pop(UINT32_MAX), 0);
+    EXPECT_EQ(t.duplicates(1077), 1U);
+
+    // different messages of the same type are all sent
+    t.receive(1, RTCM3_Pipeline_Test::message(1077, 300, 2));
+    t.receive(0, RTCM3_Pipeline_Test::message(1077, 300, 3));
+    EXPECT_EQ(t.pop(UINT32_MAX), 1077);
+    EXPECT_EQ(t.pop(UINT32_MAX), 1077);
+    EXPECT_EQ(t.pop(UINT32_MAX), 0);
+    EXPECT_EQ(t.duplicates(1077), 1U);
+}
+
+TEST(RTCM3_Pipeline, duplicate_key)
+{
+    RTCM3_Pipeline_Test t;
+
+    // lengths differing above the low byte are different messages
+    EXPECT_FALSE(t.is_duplicate(10, 0xABCDEF));
+    EXPECT_FALSE(t.is_duplicate(10 + 0x100, 0xABCDEF));
+    EXPECT_FALSE(t.is_duplicate(10 + 0x200, 0xABCDEF));
+    EXPECT_FALSE(t.is_duplicate(10, 0xABCDEE));
+    EXPECT_TRUE(t.is_duplicate(10 + 0x100, 0xABCDEF));
+    EXPECT_TRUE(t.is_duplicate(10, 0xABCDEF));
+
+    // only recent messages are remembered
+    for (uint32_t i=0; i<32; i++) {
+        EXPECT_FALSE(t.is_duplicate(20, i));
+    }
+    EXPECT_FALSE(t.is_duplicate(10, 0xABCDEF));
+}
+
+TEST(RTCM3_Pipeline, priority)
+{
+    RTCM3_Pipeline_Test t;
+
+    // ephemeris waits behind observations and station data even if
+    // it arrived first
+    t.receive(0, RTCM3_Pipeline_Test::message(1019, 61, 1));
+    t.receive(0, RTCM3_Pipeline_Test::message(1077, 200, 2));
+    t.receive(0, RTCM3_Pipeline_Test::message(1005, 19, 3));
+    t.receive(0, RTCM3_Pipeline_Test::message(1045, 62, 4));
+    EXPECT_EQ(t.pop(UINT32_MAX), 1077);
+    EXPECT_EQ(t.pop(UINT32_MAX), 1005);
+    EXPECT_EQ(t.pop(UINT32_MAX), 1019);
+    EXPECT_EQ(t.pop(UINT32_MAX), 1045);
+    EXPECT_EQ(t.pop(UINT32_MAX), 0);
+}
+
+TEST(RTCM3_Pipeline, pacing)
+{
+    RTCM3_Pipeline_Test t;
+
+    const uint16_t msm_len = 150 + 6;
+    for (uint8_t i=0; i<10; i++) {
+        t.receive(0, RTCM3_Pipeline_Test::message(1077, msm_len - 6, i));
+    }
+    t.receive(0, RTCM3_Pipeline_Test::message(1019, 61, 100));
+
+    // a smaller low priority message must not take the space an
+    // observation is waiting for
+    EXPECT_EQ(t.pop(msm_len - 1), 0);
+
+    // a UART draining 200 bytes between calls gets one observation
+    // per call, then the ephemeris
+    for (uint8_t i=0; i<10; i++) {
+        uint32_t space = 200;
+        uint16_t len;
+        EXPECT_EQ(t.pop(space, &len), 1077);
+        space -= len;
+        EXPECT_EQ(t.pop(space), 0);
+    }
+    EXPECT_EQ(t.pop(200), 1019);
+    EXPECT_EQ(t.pop(200), 0);
+    EXPECT_EQ(t.sent(1077), 10U);
+}
+
+TEST(RTCM3_Pipeline, overflow)
+{
+    RTCM3_Pipeline_Test t;
+
+    // 20 observations don't fit in the queue: the oldest are dropped
+    // as only the newest are useful
+    const uint16_t msm_payload = 250;
+    for (uint8_t i=0; i<20; i++) {
+        t.receive(0, RTCM3_Pipeline_Test::message(1077, msm_payload, i));
+    }
+    const uint32_t dropped_msm = t.dropped(1077);
+    EXPECT_GT(dropped_msm, 0U);
+
+    // ephemeris is repeated by the base, so when its queue is full new
+    // messages are dropped instead
+    const uint16_t eph_payload = 100;
+    for (uint8_t i=0; i<20; i++) {
+        t.receive(0, RTCM3_Pipeline_Test::message(1019, eph_payload, i));
+    }
+    const uint32_t dropped_eph = t.dropped(1019);
+    EXPECT_GT(dropped_eph, 0U);
+
+    uint32_t msm_count = 0;
+    uint32_t eph_count = 0;
+    uint16_t id;
+    uint8_t seed;
+    while ((id = t.pop(UINT32_MAX, nullptr, &seed)) != 0) {
+        if (id == 1077) {
+            EXPECT_EQ(eph_count, 0U);
+            EXPECT_EQ(seed, dropped_msm + msm_count);
+            msm_count++;
+        } else {
+            EXPECT_EQ(id, 1019);
+            EXPECT_EQ(seed, eph_count);
+            eph_count++;
+        }
+    }
+    EXPECT_EQ(msm_count + dropped_msm, 20U);
+    EXPECT_EQ(eph_count + dropped_eph, 20U);
+}
+
+#endif // AP_GPS_RTCM_DECODE_ENABLED
+
+AP_GTEST_MAIN()
@@ -0,0 +1,28 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/utility/RealFFT.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// forward transform at the window sizes accepted by FFT_WINDOW_SIZE
+static void BM_RealFFT(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    float in[512];
+    float out[514];
+    for (uint16_t i = 0; i < n; i++) {
+        in[i] = sinf(2 * M_PI * 11 * i / n);
+    }
+    RealFFT fft;
+    fft.init(n);
+
+    while (state.KeepRunning()) {
+        fft.forward(in, out);
+        gbenchmark_escape(out);
+    }
+}
+
+BENCHMARK(BM_RealFFT)->RangeMultiplier(2)->Range(32, 512);
+
+BENCHMARK_MAIN();
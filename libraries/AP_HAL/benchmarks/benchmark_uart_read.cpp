@@ -0,0 +1,87 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/UARTDriver.h>
+#include <AP_HAL/utility/RingBuffer.h>
+#include <AP_HAL/utility/UARTSpanReader.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  UART backed by a ring buffer in the same way as the HAL drivers, so
+  the per-call cost of reading is representative
+ */
+class BenchUART : public AP_HAL::UARTDriver {
+public:
+    BenchUART() : rxbuf(2048) {}
+
+    void fill(const uint8_t *data, uint32_t len) { rxbuf.write(data, len); }
+
+    bool is_initialized() override { return true; }
+    bool tx_pending() override { return false; }
+    uint32_t txspace() override { return 0; }
+
+protected:
+    void _begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace) override {}
+    size_t _write(const uint8_t *buffer, size_t size) override { return size; }
+    ssize_t _read(uint8_t *buffer, uint16_t count) override { return rxbuf.read(buffer, count); }
+    void _end() override {}
+    void _flush() override {}
+    uint32_t _available() override { return rxbuf.available(); }
+    bool _discard_input(void) override { rxbuf.clear(); return true; }
+
+private:
+    ByteBuffer rxbuf;
+};
+
+static const uint16_t burst_len = 1024;
+
+// byte at a time, as parsers did before UARTSpanReader
+static void BM_UARTReadByte(benchmark::State& state)
+{
+    BenchUART uart;
+    uint8_t burst[burst_len];
+    for (uint16_t i = 0; i < burst_len; i++) {
+        burst[i] = i;
+    }
+    uint32_t sum = 0;
+
+    while (state.KeepRunning()) {
+        uart.fill(burst, burst_len);
+        const uint32_t n = uart.available();
+        for (uint32_t i = 0; i < n; i++) {
+            uint8_t b;
+            if (!uart.read(b)) {
+                break;
+            }
+            sum += b;
+        }
+        gbenchmark_escape(&sum);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * burst_len);
+}
+
+static void BM_UARTReadSpan(benchmark::State& state)
+{
+    BenchUART uart;
+    uint8_t burst[burst_len];
+    for (uint16_t i = 0; i < burst_len; i++) {
+        burst[i] = i;
+    }
+    uint32_t sum = 0;
+
+    while (state.KeepRunning()) {
+        uart.fill(burst, burst_len);
+        UARTSpanReader::read_all(uart, uart.available(), [&](const uint8_t *span, uint16_t len) {
+            for (uint16_t i = 0; i < len; i++) {
+                sum += span[i];
+            }
+        });
+        gbenchmark_escape(&sum);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * burst_len);
+}
+
+BENCHMARK(BM_UARTReadByte);
+BENCHMARK(BM_UARTReadSpan);
+
+BENCHMARK_MAIN();
@@ -85,7 +85,7 @@
 #endif
 
 #ifndef HAL_GYROFFT_ENABLED
-#define HAL_GYROFFT_ENABLED 0
+#define HAL_GYROFFT_ENABLED 1
 #endif
 
 #ifndef HAL_LINUX_USE_VIRTUAL_CAN
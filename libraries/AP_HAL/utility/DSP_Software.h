@@ -14,20 +14,21 @@
  *
  * Code by Andy Piper
  */
+/*
+  portable FFT analysis for HALs without a vendor DSP library, used
+  by SITL and Linux
+ */
 #pragma once
 
 #include <AP_HAL/AP_HAL.h>
 
 #if HAL_WITH_DSP
 
-#include "AP_HAL_SITL.h"
+#include "RealFFT.h"
 
-#include <complex>
+namespace ap {
 
-typedef std::complex<float> complexf;
-
-// ChibiOS implementation of FFT analysis to run on STM32 processors
-class HALSITL::DSP : public AP_HAL::DSP {
+class DSP_Software : public AP_HAL::DSP {
 public:
     // initialise an FFT instance
     virtual FFTWindowState* fft_init(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size) override;
@@ -36,27 +37,28 @@ public:
     // perform remaining steps of an FFT analysis
     virtual uint16_t fft_analyse(FFTWindowState* state, uint16_t start_bin, uint16_t end_bin, float noise_att_cutoff) override;
 
-    // STM32-based FFT state
-    class FFTWindowStateSITL : public AP_HAL::DSP::FFTWindowState {
-        friend class HALSITL::DSP;
+    // software FFT state
+    class FFTWindowStateSoftware : public AP_HAL::DSP::FFTWindowState {
+        friend class DSP_Software;
 
     public:
-        FFTWindowStateSITL(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size);
-        virtual ~FFTWindowStateSITL();
+        FFTWindowStateSoftware(uint16_t window_size, uint16_t sample_rate, uint8_t sliding_window_size);
 
     private:
-        complexf* buf;
+        RealFFT rfft;
+        bool rfft_ok;
     };
 
 private:
-    void step_hanning(FFTWindowStateSITL* fft, FloatBuffer& samples, uint16_t advance);
-    void step_fft(FFTWindowStateSITL* fft);
+    void step_hanning(FFTWindowStateSoftware* fft, FloatBuffer& samples, uint16_t advance);
+    void step_fft(FFTWindowStateSoftware* fft);
     void mult_f32(const float* v1, const float* v2, float* vout, uint16_t len);
     void vector_max_float(const float* vin, uint16_t len, float* maxValue, uint16_t* maxIndex) const override;
     void vector_scale_float(const float* vin, float scale, float* vout, uint16_t len) const override;
     float vector_mean_float(const float* vin, uint16_t len) const override;
     void vector_add_float(const float* vin1, const float* vin2, float* vout, uint16_t len) const override;
-    void calculate_fft(complexf* f, uint16_t length);
 };
 
-#endif
+}  // namespace ap
+
+#endif // HAL_WITH_DSP
@@ -0,0 +1,203 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RealFFT.h"
+
+#include <math.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+RealFFT::~RealFFT()
+{
+    free_tables();
+}
+
+void RealFFT::free_tables()
+{
+    delete[] _bitrev;
+    delete[] _tw_re;
+    delete[] _tw_im;
+    delete[] _split_re;
+    delete[] _split_im;
+    delete[] _re;
+    delete[] _im;
+    _bitrev = nullptr;
+    _tw_re = _tw_im = nullptr;
+    _split_re = _split_im = nullptr;
+    _re = _im = nullptr;
+    _n = _m = 0;
+}
+
+bool RealFFT::init(uint16_t n)
+{
+    free_tables();
+    if (n < 4 || (n & (n - 1)) != 0) {
+        return false;
+    }
+    const uint16_t m = n / 2;
+
+    _bitrev = NEW_NOTHROW uint16_t[m];
+    _tw_re = NEW_NOTHROW float[m];
+    _tw_im = NEW_NOTHROW float[m];
+    _split_re = NEW_NOTHROW float[m];
+    _split_im = NEW_NOTHROW float[m];
+    _re = NEW_NOTHROW float[m];
+    _im = NEW_NOTHROW float[m];
+    if (_bitrev == nullptr || _tw_re == nullptr || _tw_im == nullptr ||
+        _split_re == nullptr || _split_im == nullptr || _re == nullptr || _im == nullptr) {
+        free_tables();
+        return false;
+    }
+    _n = n;
+    _m = m;
+
+    uint8_t bits = 0;
+    while ((1U << bits) < m) {
+        bits++;
+    }
+    for (uint16_t k = 0; k < m; k++) {
+        uint16_t r = 0;
+        for (uint8_t b = 0; b < bits; b++) {
+            r |= ((k >> b) & 1U) << (bits - 1 - b);
+        }
+        _bitrev[k] = r;
+    }
+
+    // the stage combining pairs of length h uses exp(-pi*i*k/h) for
+    // k < h, stored contiguously at offset h-1 so each stage reads
+    // its twiddles sequentially
+    for (uint16_t h = 1; h < m; h <<= 1) {
+        for (uint16_t k = 0; k < h; k++) {
+            const double a = -M_PI * k / h;
+            _tw_re[h - 1 + k] = cos(a);
+            _tw_im[h - 1 + k] = sin(a);
+        }
+    }
+
+    for (uint16_t k = 0; k < m; k++) {
+        const double a = -2.0 * M_PI * k / n;
+        _split_re[k] = cos(a);
+        _split_im[k] = sin(a);
+    }
+
+    return true;
+}
+
+/*
+  h radix-2 butterflies: t = w * b, a' = a + t, b' = a - t
+ */
+static void butterflies(float *ar, float *ai, float *br, float *bi,
+                        const float *wr, const float *wi, uint16_t h)
+{
+    uint16_t k = 0;
+#if defined(__ARM_NEON)
+    for (; k + 4 <= h; k += 4) {
+        const float32x4_t vwr = vld1q_f32(&wr[k]);
+        const float32x4_t vwi = vld1q_f32(&wi[k]);
+        const float32x4_t vbr = vld1q_f32(&br[k]);
+        const float32x4_t vbi = vld1q_f32(&bi[k]);
+        const float32x4_t var = vld1q_f32(&ar[k]);
+        const float32x4_t vai = vld1q_f32(&ai[k]);
+        const float32x4_t tr = vsubq_f32(vmulq_f32(vwr, vbr), vmulq_f32(vwi, vbi));
+        const float32x4_t ti = vaddq_f32(vmulq_f32(vwr, vbi), vmulq_f32(vwi, vbr));
+        vst1q_f32(&ar[k], vaddq_f32(var, tr));
+        vst1q_f32(&ai[k], vaddq_f32(vai, ti));
+        vst1q_f32(&br[k], vsubq_f32(var, tr));
+        vst1q_f32(&bi[k], vsubq_f32(vai, ti));
+    }
+#elif defined(__SSE__)
+    for (; k + 4 <= h; k += 4) {
+        const __m128 vwr = _mm_loadu_ps(&wr[k]);
+        const __m128 vwi = _mm_loadu_ps(&wi[k]);
+        const __m128 vbr = _mm_loadu_ps(&br[k]);
+        const __m128 vbi = _mm_loadu_ps(&bi[k]);
+        const __m128 var = _mm_loadu_ps(&ar[k]);
+        const __m128 vai = _mm_loadu_ps(&ai[k]);
+        const __m128 tr = _mm_sub_ps(_mm_mul_ps(vwr, vbr), _mm_mul_ps(vwi, vbi));
+        const __m128 ti = _mm_add_ps(_mm_mul_ps(vwr, vbi), _mm_mul_ps(vwi, vbr));
+        _mm_storeu_ps(&ar[k], _mm_add_ps(var, tr));
+        _mm_storeu_ps(&ai[k], _mm_add_ps(vai, ti));
+        _mm_storeu_ps(&br[k], _mm_sub_ps(var, tr));
+        _mm_storeu_ps(&bi[k], _mm_sub_ps(vai, ti));
+    }
+#endif
+    for (; k < h; k++) {
+        const float tr = wr[k] * br[k] - wi[k] * bi[k];
+        const float ti = wr[k] * bi[k] + wi[k] * br[k];
+        br[k] = ar[k] - tr;
+        bi[k] = ai[k] - ti;
+        ar[k] += tr;
+        ai[k] += ti;
+    }
+}
+
+void RealFFT::transform()
+{
+    // first stage has a unit twiddle, so skip the multiplies
+    for (uint16_t i = 0; i < _m; i += 2) {
+        const float r = _re[i + 1];
+        const float im = _im[i + 1];
+        _re[i + 1] = _re[i] - r;
+        _im[i + 1] = _im[i] - im;
+        _re[i] += r;
+        _im[i] += im;
+    }
+    for (uint16_t h = 2; h < _m; h <<= 1) {
+        const float *wr = &_tw_re[h - 1];
+        const float *wi = &_tw_im[h - 1];
+        for (uint16_t base = 0; base < _m; base += 2 * h) {
+            butterflies(&_re[base], &_im[base], &_re[base + h], &_im[base + h], wr, wi, h);
+        }
+    }
+}
+
+void RealFFT::forward(const float *in, float *out)
+{
+    if (_m == 0) {
+        return;
+    }
+
+    // pack even samples as real and odd samples as imaginary parts,
+    // in bit reversed order
+    for (uint16_t k = 0; k < _m; k++) {
+        const uint16_t j = _bitrev[k];
+        _re[k] = in[2 * j];
+        _im[k] = in[2 * j + 1];
+    }
+
+    transform();
+
+    // separate the spectra of the even and odd samples and combine
+    // them into the spectrum of the real input
+    out[0] = _re[0] + _im[0];
+    out[1] = 0.0f;
+    out[_n] = _re[0] - _im[0];
+    out[_n + 1] = 0.0f;
+    for (uint16_t k = 1; k < _m; k++) {
+        const uint16_t j = _m - k;
+        // even spectrum (Z[k] + conj(Z[m-k])) / 2
+        const float er = 0.5f * (_re[k] + _re[j]);
+        const float ei = 0.5f * (_im[k] - _im[j]);
+        // odd spectrum (Z[k] - conj(Z[m-k])) / 2i
+        const float or_ = 0.5f * (_im[k] + _im[j]);
+        const float oi = -0.5f * (_re[k] - _re[j]);
+        out[2 * k] = er + _split_re[k] * or_ - _split_im[k] * oi;
+        out[2 * k + 1] = ei + _split_re[k] * oi + _split_im[k] * or_;
+    }
+}
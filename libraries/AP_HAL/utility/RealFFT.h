@@ -0,0 +1,63 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  FFT of real valued data for boards without a vendor DSP library
+
+  A real FFT of length N is computed as a complex FFT of length N/2 on
+  the even and odd samples packed as real and imaginary parts,
+  followed by a split step to separate the two spectra. Twiddle
+  factors and the bit reversal permutation are computed once at
+  initialisation. Data is kept as separate real and imaginary arrays
+  so the butterflies can use 4-wide SSE or NEON operations.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <AP_Common/AP_Common.h>
+
+class RealFFT {
+public:
+    RealFFT() {}
+    ~RealFFT();
+
+    CLASS_NO_COPY(RealFFT);
+
+    // prepare for transforms of n samples, n must be a power of two
+    // of at least 4. Returns false on allocation failure
+    bool init(uint16_t n);
+
+    /*
+      forward transform of n real samples. out must hold n+2 floats
+      and receives the interleaved real and imaginary parts of bins
+      0 to n/2 inclusive. The result is not normalised.
+     */
+    void forward(const float *in, float *out);
+
+private:
+    void free_tables();
+
+    // complex FFT of length _m on _re/_im, input already bit reversed
+    void transform();
+
+    uint16_t _n = 0;
+    uint16_t _m = 0;                // complex FFT length, _n/2
+    uint16_t *_bitrev = nullptr;    // bit reversal permutation for _m entries
+    float *_tw_re = nullptr;        // twiddles for all butterfly stages, _m-1 entries
+    float *_tw_im = nullptr;
+    float *_split_re = nullptr;     // exp(-2*pi*i*k/_n) for the split step, _m entries
+    float *_split_im = nullptr;
+    float *_re = nullptr;           // working data, _m entries
+    float *_im = nullptr;
+};
@@ -0,0 +1,111 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  bulk reads from a UART for byte oriented protocol parsers
+
+  Reading one byte per UARTDriver::read() call takes the driver lock
+  and updates the ring buffer once per byte. These helpers read into a
+  stack buffer and hand the parser contiguous spans instead.
+ */
+#pragma once
+
+#include <AP_HAL/UARTDriver.h>
+#include <AP_Math/AP_Math.h>
+#include <string.h>
+
+class UARTSpanReader {
+public:
+    static constexpr uint16_t span_size = 64;
+
+    /*
+      read up to max_bytes, passing each span to
+      parse(const uint8_t *span, uint16_t len). For parsers which
+      always consume every byte they are given.
+     */
+    template <typename F>
+    static uint32_t read_all(AP_HAL::UARTDriver &port, uint32_t max_bytes, F parse) {
+        uint8_t buf[span_size];
+        uint32_t count = 0;
+        while (count < max_bytes) {
+            const ssize_t n = port.read(buf, MIN(max_bytes - count, uint32_t(sizeof(buf))));
+            if (n <= 0) {
+                break;
+            }
+            parse(buf, uint16_t(n));
+            count += n;
+            if (uint32_t(n) < sizeof(buf)) {
+                // a short read means the port has been drained
+                break;
+            }
+        }
+        return count;
+    }
+
+    /*
+      read up to max_bytes for a parser which may need to stop part
+      way through the data, e.g. to let the caller act on a completed
+      packet before the next one overwrites it.
+
+      parse(const uint8_t *span, uint16_t &len) is called with len set
+      to the span length. It sets len to the number of bytes it
+      consumed and returns false to stop reading. Bytes it did not
+      consume are kept and presented first on the next call.
+
+      returns the number of bytes consumed
+     */
+    template <typename F>
+    uint32_t read(AP_HAL::UARTDriver &port, uint32_t max_bytes, F parse) {
+        uint32_t count = 0;
+        if (tail_len > 0) {
+            uint16_t n = tail_len;
+            const bool more = parse(tail, n);
+            count += n;
+            tail_len -= n;
+            if (tail_len > 0) {
+                memmove(tail, &tail[n], tail_len);
+                return count;
+            }
+            if (!more) {
+                return count;
+            }
+        }
+        uint8_t buf[span_size];
+        while (count < max_bytes) {
+            const ssize_t nread = port.read(buf, MIN(max_bytes - count, uint32_t(sizeof(buf))));
+            if (nread <= 0) {
+                break;
+            }
+            uint16_t n = nread;
+            const bool more = parse(buf, n);
+            count += n;
+            if (n < nread) {
+                tail_len = nread - n;
+                memcpy(tail, &buf[n], tail_len);
+                break;
+            }
+            if (!more || uint32_t(nread) < sizeof(buf)) {
+                break;
+            }
+        }
+        return count;
+    }
+
+    // discard any bytes held back from the parser
+    void reset() { tail_len = 0; }
+
+private:
+    uint8_t tail[span_size];
+    uint8_t tail_len;
+};
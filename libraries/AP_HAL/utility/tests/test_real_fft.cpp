@@ -0,0 +1,50 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/utility/RealFFT.h>
+#include <AP_Math/AP_Math.h>
+
+// reference DFT of real input, bins 0 to n/2 interleaved
+static void naive_dft(const float *in, double *out, uint16_t n)
+{
+    for (uint16_t k = 0; k <= n / 2; k++) {
+        double re = 0, im = 0;
+        for (uint16_t t = 0; t < n; t++) {
+            const double a = -2.0 * M_PI * k * t / n;
+            re += in[t] * cos(a);
+            im += in[t] * sin(a);
+        }
+        out[2 * k] = re;
+        out[2 * k + 1] = im;
+    }
+}
+
+TEST(RealFFTTest, MatchesDFT)
+{
+    for (uint16_t n = 4; n <= 1024; n *= 2) {
+        float in[1024];
+        float out[1026];
+        double ref[1026];
+        for (uint16_t i = 0; i < n; i++) {
+            // a tone, a harmonic and deterministic noise
+            in[i] = sinf(2 * M_PI * 3.3f * i / n) + 0.5f * cosf(2 * M_PI * 7 * i / n) + 0.01f * ((i * 37) % 17);
+        }
+        RealFFT fft;
+        ASSERT_TRUE(fft.init(n));
+        fft.forward(in, out);
+        naive_dft(in, ref, n);
+        for (uint16_t i = 0; i < n + 2; i++) {
+            EXPECT_NEAR(out[i], ref[i], 1e-4 * n) << "n=" << n << " i=" << i;
+        }
+    }
+}
+
+TEST(RealFFTTest, BadSize)
+{
+    RealFFT fft;
+    EXPECT_FALSE(fft.init(0));
+    EXPECT_FALSE(fft.init(2));
+    EXPECT_FALSE(fft.init(48));
+    EXPECT_TRUE(fft.init(32));
+}
+
+AP_GTEST_MAIN()
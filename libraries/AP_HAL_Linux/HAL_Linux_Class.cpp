@@ -8,6 +8,7 @@
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/DSP_Software.h>
 #include <AP_HAL/utility/RCOutput_Tap.h>
 #include <AP_HAL/utility/getopt_cpp.h>
 #include <AP_HAL_Empty/AP_HAL_Empty.h>
@@ -243,7 +244,7 @@ static Empty::OpticalFlow opticalFlow;
 #endif
 
 #if HAL_WITH_DSP
-static Empty::DSP dspDriver;
+static ap::DSP_Software dspDriver;
 #endif
 static Empty::Flash flashDriver;
 static Empty::WSPIDeviceManager wspi_mgr_instance;
@@ -331,6 +332,8 @@ void _usage(void)
     printf("\tcpu affinity:\n");
     printf("\t                   --cpu-affinity 1 (single cpu) or 1,3 (multiple cpus) or 1-3 (range of cpus)\n");
     printf("\t                   -c 1 (single cpu) or 1,3 (multiple cpus) or 1-3 (range of cpus)\n");
+    printf("\tthread cpu affinity and priority (threads are main, rate, ap-timer, ap-uart, ap-rcin, ap-io, ...):\n");
+    printf("\t                   --thread rate:3:40 (cpu 3 with priority 40) or --thread main:2\n");
 }
 
 void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
@@ -350,6 +353,7 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
         CMDLINE_SERIAL7,
         CMDLINE_SERIAL8,
         CMDLINE_SERIAL9,
+        CMDLINE_THREAD,
     };
 
     int opt;
@@ -380,6 +384,7 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
         {"module-directory",    true,  0, 'M'},
         {"defaults",            true,  0, 'd'},
         {"cpu-affinity",        true,  0, 'c'},
+        {"thread",              true,  0, CMDLINE_THREAD},
         {"help",                false,  0, 'h'},
         {0, false, 0, 0}
     };
@@ -449,6 +454,12 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
             }
             Linux::Scheduler::from(scheduler)->set_cpu_affinity(cpu_affinity);
             break;
+        case CMDLINE_THREAD:
+            if (!Linux::Scheduler::from(scheduler)->add_thread_config(gopt.optarg)) {
+                fprintf(stderr, "Could not parse thread configuration: %s\n", gopt.optarg);
+                exit(1);
+            }
+            break;
         case 'h':
             _usage();
             exit(0);
@@ -9,6 +9,7 @@
 #include <sys/time.h>
 #include <unistd.h>
 
+#include <AP_Common/ExpandingString.h>
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_Vehicle/AP_Vehicle_Type.h>
@@ -23,26 +24,6 @@ using namespace Linux;
 
 extern const AP_HAL::HAL& hal;
 
-#define APM_LINUX_MAX_PRIORITY          20
-#define APM_LINUX_TIMER_PRIORITY        15
-#define APM_LINUX_UART_PRIORITY         14
-#define APM_LINUX_NET_PRIORITY          14
-#define APM_LINUX_RCIN_PRIORITY         13
-#define APM_LINUX_MAIN_PRIORITY         12
-#define APM_LINUX_IO_PRIORITY           10
-#define APM_LINUX_SCRIPTING_PRIORITY     1
-
-#define APM_LINUX_TIMER_RATE            1000
-#define APM_LINUX_UART_RATE             100
-
-#ifndef APM_LINUX_RCIN_RATE
-#define APM_LINUX_RCIN_RATE             100
-#endif  // APM_LINUX_RCIN_RATE
-
-#ifndef APM_LINUX_IO_RATE
-#define APM_LINUX_IO_RATE               50
-#endif  // APM_LINUX_IO_RATE
-
 #define SCHED_THREAD(name_, UPPER_NAME_)                        \
     {                                                           \
         .name = "ap-" #name_,                                   \
@@ -74,7 +55,11 @@ void Scheduler::init_realtime()
 
     mlockall(MCL_CURRENT|MCL_FUTURE);
 
+    const thread_config *config = find_thread_config("main");
     struct sched_param param = { .sched_priority = APM_LINUX_MAIN_PRIORITY };
+    if (config != nullptr && config->priority != 0) {
+        param.sched_priority = config->priority;
+    }
     if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == -1) {
         AP_HAL::panic("Scheduler: failed to set scheduling parameters: %s",
                       strerror(errno));
@@ -84,6 +69,11 @@ void Scheduler::init_realtime()
 void Scheduler::init_cpu_affinity()
 {
     if (!CPU_COUNT(&_cpu_affinity)) {
+        // threads without their own affinity keep the one we started
+        // with, even if the main thread is moved elsewhere
+        if (sched_getaffinity(0, sizeof(_cpu_affinity), &_cpu_affinity) != 0) {
+            CPU_ZERO(&_cpu_affinity);
+        }
         return;
     }
 
@@ -126,7 +116,15 @@ void Scheduler::init()
 
         t->thread->set_rate(t->rate);
         t->thread->set_stack_size(1024 * 1024);
-        t->thread->start(t->name, t->policy, t->prio);
+        start_thread(*t->thread, t->name, t->policy, t->prio);
+    }
+
+    // the main thread is moved last so the threads above do not
+    // inherit its affinity
+    const thread_config *config = find_thread_config("main");
+    if (config != nullptr && CPU_COUNT(&config->cpu_affinity) &&
+        (ret = pthread_setaffinity_np(_main_ctx, sizeof(config->cpu_affinity), &config->cpu_affinity)) != 0) {
+        AP_HAL::panic("Failed to set affinity for main thread: %s", strerror(ret));
     }
 
 #if defined(DEBUG_STACK) && DEBUG_STACK
@@ -322,6 +320,8 @@ void Scheduler::set_system_initialized()
 
 void Scheduler::reboot(bool hold_in_bootloader)
 {
+    // don't lose parameters saved in the last moments
+    Storage::from(hal.storage)->commit();
     exit(1);
 }
 
@@ -379,6 +379,7 @@ uint8_t Scheduler::calculate_thread_priority(priority_base base, int8_t priority
         { PRIORITY_I2C, AP_LINUX_SENSORS_SCHED_PRIO},
         { PRIORITY_CAN, APM_LINUX_TIMER_PRIORITY},
         { PRIORITY_TIMER, APM_LINUX_TIMER_PRIORITY},
+        { PRIORITY_RCOUT, APM_LINUX_TIMER_PRIORITY},
         { PRIORITY_RCIN, APM_LINUX_RCIN_PRIORITY},
         { PRIORITY_IO, APM_LINUX_IO_PRIORITY},
         { PRIORITY_UART, APM_LINUX_UART_PRIORITY},
@@ -417,10 +418,177 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
      */
     thread->set_auto_free(true);
 
-    if (!thread->start(name, SCHED_FIFO, thread_priority)) {
+    if (!start_thread(*thread, name, SCHED_FIFO, thread_priority)) {
         delete thread;
         return false;
     }
 
     return true;
 }
+
+/*
+  parse a thread configuration in the form NAME:CPUS[:PRIORITY]
+*/
+bool Scheduler::add_thread_config(const char *config)
+{
+    if (_num_thread_configs >= ARRAY_SIZE(_thread_configs)) {
+        return false;
+    }
+    thread_config &c = _thread_configs[_num_thread_configs];
+
+    const char *cpus = strchr(config, ':');
+    if (cpus == nullptr || cpus == config || size_t(cpus - config) >= sizeof(c.name)) {
+        return false;
+    }
+    memset(c.name, 0, sizeof(c.name));
+    memcpy(c.name, config, cpus - config);
+    cpus++;
+
+    char cpus_str[64] {};
+    const char *priority = strchr(cpus, ':');
+    const size_t cpus_len = priority != nullptr ? size_t(priority - cpus) : strlen(cpus);
+    if (cpus_len == 0 || cpus_len >= sizeof(cpus_str)) {
+        return false;
+    }
+    memcpy(cpus_str, cpus, cpus_len);
+    if (!Util::from(hal.util)->parse_cpu_set(cpus_str, &c.cpu_affinity)) {
+        return false;
+    }
+
+    c.priority = 0;
+    if (priority != nullptr) {
+        char *endptr;
+        const long prio = strtol(priority + 1, &endptr, 10);
+        if (endptr == priority + 1 || *endptr != '\0' ||
+            prio < sched_get_priority_min(SCHED_FIFO) || prio > sched_get_priority_max(SCHED_FIFO)) {
+            return false;
+        }
+        c.priority = prio;
+    }
+
+    _num_thread_configs++;
+    return true;
+}
+
+const Scheduler::thread_config *Scheduler::find_thread_config(const char *name) const
+{
+    if (name == nullptr) {
+        return nullptr;
+    }
+    for (uint8_t i = 0; i < _num_thread_configs; i++) {
+        if (strncmp(_thread_configs[i].name, name, sizeof(_thread_configs[i].name)) == 0) {
+            return &_thread_configs[i];
+        }
+    }
+    return nullptr;
+}
+
+bool Scheduler::start_thread(Thread &thread, const char *name, int policy, int prio)
+{
+    const thread_config *config = find_thread_config(name);
+    if (config != nullptr && config->priority != 0) {
+        prio = config->priority;
+    }
+    // threads created from the main thread would otherwise inherit its affinity
+    thread.set_cpu_affinity(config != nullptr ? config->cpu_affinity : _cpu_affinity);
+
+    // registered first as the thread may exit at any time once started
+    {
+        WITH_SEMAPHORE(_threads_sem);
+        if (_num_threads < ARRAY_SIZE(_threads)) {
+            _threads[_num_threads].thread = &thread;
+            _threads[_num_threads].cpu_time_usec = 0;
+            _num_threads++;
+        }
+    }
+
+    if (!thread.start(name, policy, prio)) {
+        unregister_thread(&thread);
+        return false;
+    }
+    return true;
+}
+
+void Scheduler::unregister_thread(Thread *thread)
+{
+    WITH_SEMAPHORE(_threads_sem);
+    for (uint8_t i = 0; i < _num_threads; i++) {
+        if (_threads[i].thread == thread) {
+            _num_threads--;
+            memmove(&_threads[i], &_threads[i+1], (_num_threads - i) * sizeof(_threads[0]));
+            return;
+        }
+    }
+}
+
+// print a cpu set in the form parse_cpu_set() accepts
+static void print_cpu_set(ExpandingString &str, const cpu_set_t &cpu_set)
+{
+    const char *sep = "";
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &cpu_set)) {
+            continue;
+        }
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &cpu_set)) {
+            last++;
+        }
+        if (last == cpu) {
+            str.printf("%s%d", sep, cpu);
+        } else {
+            str.printf("%s%d-%d", sep, cpu, last);
+        }
+        sep = ",";
+        cpu = last;
+    }
+}
+
+/*
+  display the priority, affinity and CPU usage of the threads as text
+  for @SYS/threads.txt. LOAD is the share of one CPU used since the
+  last call, and LAT the average and maximum wakeup latency of the
+  periodic threads
+*/
+void Scheduler::thread_info(ExpandingString &str)
+{
+    const uint64_t now_usec = AP_HAL::micros64();
+    const uint64_t dt_usec = now_usec - _last_thread_info_usec;
+    _last_thread_info_usec = now_usec;
+
+    // a header to allow for machine parsers to determine format
+    str.printf("ThreadsV1\n");
+
+    // the main thread
+    struct sched_param param;
+    int policy;
+    if (pthread_getschedparam(_main_ctx, &policy, &param) != 0) {
+        param.sched_priority = 0;
+    }
+    cpu_set_t cpu_set;
+    if (pthread_getaffinity_np(_main_ctx, sizeof(cpu_set), &cpu_set) != 0) {
+        CPU_ZERO(&cpu_set);
+    }
+    uint64_t cpu_time_usec = Thread::get_cpu_time_usec(_main_ctx);
+    str.printf("%-13.13s PRI=%3u CPU=", "main", unsigned(param.sched_priority));
+    print_cpu_set(str, cpu_set);
+    str.printf(" LOAD=%5.1f%%\n", 100.0f * float(cpu_time_usec - _main_cpu_time_usec) / float(dt_usec));
+    _main_cpu_time_usec = cpu_time_usec;
+
+    WITH_SEMAPHORE(_threads_sem);
+    for (uint8_t i = 0; i < _num_threads; i++) {
+        Thread *thread = _threads[i].thread;
+        cpu_time_usec = thread->get_cpu_time_usec();
+        str.printf("%-13.13s PRI=%3u CPU=",
+                   thread->get_name() != nullptr ? thread->get_name() : "?",
+                   unsigned(thread->get_priority()));
+        print_cpu_set(str, thread->get_cpu_affinity());
+        str.printf(" LOAD=%5.1f%%", 100.0f * float(cpu_time_usec - _threads[i].cpu_time_usec) / float(dt_usec));
+        _threads[i].cpu_time_usec = cpu_time_usec;
+
+        uint32_t avg_usec, max_usec;
+        if (thread->get_wakeup_latency(avg_usec, max_usec)) {
+            str.printf(" LAT=%u/%uus", unsigned(avg_usec), unsigned(max_usec));
+        }
+        str.printf("\n");
+    }
+}
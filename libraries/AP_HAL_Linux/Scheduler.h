@@ -10,11 +10,33 @@
 #define LINUX_SCHEDULER_MAX_TIMER_PROCS 10
 #define LINUX_SCHEDULER_MAX_TIMESLICED_PROCS 10
 #define LINUX_SCHEDULER_MAX_IO_PROCS 10
+#define LINUX_SCHEDULER_MAX_THREADS 32
+#define LINUX_SCHEDULER_MAX_THREAD_CONFIGS 8
 
 #define AP_LINUX_SENSORS_STACK_SIZE  256 * 1024
 #define AP_LINUX_SENSORS_SCHED_POLICY  SCHED_FIFO
 #define AP_LINUX_SENSORS_SCHED_PRIO 12
 
+#define APM_LINUX_MAX_PRIORITY          20
+#define APM_LINUX_TIMER_PRIORITY        15
+#define APM_LINUX_UART_PRIORITY         14
+#define APM_LINUX_NET_PRIORITY          14
+#define APM_LINUX_RCIN_PRIORITY         13
+#define APM_LINUX_MAIN_PRIORITY         12
+#define APM_LINUX_IO_PRIORITY           10
+#define APM_LINUX_SCRIPTING_PRIORITY     1
+
+#define APM_LINUX_TIMER_RATE            1000
+#define APM_LINUX_UART_RATE             100
+
+#ifndef APM_LINUX_RCIN_RATE
+#define APM_LINUX_RCIN_RATE             100
+#endif  // APM_LINUX_RCIN_RATE
+
+#ifndef APM_LINUX_IO_RATE
+#define APM_LINUX_IO_RATE               50
+#endif  // APM_LINUX_IO_RATE
+
 namespace Linux {
 
 class Scheduler : public AP_HAL::Scheduler {
@@ -60,6 +82,22 @@ public:
      */
     void set_cpu_affinity(const cpu_set_t &cpu_affinity) { _cpu_affinity = cpu_affinity; }
 
+    /*
+      set the cpu affinity and, optionally, the SCHED_FIFO priority of
+      a thread by name, in the form NAME:CPUS[:PRIORITY], e.g. rate:3:40.
+      The main thread is named "main". Must be called before init().
+     */
+    bool add_thread_config(const char *config);
+
+    // forget a thread which is about to exit
+    void unregister_thread(Thread *thread);
+
+    /*
+      display the scheduling and CPU usage of each thread for
+      @SYS/threads.txt
+     */
+    void thread_info(ExpandingString &str);
+
 private:
     class SchedulerThread : public PeriodicThread {
     public:
@@ -78,6 +116,31 @@ private:
 
     void     init_cpu_affinity();
 
+    struct thread_config {
+        char name[16];
+        cpu_set_t cpu_affinity;
+        uint8_t priority;   // 0 to keep the default priority
+    };
+    const thread_config *find_thread_config(const char *name) const;
+
+    // apply any configuration for the named thread and start it
+    bool start_thread(Thread &thread, const char *name, int policy, int prio);
+
+    thread_config _thread_configs[LINUX_SCHEDULER_MAX_THREAD_CONFIGS];
+    uint8_t _num_thread_configs;
+
+    // all the threads started by the scheduler, with their CPU time
+    // at the last call to thread_info()
+    struct {
+        Thread *thread;
+        uint64_t cpu_time_usec;
+    } _threads[LINUX_SCHEDULER_MAX_THREADS];
+    uint8_t _num_threads;
+    Semaphore _threads_sem;
+
+    uint64_t _main_cpu_time_usec;
+    uint64_t _last_thread_info_usec;
+
     void _wait_all_threads();
 
     void     _debug_stack();
@@ -4,22 +4,33 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
+#include <AP_Common/ExpandingString.h>
+#include <AP_Math/crc.h>
 
 using namespace Linux;
 
 /*
   This stores 'eeprom' data on the SD card, with a 4k size, and a
   in-memory buffer. This keeps the latency down.
+
+  Changes are written from the IO thread in batches, each going to a
+  journal file before the storage file so that a batch is either
+  written completely or not at all.
  */
 
 // name the storage file after the sketch so you can use the same board
 // card for ArduCopter and ArduPlane
 #define STORAGE_FILE AP_BUILD_TARGET_NAME ".stg"
+#define JOURNAL_FILE STORAGE_FILE ".journal"
+
+#define JOURNAL_MAGIC 0x4A475453 // "STGJ"
 
 extern const AP_HAL::HAL& hal;
 
@@ -117,6 +128,14 @@ int Storage::_storage_create(const char *dpath)
         goto fail;
     }
 
+    _journal_fd = openat(dfd, JOURNAL_FILE, O_RDWR|O_CREAT|O_CLOEXEC, 0666);
+    if (_journal_fd == -1) {
+        fprintf(stderr, "Failed to create journal file %s/%s\n", dpath,
+                JOURNAL_FILE);
+        close(fd);
+        goto fail;
+    }
+
     // ensure the directory is updated with the new size
     fsync(fd);
     fsync(dfd);
@@ -130,6 +149,32 @@ fail:
     return -1;
 }
 
+/*
+  open the storage in dpath, completing any commit which was
+  interrupted, and read it into the buffer
+ */
+bool Storage::_open(const char *dpath)
+{
+    _dirty_mask = 0;
+
+    int fd = _storage_create(dpath);
+    if (fd == -1) {
+        return false;
+    }
+    _fd = fd;
+
+    if (!_replay_journal()) {
+        return false;
+    }
+
+    if (pread(_fd, _buffer, sizeof(_buffer), 0) != sizeof(_buffer)) {
+        return false;
+    }
+
+    _initialised = true;
+    return true;
+}
+
 void Storage::init()
 {
     const char *dpath;
@@ -138,46 +183,35 @@ void Storage::init()
         return;
     }
 
-    _dirty_mask = 0;
-
     dpath = hal.util->get_custom_storage_directory();
     if (!dpath) {
         dpath = HAL_BOARD_STORAGE_DIRECTORY;
     }
 
-    int fd = _storage_create(dpath);
-    if (fd == -1) {
-        AP_HAL::panic("Cannot create storage %s (%m)", dpath);
-    }
-
-    ssize_t ret = read(fd, _buffer, sizeof(_buffer));
-
-    if (ret != sizeof(_buffer)) {
-        close(fd);
-        AP_HAL::panic("Failed to read %s (%m)", dpath);
+    if (!_open(dpath)) {
+        AP_HAL::panic("Cannot open storage %s (%m)", dpath);
     }
-
-    _fd = fd;
-    _initialised = true;
 }
 
 /*
-  mark some lines as dirty. Note that there is no attempt to avoid
-  the race condition between this code and the _timer_tick() code
-  below, which both update _dirty_mask. If we lose the race then the
-  result is that a line is written more than once, but it won't result
-  in a line not being written.
+  mark some lines as dirty. The IO thread takes the whole mask when it
+  commits, so a line marked dirty while it is being committed is
+  written again by the next commit
  */
 void Storage::_mark_dirty(uint16_t loc, uint16_t length)
 {
     if (length == 0) {
         return;
     }
+    uint32_t mask = 0;
     uint16_t end = loc + length - 1;
     for (uint8_t line=loc>>LINUX_STORAGE_LINE_SHIFT;
          line <= end>>LINUX_STORAGE_LINE_SHIFT;
          line++) {
-        _dirty_mask |= 1U << line;
+        mask |= 1U << line;
+    }
+    if (_dirty_mask.fetch_or(mask) == 0) {
+        _first_dirty_ms = AP_HAL::millis();
     }
 }
 
@@ -199,59 +233,188 @@ void Storage::write_block(uint16_t loc, const void *src, size_t n)
         init();
         memcpy(&_buffer[loc], src, n);
         _mark_dirty(loc, n);
+        _stats.bytes_changed += n;
     }
 }
 
+/*
+  commit the changes once they have stopped coming for a while, so
+  that saving many parameters at once costs one commit rather than a
+  write and sync for each
+ */
 void Storage::_timer_tick(void)
 {
-    if (!_initialised || _dirty_mask == 0 || _fd == -1) {
+    if (!_initialised || _dirty_mask == 0) {
         return;
     }
 
-    // write out the first dirty set of lines. We don't write more
-    // than one to keep the latency of this call to a minimum
-    uint8_t i, n;
-    for (i=0; i<LINUX_STORAGE_NUM_LINES; i++) {
-        if (_dirty_mask & (1<<i)) {
-            break;
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - _first_dirty_ms < LINUX_STORAGE_COMMIT_DELAY_MS ||
+        now_ms - _last_commit_ms < LINUX_STORAGE_COMMIT_INTERVAL_MS) {
+        return;
+    }
+
+    commit();
+}
+
+/*
+  write the dirty lines to the storage file. They are first written
+  with a checksum to the journal, so a power loss or crash part way
+  through leaves either the old lines in the storage file or a
+  complete journal which _replay_journal() writes over them on the
+  next boot
+ */
+bool Storage::commit()
+{
+    WITH_SEMAPHORE(_commit_sem);
+
+    if (!_initialised) {
+        return true;
+    }
+    const uint32_t line_mask = _dirty_mask.exchange(0);
+    if (line_mask == 0) {
+        return true;
+    }
+    _last_commit_ms = AP_HAL::millis();
+
+    // take a copy, as the main thread may change the lines while
+    // they are written
+    uint8_t n = 0;
+    for (uint8_t i=0; i<LINUX_STORAGE_NUM_LINES; i++) {
+        if (line_mask & (1U<<i)) {
+            memcpy(&_commit_buffer[n<<LINUX_STORAGE_LINE_SHIFT],
+                   &_buffer[i<<LINUX_STORAGE_LINE_SHIFT],
+                   LINUX_STORAGE_LINE_SIZE);
+            n++;
         }
     }
-    if (i == LINUX_STORAGE_NUM_LINES) {
-        // this shouldn't be possible
-        return;
+
+    if (!_write_journal(line_mask, _commit_buffer) ||
+        !_write_lines(line_mask, _commit_buffer)) {
+        // try again on a later tick
+        _dirty_mask |= line_mask;
+        _stats.errors++;
+        _commit_failed = true;
+        return false;
     }
-    uint32_t write_mask = (1U<<i);
-    // see how many lines to write
-    for (n=1; (i+n) < LINUX_STORAGE_NUM_LINES &&
-             n < (LINUX_STORAGE_MAX_WRITE>>LINUX_STORAGE_LINE_SHIFT); n++) {
-        if (!(_dirty_mask & (1<<(n+i)))) {
-            break;
+
+    // the lines are in the storage file, so the journal is no longer
+    // needed. This does not need to be synced, as replaying it again
+    // would write the same lines
+    if (ftruncate(_journal_fd, 0) != 0) {
+        _stats.errors++;
+    }
+
+    _sequence++;
+    _stats.commits++;
+    _commit_failed = false;
+    return true;
+}
+
+bool Storage::_write_journal(uint32_t line_mask, const uint8_t *lines)
+{
+    const size_t len = __builtin_popcount(line_mask) << LINUX_STORAGE_LINE_SHIFT;
+
+    struct journal_header header;
+    header.magic = JOURNAL_MAGIC;
+    header.sequence = _sequence;
+    header.line_mask = line_mask;
+    header.crc = crc_crc32(0, lines, len);
+    header.crc = crc_crc32(header.crc, (const uint8_t *)&header, offsetof(journal_header, crc));
+
+    struct iovec iov[2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<uint8_t *>(lines);
+    iov[1].iov_len = len;
+    if (pwritev(_journal_fd, iov, ARRAY_SIZE(iov), 0) != ssize_t(sizeof(header) + len)) {
+        return false;
+    }
+    _stats.bytes_written += sizeof(header) + len;
+
+    _stats.syncs++;
+    return fdatasync(_journal_fd) == 0;
+}
+
+/*
+  write the lines to the storage file, one write per run of
+  consecutive lines
+ */
+bool Storage::_write_lines(uint32_t line_mask, const uint8_t *lines)
+{
+    uint8_t i = 0;
+    while (i < LINUX_STORAGE_NUM_LINES) {
+        if (!(line_mask & (1U<<i))) {
+            i++;
+            continue;
+        }
+        uint8_t n = 1;
+        while (i+n < LINUX_STORAGE_NUM_LINES && (line_mask & (1U<<(i+n)))) {
+            n++;
+        }
+        const size_t len = n << LINUX_STORAGE_LINE_SHIFT;
+        if (pwrite(_fd, lines, len, i << LINUX_STORAGE_LINE_SHIFT) != ssize_t(len)) {
+            return false;
         }
-        // mark that line clean
-        write_mask |= (1<<(n+i));
+        _stats.bytes_written += len;
+        lines += len;
+        i += n;
     }
 
-    /*
-      write the lines. This also updates _dirty_mask. Note that
-      because this is a SCHED_FIFO thread it will not be preempted
-      by the main task except during blocking calls. This means we
-      don't need a semaphore around the _dirty_mask updates.
-     */
-    if (lseek(_fd, i<<LINUX_STORAGE_LINE_SHIFT, SEEK_SET) == (i<<LINUX_STORAGE_LINE_SHIFT)) {
-        _dirty_mask &= ~write_mask;
-        if (write(_fd, &_buffer[i<<LINUX_STORAGE_LINE_SHIFT], n<<LINUX_STORAGE_LINE_SHIFT) != n<<LINUX_STORAGE_LINE_SHIFT) {
-            // write error - likely EINTR
-            _dirty_mask |= write_mask;
-            close(_fd);
-            _fd = -1;
+    _stats.syncs++;
+    return fdatasync(_fd) == 0;
+}
+
+/*
+  write the lines from a complete journal to the storage file. A
+  journal which fails its checks was being written when the commit was
+  interrupted, so the storage file has not been touched and it is
+  discarded
+ */
+bool Storage::_replay_journal()
+{
+    struct journal_header header;
+    if (pread(_journal_fd, &header, sizeof(header), 0) == sizeof(header) &&
+        header.magic == JOURNAL_MAGIC &&
+        header.line_mask != 0 &&
+        (header.line_mask & ~uint32_t((1ULL<<LINUX_STORAGE_NUM_LINES)-1)) == 0) {
+        const size_t len = __builtin_popcount(header.line_mask) << LINUX_STORAGE_LINE_SHIFT;
+        uint32_t crc = 0;
+        if (pread(_journal_fd, _commit_buffer, len, sizeof(header)) == ssize_t(len)) {
+            crc = crc_crc32(0, _commit_buffer, len);
+            crc = crc_crc32(crc, (const uint8_t *)&header, offsetof(journal_header, crc));
         }
-        if (_dirty_mask == 0) {
-            if (fsync(_fd) != 0) {
-                close(_fd);
-                _fd = -1;
+        if (crc == header.crc) {
+            if (!_write_lines(header.line_mask, _commit_buffer)) {
+                return false;
             }
+            _sequence = header.sequence + 1;
         }
     }
+
+    if (ftruncate(_journal_fd, 0) != 0) {
+        return false;
+    }
+    return fdatasync(_journal_fd) == 0;
+}
+
+bool Storage::healthy()
+{
+    return _initialised && !_commit_failed;
+}
+
+void Storage::storage_info(ExpandingString &str)
+{
+    str.printf("StorageV1\n");
+    str.printf("Dirty: 0x%08x\n", unsigned(_dirty_mask));
+    str.printf("Commits: %u\n", unsigned(_stats.commits));
+    str.printf("Syncs: %u\n", unsigned(_stats.syncs));
+    str.printf("Errors: %u\n", unsigned(_stats.errors));
+    str.printf("Changed: %llu\n", (unsigned long long)_stats.bytes_changed);
+    str.printf("Written: %llu\n", (unsigned long long)_stats.bytes_written);
+    // bytes written to the card for each byte changed
+    str.printf("Amplification: %.1f\n",
+               _stats.bytes_changed ? double(_stats.bytes_written) / _stats.bytes_changed : 0.0);
 }
 
 /*
@@ -1,13 +1,25 @@
 #pragma once
 
+#include <atomic>
+
 #include <AP_HAL/AP_HAL.h>
 
 #define LINUX_STORAGE_SIZE HAL_STORAGE_SIZE
-#define LINUX_STORAGE_MAX_WRITE 512
 #define LINUX_STORAGE_LINE_SHIFT 9
 #define LINUX_STORAGE_LINE_SIZE (1<<LINUX_STORAGE_LINE_SHIFT)
 #define LINUX_STORAGE_NUM_LINES (LINUX_STORAGE_SIZE/LINUX_STORAGE_LINE_SIZE)
 
+// changes are committed once they are this old, so that a burst of
+// parameter saves goes out in one transaction
+#ifndef LINUX_STORAGE_COMMIT_DELAY_MS
+#define LINUX_STORAGE_COMMIT_DELAY_MS 500
+#endif
+
+// and no more often than this, bounding the rate of fsync calls
+#ifndef LINUX_STORAGE_COMMIT_INTERVAL_MS
+#define LINUX_STORAGE_COMMIT_INTERVAL_MS 1000
+#endif
+
 namespace Linux {
 
 class Storage : public AP_HAL::Storage
@@ -34,16 +46,50 @@ public:
 
     bool get_storage_ptr(void *&ptr, size_t &size) override;
 
+    bool healthy() override;
+
     virtual void _timer_tick(void) override;
 
+    // write out all changes now, returns false on a write error
+    bool commit();
+
+    void storage_info(ExpandingString &str) override;
+
 protected:
+    struct journal_header {
+        uint32_t magic;
+        uint32_t sequence;
+        uint32_t line_mask;
+        uint32_t crc;   // of the lines, then the fields above
+    };
+
     void _mark_dirty(uint16_t loc, uint16_t length);
     int _storage_create(const char *dpath);
+    bool _open(const char *dpath);
+    bool _replay_journal();
+    bool _write_journal(uint32_t line_mask, const uint8_t *lines);
+    bool _write_lines(uint32_t line_mask, const uint8_t *lines);
 
     int _fd;
+    int _journal_fd = -1;
     volatile bool _initialised;
-    volatile uint32_t _dirty_mask;
+    std::atomic<uint32_t> _dirty_mask;
+    uint32_t _first_dirty_ms = 0;
+    uint32_t _last_commit_ms = 0;
+    uint32_t _sequence = 0;
+    bool _commit_failed = false;
+    HAL_Semaphore _commit_sem;
     uint8_t _buffer[LINUX_STORAGE_SIZE];
+    // the dirty lines being committed, packed together
+    uint8_t _commit_buffer[LINUX_STORAGE_SIZE];
+
+    struct {
+        uint64_t bytes_changed;     // by write_block()
+        uint64_t bytes_written;     // to the journal and storage files
+        uint32_t commits;
+        uint32_t syncs;
+        uint32_t errors;
+    } _stats {};
 };
 
 }
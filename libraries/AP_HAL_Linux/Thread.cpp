@@ -20,6 +20,7 @@
 #include <limits.h>
 #include <sys/types.h>
 #include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 #include <utility>
 
@@ -41,6 +42,7 @@ void *Thread::_run_trampoline(void *arg)
     thread->_run();
 
     if (thread->_auto_free) {
+        Scheduler::from(hal.scheduler)->unregister_thread(thread);
         delete thread;
     }
 
@@ -190,6 +192,12 @@ bool Thread::start(const char *name, int policy, int prio)
         }
     }
 
+    if (CPU_COUNT(&_cpu_affinity) &&
+        (r = pthread_attr_setaffinity_np(&attr, sizeof(_cpu_affinity), &_cpu_affinity)) != 0) {
+        AP_HAL::panic("Failed to set affinity for thread '%s': %s",
+                      name, strerror(r));
+    }
+
     r = pthread_create(&_ctx, &attr, &Thread::_run_trampoline, this);
     if (r != 0) {
         AP_HAL::panic("Failed to create thread '%s': %s",
@@ -201,11 +209,39 @@ bool Thread::start(const char *name, int policy, int prio)
         pthread_setname_np(_ctx, name);
     }
 
+    _name = name;
+    _policy = policy;
+    _prio = prio;
     _started = true;
 
     return true;
 }
 
+bool Thread::set_cpu_affinity(const cpu_set_t &cpu_affinity)
+{
+    if (_started) {
+        return false;
+    }
+
+    _cpu_affinity = cpu_affinity;
+
+    return true;
+}
+
+uint64_t Thread::get_cpu_time_usec(pthread_t ctx)
+{
+    clockid_t clock_id;
+    struct timespec ts;
+
+    if (ctx == 0 ||
+        pthread_getcpuclockid(ctx, &clock_id) != 0 ||
+        clock_gettime(clock_id, &ts) != 0) {
+        return 0;
+    }
+
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
 bool Thread::is_current_thread()
 {
     return pthread_equal(pthread_self(), _ctx);
@@ -265,6 +301,14 @@ bool PeriodicThread::_run()
             next_run_usec = AP_HAL::micros64();
         } else {
             Scheduler::from(hal.scheduler)->microsleep(dt);
+
+            // how late we woke up
+            const uint64_t now_usec = AP_HAL::micros64();
+            const uint32_t latency_usec = now_usec > next_run_usec ? MIN(now_usec - next_run_usec, UINT32_MAX) : 0;
+            WITH_SEMAPHORE(_latency_sem);
+            _latency.sum_usec += latency_usec;
+            _latency.max_usec = MAX(_latency.max_usec, latency_usec);
+            _latency.count++;
         }
         next_run_usec += _period_usec;
 
@@ -277,6 +321,16 @@ bool PeriodicThread::_run()
     return true;
 }
 
+bool PeriodicThread::get_wakeup_latency(uint32_t &avg_usec, uint32_t &max_usec)
+{
+    WITH_SEMAPHORE(_latency_sem);
+    avg_usec = _latency.count ? _latency.sum_usec / _latency.count : 0;
+    max_usec = _latency.max_usec;
+    _latency = {};
+
+    return true;
+}
+
 bool PeriodicThread::stop()
 {
     if (!is_started()) {
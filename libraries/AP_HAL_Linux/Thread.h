@@ -18,10 +18,13 @@
 
 #include <pthread.h>
 #include <inttypes.h>
+#include <sched.h>
 #include <stdlib.h>
 
 #include <AP_HAL/utility/functor.h>
 
+#include "Semaphores.h"
+
 namespace Linux {
 
 /*
@@ -31,12 +34,34 @@ class Thread {
 public:
     FUNCTOR_TYPEDEF(task_t, void);
 
-    Thread(task_t t) : _task(t) { }
+    Thread(task_t t) : _task(t) { CPU_ZERO(&_cpu_affinity); }
 
     virtual ~Thread() { }
 
     bool start(const char *name, int policy, int prio);
 
+    /*
+      set the cpus the thread may run on, to be applied when it is
+      started - setting it later has no effect.
+     */
+    bool set_cpu_affinity(const cpu_set_t &cpu_affinity);
+    const cpu_set_t &get_cpu_affinity() const { return _cpu_affinity; }
+
+    const char *get_name() const { return _name; }
+    int get_policy() const { return _policy; }
+    int get_priority() const { return _prio; }
+
+    // CPU time used by the thread since it started, or 0 if unknown
+    uint64_t get_cpu_time_usec() const { return get_cpu_time_usec(_ctx); }
+    static uint64_t get_cpu_time_usec(pthread_t ctx);
+
+    /*
+      get the average and maximum time between when the thread should
+      have woken up and when it did, since the last call. Returns false
+      if the thread does not wake up periodically
+     */
+    virtual bool get_wakeup_latency(uint32_t &avg_usec, uint32_t &max_usec) { return false; }
+
     bool is_current_thread();
 
     bool is_started() const { return _started; }
@@ -69,6 +94,11 @@ protected:
     bool _auto_free = false;
     pthread_t _ctx = 0;
 
+    const char *_name = nullptr;
+    int _policy = 0;
+    int _prio = 0;
+    cpu_set_t _cpu_affinity;
+
     struct stack_debug {
         uint32_t *start;
         uint32_t *end;
@@ -87,10 +117,20 @@ public:
 
     bool stop() override;
 
+    bool get_wakeup_latency(uint32_t &avg_usec, uint32_t &max_usec) override;
+
 protected:
     bool _run() override;
 
     uint64_t _period_usec = 0;
+
+    // written by the thread, read and reset by whoever reports it
+    struct {
+        uint64_t sum_usec;
+        uint32_t max_usec;
+        uint32_t count;
+    } _latency {};
+    Semaphore _latency_sem;
 };
 
 }
@@ -10,6 +10,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "Heat_Pwm.h"
+#include "Scheduler.h"
 #include "Util.h"
 
 using namespace Linux;
@@ -299,3 +300,11 @@ bool Util::parse_cpu_set(const char *str, cpu_set_t *cpu_set) const
 
     return true;
 }
+
+/*
+  display thread scheduling and usage as text buffer for @SYS/threads.txt
+ */
+void Util::thread_info(ExpandingString &str)
+{
+    Scheduler::from(hal.scheduler)->thread_info(str);
+}
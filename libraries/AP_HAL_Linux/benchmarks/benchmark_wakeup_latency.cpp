@@ -0,0 +1,401 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  wakeup latency of the Linux HAL threads, in the style of cyclictest.
+
+  Each benchmark measures how late a thread wakes up after it should
+  have, using the HAL's own PeriodicThread, BinarySemaphore and
+  microsleep(), at the scheduler's rates and priorities. The argument
+  selects a background load to run at the same time:
+
+    0: none
+    1: cpu, a busy thread per cpu
+    2: io, synchronous writes to a file
+    3: log, buffered writes to a file with a periodic fsync, like AP_Logger
+
+  The load file is created in $TMPDIR, or /tmp. Run as root so that
+  the threads get their SCHED_FIFO priorities, and with taskset to
+  compare isolated cores.
+
+  Besides the average and maximum, the counters give a histogram of
+  the wakeups, hNNNNNus being the number which were less than NNNNN
+  microseconds late.
+ */
+#include <AP_gbenchmark.h>
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+
+#include <atomic>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_HAL_Linux/Scheduler.h>
+#include <AP_HAL_Linux/Semaphores.h>
+#include <AP_HAL_Linux/Thread.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+using namespace Linux;
+
+// how long each benchmark iteration samples for
+#define SAMPLE_TIME_USEC 100000
+
+/*
+  histogram of wakeup latencies, with buckets doubling in size from 1us
+ */
+class LatencyHistogram {
+public:
+    void add(uint32_t latency_usec) {
+        uint8_t b = 0;
+        while (b < NUM_BUCKETS - 1 && latency_usec >= (1U << b)) {
+            b++;
+        }
+        _buckets[b]++;
+        _count++;
+        _sum_usec += latency_usec;
+        _max_usec = MAX(_max_usec, latency_usec);
+    }
+
+    void report(benchmark::State &state) const {
+        state.counters["avg_us"] = _count ? double(_sum_usec) / _count : 0;
+        state.counters["max_us"] = _max_usec;
+        state.counters["wakeups"] = _count;
+        for (uint8_t b = 0; b < NUM_BUCKETS; b++) {
+            if (_buckets[b] == 0) {
+                continue;
+            }
+            char name[16];
+            if (b < NUM_BUCKETS - 1) {
+                snprintf(name, sizeof(name), "h%05uus", 1U << b);
+            } else {
+                snprintf(name, sizeof(name), "h_more");
+            }
+            state.counters[name] = _buckets[b];
+        }
+    }
+
+private:
+    static constexpr uint8_t NUM_BUCKETS = 17;  // up to 65ms
+    uint32_t _buckets[NUM_BUCKETS] {};
+    uint32_t _count = 0;
+    uint64_t _sum_usec = 0;
+    uint32_t _max_usec = 0;
+};
+
+/*
+  background load, run at normal priority
+ */
+class BackgroundLoad {
+public:
+    enum class Type {
+        NONE = 0,
+        CPU = 1,
+        IO = 2,
+        LOG = 3,
+    };
+
+    ~BackgroundLoad() { stop(); }
+
+    bool start(Type type) {
+        _stop = false;
+        if (type == Type::IO || type == Type::LOG) {
+            const char *tmpdir = getenv("TMPDIR");
+            char path[256];
+            snprintf(path, sizeof(path), "%s/ap-wakeup-latency-XXXXXX", tmpdir != nullptr ? tmpdir : "/tmp");
+            _fd = mkstemp(path);
+            if (_fd == -1) {
+                return false;
+            }
+            unlink(path);
+            if (type == Type::IO && fcntl(_fd, F_SETFL, O_DSYNC) == -1) {
+                return false;
+            }
+        }
+
+        switch (type) {
+        case Type::NONE:
+            break;
+        case Type::CPU: {
+            const long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            for (long i = 0; i < MIN(num_cpus, long(ARRAY_SIZE(_threads))); i++) {
+                _start_thread(FUNCTOR_BIND_MEMBER(&BackgroundLoad::_cpu_task, void));
+            }
+            break;
+        }
+        case Type::IO:
+        case Type::LOG:
+            _start_thread(FUNCTOR_BIND_MEMBER(&BackgroundLoad::_write_task, void));
+            break;
+        }
+        _sync = type == Type::LOG;
+        return true;
+    }
+
+    void stop() {
+        _stop = true;
+        for (uint8_t i = 0; i < _num_threads; i++) {
+            _threads[i]->join();
+            delete _threads[i];
+        }
+        _num_threads = 0;
+        if (_fd != -1) {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+
+private:
+    void _start_thread(Thread::task_t task) {
+        Thread *thread = NEW_NOTHROW Thread(task);
+        if (thread != nullptr && thread->start("load", SCHED_OTHER, 0)) {
+            _threads[_num_threads++] = thread;
+        } else {
+            delete thread;
+        }
+    }
+
+    void _cpu_task() {
+        volatile uint32_t n = 0;
+        while (!_stop) {
+            n++;
+        }
+    }
+
+    // write in blocks like the logger, wrapping the file at 16MB
+    void _write_task() {
+        static uint8_t block[4096];
+        uint32_t writes = 0;
+        while (!_stop) {
+            memset(block, writes, sizeof(block));
+            if (write(_fd, block, sizeof(block)) != ssize_t(sizeof(block))) {
+                break;
+            }
+            writes++;
+            if (_sync && writes % 256 == 0) {
+                fsync(_fd);
+            }
+            if (writes % 4096 == 0) {
+                lseek(_fd, 0, SEEK_SET);
+            }
+        }
+    }
+
+    Thread *_threads[16];
+    uint8_t _num_threads = 0;
+    int _fd = -1;
+    bool _sync = false;
+    std::atomic<bool> _stop {false};
+};
+
+/*
+  a PeriodicThread recording how late each run is. The thread keeps to
+  a fixed schedule from when it starts, so the latency is measured from
+  that schedule, restarting it if the thread loses sync
+ */
+class LatencyThread : public PeriodicThread {
+public:
+    LatencyThread()
+        : PeriodicThread(FUNCTOR_BIND_MEMBER(&LatencyThread::_task, void))
+    { }
+
+    LatencyHistogram histogram;
+
+protected:
+    bool _run() override {
+        _next_usec = AP_HAL::micros64() + _period_usec;
+        return PeriodicThread::_run();
+    }
+
+private:
+    void _task() {
+        const uint64_t now = AP_HAL::micros64();
+        if (now >= _next_usec + _period_usec) {
+            _next_usec = now;
+        }
+        histogram.add(now > _next_usec ? now - _next_usec : 0);
+        _next_usec += _period_usec;
+    }
+
+    uint64_t _next_usec = 0;
+};
+
+static void sample_sleep()
+{
+    Scheduler::from(hal.scheduler)->microsleep(SAMPLE_TIME_USEC);
+}
+
+static void periodic_thread_latency(benchmark::State &state, uint32_t rate_hz, int prio)
+{
+    BackgroundLoad load;
+    if (!load.start(BackgroundLoad::Type(state.range(0)))) {
+        state.SkipWithError("failed to start load");
+        return;
+    }
+
+    LatencyThread *thread = NEW_NOTHROW LatencyThread();
+    if (thread == nullptr || !thread->set_rate(rate_hz) || !thread->start("latency", SCHED_FIFO, prio)) {
+        delete thread;
+        state.SkipWithError("failed to start thread");
+        return;
+    }
+
+    while (state.KeepRunning()) {
+        sample_sleep();
+    }
+
+    thread->stop();
+    thread->join();
+    load.stop();
+
+    thread->histogram.report(state);
+
+    // the thread's own statistics, as shown in @SYS/threads.txt
+    uint32_t avg_usec, max_usec;
+    thread->get_wakeup_latency(avg_usec, max_usec);
+    state.counters["thread_avg_us"] = avg_usec;
+    state.counters["thread_max_us"] = max_usec;
+
+    delete thread;
+}
+
+static void BM_TimerThreadWakeup(benchmark::State &state)
+{
+    periodic_thread_latency(state, APM_LINUX_TIMER_RATE, APM_LINUX_TIMER_PRIORITY);
+}
+
+static void BM_IOThreadWakeup(benchmark::State &state)
+{
+    periodic_thread_latency(state, APM_LINUX_IO_RATE, APM_LINUX_IO_PRIORITY);
+}
+
+/*
+  time from a BinarySemaphore being signalled until the thread waiting
+  on it runs, as for a thread waiting on new sensor data
+ */
+class SemaphoreThread : public Thread {
+public:
+    SemaphoreThread()
+        : Thread(FUNCTOR_BIND_MEMBER(&SemaphoreThread::_task, void))
+    { }
+
+    void signal() {
+        _signal_usec = AP_HAL::micros64();
+        _sem.signal();
+    }
+
+    void stop_waiting() {
+        _stop = true;
+        _sem.signal();
+    }
+
+    LatencyHistogram histogram;
+
+private:
+    void _task() {
+        while (true) {
+            _sem.wait_blocking();
+            if (_stop) {
+                break;
+            }
+            histogram.add(AP_HAL::micros64() - _signal_usec);
+        }
+    }
+
+    BinarySemaphore _sem;
+    std::atomic<uint64_t> _signal_usec {0};
+    std::atomic<bool> _stop {false};
+};
+
+static void BM_SemaphoreWakeup(benchmark::State &state)
+{
+    BackgroundLoad load;
+    if (!load.start(BackgroundLoad::Type(state.range(0)))) {
+        state.SkipWithError("failed to start load");
+        return;
+    }
+
+    SemaphoreThread *thread = NEW_NOTHROW SemaphoreThread();
+    if (thread == nullptr || !thread->start("latency", SCHED_FIFO, APM_LINUX_MAIN_PRIORITY)) {
+        delete thread;
+        state.SkipWithError("failed to start thread");
+        return;
+    }
+
+    const uint32_t period_usec = hz_to_usec(APM_LINUX_TIMER_RATE);
+    while (state.KeepRunning()) {
+        for (uint32_t t = 0; t < SAMPLE_TIME_USEC; t += period_usec) {
+            Scheduler::from(hal.scheduler)->microsleep(period_usec);
+            thread->signal();
+        }
+    }
+
+    thread->stop_waiting();
+    thread->join();
+    load.stop();
+
+    thread->histogram.report(state);
+    delete thread;
+}
+
+/*
+  how late microsleep() returns in the main thread, as when the main
+  loop waits for the next IMU sample at 400Hz
+ */
+static void BM_MainLoopDelay(benchmark::State &state)
+{
+    BackgroundLoad load;
+    if (!load.start(BackgroundLoad::Type(state.range(0)))) {
+        state.SkipWithError("failed to start load");
+        return;
+    }
+
+    int policy;
+    struct sched_param old_param;
+    pthread_getschedparam(pthread_self(), &policy, &old_param);
+    if (geteuid() == 0) {
+        const struct sched_param param = { .sched_priority = APM_LINUX_MAIN_PRIORITY };
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    }
+
+    LatencyHistogram histogram;
+    const uint32_t period_usec = 2500;
+    while (state.KeepRunning()) {
+        for (uint32_t t = 0; t < SAMPLE_TIME_USEC; t += period_usec) {
+            const uint64_t wake_usec = AP_HAL::micros64() + period_usec;
+            Scheduler::from(hal.scheduler)->microsleep(period_usec);
+            const uint64_t now = AP_HAL::micros64();
+            histogram.add(now > wake_usec ? now - wake_usec : 0);
+        }
+    }
+
+    pthread_setschedparam(pthread_self(), policy, &old_param);
+    load.stop();
+
+    histogram.report(state);
+}
+
+BENCHMARK(BM_TimerThreadWakeup)->DenseRange(0, 3)->Iterations(20)->UseRealTime();
+BENCHMARK(BM_IOThreadWakeup)->DenseRange(0, 3)->Iterations(100)->UseRealTime();
+BENCHMARK(BM_SemaphoreWakeup)->DenseRange(0, 3)->Iterations(20)->UseRealTime();
+BENCHMARK(BM_MainLoopDelay)->DenseRange(0, 3)->Iterations(20)->UseRealTime();
+
+#endif
+
+BENCHMARK_MAIN();
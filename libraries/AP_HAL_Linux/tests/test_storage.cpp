@@ -0,0 +1,238 @@
+#include <AP_gtest.h>
+
+/*
+  tests for the Linux storage journal. The storage is kept in a
+  temporary directory, and a child process writing to it is killed at
+  random points to check that each commit is written completely or not
+  at all
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL_Linux/Storage.h>
+
+using namespace Linux;
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+class TestStorage final : public Storage {
+public:
+    ~TestStorage() {
+        close(_fd);
+        close(_journal_fd);
+    }
+
+    using Storage::_open;
+
+    // write the journal for the changes but not the storage file, as
+    // if the commit was interrupted
+    bool commit_journal_only() {
+        const uint32_t line_mask = _dirty_mask.exchange(0);
+        uint8_t n = 0;
+        for (uint8_t i=0; i<LINUX_STORAGE_NUM_LINES; i++) {
+            if (line_mask & (1U<<i)) {
+                memcpy(&_commit_buffer[n++<<LINUX_STORAGE_LINE_SHIFT],
+                       &_buffer[i<<LINUX_STORAGE_LINE_SHIFT], LINUX_STORAGE_LINE_SIZE);
+            }
+        }
+        return _write_journal(line_mask, _commit_buffer);
+    }
+
+    void corrupt_journal() {
+        const uint8_t b = 0x55;
+        ASSERT_EQ(1, pwrite(_journal_fd, &b, 1, sizeof(journal_header) + 10));
+    }
+
+    uint32_t commits() const { return _stats.commits; }
+    uint64_t bytes_changed() const { return _stats.bytes_changed; }
+    uint64_t bytes_written() const { return _stats.bytes_written; }
+};
+
+class StorageTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const char *tmpdir = getenv("TMPDIR");
+        snprintf(_dir, sizeof(_dir), "%s/ap-storage-XXXXXX", tmpdir != nullptr ? tmpdir : "/tmp");
+        ASSERT_NE(nullptr, mkdtemp(_dir));
+    }
+
+    void TearDown() override {
+        char cmd[300];
+        snprintf(cmd, sizeof(cmd), "rm -rf %s", _dir);
+        ASSERT_EQ(0, system(cmd));
+    }
+
+    TestStorage *open_storage() {
+        TestStorage *storage = new TestStorage();
+        if (!storage->_open(_dir)) {
+            delete storage;
+            return nullptr;
+        }
+        return storage;
+    }
+
+    char _dir[256];
+};
+
+static void fill(Storage *storage, uint8_t value)
+{
+    uint8_t line[LINUX_STORAGE_LINE_SIZE];
+    memset(line, value, sizeof(line));
+    for (uint16_t loc=0; loc<LINUX_STORAGE_SIZE; loc += sizeof(line)) {
+        storage->write_block(loc, line, sizeof(line));
+    }
+}
+
+static bool check_fill(Storage *storage, uint8_t value)
+{
+    uint8_t buffer[LINUX_STORAGE_SIZE];
+    storage->read_block(buffer, 0, sizeof(buffer));
+    for (uint16_t i=0; i<sizeof(buffer); i++) {
+        if (buffer[i] != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_F(StorageTest, Reopen)
+{
+    TestStorage *storage = open_storage();
+    ASSERT_NE(nullptr, storage);
+    fill(storage, 1);
+    EXPECT_TRUE(storage->commit());
+    EXPECT_TRUE(storage->healthy());
+    delete storage;
+
+    storage = open_storage();
+    ASSERT_NE(nullptr, storage);
+    EXPECT_TRUE(check_fill(storage, 1));
+    delete storage;
+}
+
+TEST_F(StorageTest, ReplayJournal)
+{
+    TestStorage *storage = open_storage();
+    ASSERT_NE(nullptr, storage);
+    fill(storage, 1);
+    EXPECT_TRUE(storage->commit());
+    fill(storage, 2);
+    EXPECT_TRUE(storage->commit_journal_only());
+    delete storage;
+
+    storage = open_storage();
+    ASSERT_NE(nullptr, storage);
+    EXPECT_TRUE(check_fill(storage, 2));
+    delete storage;
+}
+
+TEST_F(StorageTest, DiscardIncompleteJournal)
+{
+    TestStorage *storage = open_storage();
+    ASSERT_NE(nullptr, storage);
+    fill(storage, 1);
+    EXPECT_TRUE(storage->commit());
+    fill(storage, 2);
+    EXPECT_TRUE(storage->commit_journal_only());
+    storage->corrupt_journal();
+    delete storage;
+
+    storage = open_storage();
+    ASSERT_NE(nullptr, storage);
+    EXPECT_TRUE(check_fill(storage, 1));
+    delete storage;
+}
+
+/*
+  many small changes to the same lines are written in one commit
+ */
+TEST_F(StorageTest, CoalesceWrites)
+{
+    TestStorage *storage = open_storage();
+    ASSERT_NE(nullptr, storage);
+    for (uint16_t i=1; i<=1000; i++) {
+        // a parameter changing in the first line, and a counter
+        // spanning the boundary of the next two
+        storage->write_block(8, &i, sizeof(i));
+        const uint32_t v = i;
+        storage->write_block(2*LINUX_STORAGE_LINE_SIZE - 2, &v, sizeof(v));
+    }
+    EXPECT_TRUE(storage->commit());
+    EXPECT_TRUE(storage->commit());
+    EXPECT_EQ(1U, storage->commits());
+    EXPECT_EQ(1000U * 6, storage->bytes_changed());
+    // the lines go to the journal then the storage file
+    EXPECT_GT(storage->bytes_written(), 2U * 3 * LINUX_STORAGE_LINE_SIZE);
+    EXPECT_LT(storage->bytes_written(), 2U * 3 * LINUX_STORAGE_LINE_SIZE + 100);
+    delete storage;
+}
+
+/*
+  generation g of the crash test writes g to the first line and to the
+  lines for which line_changed() is true, so each commit writes several
+  runs of lines. Returns the value line i holds after generation g
+ */
+static bool line_changed(uint8_t i, uint32_t g)
+{
+    return i == 0 || (i * 7 + g) % 3 != 0;
+}
+
+static uint8_t line_value(uint8_t i, uint32_t g)
+{
+    while (g > 0 && !line_changed(i, g)) {
+        g--;
+    }
+    return g;
+}
+
+TEST_F(StorageTest, KillDuringCommit)
+{
+    srandom(getpid());
+    uint32_t generations = 0;
+    for (uint8_t kill_count=0; kill_count<30; kill_count++) {
+        TestStorage *storage = open_storage();
+        ASSERT_NE(nullptr, storage);
+        uint8_t buffer[LINUX_STORAGE_SIZE];
+        storage->read_block(buffer, 0, sizeof(buffer));
+        const uint32_t g = buffer[0];
+        for (uint8_t i=0; i<LINUX_STORAGE_NUM_LINES; i++) {
+            const uint8_t value = line_value(i, g);
+            for (uint16_t j=0; j<LINUX_STORAGE_LINE_SIZE; j++) {
+                ASSERT_EQ(value, buffer[(i<<LINUX_STORAGE_LINE_SHIFT) + j]);
+            }
+        }
+        generations += g;
+
+        const pid_t pid = fork();
+        ASSERT_NE(-1, pid);
+        if (pid == 0) {
+            // write each generation in full, leaving write_block() to
+            // find the lines which changed, and wrap before the
+            // generation overflows the first line
+            for (uint32_t next=1; ; next = next % 250 + 1) {
+                uint8_t line[LINUX_STORAGE_LINE_SIZE];
+                for (uint8_t i=0; i<LINUX_STORAGE_NUM_LINES; i++) {
+                    memset(line, line_value(i, next), sizeof(line));
+                    storage->write_block(i<<LINUX_STORAGE_LINE_SHIFT, line, sizeof(line));
+                }
+                storage->commit();
+            }
+        }
+        delete storage;
+
+        usleep(1000 + random() % 20000);
+        kill(pid, SIGKILL);
+        int status;
+        ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    }
+    // the child must have got some way each time
+    EXPECT_GT(generations, 0U);
+}
+
+AP_GTEST_MAIN()
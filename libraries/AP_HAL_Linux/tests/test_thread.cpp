@@ -17,6 +17,7 @@
 #include <AP_gtest.h>
 
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
@@ -117,4 +118,55 @@ TEST(LinuxThread, periodic_thread)
     EXPECT_TRUE(thr.join());
 }
 
+class TestThread3 : public Thread {
+public:
+    TestThread3() : Thread{FUNCTOR_BIND_MEMBER(&TestThread3::_task, void)} { }
+
+    int cpu = -1;
+
+protected:
+    void _task() {
+        cpu = sched_getcpu();
+    }
+};
+
+TEST(LinuxThread, cpu_affinity)
+{
+    TestThread3 thr;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(0, &cpu_set);
+    EXPECT_TRUE(thr.set_cpu_affinity(cpu_set));
+    EXPECT_TRUE(thr.start(nullptr, 0, 0));
+
+    // this must fail as the thread already started
+    EXPECT_FALSE(thr.set_cpu_affinity(cpu_set));
+
+    EXPECT_TRUE(thr.join());
+    EXPECT_EQ(thr.cpu, 0);
+    EXPECT_TRUE(CPU_EQUAL(&cpu_set, &thr.get_cpu_affinity()));
+
+    uint32_t avg_usec, max_usec;
+    EXPECT_FALSE(thr.get_wakeup_latency(avg_usec, max_usec));
+}
+
+TEST(LinuxThread, periodic_thread_latency)
+{
+    TestPeriodicThread1 thr;
+    EXPECT_TRUE(thr.set_rate(1000));
+    EXPECT_TRUE(thr.start(nullptr, 0, 0));
+
+    // the stats are read and reset while the thread updates them
+    for (uint8_t i=0; i<100; i++) {
+        usleep(1000);
+        uint32_t avg_usec, max_usec;
+        EXPECT_TRUE(thr.get_wakeup_latency(avg_usec, max_usec));
+        EXPECT_LE(avg_usec, max_usec);
+    }
+    EXPECT_GT(thr.get_cpu_time_usec(), 0U);
+
+    EXPECT_TRUE(thr.stop());
+    EXPECT_TRUE(thr.join());
+}
+
 AP_GTEST_MAIN()
@@ -23,7 +23,6 @@
 #include "GPIO.h"
 #include "SITL_State.h"
 #include "Util.h"
-#include "DSP.h"
 #include "CANSocketIface.h"
 #include "SPIDevice.h"
 
@@ -34,6 +33,7 @@
 #include <AP_Logger/AP_Logger.h>
 #include <AP_RCProtocol/AP_RCProtocol_config.h>
 #include <AP_HAL/SIMState.h>
+#include <AP_HAL/utility/DSP_Software.h>
 
 using namespace HALSITL;
 
@@ -56,7 +56,7 @@ static AP_HAL::SIMState xsimstate;
 #endif
 
 #if HAL_WITH_DSP
-static DSP dspDriver;
+static ap::DSP_Software dspDriver;
 #endif
 
 
@@ -287,6 +287,7 @@ void HAL_SITL::run(int argc, char * const argv[], Callbacks* callbacks) const
     while (true) {
         if (HALSITL::Scheduler::_should_exit) {
             ::fprintf(stderr, "Exitting\n");
+            _sitl_state->sim_detach();
             exit(0);
         }
         if (fill_count++ % 10 == 0) {
@@ -316,6 +317,7 @@ void HAL_SITL::run(int argc, char * const argv[], Callbacks* callbacks) const
 
 void HAL_SITL::actually_reboot()
 {
+    sitlState.sim_detach();
     execv(new_argv[0], new_argv);
     AP_HAL::panic("PANIC: REBOOT FAILED: %s", strerror(errno));
 }
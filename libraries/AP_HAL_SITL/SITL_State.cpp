@@ -120,8 +120,12 @@ void SITL_State::_fdm_input_step(void)
 {
     _fdm_input_local();
 
-    /* make sure we die if our parent dies */
-    if (kill(_parent_pid, 0) != 0) {
+    /*
+      make sure we die if our parent dies. This costs a system call,
+      so it is checked every few hundred frames rather than every frame
+     */
+    if (_update_count % 256 == 0 && kill(_parent_pid, 0) != 0) {
+        sim_detach();
         exit(1);
     }
 
@@ -151,7 +155,10 @@ void SITL_State::_fdm_input_step(void)
 void SITL_State::wait_clock(uint64_t wait_time_usec)
 {
     float speedup = sitl_model->get_speedup();
-    if (speedup < 1) {
+    if (is_zero(speedup)) {
+        // running as fast as possible
+        speedup = FLT_MAX;
+    } else if (speedup < 1) {
         // for purposes of sleeps treat low speedups as 1
         speedup = 1.0;
     }
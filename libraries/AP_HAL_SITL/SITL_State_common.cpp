@@ -266,6 +266,14 @@ SITL::SerialDevice *SITL_State_Common::create_serial_sim(const char *name, const
         inertiallabs = NEW_NOTHROW SITL::InertialLabs();
         return inertiallabs;
 
+#if AP_SIM_SWARM_ENABLED
+    } else if (streq(name, "swarm")) {
+        if (swarm_link != nullptr) {
+            AP_HAL::panic("Only one swarm link at a time");
+        }
+        swarm_link = NEW_NOTHROW SITL::SwarmLink();
+        return swarm_link;
+#endif
 #if AP_SIM_AIS_ENABLED
     } else if (streq(name, "AIS")) {
         if ((ais != nullptr) || (ais_replay != nullptr)) {
@@ -301,7 +309,23 @@ SITL::SerialDevice *SITL_State_Common::create_serial_sim(const char *name, const
 }
 
 /*
-  update simulators
+  leave the lock-step clock so the other instances stop waiting for
+  us straight away, rather than when they notice our process is gone,
+  and leave the shared world so they stop seeing our vehicle
+ */
+void SITL_State_Common::sim_detach(void)
+{
+#if AP_SIM_LOCKSTEP_ENABLED
+    lockstep.detach();
+#endif
+#if AP_SIM_SWARM_ENABLED
+    swarm.detach();
+#endif
+}
+
+/*
+  update simulators. These are polled on every physics frame, at any
+  speedup, and each one gates its own output on simulated time
  */
 void SITL_State_Common::sim_update(void)
 {
@@ -315,6 +339,11 @@ void SITL_State_Common::sim_update(void)
         adsb->update(*sitl_model);
     }
 #endif  // AP_SIM_ADSB_ENABLED
+#if AP_SIM_SWARM_ENABLED
+    if (swarm_link != nullptr) {
+        swarm_link->update(*sitl_model);
+    }
+#endif
 #if AP_SIM_VICON_ENABLED
     if (vicon != nullptr) {
         Quaternion attitude;
@@ -76,6 +76,10 @@ public:
     // name parameter
     SITL::SerialDevice *create_serial_sim(const char *name, const char *arg, const uint8_t portNumber);
 
+    // leave anything shared with other SITL instances, called when
+    // this instance exits or reboots
+    void sim_detach(void);
+
     // simulated airspeed, sonar and battery monitor
     float sonar_pin_voltage;    // pin 0
     float airspeed_pin_voltage[AIRSPEED_MAX_SENSORS]; // pin 1
@@ -171,6 +175,18 @@ public:
     SITL::JSON_Master ride_along;
 #endif
 
+#if AP_SIM_LOCKSTEP_ENABLED
+    // shared lock-step clock for multi-vehicle simulation
+    SITL::Lockstep lockstep;
+#endif
+
+#if AP_SIM_SWARM_ENABLED
+    // world shared with the other vehicles in lock-step
+    SITL::Swarm swarm;
+    // MAVLink traffic from the other vehicles in the world
+    SITL::SwarmLink *swarm_link;
+#endif
+
 #if AP_SIM_AIS_ENABLED
     // simulated AIS stream
     SITL::AIS *ais;
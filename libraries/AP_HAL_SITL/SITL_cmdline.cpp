@@ -82,7 +82,7 @@ void SITL_State::_usage(void)
            "\t--help|-h                display this help information\n"
            "\t--wipe|-w                wipe eeprom\n"
            "\t--unhide-groups|-u       parameter enumeration ignores AP_PARAM_FLAG_ENABLE\n"
-           "\t--speedup|-s SPEEDUP     set simulation speedup\n"
+           "\t--speedup|-s SPEEDUP     set simulation speedup, 0 for as fast as possible\n"
            "\t--rate|-r RATE           set SITL framerate\n"
            "\t--console|-C             use console instead of TCP ports\n"
            "\t--instance|-I N          set instance of SITL (adds 10*instance to all port numbers)\n"
@@ -117,6 +117,7 @@ void SITL_State::_usage(void)
            "\t--start-time TIMESTR     set simulation start time in UNIX timestamp\n"
            "\t--sysid ID               set MAV_SYSID\n"
            "\t--slave number           set the number of JSON slaves\n"
+           "\t--lockstep NUM[:NAME]    step time in lock-step with NUM instances sharing clock and world NAME\n"
         );
 }
 
@@ -244,6 +245,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     char *autotest_dir = nullptr;
     _fg_address = "127.0.0.1";
     const char* config = "";
+    const char *lockstep_str = nullptr;
 
     const int BASE_PORT = 5760;
     const int RCIN_PORT = 5501;
@@ -303,6 +305,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         CMDLINE_START_TIME,
         CMDLINE_SYSID,
         CMDLINE_SLAVE,
+        CMDLINE_LOCKSTEP,
 #if STORAGE_USE_FLASH
         CMDLINE_SET_STORAGE_FLASH_ENABLED,
 #endif
@@ -363,6 +366,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"start-time",      true,   0, CMDLINE_START_TIME},
         {"sysid",           true,   0, CMDLINE_SYSID},
         {"slave",           true,   0, CMDLINE_SLAVE},
+        {"lockstep",        true,   0, CMDLINE_LOCKSTEP},
 #if STORAGE_USE_FLASH
         {"set-storage-flash-enabled", true,   0, CMDLINE_SET_STORAGE_FLASH_ENABLED},
 #endif
@@ -572,6 +576,9 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
 #endif  // AP_SIM_JSON_MASTER_ENABLED
             break;
         }
+        case CMDLINE_LOCKSTEP:
+            lockstep_str = gopt.optarg;
+            break;
         default:
             _usage();
             exit(1);
@@ -624,6 +631,31 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         exit(1);
     }
 
+    if (lockstep_str != nullptr) {
+#if AP_SIM_LOCKSTEP_ENABLED
+        const int num_instances = atoi(lockstep_str);
+        const char *colon = strchr(lockstep_str, ':');
+        const char *lockstep_name = colon != nullptr ? colon+1 : "default";
+        if (num_instances < 1 || num_instances > SITL::Lockstep::MAX_INSTANCES ||
+            !lockstep.init(lockstep_name, num_instances, _instance)) {
+            printf("Failed to setup lockstep (%s)\n", lockstep_str);
+            exit(1);
+        }
+        sitl_model->set_lockstep(&lockstep);
+#if AP_SIM_SWARM_ENABLED
+        // vehicles in lock-step share a world
+        if (!swarm.init(lockstep_name, num_instances, _instance)) {
+            printf("Failed to setup swarm (%s)\n", lockstep_str);
+            exit(1);
+        }
+        sitl_model->set_swarm(&swarm);
+#endif
+#else
+        printf("Lockstep not supported on this platform\n");
+        exit(1);
+#endif
+    }
+
     if (storage_posix_enabled && storage_flash_enabled) {
         // this will change in the future!
         printf("Only one of flash or posix storage may be selected");
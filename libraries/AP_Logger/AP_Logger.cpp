@@ -961,13 +961,13 @@ void AP_Logger::Write_Fence()
 
 void AP_Logger::Write_NamedValueFloat(const char *name, float value)
 {
-    WriteStreaming(
+    LOGGER_WRITE_STREAMING(
         "NVF",
         "TimeUS,Name,Value",
         "s#-",
         "F--",
         "QNf",
-        AP_HAL::micros(),
+        AP_HAL::micros64(),
         name,
         value
         );
@@ -1070,6 +1070,38 @@ void AP_Logger::WriteV(const char *name, const char *labels, const char *units,
     }
 }
 
+void AP_Logger::WriteTyped(log_write_fmt *&f, const char *name, const char *labels, const char *units, const char *mults, const char *fmt,
+                           uint8_t *buffer, uint8_t size, bool is_critical, bool is_streaming)
+{
+#if APM_BUILD_TYPE(APM_BUILD_Replay)
+    // msg types are re-used in replay, see WriteV()
+    f = nullptr;
+#endif
+    if (f == nullptr) {
+        const bool direct_comp = APM_BUILD_TYPE(APM_BUILD_Replay);
+        log_write_fmt *f_for_name = msg_fmt_for_name(name, labels, units, mults, fmt, direct_comp);
+        if (f_for_name == nullptr) {
+#if !APM_BUILD_TYPE(APM_BUILD_Replay)
+            INTERNAL_ERROR(AP_InternalError::error_t::logger_mapfailure);
+#endif
+            return;
+        }
+        if (f_for_name->msg_len != size) {
+            // the sizes in AP_Logger_Typed.h don't match Write_calc_msg_len()
+            INTERNAL_ERROR(AP_InternalError::error_t::logger_logwrite_missingfmt);
+            return;
+        }
+        f = f_for_name;
+    }
+
+    buffer[0] = HEAD_BYTE1;
+    buffer[1] = HEAD_BYTE2;
+    buffer[2] = f->msg_type;
+    for (uint8_t i=0; i<_next_backend; i++) {
+        backends[i]->WritePrioritisedBlock(buffer, size, is_critical, is_streaming);
+    }
+}
+
 /*
   when we are doing replay logging we want to delay start of the EKF
   until after the headers are out so that on replay all parameter
@@ -190,6 +190,7 @@ class AP_Logger
 {
     friend class AP_Logger_Backend; // for _num_types
     friend class AP_Logger_RateLimiter;
+    friend class AP_Logger_Benchmark;
 
 public:
     FUNCTOR_TYPEDEF(vehicle_startup_message_Writer, void);
@@ -421,6 +422,11 @@ public:
     // output a FMT message for each backend if not already done so
     void Safe_Write_Emit_FMT(log_write_fmt *f);
 
+    // write a message packed by LOGGER_WRITE() in AP_Logger_Typed.h,
+    // looking up its msg type and caching it in f on the first call
+    void WriteTyped(log_write_fmt *&f, const char *name, const char *labels, const char *units, const char *mults, const char *fmt,
+                    uint8_t *buffer, uint8_t size, bool is_critical, bool is_streaming);
+
     // get count of number of times we have started logging
     uint8_t get_log_start_count(void) const {
         return _log_start_count;
@@ -639,9 +645,14 @@ namespace AP {
 #define LOGGER_WRITE_ERROR(subsys, err) AP::logger().Write_Error(subsys, err)
 #define LOGGER_WRITE_EVENT(evt) AP::logger().Write_Event(evt)
 
+#include "AP_Logger_Typed.h"
+
 #else
 
 #define LOGGER_WRITE_ERROR(subsys, err)
 #define LOGGER_WRITE_EVENT(evt)
+#define LOGGER_WRITE(name, labels, units, mults, fmt, ...)
+#define LOGGER_WRITE_STREAMING(name, labels, units, mults, fmt, ...)
+#define LOGGER_WRITE_CRITICAL(name, labels, units, mults, fmt, ...)
 
 #endif  // HAL_LOGGING_ENABLED
@@ -1057,6 +1057,11 @@ bool AP_Logger_File::io_thread_alive() const
     // disk.  Unfortunately these hardware devices do not obey our
     // SITL speedup options, so we allow for it here.
     SITL::SIM *sitl = AP::sitl();
+    if (sitl != nullptr && is_zero(sitl->speedup)) {
+        // running as fast as possible, so there is no bound on how
+        // far simulated time can get ahead of the disk
+        return true;
+    }
     if (sitl != nullptr && sitl->speedup > 0) {
         timeout_ms *= sitl->speedup;
     }
@@ -0,0 +1,189 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  typed version of AP_Logger::Write() for messages written at a high
+  rate:
+
+    LOGGER_WRITE("NVF", "TimeUS,Name,Value", "s#-", "F--", "QNf",
+                 AP_HAL::micros64(), name, value);
+
+  The name, labels, units, multipliers and format must be string
+  literals. They are checked against each other and against the
+  arguments at compile time, the message is packed at offsets fixed at
+  compile time and the message type is looked up on the first call
+  only, where Write() walks the list of formats and then packs the
+  arguments by parsing the format for each backend on every call.
+
+  This file is included by AP_Logger.h.
+ */
+
+#include <string.h>
+#include <type_traits>
+
+#include <AP_Common/float16.h>
+
+namespace AP_Logger_Typed {
+
+// size of the field for a format character, or zero if it is not one
+constexpr uint8_t field_size(char c)
+{
+    return (c == 'b' || c == 'B' || c == 'M') ? 1 :
+           (c == 'h' || c == 'H' || c == 'c' || c == 'C' || c == 'g') ? 2 :
+           (c == 'i' || c == 'I' || c == 'e' || c == 'E' || c == 'L' || c == 'f' || c == 'n') ? 4 :
+           (c == 'd' || c == 'q' || c == 'Q') ? 8 :
+           (c == 'N') ? 16 :
+           (c == 'Z' || c == 'a') ? 64 : 0;
+}
+
+constexpr bool fmt_valid(const char *fmt)
+{
+    return *fmt == '\0' || (field_size(*fmt) != 0 && fmt_valid(fmt + 1));
+}
+
+// size of the fields of a message, without the header
+constexpr uint16_t fields_size(const char *fmt)
+{
+    return *fmt == '\0' ? 0 : field_size(*fmt) + fields_size(fmt + 1);
+}
+
+constexpr uint8_t length(const char *s)
+{
+    return *s == '\0' ? 0 : 1 + length(s + 1);
+}
+
+constexpr uint8_t count_labels(const char *labels)
+{
+    return *labels == '\0' ? 1 : (*labels == ',' ? 1 : 0) + count_labels(labels + 1);
+}
+
+template <typename T>
+struct NumberField {
+    template <typename A>
+    static void pack(uint8_t *buf, A value) {
+        static_assert(std::is_arithmetic<A>::value || std::is_enum<A>::value, "log field needs a number");
+        const T tmp = T(value);
+        memcpy(buf, &tmp, sizeof(tmp));
+    }
+};
+
+struct Float16Field {
+    template <typename A>
+    static void pack(uint8_t *buf, A value) {
+        static_assert(std::is_arithmetic<A>::value, "log field needs a number");
+        Float16_t tmp;
+        tmp.set(value);
+        memcpy(buf, &tmp, sizeof(tmp));
+    }
+};
+
+template <uint8_t N>
+struct CharField {
+    static void pack(uint8_t *buf, const char *value) {
+        const uint8_t len = strnlen(value, N);
+        memcpy(buf, value, len);
+        memset(&buf[len], 0, N - len);
+    }
+};
+
+struct Int16ArrayField {
+    static void pack(uint8_t *buf, const int16_t *value) {
+        memcpy(buf, value, sizeof(int16_t[32]));
+    }
+};
+
+// the argument types for each format character, as in
+// AP_Logger_Backend::Write()
+template <char c> struct Field;
+template <> struct Field<'a'> : Int16ArrayField {};
+template <> struct Field<'b'> : NumberField<int8_t> {};
+template <> struct Field<'c'> : NumberField<int16_t> {};
+template <> struct Field<'d'> : NumberField<double> {};
+template <> struct Field<'e'> : NumberField<int32_t> {};
+template <> struct Field<'f'> : NumberField<float> {};
+template <> struct Field<'g'> : Float16Field {};
+template <> struct Field<'h'> : NumberField<int16_t> {};
+template <> struct Field<'i'> : NumberField<int32_t> {};
+template <> struct Field<'n'> : CharField<4> {};
+template <> struct Field<'B'> : NumberField<uint8_t> {};
+template <> struct Field<'C'> : NumberField<uint16_t> {};
+template <> struct Field<'E'> : NumberField<uint32_t> {};
+template <> struct Field<'H'> : NumberField<uint16_t> {};
+template <> struct Field<'I'> : NumberField<uint32_t> {};
+template <> struct Field<'L'> : NumberField<int32_t> {};
+template <> struct Field<'M'> : NumberField<uint8_t> {};
+template <> struct Field<'N'> : CharField<16> {};
+template <> struct Field<'Z'> : CharField<64> {};
+template <> struct Field<'q'> : NumberField<int64_t> {};
+template <> struct Field<'Q'> : NumberField<uint64_t> {};
+
+// pack the arguments from field I of the format onwards
+template <typename Spec, uint8_t I>
+struct Packer {
+    static void pack(uint8_t *) {}
+
+    template <typename A, typename... Args>
+    static void pack(uint8_t *buf, const A &value, const Args&... args) {
+        Field<Spec::fmt()[I]>::pack(buf, value);
+        Packer<Spec, I+1>::pack(buf + field_size(Spec::fmt()[I]), args...);
+    }
+};
+
+template <typename Spec, bool is_critical, bool is_streaming>
+struct Writer {
+    template <typename... Args>
+    static void write(const Args&... args) {
+        static_assert(length(Spec::name()) > 0 && length(Spec::name()) < LS_NAME_SIZE, "log name must be 1 to 4 characters");
+        static_assert(fmt_valid(Spec::fmt()), "unknown log format character");
+        static_assert(length(Spec::fmt()) < LS_FORMAT_SIZE, "too many log fields");
+        static_assert(length(Spec::labels()) < LS_LABELS_SIZE, "log labels too long");
+        static_assert(count_labels(Spec::labels()) == length(Spec::fmt()), "log labels do not match format");
+        static_assert(length(Spec::units()) == length(Spec::fmt()), "log units do not match format");
+        static_assert(length(Spec::mults()) == length(Spec::fmt()), "log multipliers do not match format");
+        static_assert(sizeof...(Args) == length(Spec::fmt()), "log arguments do not match format");
+        static_assert(LOG_PACKET_HEADER_LEN + fields_size(Spec::fmt()) <= LOG_PACKET_MAX_LEN, "log message too long");
+
+        constexpr uint8_t msg_len = LOG_PACKET_HEADER_LEN + fields_size(Spec::fmt());
+        uint8_t buffer[msg_len];
+        Packer<Spec, 0>::pack(&buffer[LOG_PACKET_HEADER_LEN], args...);
+
+        // one per call site, as Spec is declared by the macro
+        static AP_Logger::log_write_fmt *f;
+        AP::logger().WriteTyped(f, Spec::name(), Spec::labels(), Spec::units(), Spec::mults(), Spec::fmt(),
+                                buffer, msg_len, is_critical, is_streaming);
+    }
+};
+
+}  // namespace AP_Logger_Typed
+
+#define LOGGER_WRITE_TYPED(is_critical, is_streaming, name_, labels_, units_, mults_, fmt_, ...) \
+    do {                                                                \
+        struct LoggerWriteSpec {                                        \
+            static constexpr const char *name() { return name_; }       \
+            static constexpr const char *labels() { return labels_; }   \
+            static constexpr const char *units() { return units_; }     \
+            static constexpr const char *mults() { return mults_; }     \
+            static constexpr const char *fmt() { return fmt_; }         \
+        };                                                              \
+        AP_Logger_Typed::Writer<LoggerWriteSpec, is_critical, is_streaming>::write(__VA_ARGS__); \
+    } while (0)
+
+#define LOGGER_WRITE(name, labels, units, mults, fmt, ...) \
+    LOGGER_WRITE_TYPED(false, false, name, labels, units, mults, fmt, __VA_ARGS__)
+#define LOGGER_WRITE_STREAMING(name, labels, units, mults, fmt, ...) \
+    LOGGER_WRITE_TYPED(false, true, name, labels, units, mults, fmt, __VA_ARGS__)
+#define LOGGER_WRITE_CRITICAL(name, labels, units, mults, fmt, ...) \
+    LOGGER_WRITE_TYPED(true, false, name, labels, units, mults, fmt, __VA_ARGS__)
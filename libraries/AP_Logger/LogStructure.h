@@ -635,6 +635,19 @@ struct PACKED log_Scripting {
     uint32_t run_time;
     int32_t total_mem;
     int32_t run_mem;
+    uint32_t allocs;
+};
+
+struct PACKED log_ScriptingProfile {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    char name[16];
+    uint16_t func_line;
+    uint16_t line;
+    uint32_t samples;
+    uint32_t instructions;
+    uint32_t run_time;
+    uint32_t allocs;
 };
 
 struct PACKED log_MotBatt {
@@ -1135,6 +1148,18 @@ struct PACKED log_VER {
 // @Field: Runtime: run time
 // @Field: Total_mem: total memory usage of all scripts
 // @Field: Run_mem: run memory usage
+// @Field: Allocs: number of allocations made during the run
+
+// @LoggerMessage: SCRP
+// @Description: Scripting profiler hot spots, see SCR_PROF_RATE
+// @Field: TimeUS: Time since system startup
+// @Field: Name: script name
+// @Field: FLine: line the sampled function was defined on, 0 for the script's main chunk
+// @Field: Line: line being executed when sampled
+// @Field: Samples: total number of samples taken on this line
+// @Field: Insn: total VM instructions charged to this line
+// @Field: Runtime: total time charged to this line
+// @Field: Allocs: total allocations charged to this line
 
 // @LoggerMessage: VER
 // @Description: Ardupilot version
@@ -1284,7 +1309,9 @@ LOG_STRUCTURE_FROM_VISUALODOM \
       "FILE",   "NIBZ",       "FileName,Offset,Length,Data", "----", "----" }, \
 LOG_STRUCTURE_FROM_AIS \
     { LOG_SCRIPTING_MSG, sizeof(log_Scripting), \
-      "SCR",   "QNIii", "TimeUS,Name,Runtime,Total_mem,Run_mem", "s#sbb", "F-F--", true }, \
+      "SCR",   "QNIiiI", "TimeUS,Name,Runtime,Total_mem,Run_mem,Allocs", "s#sbb-", "F-F---", true }, \
+    { LOG_SCRIPTING_PROFILE_MSG, sizeof(log_ScriptingProfile), \
+      "SCRP",  "QNHHIIII", "TimeUS,Name,FLine,Line,Samples,Insn,Runtime,Allocs", "s#----s-", "F-----F-", true }, \
     { LOG_VER_MSG, sizeof(log_VER), \
       "VER",   "QBHBBBBIZHBBII", "TimeUS,BT,BST,Maj,Min,Pat,FWT,GH,FWS,APJ,BU,FV,IMI,ICI", "s-------------", "F-------------", false }, \
     { LOG_MOTBATT_MSG, sizeof(log_MotBatt), \
@@ -1372,6 +1399,7 @@ enum LogMessages : uint8_t {
     LOG_STAK_MSG,
     LOG_FILE_MSG,
     LOG_SCRIPTING_MSG,
+    LOG_SCRIPTING_PROFILE_MSG,
     LOG_VIDEO_STABILISATION_MSG,
     LOG_MOTBATT_MSG,
     LOG_VER_MSG,
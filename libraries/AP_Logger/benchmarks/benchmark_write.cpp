@@ -0,0 +1,97 @@
+#include <AP_gbenchmark.h>
+
+/*
+  cost of writing a message with its format given at the call site,
+  through AP_Logger::Write(), which finds the format by name and then
+  packs the arguments by parsing the format for each backend, and
+  through LOGGER_WRITE(). The backend discards the messages.
+ */
+
+#include <AP_Logger/AP_Logger.h>
+#include <AP_Logger/AP_Logger_Backend.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// number of other messages written with Write() ahead of the one being
+// benchmarked in the list of formats
+#define OTHER_FORMATS 40
+
+class AP_Logger_Null : public AP_Logger_Backend {
+public:
+    using AP_Logger_Backend::AP_Logger_Backend;
+
+    bool CardInserted(void) const override { return true; }
+    void EraseAll() override {}
+    uint16_t find_last_log() override { return 0; }
+    void get_log_boundaries(uint16_t list_entry, uint32_t & start_page, uint32_t & end_page) override {}
+    void get_log_info(uint16_t list_entry, uint32_t &size, uint32_t &time_utc) override {}
+    int16_t get_log_data(uint16_t list_entry, uint16_t page, uint32_t offset, uint16_t len, uint8_t *data) override { return 0; }
+    void end_log_transfer() override {}
+    uint16_t get_num_logs() override { return 0; }
+    bool logging_started(void) const override { return true; }
+    void Init() override {}
+    uint32_t bufferspace_available() override { return UINT32_MAX; }
+    void stop_logging(void) override {}
+    bool logging_failed() const override { return false; }
+
+protected:
+    bool WritesOK() const override { return true; }
+    bool _WritePrioritisedBlock(const void *pBuffer, uint16_t size, bool is_critical) override { return true; }
+};
+
+class AP_Logger_Benchmark {
+public:
+    static AP_Logger &get_logger() {
+        static AP_Logger logger;
+        static LoggerMessageWriter_DFLogStart writer;
+        static AP_Logger_Null backend{logger, &writer};
+        static char names[OTHER_FORMATS][LS_NAME_SIZE];
+        if (logger._next_backend == 0) {
+            logger.backends[logger._next_backend++] = &backend;
+            for (uint8_t i=0; i<OTHER_FORMATS; i++) {
+                snprintf(names[i], sizeof(names[i]), "X%03u", i);
+                logger.msg_fmt_for_name(names[i], "TimeUS,Value", "s-", "F-", "Qf");
+            }
+            // SITL checks the first 65535 blocks written
+            for (uint32_t i=0; i<65535; i++) {
+                LOGGER_WRITE("XWRM", "TimeUS", "s", "F", "Q", AP_HAL::micros64());
+            }
+        }
+        return logger;
+    }
+};
+
+static float rand_float()
+{
+    static uint32_t seed = 1;
+    seed = seed * 1103515245U + 12345U;
+    return ((seed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+// a message like the gimbal attitude logged by AP_Mount
+static void BM_Write(benchmark::State& state)
+{
+    AP_Logger &logger = AP_Logger_Benchmark::get_logger();
+    const float roll = rand_float(), pitch = rand_float(), yaw = rand_float();
+    while (state.KeepRunning()) {
+        logger.Write("BWR", "TimeUS,I,DesRoll,Roll,DesPitch,Pitch,DesYaw,Yaw,Name",
+                     "s#dddddd-", "F--------", "QBffffffN",
+                     AP_HAL::micros64(), uint8_t(0), roll, roll, pitch, pitch, yaw, yaw, "gimbal");
+    }
+}
+
+static void BM_WriteTyped(benchmark::State& state)
+{
+    AP_Logger_Benchmark::get_logger();
+    const float roll = rand_float(), pitch = rand_float(), yaw = rand_float();
+    while (state.KeepRunning()) {
+        LOGGER_WRITE("BWRT", "TimeUS,I,DesRoll,Roll,DesPitch,Pitch,DesYaw,Yaw,Name",
+                     "s#dddddd-", "F--------", "QBffffffN",
+                     AP_HAL::micros64(), uint8_t(0), roll, roll, pitch, pitch, yaw, yaw, "gimbal");
+    }
+}
+
+BENCHMARK(BM_Write);
+BENCHMARK(BM_WriteTyped);
+
+BENCHMARK_MAIN();
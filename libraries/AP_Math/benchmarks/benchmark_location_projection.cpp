@@ -0,0 +1,52 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Common/Location.h>
+#include <AP_Common/LocationProjection.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const uint16_t num_points = 256;
+
+static void make_points(const Location &origin, Location *locs)
+{
+    for (uint16_t i = 0; i < num_points; i++) {
+        locs[i] = origin;
+        locs[i].offset(((i * 37) % 200) * 10.0 - 1000.0, ((i * 53) % 200) * 10.0 - 1000.0);
+    }
+}
+
+static void BM_LocationDistanceNE(benchmark::State& state)
+{
+    const Location origin{-353632620, 1491652370, 0, Location::AltFrame::ABSOLUTE};
+    Location locs[num_points];
+    Vector2f ne[num_points];
+    make_points(origin, locs);
+
+    while (state.KeepRunning()) {
+        for (uint16_t i = 0; i < num_points; i++) {
+            ne[i] = origin.get_distance_NE(locs[i]);
+        }
+        gbenchmark_escape(ne);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * num_points);
+}
+
+static void BM_LocationProjectionNE(benchmark::State& state)
+{
+    const Location origin{-353632620, 1491652370, 0, Location::AltFrame::ABSOLUTE};
+    Location locs[num_points];
+    Vector2f ne[num_points];
+    make_points(origin, locs);
+    const LocationProjection projection{origin};
+
+    while (state.KeepRunning()) {
+        projection.get_distance_NE(locs, ne, num_points);
+        gbenchmark_escape(ne);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * num_points);
+}
+
+BENCHMARK(BM_LocationDistanceNE);
+BENCHMARK(BM_LocationProjectionNE);
+
+BENCHMARK_MAIN();
@@ -106,6 +106,7 @@ bool AP_MotorsMatrix::set_throttle_factor(int8_t motor_num, float throttle_facto
     }
 
     _throttle_factor[motor_num] = throttle_factor;
+    pack_motors();
     return true;
 }
 
@@ -156,29 +157,31 @@ void AP_MotorsMatrix::output_to_motors()
         }
         case SpoolState::GROUND_IDLE:
             // sends output to motors when armed but not flying
-            for (i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-                if (motor_enabled[i]) {
-                    set_actuator_with_slew(_actuator[i], actuator_spin_up_to_ground_idle());
-                }
+            for (i = 0; i < _packed.count; i++) {
+                set_actuator_with_slew(_actuator[_packed.motor[i]], actuator_spin_up_to_ground_idle());
             }
             break;
         case SpoolState::SPOOLING_UP:
         case SpoolState::THROTTLE_UNLIMITED:
-        case SpoolState::SPOOLING_DOWN:
-            // set motor output based on thrust requests
-            for (i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-                if (motor_enabled[i]) {
-                    set_actuator_with_slew(_actuator[i], thr_lin.thrust_to_actuator(_thrust_rpyt_out[i]));
-                }
+        case SpoolState::SPOOLING_DOWN: {
+            // set motor output based on thrust requests, with the thrust
+            // curve applied to all the motors at once
+            float actuator[AP_MOTORS_MAX_NUM_MOTORS];
+            for (i = 0; i < _packed.count; i++) {
+                actuator[i] = _thrust_rpyt_out[_packed.motor[i]];
+            }
+            thr_lin.thrust_to_actuator(actuator, actuator, _packed.count);
+            for (i = 0; i < _packed.count; i++) {
+                set_actuator_with_slew(_actuator[_packed.motor[i]], actuator[i]);
             }
             break;
+        }
     }
 
     // convert output to PWM and send to each motor
-    for (i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            rc_write(i, output_to_pwm(_actuator[i]));
-        }
+    for (i = 0; i < _packed.count; i++) {
+        const uint8_t motor = _packed.motor[i];
+        rc_write(motor, output_to_pwm(_actuator[motor]));
     }
 }
 
@@ -271,29 +274,40 @@ void AP_MotorsMatrix::output_armed_stabilizing()
     // Octo-Quad (x8) + : MOT_YAW_HEADROOM = 300, ATC_RAT_RLL_IMAX = 0.5,   ATC_RAT_PIT_IMAX = 0.5,   ATC_RAT_YAW_IMAX = 0.25
     // Quads cannot make use of motor loss handling because it doesn't have enough degrees of freedom.
 
+    // the packed index of the lost motor, excluded from the calculation if thrust boost is enabled
+    uint8_t lost = _packed.count;
+    if (_thrust_boost) {
+        for (uint8_t i = 0; i < _packed.count; i++) {
+            if (_packed.motor[i] == _motor_lost_index) {
+                lost = i;
+            }
+        }
+    }
+
+    // combined roll, pitch, yaw and throttle outputs of the packed motors
+    float thrust_rpyt_out[AP_MOTORS_MAX_NUM_MOTORS];
+
     // calculate amount of yaw we can fit into the throttle range
     // this is always equal to or less than the requested yaw from the pilot or rate controller
     float yaw_allowed = 1.0f; // amount of yaw we can fit in
-    for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            // calculate the thrust outputs for roll and pitch
-            _thrust_rpyt_out[i] = roll_thrust * _roll_factor[i] + pitch_thrust * _pitch_factor[i];
-
-            // Check the maximum yaw control that can be used on this channel
-            // Exclude any lost motors if thrust boost is enabled
-            if (!is_zero(_yaw_factor[i]) && (!_thrust_boost || i != _motor_lost_index)) {
-                const float thrust_rp_best_throttle = throttle_thrust_best_rpy + _thrust_rpyt_out[i];
-                float motor_room;
-                if (is_positive(yaw_thrust * _yaw_factor[i])) {
-                    // room to upper limit
-                    motor_room = 1.0 - thrust_rp_best_throttle;
-                } else {
-                    // room to lower limit
-                    motor_room = thrust_rp_best_throttle;
-                }
-                const float motor_yaw_allowed = MAX(motor_room, 0.0)/fabsf(_yaw_factor[i]);
-                yaw_allowed = MIN(yaw_allowed, motor_yaw_allowed);
+    for (uint8_t i = 0; i < _packed.count; i++) {
+        // calculate the thrust outputs for roll and pitch
+        thrust_rpyt_out[i] = roll_thrust * _packed.roll[i] + pitch_thrust * _packed.pitch[i];
+
+        // Check the maximum yaw control that can be used on this channel
+        // Exclude any lost motors if thrust boost is enabled
+        if (!is_zero(_packed.yaw[i]) && i != lost) {
+            const float thrust_rp_best_throttle = throttle_thrust_best_rpy + thrust_rpyt_out[i];
+            float motor_room;
+            if (is_positive(yaw_thrust * _packed.yaw[i])) {
+                // room to upper limit
+                motor_room = 1.0 - thrust_rp_best_throttle;
+            } else {
+                // room to lower limit
+                motor_room = thrust_rp_best_throttle;
             }
+            const float motor_yaw_allowed = MAX(motor_room, 0.0)/fabsf(_packed.yaw[i]);
+            yaw_allowed = MIN(yaw_allowed, motor_yaw_allowed);
         }
     }
 
@@ -308,18 +322,18 @@ void AP_MotorsMatrix::output_armed_stabilizing()
     yaw_allowed = MAX(yaw_allowed, yaw_allowed_min);
 
     // Include the lost motor scaled by _thrust_boost_ratio to smoothly transition this motor in and out of the calculation
-    if (_thrust_boost && motor_enabled[_motor_lost_index]) {
+    if (lost < _packed.count) {
         // Check the maximum yaw control that can be used on this channel
         // Exclude any lost motors if thrust boost is enabled
-        if (!is_zero(_yaw_factor[_motor_lost_index])){
-            const float thrust_rp_best_throttle = throttle_thrust_best_rpy + _thrust_rpyt_out[_motor_lost_index];
+        if (!is_zero(_packed.yaw[lost])){
+            const float thrust_rp_best_throttle = throttle_thrust_best_rpy + thrust_rpyt_out[lost];
             float motor_room;
-            if (is_positive(yaw_thrust * _yaw_factor[_motor_lost_index])) {
+            if (is_positive(yaw_thrust * _packed.yaw[lost])) {
                 motor_room = 1.0 - thrust_rp_best_throttle;
             } else {
                 motor_room = thrust_rp_best_throttle;
             }
-            const float motor_yaw_allowed = MAX(motor_room, 0.0)/fabsf(_yaw_factor[_motor_lost_index]);
+            const float motor_yaw_allowed = MAX(motor_room, 0.0)/fabsf(_packed.yaw[lost]);
             yaw_allowed = boost_ratio(yaw_allowed, MIN(yaw_allowed, motor_yaw_allowed));
         }
     }
@@ -333,26 +347,24 @@ void AP_MotorsMatrix::output_armed_stabilizing()
     // add yaw control to thrust outputs
     float rpy_low = 1.0f;   // lowest thrust value
     float rpy_high = -1.0f; // highest thrust value
-    for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            _thrust_rpyt_out[i] = _thrust_rpyt_out[i] + yaw_thrust * _yaw_factor[i];
+    for (uint8_t i = 0; i < _packed.count; i++) {
+        thrust_rpyt_out[i] = thrust_rpyt_out[i] + yaw_thrust * _packed.yaw[i];
 
-            // record lowest roll + pitch + yaw command
-            if (_thrust_rpyt_out[i] < rpy_low) {
-                rpy_low = _thrust_rpyt_out[i];
-            }
-            // record highest roll + pitch + yaw command
-            // Exclude any lost motors if thrust boost is enabled
-            if (_thrust_rpyt_out[i] > rpy_high && (!_thrust_boost || i != _motor_lost_index)) {
-                rpy_high = _thrust_rpyt_out[i];
-            }
+        // record lowest roll + pitch + yaw command
+        if (thrust_rpyt_out[i] < rpy_low) {
+            rpy_low = thrust_rpyt_out[i];
+        }
+        // record highest roll + pitch + yaw command
+        // Exclude any lost motors if thrust boost is enabled
+        if (thrust_rpyt_out[i] > rpy_high && i != lost) {
+            rpy_high = thrust_rpyt_out[i];
         }
     }
     // Include the lost motor scaled by _thrust_boost_ratio to smoothly transition this motor in and out of the calculation
-    if (_thrust_boost) {
+    if (lost < _packed.count) {
         // record highest roll + pitch + yaw command
-        if (_thrust_rpyt_out[_motor_lost_index] > rpy_high && motor_enabled[_motor_lost_index]) {
-            rpy_high = boost_ratio(rpy_high, _thrust_rpyt_out[_motor_lost_index]);
+        if (thrust_rpyt_out[lost] > rpy_high) {
+            rpy_high = boost_ratio(rpy_high, thrust_rpyt_out[lost]);
         }
     }
 
@@ -389,10 +401,11 @@ void AP_MotorsMatrix::output_armed_stabilizing()
 
     // add scaled roll, pitch, constrained yaw and throttle for each motor
     const float throttle_thrust_best_plus_adj = throttle_thrust_best_rpy + thr_adj;
-    for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            _thrust_rpyt_out[i] = (throttle_thrust_best_plus_adj * _throttle_factor[i]) + (rpy_scale * _thrust_rpyt_out[i]);
-        }
+    for (uint8_t i = 0; i < _packed.count; i++) {
+        thrust_rpyt_out[i] = (throttle_thrust_best_plus_adj * _packed.throttle[i]) + (rpy_scale * thrust_rpyt_out[i]);
+    }
+    for (uint8_t i = 0; i < _packed.count; i++) {
+        _thrust_rpyt_out[_packed.motor[i]] = thrust_rpyt_out[i];
     }
 
     // determine throttle thrust for harmonic notch
@@ -415,26 +428,19 @@ void AP_MotorsMatrix::check_for_failed_motor(float throttle_thrust_best_plus_adj
 {
     // record filtered and scaled thrust output for motor loss monitoring purposes
     float alpha = _dt_s / (_dt_s + 0.5f);
-    for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            _thrust_rpyt_out_filt[i] += alpha * (_thrust_rpyt_out[i] - _thrust_rpyt_out_filt[i]);
-        }
-    }
-
     float rpyt_high = 0.0f;
     float rpyt_sum = 0.0f;
-    uint8_t number_motors = 0.0f;
-    for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            number_motors += 1;
-            rpyt_sum += _thrust_rpyt_out_filt[i];
-            // record highest filtered thrust command
-            if (_thrust_rpyt_out_filt[i] > rpyt_high) {
-                rpyt_high = _thrust_rpyt_out_filt[i];
-                // hold motor lost index constant while thrust boost is active
-                if (!_thrust_boost) {
-                    _motor_lost_index = i;
-                }
+    const uint8_t number_motors = _packed.count;
+    for (uint8_t j = 0; j < number_motors; j++) {
+        const uint8_t i = _packed.motor[j];
+        _thrust_rpyt_out_filt[i] += alpha * (_thrust_rpyt_out[i] - _thrust_rpyt_out_filt[i]);
+        rpyt_sum += _thrust_rpyt_out_filt[i];
+        // record highest filtered thrust command
+        if (_thrust_rpyt_out_filt[i] > rpyt_high) {
+            rpyt_high = _thrust_rpyt_out_filt[i];
+            // hold motor lost index constant while thrust boost is active
+            if (!_thrust_boost) {
+                _motor_lost_index = i;
             }
         }
     }
@@ -524,6 +530,8 @@ void AP_MotorsMatrix::add_motor_raw(int8_t motor_num, float roll_fac, float pitc
 
         // call parent class method
         add_motor_num(motor_num);
+
+        pack_motors();
     }
 }
 
@@ -555,6 +563,7 @@ void AP_MotorsMatrix::remove_motor(int8_t motor_num)
         _pitch_factor[motor_num] = 0.0f;
         _yaw_factor[motor_num] = 0.0f;
         _throttle_factor[motor_num] = 0.0f;
+        pack_motors();
     }
 }
 
@@ -1384,6 +1393,25 @@ void AP_MotorsMatrix::normalise_rpy_factors()
             }
         }
     }
+
+    pack_motors();
+}
+
+// packs the factors of the enabled motors together for the mixer
+void AP_MotorsMatrix::pack_motors()
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (motor_enabled[i]) {
+            _packed.roll[count] = _roll_factor[i];
+            _packed.pitch[count] = _pitch_factor[i];
+            _packed.yaw[count] = _yaw_factor[i];
+            _packed.throttle[count] = _throttle_factor[i];
+            _packed.motor[count] = i;
+            count++;
+        }
+    }
+    _packed.count = count;
 }
 
 
@@ -1408,6 +1436,7 @@ void AP_MotorsMatrix::disable_yaw_torque(void)
     for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
         _yaw_factor[i] = 0;
     }
+    pack_motors();
 }
 
 #if APM_BUILD_TYPE(APM_BUILD_UNKNOWN)
@@ -127,6 +127,10 @@ protected:
     // normalizes the roll, pitch and yaw factors so maximum magnitude is 0.5
     void                normalise_rpy_factors();
 
+    // packs the factors of the enabled motors together for the mixer,
+    // must be called whenever the enabled motors or their factors change
+    void                pack_motors();
+
     // call vehicle supplied thrust compensation if set
     void                thrust_compensation(void) override;
 
@@ -145,6 +149,17 @@ protected:
     float               _thrust_rpyt_out[AP_MOTORS_MAX_NUM_MOTORS]; // combined roll, pitch, yaw and throttle outputs to motors in 0~1 range
     uint8_t             _test_order[AP_MOTORS_MAX_NUM_MOTORS];  // order of the motors in the test sequence
 
+    // the enabled motors packed together in motor number order, so the
+    // mixer only runs over the motors in use
+    struct {
+        float           roll[AP_MOTORS_MAX_NUM_MOTORS];
+        float           pitch[AP_MOTORS_MAX_NUM_MOTORS];
+        float           yaw[AP_MOTORS_MAX_NUM_MOTORS];
+        float           throttle[AP_MOTORS_MAX_NUM_MOTORS];
+        uint8_t         motor[AP_MOTORS_MAX_NUM_MOTORS];    // motor number of each packed motor
+        uint8_t         count;
+    } _packed;
+
     // motor failure handling
     float               _thrust_rpyt_out_filt[AP_MOTORS_MAX_NUM_MOTORS];    // filtered thrust outputs with 1 second time constant
     uint8_t             _motor_lost_index;  // index number of the lost motor
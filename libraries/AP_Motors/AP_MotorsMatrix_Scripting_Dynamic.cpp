@@ -52,6 +52,8 @@ void AP_MotorsMatrix_Scripting_Dynamic::load_factors(const factor_table &new_tab
     memcpy(_yaw_factor,new_table.yaw,sizeof(_yaw_factor));
     memcpy(_throttle_factor,new_table.throttle,sizeof(_throttle_factor));
 
+    pack_motors();
+
 #if debug_print
     hal.console->printf("Got new factors:\n");
     for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
@@ -110,6 +112,8 @@ bool AP_MotorsMatrix_Scripting_Dynamic::init(uint8_t expected_num_motors)
             _mav_type = MAV_TYPE_GENERIC;
     }
 
+    pack_motors();
+
     set_update_rate(_speed_hz);
 
     return true;
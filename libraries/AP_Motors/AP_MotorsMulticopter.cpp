@@ -222,7 +222,7 @@ const AP_Param::GroupInfo AP_MotorsMulticopter::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Motor options
     // @Description: Motor options
-    // @Bitmask: 0:Voltage compensation uses raw voltage
+    // @Bitmask: 0:Voltage compensation uses raw voltage, 1:Thrust curve from lookup table
     // @User: Advanced
     AP_GROUPINFO("OPTIONS", 43, AP_MotorsMulticopter, _options, 0),
 
@@ -264,6 +264,11 @@ void AP_MotorsMulticopter::output()
     // calc filtered battery voltage and lift_max
     thr_lin.update_lift_max_from_batt_voltage();
 
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+    // rebuild the thrust curve lookup table if the expo has changed
+    thr_lin.update_curve_lut();
+#endif
+
     // run spool logic
     output_logic();
 
@@ -283,7 +283,8 @@ public:
 #endif
 
     enum MotorOptions : uint8_t {
-        BATT_RAW_VOLTAGE = (1 << 0U)
+        BATT_RAW_VOLTAGE = (1 << 0U),
+        THRUST_CURVE_LUT = (1 << 1U),
     };
     bool has_option(MotorOptions option) { return _options.get() & uint8_t(option); }
 
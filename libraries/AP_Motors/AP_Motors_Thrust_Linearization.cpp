@@ -103,8 +103,58 @@ Thrust_Linearization::Thrust_Linearization(AP_Motors& _motors) :
 // converts desired thrust to linearized actuator output in a range of 0~1
 float Thrust_Linearization::thrust_to_actuator(float thrust_in) const
 {
-    thrust_in = constrain_float(thrust_in, 0.0, 1.0);
-    return spin_min + (spin_max - spin_min) * apply_thrust_curve_and_volt_scaling(thrust_in);
+    float actuator;
+    thrust_to_actuator(&thrust_in, &actuator, 1);
+    return actuator;
+}
+
+// converts the desired thrust of count motors to linearized actuator outputs
+// the thrust curve is the same as apply_thrust_curve_and_volt_scaling(), with
+// the terms which are the same for every motor worked out once
+void Thrust_Linearization::thrust_to_actuator(const float *thrust_in, float *actuator, uint8_t count) const
+{
+    float battery_scale = 1.0f;
+    if (is_positive(batt_voltage_filt.get())) {
+        battery_scale = 1.0f / batt_voltage_filt.get();
+    }
+    const float actuator_min = spin_min;
+    const float actuator_range = spin_max - spin_min;
+    const float thrust_curve_expo = constrain_float(curve_expo, -1.0f, 1.0f);
+
+    if (is_zero(thrust_curve_expo)) {
+        // zero expo means linear, avoid floating point exception for small values
+        for (uint8_t i = 0; i < count; i++) {
+            const float thrust = constrain_float(thrust_in[i], 0.0f, 1.0f);
+            actuator[i] = actuator_min + actuator_range * (lift_max * thrust * battery_scale);
+        }
+        return;
+    }
+
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+    if (use_curve_lut) {
+        // interpolate the table, which lift_max * thrust covers as lift_max is at most 1
+        const float lut_scale = lift_max * AP_MOTORS_THRUST_CURVE_LUT_SIZE;
+        for (uint8_t i = 0; i < count; i++) {
+            const float pos = constrain_float(thrust_in[i] * lut_scale, 0.0f, AP_MOTORS_THRUST_CURVE_LUT_SIZE);
+            const uint16_t idx = MIN(uint16_t(pos), AP_MOTORS_THRUST_CURVE_LUT_SIZE - 1);
+            const float throttle_ratio = curve_lut[idx] + (pos - idx) * (curve_lut[idx + 1] - curve_lut[idx]);
+            actuator[i] = actuator_min + actuator_range * constrain_float(throttle_ratio * battery_scale, 0.0f, 1.0f);
+        }
+        return;
+    }
+#endif
+
+    // apply thrust curve - domain -1.0 to 1.0, range -1.0 to 1.0
+    const float curve_offset = thrust_curve_expo - 1.0f;
+    const float curve_sq = (1.0f - thrust_curve_expo) * (1.0f - thrust_curve_expo);
+    const float curve_gain = 4.0f * thrust_curve_expo * lift_max;
+    const float curve_div = 2.0f * thrust_curve_expo;
+    for (uint8_t i = 0; i < count; i++) {
+        const float thrust = constrain_float(thrust_in[i], 0.0f, 1.0f);
+        // the same as safe_sqrt(), without a branch on the result
+        const float throttle_ratio = (curve_offset + sqrtf(MAX(curve_sq + curve_gain * thrust, 0.0f))) / curve_div;
+        actuator[i] = actuator_min + actuator_range * constrain_float(throttle_ratio * battery_scale, 0.0f, 1.0f);
+    }
 }
 
 // inverse of above, tested with AP_Motors/examples/expo_inverse_test
@@ -185,6 +235,55 @@ void Thrust_Linearization::update_lift_max_from_batt_voltage()
 #endif
 }
 
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+/*
+  rebuild the thrust curve lookup table when the expo changes. The
+  table is only used if interpolating it is accurate to within
+  AP_MOTORS_THRUST_CURVE_LUT_MAX_ERROR, which rules out expos close to
+  1 or -1 where the curve is steepest
+ */
+void Thrust_Linearization::update_curve_lut()
+{
+    use_curve_lut = false;
+    const float thrust_curve_expo = constrain_float(curve_expo, -1.0f, 1.0f);
+    if (!motors.has_option(AP_Motors::MotorOptions::THRUST_CURVE_LUT) || is_zero(thrust_curve_expo)) {
+        // the linear curve is as quick as the table
+        return;
+    }
+
+    // the curve is (curve_offset + sqrt(curve_sq + curve_gain * x)) / curve_div where x = lift_max * thrust
+    const float curve_offset = thrust_curve_expo - 1.0f;
+    const float curve_sq = (1.0f - thrust_curve_expo) * (1.0f - thrust_curve_expo);
+    const float curve_gain = 4.0f * thrust_curve_expo;
+    const float curve_div = 2.0f * thrust_curve_expo;
+
+    if (!is_equal(thrust_curve_expo, curve_lut_expo)) {
+        for (uint16_t i = 0; i <= AP_MOTORS_THRUST_CURVE_LUT_SIZE; i++) {
+            const float x = float(i) / AP_MOTORS_THRUST_CURVE_LUT_SIZE;
+            curve_lut[i] = (curve_offset + safe_sqrt(curve_sq + curve_gain * x)) / curve_div;
+        }
+
+        // the slope of the curve is 1 / sqrt(curve_sq + curve_gain * x), so the
+        // error of each segment is largest where that equals the slope of the segment
+        curve_lut_error = 0.0f;
+        for (uint16_t i = 0; i < AP_MOTORS_THRUST_CURVE_LUT_SIZE; i++) {
+            const float slope = (curve_lut[i + 1] - curve_lut[i]) * AP_MOTORS_THRUST_CURVE_LUT_SIZE;
+            if (!is_positive(slope)) {
+                continue;
+            }
+            const float x0 = float(i) / AP_MOTORS_THRUST_CURVE_LUT_SIZE;
+            const float x1 = float(i + 1) / AP_MOTORS_THRUST_CURVE_LUT_SIZE;
+            const float x = constrain_float((1.0f / sq(slope) - curve_sq) / curve_gain, x0, x1);
+            const float curve = (curve_offset + safe_sqrt(curve_sq + curve_gain * x)) / curve_div;
+            curve_lut_error = MAX(curve_lut_error, fabsf(curve - (curve_lut[i] + slope * (x - x0))));
+        }
+        curve_lut_expo = thrust_curve_expo;
+    }
+
+    use_curve_lut = curve_lut_error <= AP_MOTORS_THRUST_CURVE_LUT_MAX_ERROR;
+}
+#endif // AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+
 // return gain scheduling gain based on voltage and air density
 float Thrust_Linearization::get_compensation_gain() const
 {
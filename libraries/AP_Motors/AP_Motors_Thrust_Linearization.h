@@ -2,11 +2,18 @@
 
 #include <AP_Param/AP_Param.h>
 #include <Filter/LowPassFilter.h>
+#include "AP_Motors_config.h"
+
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+#define AP_MOTORS_THRUST_CURVE_LUT_SIZE         128     // number of segments in the thrust curve lookup table
+#define AP_MOTORS_THRUST_CURVE_LUT_MAX_ERROR    0.001f  // lookup table is only used if its error is below this
+#endif
 
 class AP_Motors;
 class Thrust_Linearization {
 friend class AP_MotorsMulticopter;
 friend class AP_MotorsMulticopter_test;
+friend class AP_MotorsMatrix_test;
 friend class AP_MotorsHeli_Single;
 public:
     Thrust_Linearization(AP_Motors& _motors);
@@ -20,12 +27,20 @@ public:
     // Converts desired thrust to linearized actuator output in a range of 0~1
     float thrust_to_actuator(float thrust_in) const;
 
+    // Converts the desired thrust of a number of motors, thrust_in and actuator may be the same array
+    void thrust_to_actuator(const float *thrust_in, float *actuator, uint8_t count) const;
+
     // Inverse of above
     float actuator_to_thrust(float actuator) const;
 
     // Update_lift_max_from_batt_voltage - used for voltage compensation
     void update_lift_max_from_batt_voltage();
 
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+    // rebuild the thrust curve lookup table when the expo changes
+    void update_curve_lut();
+#endif
+
     // return gain scheduling gain based on voltage and air density
     float get_compensation_gain() const;
 
@@ -60,5 +75,13 @@ private:
     float               throttle_limit;    // ratio of throttle limit between hover and maximum
     LowPassFilterFloat  batt_voltage_filt; // filtered battery voltage expressed as a percentage (0 ~ 1.0) of batt_voltage_max
 
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+    // thrust curve without voltage scaling, sampled over lift_max * thrust
+    float               curve_lut[AP_MOTORS_THRUST_CURVE_LUT_SIZE + 1];
+    float               curve_lut_expo;    // expo the table was built for, zero if there is no table
+    float               curve_lut_error;   // largest error of interpolating the table
+    bool                use_curve_lut;     // true if the table is selected and accurate enough
+#endif
+
     AP_Motors& motors;
 };
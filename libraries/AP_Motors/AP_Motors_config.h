@@ -64,3 +64,8 @@
 #ifndef AP_MOTORS_FRAME_OCTAQUAD_COROTATING_SCALE_FACTOR
 #define AP_MOTORS_FRAME_OCTAQUAD_COROTATING_SCALE_FACTOR 0.9
 #endif
+
+// lookup table for the thrust curve, selected with MOT_OPTIONS
+#ifndef AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+#define AP_MOTORS_THRUST_CURVE_LUT_ENABLED 1
+#endif
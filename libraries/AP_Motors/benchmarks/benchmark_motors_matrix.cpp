@@ -0,0 +1,101 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Motors/AP_MotorsMatrix.h>
+#include <SRV_Channel/SRV_Channel.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static SRV_Channels srvs;
+
+/*
+  the work done by the matrix mixer each loop: mixing the roll, pitch,
+  yaw and throttle inputs, and the thrust curve for each motor. The
+  argument is the frame class, all with the X frame type
+ */
+class AP_MotorsMatrix_test : public AP_MotorsMatrix {
+public:
+    AP_MotorsMatrix_test() : AP_MotorsMatrix(400) {
+        _dt_s = 1.0f / 400.0f;
+        _throttle_thrust_max = 1.0f;
+        set_throttle_avg_max(0.5f);
+        thr_lin.spin_min.set(0.15f);
+        thr_lin.spin_max.set(0.95f);
+        thr_lin.curve_expo.set(0.65f);
+        _spool_state = SpoolState::THROTTLE_UNLIMITED;
+    }
+
+    void setup(motor_frame_class frame_class, bool use_lut) {
+        if (frame_class != _active_frame_class) {
+            _active_frame_class = frame_class;
+            _active_frame_type = MOTOR_FRAME_TYPE_X;
+            setup_motors(frame_class, MOTOR_FRAME_TYPE_X);
+        }
+        _options.set(use_lut ? AP_Motors::MotorOptions::THRUST_CURVE_LUT : 0);
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+        thr_lin.update_curve_lut();
+#endif
+    }
+
+    void mix(float roll, float pitch, float yaw, float throttle) {
+        set_roll(roll);
+        set_pitch(pitch);
+        set_yaw(yaw);
+        _throttle_filter.reset(throttle);
+        output_armed_stabilizing();
+    }
+
+    void output() {
+        output_to_motors();
+    }
+};
+
+static AP_MotorsMatrix_test motors;
+
+static void run(benchmark::State &state, bool output, bool use_lut)
+{
+    motors.setup(AP_Motors::motor_frame_class(state.range(0)), use_lut);
+    uint32_t count = 0;
+    while (state.KeepRunning()) {
+        // vary the inputs so some loops saturate the motors
+        const float in = (count++ % 64) * (1.0f / 32.0f) - 1.0f;
+        motors.mix(0.3f * in, -0.2f * in, 0.5f * in, 0.5f + 0.4f * in);
+        if (output) {
+            motors.output();
+        }
+        gbenchmark_escape(&motors);
+    }
+}
+
+static void BM_Mix(benchmark::State &state)
+{
+    run(state, false, false);
+}
+
+static void BM_MixAndOutput(benchmark::State &state)
+{
+    run(state, true, false);
+}
+
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+static void BM_MixAndOutputLUT(benchmark::State &state)
+{
+    run(state, true, true);
+}
+#endif
+
+static void frame_classes(benchmark::internal::Benchmark *b)
+{
+    b->Arg(AP_Motors::MOTOR_FRAME_QUAD);
+    b->Arg(AP_Motors::MOTOR_FRAME_HEXA);
+    b->Arg(AP_Motors::MOTOR_FRAME_OCTA);
+    b->Arg(AP_Motors::MOTOR_FRAME_OCTAQUAD);
+    b->Arg(AP_Motors::MOTOR_FRAME_DODECAHEXA);
+}
+
+BENCHMARK(BM_Mix)->Apply(frame_classes);
+BENCHMARK(BM_MixAndOutput)->Apply(frame_classes);
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+BENCHMARK(BM_MixAndOutputLUT)->Apply(frame_classes);
+#endif
+
+BENCHMARK_MAIN();
@@ -0,0 +1,405 @@
+#include <AP_gtest.h>
+
+/*
+  tests for the AP_MotorsMatrix mixer and the thrust curve. The mixer
+  is compared with the mixer as it was before the enabled motors were
+  packed together, for every frame class and type the matrix supports
+ */
+
+#include <AP_Motors/AP_MotorsMatrix.h>
+#include <SRV_Channel/SRV_Channel.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static SRV_Channels srvs;
+
+class AP_MotorsMatrix_test : public AP_MotorsMatrix {
+public:
+    AP_MotorsMatrix_test() : AP_MotorsMatrix(400) {
+        _dt_s = 1.0f / 400.0f;
+        _throttle_thrust_max = 1.0f;
+        set_throttle_avg_max(0.5f);
+        thr_lin.spin_min.set(0.15f);
+        thr_lin.spin_max.set(0.95f);
+        set_thrust_curve(0.65f, 1.0f, 1.0f, false);
+    }
+
+    // setup the thrust curve, with lift_max and the battery voltage as
+    // if they came from voltage compensation
+    void set_thrust_curve(float expo, float lift_max, float batt_voltage, bool use_lut) {
+        thr_lin.curve_expo.set(expo);
+        thr_lin.lift_max = lift_max;
+        thr_lin.batt_voltage_filt.reset(batt_voltage);
+        _options.set(use_lut ? AP_Motors::MotorOptions::THRUST_CURVE_LUT : 0);
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+        thr_lin.update_curve_lut();
+#endif
+    }
+
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+    bool using_curve_lut() const { return thr_lin.use_curve_lut; }
+    float curve_lut_error() const { return thr_lin.curve_lut_error; }
+#endif
+
+    // setup the motors without changing the output rate
+    bool setup(motor_frame_class frame_class, motor_frame_type frame_type) {
+        _active_frame_class = frame_class;
+        _active_frame_type = frame_type;
+        setup_motors(frame_class, frame_type);
+        for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            _thrust_rpyt_out_filt[i] = 0.0f;
+        }
+        _motor_lost_index = 0;
+        _thrust_balanced = true;
+        return initialised_ok();
+    }
+
+    void set_inputs(float roll, float pitch, float yaw, float throttle, bool boost) {
+        set_roll(roll);
+        set_pitch(pitch);
+        set_yaw(yaw);
+        _throttle_filter.reset(throttle);
+        _thrust_boost = boost;
+        _thrust_boost_ratio = boost ? 0.5f : 0.0f;
+    }
+
+    // the mixer state after output_armed_stabilizing()
+    struct State {
+        float thrust_rpyt_out[AP_MOTORS_MAX_NUM_MOTORS];
+        float thrust_rpyt_out_filt[AP_MOTORS_MAX_NUM_MOTORS];
+        uint8_t motor_lost_index;
+        bool thrust_balanced;
+        bool thrust_boost;
+        float throttle_out;
+        AP_Motors_limit limit;
+    };
+
+    void mix(State &s) {
+        limit.set_all(false);
+        output_armed_stabilizing();
+        save(s);
+    }
+
+    // the mixer before the enabled motors were packed together
+    void reference_mix(State &s) {
+        save(s);
+        s.limit.set_all(false);
+
+        const float compensation_gain = thr_lin.get_compensation_gain();
+        const float roll_thrust = (_roll_in + _roll_in_ff) * compensation_gain;
+        const float pitch_thrust = (_pitch_in + _pitch_in_ff) * compensation_gain;
+        float yaw_thrust = (_yaw_in + _yaw_in_ff) * compensation_gain;
+        float throttle_thrust = get_throttle() * compensation_gain;
+        float throttle_avg_max = _throttle_avg_max * compensation_gain;
+        const float throttle_thrust_max = ref_boost_ratio(1.0, _throttle_thrust_max * compensation_gain);
+
+        if (throttle_thrust <= 0.0f) {
+            throttle_thrust = 0.0f;
+            s.limit.throttle_lower = true;
+        }
+        if (throttle_thrust >= throttle_thrust_max) {
+            throttle_thrust = throttle_thrust_max;
+            s.limit.throttle_upper = true;
+        }
+        throttle_avg_max = constrain_float(throttle_avg_max, throttle_thrust, throttle_thrust_max);
+        float throttle_thrust_best_rpy = MIN(0.5f, throttle_avg_max);
+
+        float *out = s.thrust_rpyt_out;
+        float yaw_allowed = 1.0f;
+        for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (motor_enabled[i]) {
+                out[i] = roll_thrust * _roll_factor[i] + pitch_thrust * _pitch_factor[i];
+                if (!is_zero(_yaw_factor[i]) && (!_thrust_boost || i != s.motor_lost_index)) {
+                    const float thrust_rp_best_throttle = throttle_thrust_best_rpy + out[i];
+                    float motor_room;
+                    if (is_positive(yaw_thrust * _yaw_factor[i])) {
+                        motor_room = 1.0 - thrust_rp_best_throttle;
+                    } else {
+                        motor_room = thrust_rp_best_throttle;
+                    }
+                    const float motor_yaw_allowed = MAX(motor_room, 0.0)/fabsf(_yaw_factor[i]);
+                    yaw_allowed = MIN(yaw_allowed, motor_yaw_allowed);
+                }
+            }
+        }
+
+        float yaw_allowed_min = (float)_yaw_headroom * 0.001f;
+        yaw_allowed_min = ref_boost_ratio(0.5, yaw_allowed_min);
+        yaw_allowed = MAX(yaw_allowed, yaw_allowed_min);
+
+        const uint8_t lost = s.motor_lost_index;
+        if (_thrust_boost && motor_enabled[lost]) {
+            if (!is_zero(_yaw_factor[lost])){
+                const float thrust_rp_best_throttle = throttle_thrust_best_rpy + out[lost];
+                float motor_room;
+                if (is_positive(yaw_thrust * _yaw_factor[lost])) {
+                    motor_room = 1.0 - thrust_rp_best_throttle;
+                } else {
+                    motor_room = thrust_rp_best_throttle;
+                }
+                const float motor_yaw_allowed = MAX(motor_room, 0.0)/fabsf(_yaw_factor[lost]);
+                yaw_allowed = ref_boost_ratio(yaw_allowed, MIN(yaw_allowed, motor_yaw_allowed));
+            }
+        }
+
+        if (fabsf(yaw_thrust) > yaw_allowed) {
+            yaw_thrust = constrain_float(yaw_thrust, -yaw_allowed, yaw_allowed);
+            s.limit.yaw = true;
+        }
+
+        float rpy_low = 1.0f;
+        float rpy_high = -1.0f;
+        for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (motor_enabled[i]) {
+                out[i] = out[i] + yaw_thrust * _yaw_factor[i];
+                if (out[i] < rpy_low) {
+                    rpy_low = out[i];
+                }
+                if (out[i] > rpy_high && (!_thrust_boost || i != lost)) {
+                    rpy_high = out[i];
+                }
+            }
+        }
+        if (_thrust_boost) {
+            if (out[lost] > rpy_high && motor_enabled[lost]) {
+                rpy_high = ref_boost_ratio(rpy_high, out[lost]);
+            }
+        }
+
+        float rpy_scale = 1.0f;
+        if (rpy_high - rpy_low > 1.0f) {
+            rpy_scale = 1.0f / (rpy_high - rpy_low);
+        }
+        if (throttle_avg_max + rpy_low < 0) {
+            rpy_scale = MIN(rpy_scale, -throttle_avg_max / rpy_low);
+        }
+
+        rpy_high *= rpy_scale;
+        rpy_low *= rpy_scale;
+        throttle_thrust_best_rpy = -rpy_low;
+        float thr_adj = throttle_thrust - throttle_thrust_best_rpy;
+        if (rpy_scale < 1.0f) {
+            s.limit.set_rpy(true);
+            if (thr_adj > 0.0f) {
+                s.limit.throttle_upper = true;
+            }
+            thr_adj = 0.0f;
+        } else if (thr_adj < 0.0f) {
+            thr_adj = 0.0f;
+        } else if (thr_adj > 1.0f - (throttle_thrust_best_rpy + rpy_high)) {
+            thr_adj = 1.0f - (throttle_thrust_best_rpy + rpy_high);
+            s.limit.throttle_upper = true;
+        }
+
+        const float throttle_thrust_best_plus_adj = throttle_thrust_best_rpy + thr_adj;
+        for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (motor_enabled[i]) {
+                out[i] = (throttle_thrust_best_plus_adj * _throttle_factor[i]) + (rpy_scale * out[i]);
+            }
+        }
+        s.throttle_out = throttle_thrust_best_plus_adj / compensation_gain;
+
+        // check_for_failed_motor()
+        float *filt = s.thrust_rpyt_out_filt;
+        float alpha = _dt_s / (_dt_s + 0.5f);
+        for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (motor_enabled[i]) {
+                filt[i] += alpha * (out[i] - filt[i]);
+            }
+        }
+        float rpyt_high = 0.0f;
+        float rpyt_sum = 0.0f;
+        uint8_t number_motors = 0.0f;
+        for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (motor_enabled[i]) {
+                number_motors += 1;
+                rpyt_sum += filt[i];
+                if (filt[i] > rpyt_high) {
+                    rpyt_high = filt[i];
+                    if (!_thrust_boost) {
+                        s.motor_lost_index = i;
+                    }
+                }
+            }
+        }
+        float thrust_balance = 1.0f;
+        if (rpyt_sum > 0.1f) {
+            thrust_balance = rpyt_high * number_motors / rpyt_sum;
+        }
+        const bool is_corotating = _active_frame_type == MOTOR_FRAME_TYPE_X_COR ||
+                                   _active_frame_type == MOTOR_FRAME_TYPE_CW_X_COR;
+        if (number_motors >= 6 && thrust_balance >= 1.5f && s.thrust_balanced && !is_corotating) {
+            s.thrust_balanced = false;
+        }
+        if (thrust_balance <= 1.25f && !s.thrust_balanced) {
+            s.thrust_balanced = true;
+        }
+        if ((_throttle_thrust_max * thr_lin.get_compensation_gain() > throttle_thrust_best_plus_adj) && (rpyt_high < 0.9f) && s.thrust_balanced) {
+            s.thrust_boost = false;
+        }
+    }
+
+    bool enabled(uint8_t i) const { return motor_enabled[i]; }
+    float thrust(uint8_t i) const { return _thrust_rpyt_out[i]; }
+
+    // write the mixer output to the motors, as output() does
+    void output_unlimited(float *actuator) {
+        _spool_state = SpoolState::THROTTLE_UNLIMITED;
+        output_to_motors();
+        memcpy(actuator, _actuator, sizeof(_actuator));
+    }
+
+    Thrust_Linearization &get_thr_lin() { return thr_lin; }
+
+private:
+    void save(State &s) const {
+        memcpy(s.thrust_rpyt_out, _thrust_rpyt_out, sizeof(s.thrust_rpyt_out));
+        memcpy(s.thrust_rpyt_out_filt, _thrust_rpyt_out_filt, sizeof(s.thrust_rpyt_out_filt));
+        s.motor_lost_index = _motor_lost_index;
+        s.thrust_balanced = _thrust_balanced;
+        s.thrust_boost = _thrust_boost;
+        s.throttle_out = _throttle_out;
+        s.limit = limit;
+    }
+
+    float ref_boost_ratio(float boost_value, float normal_value) const {
+        return _thrust_boost_ratio * boost_value + (1.0 - _thrust_boost_ratio) * normal_value;
+    }
+};
+
+static AP_MotorsMatrix_test motors;
+
+static const AP_Motors::motor_frame_class frame_classes[] {
+    AP_Motors::MOTOR_FRAME_QUAD,
+    AP_Motors::MOTOR_FRAME_HEXA,
+    AP_Motors::MOTOR_FRAME_OCTA,
+    AP_Motors::MOTOR_FRAME_OCTAQUAD,
+    AP_Motors::MOTOR_FRAME_Y6,
+    AP_Motors::MOTOR_FRAME_DODECAHEXA,
+    AP_Motors::MOTOR_FRAME_DECA,
+};
+
+static const float rpy_tests[] { -1.0f, -0.45f, -0.1f, 0.0f, 0.2f, 0.6f, 1.0f };
+static const float throttle_tests[] { 0.0f, 0.05f, 0.3f, 0.5f, 0.8f, 1.0f };
+
+TEST(AP_MotorsMatrix, MixerMatchesReference)
+{
+    uint16_t frames = 0;
+    for (const auto frame_class : frame_classes) {
+        for (uint8_t t = AP_Motors::MOTOR_FRAME_TYPE_PLUS; t <= AP_Motors::MOTOR_FRAME_TYPE_CW_X_COR; t++) {
+            const auto frame_type = AP_Motors::motor_frame_type(t);
+            if (!motors.setup(frame_class, frame_type)) {
+                continue;
+            }
+            frames++;
+            char frame_string[30];
+            motors.get_frame_and_type_string(frame_string, ARRAY_SIZE(frame_string));
+            SCOPED_TRACE(frame_string);
+            // the filtered outputs, lost motor and thrust boost carry
+            // on from one mix to the next
+            for (uint8_t boost = 0; boost < 2; boost++) {
+                for (const float roll : rpy_tests) {
+                    for (const float pitch : rpy_tests) {
+                        for (const float yaw : rpy_tests) {
+                            for (const float throttle : throttle_tests) {
+                                motors.set_inputs(roll, pitch, yaw, throttle, boost);
+                                AP_MotorsMatrix_test::State expected, state;
+                                motors.reference_mix(expected);
+                                motors.mix(state);
+                                for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+                                    if (motors.enabled(i)) {
+                                        ASSERT_EQ(expected.thrust_rpyt_out[i], state.thrust_rpyt_out[i]);
+                                        ASSERT_EQ(expected.thrust_rpyt_out_filt[i], state.thrust_rpyt_out_filt[i]);
+                                    }
+                                }
+                                ASSERT_EQ(expected.motor_lost_index, state.motor_lost_index);
+                                ASSERT_EQ(expected.thrust_balanced, state.thrust_balanced);
+                                ASSERT_EQ(expected.thrust_boost, state.thrust_boost);
+                                ASSERT_EQ(expected.throttle_out, state.throttle_out);
+                                ASSERT_EQ(expected.limit.roll, state.limit.roll);
+                                ASSERT_EQ(expected.limit.pitch, state.limit.pitch);
+                                ASSERT_EQ(expected.limit.yaw, state.limit.yaw);
+                                ASSERT_EQ(expected.limit.throttle_lower, state.limit.throttle_lower);
+                                ASSERT_EQ(expected.limit.throttle_upper, state.limit.throttle_upper);
+                            }
+                        }
+                    }
+                }
+            }
+
+            // the motors are driven from the thrust curve of each output
+            float actuator[AP_MOTORS_MAX_NUM_MOTORS];
+            motors.output_unlimited(actuator);
+            for (uint8_t i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
+                if (motors.enabled(i)) {
+                    EXPECT_EQ(motors.get_thr_lin().thrust_to_actuator(motors.thrust(i)), actuator[i]);
+                }
+            }
+        }
+    }
+    // every frame class has at least a plus or an X type
+    EXPECT_GE(frames, ARRAY_SIZE(frame_classes));
+}
+
+static const float thrust_tests[] { -0.1f, 0.0f, 1.0e-6f, 0.001f, 0.01f, 0.1f, 0.25f, 0.5f, 0.75f, 0.99f, 1.0f, 1.1f };
+
+/*
+  the thrust curve applied to many motors at once is the same as for
+  each motor on its own
+ */
+TEST(AP_MotorsMatrix, ThrustCurve)
+{
+    Thrust_Linearization &thr_lin = motors.get_thr_lin();
+    const float spin_min = thr_lin.get_spin_min();
+    const float spin_range = thr_lin.get_spin_max() - spin_min;
+    for (const float expo : { -1.0f, -0.5f, 0.0f, 0.3f, 0.65f, 0.9f, 1.0f }) {
+        for (const float batt_voltage : { 1.0f, 0.8f }) {
+            // lift_max as update_lift_max_from_batt_voltage() would set it
+            const float lift_max = batt_voltage * (1 - expo) + expo * batt_voltage * batt_voltage;
+            motors.set_thrust_curve(expo, lift_max, batt_voltage, false);
+            float actuator[ARRAY_SIZE(thrust_tests)];
+            thr_lin.thrust_to_actuator(thrust_tests, actuator, ARRAY_SIZE(thrust_tests));
+            for (uint8_t i = 0; i < ARRAY_SIZE(thrust_tests); i++) {
+                const float thrust = constrain_float(thrust_tests[i], 0.0f, 1.0f);
+                EXPECT_EQ(spin_min + spin_range * thr_lin.apply_thrust_curve_and_volt_scaling(thrust), actuator[i]);
+                EXPECT_EQ(actuator[i], thr_lin.thrust_to_actuator(thrust_tests[i]));
+            }
+        }
+    }
+}
+
+#if AP_MOTORS_THRUST_CURVE_LUT_ENABLED
+/*
+  the thrust curve lookup table is within its error of the thrust
+  curve, and is not used when it can't be accurate enough
+ */
+TEST(AP_MotorsMatrix, ThrustCurveLUT)
+{
+    Thrust_Linearization &thr_lin = motors.get_thr_lin();
+    const float spin_range = thr_lin.get_spin_max() - thr_lin.get_spin_min();
+    for (const float expo : { -1.0f, -0.5f, 0.0f, 0.3f, 0.65f, 0.75f, 0.9f, 1.0f }) {
+        for (const float batt_voltage : { 1.0f, 0.8f }) {
+            const float lift_max = batt_voltage * (1 - expo) + expo * batt_voltage * batt_voltage;
+            motors.set_thrust_curve(expo, lift_max, batt_voltage, true);
+            if (is_zero(expo) || fabsf(expo) > 0.8f) {
+                EXPECT_FALSE(motors.using_curve_lut());
+                continue;
+            }
+            ASSERT_TRUE(motors.using_curve_lut());
+            EXPECT_LE(motors.curve_lut_error(), AP_MOTORS_THRUST_CURVE_LUT_MAX_ERROR);
+            // the error of the table is scaled by voltage compensation
+            const float tolerance = spin_range * motors.curve_lut_error() / batt_voltage + 1.0e-6f;
+            for (uint16_t i = 0; i <= 1000; i++) {
+                const float thrust = i * 0.001f;
+                const float actuator = thr_lin.thrust_to_actuator(thrust);
+                motors.set_thrust_curve(expo, lift_max, batt_voltage, false);
+                EXPECT_NEAR(thr_lin.thrust_to_actuator(thrust), actuator, tolerance);
+                motors.set_thrust_curve(expo, lift_max, batt_voltage, true);
+            }
+        }
+    }
+    motors.set_thrust_curve(0.65f, 1.0f, 1.0f, false);
+}
+#endif
+
+AP_GTEST_MAIN()
@@ -20,6 +20,17 @@
 #include <AP_Math/AP_Math.h>
 #include <AP_Math/vectorN.h>
 #include "AP_Nav_Common.h"
+#include <AP_NavEKF3/AP_NavEKF3_feature.h>
+
+/*
+  where EKF3 cores may be updated on worker threads each thread has
+  its own scratch space
+ */
+#if EK3_FEATURE_PARALLEL_CORES
+#define EKF_SCRATCH_STORAGE thread_local
+#else
+#define EKF_SCRATCH_STORAGE
+#endif
 
 /*
   this declares a common parent class for AP_NavEKF2 and
@@ -42,8 +53,8 @@ public:
 #endif
 
 protected:
-    static Matrix24 KHP;                  // intermediate result used for covariance updates
-    static Vector28 Kfusion;              // intermediate fusion vector
+    static EKF_SCRATCH_STORAGE Matrix24 KHP;        // intermediate result used for covariance updates
+    static EKF_SCRATCH_STORAGE Vector28 Kfusion;    // intermediate fusion vector
 
     // fill all the common scratch variables with NaN on SITL
     void fill_scratch_variables(void);
@@ -72,27 +72,28 @@ private:
     Vector3F delta_velocity;
     ftype angle_dt;
     ftype velocity_dt;
+    // The AHRS and EKF states for the bank of models are stored with the model index last, eg R[row][col][mdl_idx],
+    // so that each step of the prediction and update runs across all of the models in one loop.
     struct ahrs_struct {
-        Matrix3F R;             // matrix that rotates a vector from body to earth frame
-        Vector3F gyro_bias;     // gyro bias learned and used by the quaternion calculation
-        bool aligned;           // true when AHRS has been aligned
-        ftype accel_FR[2];      // front-right acceleration vector in a horizontal plane (m/s/s)
-        ftype vel_NE[2];        // NE velocity vector from last GPS measurement (m/s)
-        bool fuse_gps;          // true when GPS should be fused on that frame
-        ftype accel_dt;         // time step used when generating _simple_accel_FR data (sec)
+        ftype R[3][3][N_MODELS_EKFGSF];         // matrices that rotate a vector from body to earth frame
+        ftype gyro_bias[3][N_MODELS_EKFGSF];    // gyro bias learned and used by the quaternion calculation
     };
-    ahrs_struct AHRS[N_MODELS_EKFGSF];
+    ahrs_struct AHRS;
     bool ahrs_tilt_aligned;         // true the initial tilt alignment has been calculated
     ftype accel_gain;               // gain from accel vector tilt error to rate gyro correction used by AHRS calculation
     Vector3F ahrs_accel;            // filtered body frame specific force vector used by AHRS calculation (m/s/s)
     ftype ahrs_accel_norm;          // length of body frame specific force vector used by AHRS calculation (m/s/s)
     ftype true_airspeed;            // true airspeed used to correct for centripetal acceleratoin in coordinated turns (m/s)
 
-    // Runs quaternion prediction for the selected AHRS using IMU (and optionally true airspeed) data
-    void predictAHRS(const uint8_t mdl_idx);
+    // Runs quaternion prediction for all AHRS using IMU (and optionally true airspeed) data
+    void predictAHRS();
 
-    // Applies a body frame delta angle to a body to earth frame rotation matrix using a small angle approximation
-    Matrix3F updateRotMat(const Matrix3F &R, const Vector3F &g) const;
+    // Applies a body frame delta angle to each body to earth frame rotation matrix using a small angle approximation
+    void updateRotMat(const ftype g[3][N_MODELS_EKFGSF]);
+
+    // Get and set the body to earth frame rotation matrix for the selected AHRS
+    Matrix3F getRotMat(const uint8_t mdl_idx) const;
+    void setRotMat(const uint8_t mdl_idx, const Matrix3F &R);
 
     // Initialises the tilt (roll and pitch) for all AHRS using IMU acceleration data
     void alignTilt();
@@ -103,27 +104,27 @@ private:
     // The Following declarations are used by bank of EKF's that estimate yaw angle starting from a different yaw hypothesis for each filter.
 
     struct EKF_struct {
-        ftype X[3];     // Vel North (m/s),  Vel East (m/s), yaw (rad)
-        ftype P[3][3];  // covariance matrix
-        ftype S[2][2];  // N,E velocity innovation variance (m/s)^2
-        ftype innov[2]; // Velocity N,E innovation (m/s)
+        ftype X[3][N_MODELS_EKFGSF];        // Vel North (m/s),  Vel East (m/s), yaw (rad)
+        ftype P[3][3][N_MODELS_EKFGSF];     // covariance matrix
+        ftype S[2][2][N_MODELS_EKFGSF];     // N,E velocity innovation variance (m/s)^2
+        ftype innov[2][N_MODELS_EKFGSF];    // Velocity N,E innovation (m/s)
     };
-    EKF_struct EKF[N_MODELS_EKFGSF];
+    EKF_struct EKF;
     bool vel_fuse_running;  // true when the bank of EKF's has started fusing GPS velocity data
     bool run_ekf_gsf;       // true when operating condition is suitable for to run the GSF and EKF models and fuse velocity data
 
     // Resets states and covariances for the EKF's and GSF including GSF weights, but not the AHRS complementary filters
     void resetEKFGSF();
 
-    // Runs the state and covariance prediction for the selected EKF
-    void predict(const uint8_t mdl_idx);
+    // Runs the AHRS prediction and the state and covariance prediction for all EKF's
+    void predict();
 
-    // Runs the state and covariance update for the selected EKF using the GPS NE velocity measurement
-    // Returns false if the sttae and covariance correction failed
-    bool correct(const uint8_t mdl_idx, const Vector2F &vel, const ftype velObsVar);
+    // Runs the state and covariance update for all EKF's using the GPS NE velocity measurement
+    // Returns false if the state and covariance correction failed for any EKF
+    bool correct(const Vector2F &vel, const ftype velObsVar);
 
-    // Forces symmetry on the covariance matrix for the selected EKF
-    void forceSymmetry(const uint8_t mdl_idx);
+    // Forces symmetry on the covariance matrix for all EKF's
+    void forceSymmetry();
 
     // The following declarations are used  by the Gaussian Sum Filter that combines the state estimates from the bank of
     // EKF's to form a single state estimate.
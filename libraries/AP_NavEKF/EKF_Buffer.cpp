@@ -45,6 +45,58 @@ uint32_t ekf_ring_buffer::time_ms(uint8_t idx) const
     return el->time_ms;
 }
 
+/*
+  return the number of elements, starting from the oldest, which have
+  a timestamp at or before sample_time_ms. These are the elements
+  recall() consumes.
+*/
+uint8_t ekf_ring_buffer::count_due(const uint32_t sample_time_ms) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    const int32_t dt_oldest = sample_time_ms - time_ms(oldest);
+    if (dt_oldest < 0) {
+        // nothing is due yet, this is the common case
+        return 0;
+    }
+    const int32_t dt_newest = sample_time_ms - time_ms(index_after_oldest(count-1));
+    if (ordered && dt_oldest >= dt_newest) {
+        /*
+          the ages decrease monotonically from oldest to newest, so
+          the due elements are a prefix which can be found by
+          bisection
+         */
+        if (dt_newest >= 0) {
+            return count;
+        }
+        // element lo is due, element hi is not
+        uint8_t lo = 0;
+        uint8_t hi = count-1;
+        while (hi - lo > 1) {
+            const uint8_t mid = (lo + hi) / 2;
+            const int32_t dt = sample_time_ms - time_ms(index_after_oldest(mid));
+            if (dt >= 0) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        return hi;
+    }
+
+    // timestamps out of order, scan until the first element which is not due
+    uint8_t n = 1;
+    while (n < count) {
+        const int32_t dt = sample_time_ms - time_ms(index_after_oldest(n));
+        if (dt < 0) {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
 /*
   Search through a ring buffer and return the newest data that is
   older than the time specified by sample_time_ms
@@ -52,30 +104,44 @@ uint32_t ekf_ring_buffer::time_ms(uint8_t idx) const
 */
 bool ekf_ring_buffer::recall(void *element, const uint32_t sample_time_ms)
 {
+    const uint8_t due = count_due(sample_time_ms);
+    if (due == 0) {
+        return false;
+    }
+
+    // all due elements are discarded, the newest of them is used if
+    // it is recent enough
     bool ret = false;
-    uint8_t best_index = 0;  // only valid when ret becomes true
-    while (count > 0) {
-        const uint32_t toldest = time_ms(oldest);
-        const int32_t dt = sample_time_ms - toldest;
-        const bool matches = dt >= 0 && dt < 100;
-        if (matches) {
-            best_index = oldest;
+    uint8_t best_index = 0;
+    if (ordered) {
+        // the newest due element is also the youngest
+        const uint8_t idx = index_after_oldest(due-1);
+        const int32_t dt = sample_time_ms - time_ms(idx);
+        if (dt < 100) {
+            best_index = idx;
             ret = true;
         }
-        if (dt < 0) {
-            // the oldest element is younger than we want, stop
-            // searching and don't consume this element
-            break;
+    } else {
+        for (uint8_t i=0; i<due; i++) {
+            const uint8_t idx = index_after_oldest(i);
+            const int32_t dt = sample_time_ms - time_ms(idx);
+            if (dt < 100) {
+                best_index = idx;
+                ret = true;
+            }
         }
-        // discard the sample
-        count--;
-        oldest = (oldest+1) % size;
     }
 
     if (ret) {
         memcpy(element, get_offset(best_index), elsize);
     }
 
+    oldest = index_after_oldest(due);
+    count -= due;
+    if (count == 0) {
+        ordered = true;
+    }
+
     return ret;
 }
 
@@ -89,8 +155,22 @@ void ekf_ring_buffer::push(const void *element)
         return;
     }
 
+    if (count > 0) {
+        /*
+          keep track of whether timestamps are in order. Steps are
+          limited so the whole buffer spans well under half the
+          32 bit range, which keeps the signed age comparisons in
+          recall() valid
+         */
+        const uint32_t newest_ms = time_ms(index_after_oldest(count-1));
+        const uint32_t step_ms = ((const EKF_obs_element_t *)element)->time_ms - newest_ms;
+        if (step_ms >= (1U<<22)) {
+            ordered = false;
+        }
+    }
+
     // Advance head to next available index
-    const uint8_t head = (oldest+count) % size;
+    const uint8_t head = index_after_oldest(count);
 
     // New data is written at the head
     memcpy(get_offset(head), element, elsize);
@@ -98,7 +178,7 @@ void ekf_ring_buffer::push(const void *element)
     if (count < size) {
         count++;
     } else {
-        oldest = (oldest+1) % size;
+        oldest = index_after_oldest(1);
     }
 }
 
@@ -108,6 +188,7 @@ void ekf_ring_buffer::reset()
 {
     count = 0;
     oldest = 0;
+    ordered = true;
 }
 
 ////////////////////////////////////////////////////
@@ -52,8 +52,22 @@ private:
     // total number of elements in the buffer
     uint8_t count;
 
+    // true when the timestamps from oldest to newest are known to be
+    // in order, allowing recall to find its element without a scan
+    bool ordered;
+
     uint32_t time_ms(uint8_t idx) const;
     void *get_offset(uint8_t idx) const;
+
+    // index of the element n places after the oldest
+    uint8_t index_after_oldest(uint8_t n) const {
+        const uint16_t idx = uint16_t(oldest) + n;
+        return idx >= size ? idx - size : idx;
+    }
+
+    // number of elements, starting from the oldest, which are not
+    // younger than sample_time_ms
+    uint8_t count_due(const uint32_t sample_time_ms) const;
 };
 
 /*
@@ -0,0 +1,62 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_NavEKF/EKFGSF_yaw.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  the yaw estimator work done for each EKF3 core: an update every IMU
+  sample at 400Hz and, for the update benchmark, velocity fusion every
+  40 samples. The yaw estimator is running, so both the AHRS and the
+  EKF's of the model bank are updated
+ */
+static EKFGSF_yaw &setup_gsf()
+{
+    static EKFGSF_yaw gsf;
+    static bool done;
+    if (!done) {
+        const ftype dt = 0.0025;
+        const Vector3F delVel{0.0f, 0.0f, -GRAVITY_MSS * dt};
+        const Vector3F delAng{0.0f, 0.0f, 0.0f};
+        for (uint16_t i=0; i<400; i++) {
+            gsf.update(delAng, delVel, dt, dt, true, 0);
+            if (i % 40 == 0) {
+                gsf.fuseVelData(Vector2F{5.0f, 2.0f}, 0.3f);
+            }
+        }
+        done = true;
+    }
+    return gsf;
+}
+
+static void BM_EKFGSF_Update(benchmark::State& state)
+{
+    EKFGSF_yaw &gsf = setup_gsf();
+    const ftype dt = 0.0025;
+    const Vector3F delVel{0.01f * dt, 0.02f * dt, -GRAVITY_MSS * dt};
+    const Vector3F delAng{0.001f * dt, -0.001f * dt, 0.05f * dt};
+    uint32_t count = 0;
+
+    while (state.KeepRunning()) {
+        gsf.update(delAng, delVel, dt, dt, true, 0);
+        if (++count % 40 == 0) {
+            gsf.fuseVelData(Vector2F{5.0f, 2.0f}, 0.3f);
+        }
+        gbenchmark_escape(&gsf);
+    }
+}
+
+static void BM_EKFGSF_FuseVelData(benchmark::State& state)
+{
+    EKFGSF_yaw &gsf = setup_gsf();
+
+    while (state.KeepRunning()) {
+        gsf.fuseVelData(Vector2F{5.0f, 2.0f}, 0.3f);
+        gbenchmark_escape(&gsf);
+    }
+}
+
+BENCHMARK(BM_EKFGSF_Update);
+BENCHMARK(BM_EKFGSF_FuseVelData);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,60 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_NavEKF/EKF_Buffer.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+struct bench_element : EKF_obs_element_t {
+    float data[6];
+};
+
+/*
+  typical EKF usage: a sensor pushing at 10ms intervals and the
+  fusion horizon trailing 100ms behind, recalled every IMU update
+ */
+static void BM_RingBufferRecall(benchmark::State& state)
+{
+    EKF_obs_buffer_t<bench_element> buf;
+    buf.init(state.range(0));
+    bench_element e {};
+    uint32_t now_ms = 0;
+
+    while (state.KeepRunning()) {
+        now_ms += 2;
+        if (now_ms % 10 == 0) {
+            e.time_ms = now_ms;
+            buf.push(e);
+        }
+        bench_element out;
+        bool ret = buf.recall(out, now_ms - 100);
+        gbenchmark_escape(&ret);
+        gbenchmark_escape(&out);
+    }
+}
+
+// recall after the buffer has been left to fill, e.g. while a sensor was not being fused
+static void BM_RingBufferRecallFull(benchmark::State& state)
+{
+    EKF_obs_buffer_t<bench_element> buf;
+    const uint8_t size = state.range(0);
+    buf.init(size);
+    bench_element e {};
+    uint32_t now_ms = 0;
+
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<size; i++) {
+            e.time_ms = now_ms;
+            now_ms += 10;
+            buf.push(e);
+        }
+        bench_element out;
+        bool ret = buf.recall(out, now_ms - 50);
+        gbenchmark_escape(&ret);
+        gbenchmark_escape(&out);
+    }
+}
+
+BENCHMARK(BM_RingBufferRecall)->Arg(8)->Arg(32)->Arg(64);
+BENCHMARK(BM_RingBufferRecallFull)->Arg(8)->Arg(32)->Arg(64);
+
+BENCHMARK_MAIN();
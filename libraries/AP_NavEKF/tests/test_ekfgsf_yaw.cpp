@@ -0,0 +1,106 @@
+#include <AP_gtest.h>
+
+/*
+  tests for AP_NavEKF/EKFGSF_yaw.cpp
+
+  The expected values were produced by the model bank before it was
+  stored as arrays across the models, so the yaw estimates must match
+  them to rounding
+ */
+
+#include <AP_NavEKF/EKFGSF_yaw.h>
+
+#include <AP_HAL/AP_HAL.h>
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+
+static uint32_t seed = 1;
+static double noise()
+{
+    seed = seed * 1103515245U + 12345U;
+    return ((seed >> 8) & 0xFFFF) / 65536.0 - 0.5;
+}
+
+static const struct {
+    uint32_t step;
+    double yaw;
+    double yaw_variance;
+    uint8_t n_clips;
+    double vel_innov_length;
+} expected[] = {
+    {  1999, 1.0376285267909988, 3.5854013599470038, 0, 0.065918018045624388 },
+    {  3999, 0.87189766490300624, 0.0086167161785746498, 1, 0.68923610429919735 },
+    {  5999, 0.81178223589613474, 0.0077519918471917176, 1, 1.3752678195293968 },
+    {  7999, 0.38003585335004952, 0.0053686002536469995, 1, 1.0682020011904119 },
+    {  9999, 0.44400806410561888, 0.0013356737534965745, 2, 0.67658649673591054 },
+    { 11999, 0.087052857683557514, 0.0013525436381994981, 1, 1.0140301089234862 },
+    { 13999, 0.1806122992992342, 0.0011251475137226592, 1, 0.77958899014503669 },
+    { 15999, 1.0483175650824181, 0.13873276856925484, 1, 0.69987944519673395 },
+    { 17999, 1.6421781914023081, 0.0010431974801946133, 4, 0.88565501378556322 },
+    { 19999, 0.97028294210683352, 0.001039630502402336, 1, 0.62465044488479882 },
+    { 21999, 1.7286513257584379, 0.00094529487526472469, 4, 0.06940459118982778 },
+    { 23999, 1.2345266879661805, 0.0012568499221346733, 0, 0.44949519176901687 },
+    { 25999, 1.3075007556660316, 0.0017408307818153452, 0, 0.64413003377176636 },
+    { 27999, 1.9284623212212231, 0.0015128964319963683, 0, 0.5351113291891616 },
+    { 29999, 1.5152152939759087, 0.0011080959212933926, 1, 0.47108738326129285 },
+    { 31999, 1.8345172810090615, 0.037669004956154446, 0, 0.21775099670597695 },
+    { 33999, 1.7568010728498729, 0.0015102032618481537, 0, 0.43852477526797606 },
+    { 35999, 1.8281311922227632, 0.0011595475785034291, 0, 0.51240843069200748 },
+    { 37999, 2.1988958911500949, 0.016327103895480137, 0, 0.51077341767527018 },
+    { 39999, 2.0278240433524322, 0.0010750393543473755, 1, 0.3396945369906495 },
+};
+
+/*
+  100 seconds of a level vehicle which accelerates, turns and changes
+  speed, with noisy IMU data at 400Hz and GPS velocity at 10Hz
+ */
+TEST(EKFGSF_yaw, Flight)
+{
+    static EKFGSF_yaw gsf;
+    // expected values are from a double precision build, and are
+    // rounded to float as all constants are
+    const double tol = sizeof(ftype) == sizeof(double) ? 1.0e-6 : 5.0e-3;
+    const ftype dt = 0.0025;
+    double yaw = 0.7;
+    double speed = 0;
+    uint8_t checked = 0;
+
+    ftype yaw_est, yaw_variance, innov_length;
+    EXPECT_FALSE(gsf.getYawData(yaw_est, yaw_variance));
+    EXPECT_FALSE(gsf.getVelInnovLength(innov_length));
+
+    for (uint32_t i=0; i<40000; i++) {
+        const double t = i * dt;
+        const double accel = t > 5 ? (t < 15 ? 1.0 : 0.8 * sin(0.5 * t)) : 0;
+        const double rate = t > 20 && t < 40 ? 0.1 * sin(t * 0.2) : 0.02;
+        speed += accel * dt;
+        yaw += rate * dt;
+
+        const Vector3F delVel{ftype((accel + 0.2 * noise()) * dt), ftype((speed * rate + 0.2 * noise()) * dt), ftype((-GRAVITY_MSS + 0.2 * noise()) * dt)};
+        const Vector3F delAng{ftype(0.01 * noise() * dt), ftype(0.01 * noise() * dt), ftype((rate + 0.01 * noise()) * dt)};
+        gsf.update(delAng, delVel, dt, dt, t > 3, 0);
+
+        if (i % 40 == 0) {
+            const double vn = speed * cos(yaw) + 0.1 * noise();
+            const double ve = speed * sin(yaw) + 0.1 * noise();
+            gsf.fuseVelData(Vector2F{ftype(vn), ftype(ve)}, 0.3);
+        }
+
+        if (checked < ARRAY_SIZE(expected) && i == expected[checked].step) {
+            const auto &e = expected[checked++];
+            uint8_t n_clips = 0;
+            ASSERT_TRUE(gsf.getYawData(yaw_est, yaw_variance, &n_clips));
+            ASSERT_TRUE(gsf.getVelInnovLength(innov_length));
+            EXPECT_NEAR(e.yaw, yaw_est, tol);
+            EXPECT_NEAR(e.yaw_variance, yaw_variance, e.yaw_variance * tol);
+            EXPECT_EQ(e.n_clips, n_clips);
+            EXPECT_NEAR(e.vel_innov_length, innov_length, tol);
+        }
+    }
+    EXPECT_EQ(ARRAY_SIZE(expected), checked);
+}
+
+AP_GTEST_MAIN()
+
+#endif // HAL_SITL or HAL_LINUX
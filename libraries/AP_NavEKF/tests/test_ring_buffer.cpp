@@ -122,6 +122,103 @@ TEST(EKF_Buffer, EKF_Buffer)
     EXPECT_FALSE(buf.recall(d2, 103));
 }
 
+/*
+  reference implementation of recall(), a linear scan from the oldest
+  element, which the buffer must match exactly
+ */
+class ref_ring_buffer {
+public:
+    struct element : EKF_obs_element_t {
+        uint32_t data;
+    };
+
+    ref_ring_buffer(uint8_t _size) : size(_size), oldest(0), count(0) {}
+
+    void push(const element &e) {
+        elements[(oldest+count) % size] = e;
+        if (count < size) {
+            count++;
+        } else {
+            oldest = (oldest+1) % size;
+        }
+    }
+
+    bool recall(element &e, uint32_t sample_time_ms) {
+        bool ret = false;
+        while (count > 0) {
+            const int32_t dt = sample_time_ms - elements[oldest].time_ms;
+            if (dt < 0) {
+                break;
+            }
+            if (dt < 100) {
+                e = elements[oldest];
+                ret = true;
+            }
+            count--;
+            oldest = (oldest+1) % size;
+        }
+        return ret;
+    }
+
+private:
+    element elements[64];
+    uint8_t size;
+    uint8_t oldest;
+    uint8_t count;
+};
+
+TEST(EKF_Buffer, matches_linear_scan)
+{
+    // deterministic pseudo-random sequence
+    uint32_t seed = 1;
+    auto rand_u32 = [&seed]() {
+        seed = seed * 1103515245U + 12345U;
+        return seed >> 1;
+    };
+
+    for (uint8_t size=1; size<=40; size++) {
+        EKF_obs_buffer_t<ref_ring_buffer::element> buf;
+        ASSERT_TRUE(buf.init(size));
+        ref_ring_buffer ref(size);
+
+        // start near the 32 bit wrap for some buffers
+        uint32_t now = (size % 4 == 0) ? 0xFFFFF000U : rand_u32();
+        uint32_t data = 0;
+        for (uint16_t i=0; i<3000; i++) {
+            if (rand_u32() % 3 != 0) {
+                // mostly monotonic timestamps, with occasional
+                // steps backwards and large jumps
+                switch (rand_u32() % 20) {
+                case 0:
+                    now -= rand_u32() % 300;
+                    break;
+                case 1:
+                    now += rand_u32() << 8;
+                    break;
+                default:
+                    now += rand_u32() % 60;
+                    break;
+                }
+                ref_ring_buffer::element e;
+                e.time_ms = now;
+                e.data = data++;
+                buf.push(e);
+                ref.push(e);
+            } else {
+                const uint32_t sample_ms = now - 200 + rand_u32() % 400;
+                ref_ring_buffer::element e1 {}, e2 {};
+                const bool ret1 = buf.recall(e1, sample_ms);
+                const bool ret2 = ref.recall(e2, sample_ms);
+                ASSERT_EQ(ret1, ret2);
+                if (ret1) {
+                    EXPECT_EQ(e1.data, e2.data);
+                    EXPECT_EQ(e1.time_ms, e2.time_ms);
+                }
+            }
+        }
+    }
+}
+
 TEST(ekf_imu_buffer, one_element_case)
 {
     // test degenerate 1-element case:
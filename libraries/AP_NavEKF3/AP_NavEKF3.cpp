@@ -13,6 +13,10 @@
 
 #include <new>
 
+#if EK3_FEATURE_PARALLEL_CORES
+extern const AP_HAL::HAL& hal;
+#endif
+
 /*
   parameter defaults for different types of vehicle. The
   APM_BUILD_DIRECTORY is taken from the main vehicle directory name
@@ -739,8 +743,8 @@ const AP_Param::GroupInfo NavEKF3::var_info2[] = {
 
     // @Param: OPTIONS
     // @DisplayName: Optional EKF behaviour
-    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution.  Bit 2 (Optflow may use terrain alt): Terrain SRTM data will be used if the vehicle climbs above the rangefinder's range allowing optical flow to be used at higher altitudes.
-    // @Bitmask: 0:JammingExpected, 1:ManualLaneSwitching, 2:Optflow may use terrain alt
+    // @Description: EKF optional behaviour. Bit 0 (JammingExpected): Setting JammingExpected will change the EKF behaviour such that if dead reckoning navigation is possible it will require the preflight alignment GPS quality checks controlled by EK3_GPS_CHECK and EK3_CHECK_SCALE to pass before resuming GPS use if GPS lock is lost for more than 2 seconds to prevent bad position estimate. Bit 1 (Manual lane switching): DANGEROUS – If enabled, this disables automatic lane switching. If the active lane becomes unhealthy, no automatic switching will occur. Users must manually set EK3_PRIMARY to change lanes. No health checks will be performed on the selected lane. Use with extreme caution.  Bit 2 (Optflow may use terrain alt): Terrain SRTM data will be used if the vehicle climbs above the rangefinder's range allowing optical flow to be used at higher altitudes. Bit 3 (Parallel cores): On Linux boards the cores are updated at the same time on their own threads once the EKF origin has been set. Takes effect when the EKF is initialised.
+    // @Bitmask: 0:JammingExpected, 1:ManualLaneSwitching, 2:Optflow may use terrain alt, 3:ParallelCores
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  11, NavEKF3, _options, 0),
 
@@ -859,6 +863,10 @@ bool NavEKF3::InitialiseFilter(void)
     // invalidate shared origin
     common_origin_valid = false;
 
+#if EK3_FEATURE_PARALLEL_CORES
+    start_core_workers();
+#endif
+
     // initialise the cores. We return success only if all cores
     // initialise successfully
     bool ret = true;
@@ -903,6 +911,102 @@ bool NavEKF3::coreBetterScore(uint8_t new_core, uint8_t current_core) const
     return coreRelativeErrors[new_core] < coreRelativeErrors[current_core];
 }
 
+/*
+  return true if a core may run its prediction step this frame
+ */
+bool NavEKF3::allow_state_prediction(uint8_t i) const
+{
+    // if we have not overrun by more than 3 IMU frames, and we
+    // have already used more than 1/3 of the CPU budget for this
+    // loop then suppress the prediction step. This allows
+    // multiple EKF instances to cooperate on scheduling
+    if (core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
+        dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i)) {
+        return false;
+    }
+    return true;
+}
+
+#if EK3_FEATURE_PARALLEL_CORES
+/*
+  start a thread for each core after the first if parallel core
+  updates are enabled. If a thread can't be started those already
+  started are stopped and the cores are updated one after the other
+  as usual
+ */
+void NavEKF3::start_core_workers(void)
+{
+    if (workers != nullptr || num_cores < 2 || !option_is_enabled(Option::ParallelCores)) {
+        return;
+    }
+    // threads are named so they can be pinned to a CPU. The HALs keep
+    // the name for the life of the thread
+    static const char *const names[] { "ekf3-1", "ekf3-2" };
+    static_assert(ARRAY_SIZE(names) >= MAX_EKF_CORES-1, "need a thread name for each core");
+
+    CoreWorker *new_workers = NEW_NOTHROW CoreWorker[num_cores-1];
+    if (new_workers == nullptr) {
+        return;
+    }
+    for (uint8_t i=1; i<num_cores; i++) {
+        CoreWorker &w = new_workers[i-1];
+        w.core = &core[i];
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND(&w, &CoreWorker::run, void),
+                                          names[i-1], 32768, AP_HAL::Scheduler::PRIORITY_MAIN, 0)) {
+            // the workers are only freed once every thread started
+            // has returned from run()
+            for (uint8_t j=1; j<i; j++) {
+                new_workers[j-1].stop = true;
+                new_workers[j-1].start.signal();
+                new_workers[j-1].done.wait_blocking();
+            }
+            delete[] new_workers;
+            GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "EKF3 parallel cores unavailable");
+            return;
+        }
+    }
+    workers = new_workers;
+}
+
+void NavEKF3::CoreWorker::run(void)
+{
+    while (true) {
+        start.wait_blocking();
+        if (stop) {
+            done.signal();
+            return;
+        }
+        core->UpdateFilter(allow_state_prediction);
+        done.signal();
+    }
+}
+
+/*
+  update the cores at the same time, core 0 on the calling thread and
+  the rest on the workers, returning when all have finished. The DAL
+  inputs for the frame don't change while the cores run, and each
+  thread has its own fusion scratch space, so the cores give the same
+  results as they would updated one after the other. Their effects
+  outside the EKF are applied by UpdateFilter() after this returns
+ */
+void NavEKF3::update_cores_parallel(void)
+{
+    // decide on predictions before any core starts, as the time
+    // remaining would otherwise depend on which cores had finished
+    for (uint8_t i=1; i<num_cores; i++) {
+        workers[i-1].allow_state_prediction = allow_state_prediction(i);
+    }
+    const bool allow_prediction0 = allow_state_prediction(0);
+    for (uint8_t i=1; i<num_cores; i++) {
+        workers[i-1].start.signal();
+    }
+    core[0].UpdateFilter(allow_prediction0);
+    for (uint8_t i=1; i<num_cores; i++) {
+        workers[i-1].done.wait_blocking();
+    }
+}
+#endif  // EK3_FEATURE_PARALLEL_CORES
+
 /* 
   Update Filter States - this should be called whenever new IMU data is available
   Execution speed governed by SCHED_LOOP_RATE
@@ -917,17 +1021,23 @@ void NavEKF3::UpdateFilter(void)
 
     imuSampleTime_us = dal.micros64();
 
-    for (uint8_t i=0; i<num_cores; i++) {
-        // if we have not overrun by more than 3 IMU frames, and we
-        // have already used more than 1/3 of the CPU budget for this
-        // loop then suppress the prediction step. This allows
-        // multiple EKF instances to cooperate on scheduling
-        bool allow_state_prediction = true;
-        if (core[i].getFramesSincePredict() < (_framesPerPrediction+3) &&
-            dal.ekf_low_time_remaining(AP_DAL::EKFType::EKF3, i)) {
-            allow_state_prediction = false;
+#if EK3_FEATURE_PARALLEL_CORES
+    // the cores share the EKF origin, so they are only updated in
+    // parallel once it is set and they no longer change it
+    if (workers != nullptr && common_origin_valid) {
+        update_cores_parallel();
+    } else
+#endif
+    {
+        for (uint8_t i=0; i<num_cores; i++) {
+            core[i].UpdateFilter(allow_state_prediction(i));
         }
-        core[i].UpdateFilter(allow_state_prediction);
+    }
+
+    // effects on AHRS and the log are applied here, in core order,
+    // whichever threads the cores were updated on
+    for (uint8_t i=0; i<num_cores; i++) {
+        core[i].applyDeferredUpdates();
     }
 
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
@@ -25,6 +25,12 @@
 #include <AP_NavEKF/AP_Nav_Common.h>
 #include <AP_NavEKF/AP_NavEKF_Source.h>
 
+#include "AP_NavEKF3_feature.h"
+
+#if EK3_FEATURE_PARALLEL_CORES
+#include <AP_HAL/Semaphores.h>
+#endif
+
 class NavEKF3_core;
 class EKFGSF_yaw;
 
@@ -384,6 +390,31 @@ private:
     uint8_t primary;   // current primary core
     NavEKF3_core *core = nullptr;
 
+#if EK3_FEATURE_PARALLEL_CORES
+    /*
+      a thread which updates one core when the main thread signals it
+     */
+    class CoreWorker {
+    public:
+        NavEKF3_core *core;
+        bool allow_state_prediction;
+        bool stop;              // return from run() rather than update
+        HAL_BinarySemaphore start;
+        HAL_BinarySemaphore done;
+
+        void run(void);
+    };
+    // workers for cores 1 to num_cores-1, core 0 is updated on the
+    // main thread
+    CoreWorker *workers = nullptr;
+
+    void start_core_workers(void);
+    void update_cores_parallel(void);
+#endif
+
+    // return true if a core may run its prediction step this frame
+    bool allow_state_prediction(uint8_t i) const;
+
     uint32_t _frameTimeUsec;        // time per IMU frame
     uint8_t  _framesPerPrediction;  // expected number of IMU frames per prediction
   
@@ -469,6 +500,7 @@ private:
         JammingExpected         = (1<<0),
         ManualLaneSwitch        = (1<<1),
         OptflowMayUseTerrainAlt = (1<<2),
+        ParallelCores           = (1<<3),
     };
     bool option_is_enabled(Option option) const {
         return (_options & (uint32_t)option) != 0;
@@ -445,6 +445,35 @@ void NavEKF3_core::Log_Write_Timing(uint64_t time_us)
     AP::logger().WriteBlock(&xkt, sizeof(xkt));
 }
 
+void NavEKF3_core::Log_Write_XKFM(uint64_t time_us) const
+{
+    const struct log_XKFM pkt{
+        LOG_PACKET_HEADER_INIT(LOG_XKFM_MSG),
+        time_us            : time_us,
+        core               : core_index,
+        ongroundnotmoving  : moveCheckLog.onGroundNotMoving,
+        gyro_length_ratio  : float(moveCheckLog.gyro_length_ratio),
+        accel_length_ratio : float(moveCheckLog.accel_length_ratio),
+        gyro_diff_ratio    : float(moveCheckLog.gyro_diff_ratio),
+        accel_diff_ratio   : float(moveCheckLog.accel_diff_ratio),
+    };
+    AP::logger().WriteBlock(&pkt, sizeof(pkt));
+}
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+void NavEKF3_core::Log_Write_XKTV(uint64_t time_us) const
+{
+    const struct log_XKTV msg {
+        LOG_PACKET_HEADER_INIT(LOG_XKTV_MSG),
+        time_us      : time_us,
+        core         : core_index,
+        tvs          : float(tiltErrorVariance),
+        tvd          : float(tiltErrorVarianceAlt),
+    };
+    AP::logger().WriteBlock(&msg, sizeof(msg));
+}
+#endif
+
 void NavEKF3_core::Log_Write_GSF(uint64_t time_us)
 {
     if (yawEstimator == nullptr) {
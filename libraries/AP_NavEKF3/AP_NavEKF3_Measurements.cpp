@@ -1456,19 +1456,12 @@ void NavEKF3_core::updateMovementCheck(void)
 
     if (logStatusChange || imuSampleTime_ms - lastMoveCheckLogTime_ms > 200) {
         lastMoveCheckLogTime_ms = imuSampleTime_ms;
-#if HAL_LOGGING_ENABLED
-        const struct log_XKFM pkt{
-            LOG_PACKET_HEADER_INIT(LOG_XKFM_MSG),
-            time_us            : dal.micros64(),
-            core               : core_index,
-            ongroundnotmoving  : onGroundNotMoving,
-            gyro_length_ratio  : float(gyro_length_ratio),
-            accel_length_ratio : float(accel_length_ratio),
-            gyro_diff_ratio    : float(gyro_diff_ratio),
-            accel_diff_ratio   : float(accel_diff_ratio),
-        };
-        AP::logger().WriteBlock(&pkt, sizeof(pkt));
-#endif
+        moveCheckLog.gyro_length_ratio = gyro_length_ratio;
+        moveCheckLog.accel_length_ratio = accel_length_ratio;
+        moveCheckLog.gyro_diff_ratio = gyro_diff_ratio;
+        moveCheckLog.accel_diff_ratio = accel_diff_ratio;
+        moveCheckLog.onGroundNotMoving = onGroundNotMoving;
+        deferred.logXKFM = true;
     }
 }
 
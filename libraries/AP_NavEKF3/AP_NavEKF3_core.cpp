@@ -723,6 +723,31 @@ void NavEKF3_core::UpdateFilter(bool predict)
     }
 }
 
+/*
+  apply the effects of UpdateFilter() on the rest of the vehicle. The
+  frontend calls this on its own thread after all the cores have been
+  updated, so that cores updated on worker threads don't change AHRS
+  state or write log messages part way through a frame
+ */
+void NavEKF3_core::applyDeferredUpdates(void)
+{
+    if (deferred.takeoffExpected) {
+        dal.set_takeoff_expected();
+    }
+#if HAL_LOGGING_ENABLED
+    const uint64_t time_us = dal.micros64();
+    if (deferred.logXKFM) {
+        Log_Write_XKFM(time_us);
+    }
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    if (deferred.logXKTV) {
+        Log_Write_XKTV(time_us);
+    }
+#endif
+#endif  // HAL_LOGGING_ENABLED
+    memset(&deferred, 0, sizeof(deferred));
+}
+
 void NavEKF3_core::correctDeltaAngle(Vector3F &delAng, ftype delAngDT, uint8_t gyro_index)
 {
     delAng -= inactiveBias[gyro_index].gyro_bias * (delAngDT / dtEkfAvg);
@@ -897,7 +922,7 @@ void NavEKF3_core::calcOutputStates()
     if (!inFlight && !dal.get_takeoff_expected() && assume_zero_sideslip()) {
         const ftype launchDelVel = imuDataNew.delVel.x + GRAVITY_MSS * imuDataNew.delVelDT * Tbn_temp.c.x;
         if (launchDelVel > GRAVITY_MSS * imuDataNew.delVelDT) {
-            dal.set_takeoff_expected();
+            deferred.takeoffExpected = true;
         }
     }
 
@@ -2203,7 +2228,7 @@ void NavEKF3_core::verifyTiltErrorVariance()
     const Vector3f gravity_ef = Vector3f(0.0f,0.0f,1.0f);
     Matrix3f Tnb;
     const float quat_delta = 0.001f;
-    float tiltErrorVarianceAlt = 0.0f;
+    tiltErrorVarianceAlt = 0.0f;
     for (uint8_t index = 0; index<4; index++) {
         QuaternionF quat = stateStruct.quat;
 
@@ -2230,14 +2255,7 @@ void NavEKF3_core::verifyTiltErrorVariance()
     tiltErrorVarianceAlt = MIN(tiltErrorVarianceAlt, sq(radians(30.0f)));
     if (imuSampleTime_ms - lastLogTime_ms > 500) {
         lastLogTime_ms = imuSampleTime_ms;
-        const struct log_XKTV msg {
-            LOG_PACKET_HEADER_INIT(LOG_XKTV_MSG),
-            time_us      : dal.micros64(),
-            core         : core_index,
-            tvs          : float(tiltErrorVariance),
-            tvd          : float(tiltErrorVarianceAlt),
-        };
-        AP::logger().WriteBlock(&msg, sizeof(msg));
+        deferred.logXKTV = true;
     }
 #endif  // HAL_LOGGING_ENABLED
 }
@@ -469,6 +469,11 @@ public:
 
     void Log_Write(uint64_t time_us);
 
+    // apply the effects of the last UpdateFilter() outside the core,
+    // which are left for the frontend to apply on its own thread once
+    // every core has been updated
+    void applyDeferredUpdates(void);
+
     // returns true when the state estimates are significantly degraded by vibration
     bool isVibrationAffected() const { return badIMUdata; }
 
@@ -1014,6 +1019,7 @@ private:
     // calculate the tilt error variance using an alternative numerical difference technique
     // and log with value generated by NavEKF3_core::calcTiltErrorVariance()
     void verifyTiltErrorVariance();
+    ftype tiltErrorVarianceAlt;     // tilt error variance from verifyTiltErrorVariance() (rad^2)
 #endif
 
     // update timing statistics structure
@@ -1488,6 +1494,20 @@ private:
     Vector3F accel_prev;                // accelerometer vector from previous time step (m/s/s)
     bool onGroundNotMoving;             // true when on the ground and not moving
     uint32_t lastMoveCheckLogTime_ms;   // last time the movement check data was logged (msec)
+    struct {
+        ftype gyro_length_ratio;
+        ftype accel_length_ratio;
+        ftype gyro_diff_ratio;
+        ftype accel_diff_ratio;
+        bool onGroundNotMoving;
+    } moveCheckLog;                     // movement check data for the XKFM log message
+
+    // effects of UpdateFilter() outside the core, left for applyDeferredUpdates()
+    struct {
+        bool takeoffExpected;           // fixed wing launch detected
+        bool logXKFM;                   // movement check data to log
+        bool logXKTV;                   // tilt error variance check to log
+    } deferred;
 
 	// variables used to inhibit accel bias learning
     bool inhibitDelVelBiasStates;       // true when all IMU delta velocity bias states are de-activated
@@ -1663,4 +1683,8 @@ private:
     void Log_Write_State_Variances(uint64_t time_us);
     void Log_Write_Timing(uint64_t time_us);
     void Log_Write_GSF(uint64_t time_us);
+    void Log_Write_XKFM(uint64_t time_us) const;
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    void Log_Write_XKTV(uint64_t time_us) const;
+#endif
 };
@@ -51,3 +51,9 @@
 #ifndef EK3_FEATURE_OPTFLOW_SRTM
 #define EK3_FEATURE_OPTFLOW_SRTM EK3_FEATURE_OPTFLOW_FUSION
 #endif
+
+// updating the cores on worker threads on multi-core Linux targets,
+// and on SITL and Replay for testing
+#ifndef EK3_FEATURE_PARALLEL_CORES
+#define EK3_FEATURE_PARALLEL_CORES (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL) && !APM_BUILD_TYPE(APM_BUILD_AP_DAL_Standalone)
+#endif
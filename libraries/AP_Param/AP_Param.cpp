@@ -104,6 +104,13 @@ uint16_t AP_Param::_count_marker;
 uint16_t AP_Param::_count_marker_done;
 HAL_Semaphore AP_Param::_count_sem;
 
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+// offsets of the parameters in storage
+AP_Param_StorageIndex AP_Param::_storage_index;
+AP_Param::StorageIndexState AP_Param::_storage_index_state;
+HAL_Semaphore AP_Param::_storage_index_sem;
+#endif
+
 // storage and naming information about all types that can be saved
 const AP_Param::Info *AP_Param::_var_info;
 
@@ -115,7 +122,9 @@ uint16_t AP_Param::num_read_only;
 // goes true if we run out of param space
 bool AP_Param::eeprom_full;
 
-ObjectBuffer_TS<AP_Param::param_save> AP_Param::save_queue{30};
+struct AP_Param::param_save AP_Param::save_queue[30];
+uint8_t AP_Param::save_queue_count;
+HAL_Semaphore AP_Param::save_queue_sem;
 bool AP_Param::registered_save_handler;
 
 bool AP_Param::done_all_default_params;
@@ -187,6 +196,10 @@ void AP_Param::erase_all(void)
 
     // add a sentinel directly after the header
     write_sentinel(sizeof(struct EEPROM_header));
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    clear_storage_index();
+#endif
 }
 
 /* the 'group_id' of a element of a group is the 18 bit identifier
@@ -379,6 +392,9 @@ bool AP_Param::setup(void)
             _storage.copy_area(_storage_bak)) {
             // restored from backup
             INTERNAL_ERROR(AP_InternalError::error_t::params_restored);
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+            clear_storage_index();
+#endif
             return true;
         }
 #endif // AP_PARAM_STORAGE_BAK_ENABLED
@@ -762,6 +778,19 @@ bool AP_Param::is_sentinel(const Param_header &phdr)
 // if the sentinel isn't found either, the offset is set to 0xFFFF
 bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
 {
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    {
+        WITH_SEMAPHORE(_storage_index_sem);
+        if (build_storage_index()) {
+            if (_storage_index.find(header_word(*target), *pofs)) {
+                return true;
+            }
+            *pofs = sentinel_offset;
+            return false;
+        }
+    }
+#endif
+
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
     while (ofs < _storage.size()) {
@@ -786,6 +815,59 @@ bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
     return false;
 }
 
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+// fill the storage index with one pass through the storage, if not
+// already done. Returns false if the index can't be used and scan()
+// must read through the storage. Called with _storage_index_sem held
+bool AP_Param::build_storage_index()
+{
+    if (_storage_index_state != StorageIndexState::EMPTY) {
+        return _storage_index_state == StorageIndexState::BUILT;
+    }
+    _storage_index_state = StorageIndexState::FAILED;
+
+    struct Param_header phdr;
+    uint16_t ofs = sizeof(AP_Param::EEPROM_header);
+    while (ofs < _storage.size()) {
+        _storage.read_block(&phdr, ofs, sizeof(phdr));
+        if (is_sentinel(phdr)) {
+            sentinel_offset = ofs;
+            _storage_index_state = StorageIndexState::BUILT;
+            return true;
+        }
+        if (!_storage_index.add(header_word(phdr), ofs)) {
+            Debug("out of memory for storage index");
+            break;
+        }
+        ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
+    }
+    _storage_index.clear();
+    return false;
+}
+
+// forget the storage index, to be rebuilt on the next scan() after
+// the storage is erased or replaced
+void AP_Param::clear_storage_index()
+{
+    WITH_SEMAPHORE(_storage_index_sem);
+    _storage_index.clear();
+    _storage_index_state = StorageIndexState::EMPTY;
+}
+
+// add a parameter which has been appended to the storage
+void AP_Param::add_to_storage_index(const struct Param_header &phdr, uint16_t ofs)
+{
+    WITH_SEMAPHORE(_storage_index_sem);
+    if (_storage_index_state != StorageIndexState::BUILT) {
+        return;
+    }
+    if (!_storage_index.add(header_word(phdr), ofs)) {
+        _storage_index.clear();
+        _storage_index_state = StorageIndexState::FAILED;
+    }
+}
+#endif  // AP_PARAM_STORAGE_INDEX_ENABLED
+
 /**
  * add a _X, _Y, _Z suffix to the name of a Vector3f element
  * @param buffer
@@ -1236,6 +1318,9 @@ void AP_Param::save_sync(bool force_save, bool send_to_gcs)
     write_sentinel(ofs + sizeof(phdr) + type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
     eeprom_write_check(&phdr, ofs, sizeof(phdr));
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    add_to_storage_index(phdr, ofs);
+#endif
 
     if (send_to_gcs) {
         send_parameter(name, (enum ap_var_type)phdr.type, idx);
@@ -1247,19 +1332,26 @@ void AP_Param::save_sync(bool force_save, bool send_to_gcs)
 */
 void AP_Param::save(bool force_save)
 {
-    struct param_save p, p2;
-    p.param = this;
-    p.force_save = force_save;
-    if (save_queue.peek(p2) &&
-        p2.param == this &&
-        p2.force_save == force_save) {
-        // this one is already at the head of the list to be
-        // saved. This check is cheap and catches the case where we
-        // are flooding the save queue with one parameter (eg. mission
-        // creation, changing MIS_TOTAL)
-        return;
-    }
-    while (!save_queue.push(p)) {
+    while (true) {
+        {
+            WITH_SEMAPHORE(save_queue_sem);
+            for (uint8_t i=0; i<save_queue_count; i++) {
+                if (save_queue[i].param == this) {
+                    // this one is already waiting to be saved. This
+                    // catches the case where we are flooding the save
+                    // queue with one parameter (eg. mission creation,
+                    // changing MIS_TOTAL, autotune or scripts)
+                    save_queue[i].force_save = save_queue[i].force_save || force_save;
+                    return;
+                }
+            }
+            if (save_queue_count < ARRAY_SIZE(save_queue)) {
+                save_queue[save_queue_count].param = this;
+                save_queue[save_queue_count].force_save = force_save;
+                save_queue_count++;
+                return;
+            }
+        }
         // if we can't save to the queue
         if (hal.util->get_soft_armed() && hal.scheduler->in_main_thread()) {
             // if we are armed in main thread then don't sleep, instead we lose the
@@ -1276,13 +1368,28 @@ void AP_Param::save(bool force_save)
     }
 }
 
+/*
+  take the oldest parameter from the save queue
+*/
+bool AP_Param::save_queue_pop(struct param_save &p)
+{
+    WITH_SEMAPHORE(save_queue_sem);
+    if (save_queue_count == 0) {
+        return false;
+    }
+    p = save_queue[0];
+    save_queue_count--;
+    memmove(&save_queue[0], &save_queue[1], save_queue_count * sizeof(save_queue[0]));
+    return true;
+}
+
 /*
   background function for saving parameters. This runs on the IO thread
  */
 void AP_Param::save_io_handler(void)
 {
     struct param_save p;
-    while (save_queue.pop(p)) {
+    while (save_queue_pop(p)) {
         p.param->save_sync(p.force_save, true);
     }
     if (hal.scheduler->is_system_initialized()) {
@@ -1297,7 +1404,7 @@ void AP_Param::save_io_handler(void)
 void AP_Param::flush(void)
 {
     uint16_t counter = 200; // 2 seconds max
-    while (counter-- && save_queue.available()) {
+    while (counter-- && save_queue_count > 0) {
         hal.scheduler->expect_delay_ms(10);
         hal.scheduler->delay(10);
         hal.scheduler->expect_delay_ms(0);
@@ -31,6 +31,7 @@
 #include <AP_Scripting/AP_Scripting_config.h>
 
 #include "AP_Param_config.h"
+#include "AP_Param_StorageIndex.h"
 
 #include "float.h"
 
@@ -750,6 +751,18 @@ private:
     static bool                 scan(
                                     const struct Param_header *phdr,
                                     uint16_t *pofs);
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    static bool                 build_storage_index();
+    static void                 clear_storage_index();
+    static void                 add_to_storage_index(
+                                    const struct Param_header &phdr,
+                                    uint16_t ofs);
+    static uint32_t             header_word(const struct Param_header &phdr) {
+        uint32_t v;
+        memcpy(&v, &phdr, sizeof(v));
+        return v;
+    }
+#endif
     static void                 eeprom_write_check(
                                     const void *ptr,
                                     uint16_t ofs,
@@ -816,6 +829,17 @@ private:
     static uint16_t             _count_marker;
     static uint16_t             _count_marker_done;
     static HAL_Semaphore        _count_sem;
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+    enum class StorageIndexState : uint8_t {
+        EMPTY,
+        BUILT,
+        FAILED,     // out of memory or no sentinel, scan the storage instead
+    };
+    static AP_Param_StorageIndex _storage_index;
+    static StorageIndexState    _storage_index_state;
+    static HAL_Semaphore        _storage_index_sem;
+#endif
     static const struct Info *  _var_info;
 
 #if AP_PARAM_DYNAMIC_ENABLED
@@ -854,12 +878,16 @@ private:
     static bool _hide_disabled_groups;
 
     // support for background saving of parameters. We pack it to reduce memory for the
-    // queue
+    // queue. A parameter saved again before the IO thread has written
+    // it is only queued once
     struct PACKED param_save {
         AP_Param *param;
         bool force_save;
     };
-    static ObjectBuffer_TS<struct param_save> save_queue;
+    static struct param_save save_queue[30];
+    static uint8_t save_queue_count;
+    static HAL_Semaphore save_queue_sem;
+    static bool save_queue_pop(struct param_save &p);
     static bool registered_save_handler;
 
     // background function for saving parameters
@@ -0,0 +1,108 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Param_StorageIndex.h"
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+
+#include <string.h>
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/AP_HAL.h>
+
+AP_Param_StorageIndex::~AP_Param_StorageIndex()
+{
+    clear();
+}
+
+void AP_Param_StorageIndex::clear()
+{
+    delete[] _headers;
+    delete[] _offsets;
+    _headers = nullptr;
+    _offsets = nullptr;
+    _bits = 0;
+    _count = 0;
+}
+
+bool AP_Param_StorageIndex::find(uint32_t header, uint16_t &ofs) const
+{
+    if (_bits == 0) {
+        return false;
+    }
+    const uint16_t mask = (1U << _bits) - 1;
+    for (uint16_t i = slot(header); _offsets[i] != 0; i = (i + 1) & mask) {
+        if (_headers[i] == header) {
+            ofs = _offsets[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AP_Param_StorageIndex::add(uint32_t header, uint16_t ofs)
+{
+    // keep the table at most 3/4 full
+    if ((uint32_t(_count) + 1) * 4 > (3U << _bits) && !grow()) {
+        return false;
+    }
+    const uint16_t mask = (1U << _bits) - 1;
+    uint16_t i = slot(header);
+    for (; _offsets[i] != 0; i = (i + 1) & mask) {
+        if (_headers[i] == header) {
+            return true;
+        }
+    }
+    _headers[i] = header;
+    _offsets[i] = ofs;
+    _count++;
+    return true;
+}
+
+bool AP_Param_StorageIndex::grow()
+{
+    // storage offsets are 16 bit, so there can't be more than 16k parameters
+    const uint8_t bits = _bits == 0 ? 7 : _bits + 1;
+    if (bits > 15) {
+        return false;
+    }
+    const uint16_t size = 1U << bits;
+    uint32_t *headers = NEW_NOTHROW uint32_t[size];
+    uint16_t *offsets = NEW_NOTHROW uint16_t[size];
+    if (headers == nullptr || offsets == nullptr) {
+        delete[] headers;
+        delete[] offsets;
+        return false;
+    }
+    memset(offsets, 0, size * sizeof(offsets[0]));
+
+    uint32_t *old_headers = _headers;
+    uint16_t *old_offsets = _offsets;
+    const uint16_t old_size = _bits != 0 ? 1U << _bits : 0;
+    _headers = headers;
+    _offsets = offsets;
+    _bits = bits;
+    _count = 0;
+    for (uint16_t i = 0; i < old_size; i++) {
+        if (old_offsets[i] != 0) {
+            add(old_headers[i], old_offsets[i]);
+        }
+    }
+    delete[] old_headers;
+    delete[] old_offsets;
+    return true;
+}
+
+#endif  // AP_PARAM_STORAGE_INDEX_ENABLED
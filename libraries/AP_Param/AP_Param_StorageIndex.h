@@ -0,0 +1,62 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  index of the parameters in storage, from the 32 bit Param_header of
+  each to its offset in storage, so that AP_Param::scan() doesn't need
+  to read through the storage from the start to find a parameter.
+
+  This is an open addressed hash table which grows as parameters are
+  added. It is filled by one pass through the storage and then kept in
+  step as parameters are appended to it.
+ */
+#pragma once
+
+#include "AP_Param_config.h"
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+
+#include <stdint.h>
+
+class AP_Param_StorageIndex {
+public:
+    ~AP_Param_StorageIndex();
+
+    // find the storage offset of a header, returns false if not in the index
+    bool find(uint32_t header, uint16_t &ofs) const;
+
+    // add a header stored at ofs. If the header is already in the
+    // index the first offset is kept, as scan() finds the first copy.
+    // Returns false if memory could not be allocated
+    bool add(uint32_t header, uint16_t ofs);
+
+    // remove all headers and free the memory
+    void clear();
+
+    uint16_t count() const { return _count; }
+
+private:
+    bool grow();
+    uint16_t slot(uint32_t header) const {
+        return (header * 2654435761U) >> (32 - _bits);
+    }
+
+    // an offset of 0 is the EEPROM_header, so marks an empty slot
+    uint32_t *_headers = nullptr;
+    uint16_t *_offsets = nullptr;
+    uint8_t _bits = 0;
+    uint16_t _count = 0;
+};
+
+#endif  // AP_PARAM_STORAGE_INDEX_ENABLED
@@ -0,0 +1,129 @@
+#include <AP_gbenchmark.h>
+
+/*
+  cost of finding parameters in storage by reading through it from
+  the start, as AP_Param::scan() did, and with AP_Param_StorageIndex.
+
+  The storage is an image in RAM laid out as AP_Param lays it out,
+  with a float after each header. Reading it is a memcpy, where
+  AP_Param reads through StorageAccess and the HAL, so the scan is
+  cheaper here than on a vehicle. The argument is the number of
+  parameters in storage.
+ */
+
+#include <AP_Param/AP_Param_StorageIndex.h>
+#include <AP_Common/AP_Common.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+
+// parameters saved together, as by autotune or a GCS writing all
+#define BURST_SIZE 100
+
+static const uint32_t sentinel = 0xFFFFFFFF;
+static uint8_t storage[16384];
+
+static uint32_t seed = 1;
+static uint32_t rand_u32()
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed;
+}
+
+// fill the storage with count parameters, returning their headers
+static const uint32_t *fill_storage(uint16_t count)
+{
+    static uint32_t headers[(sizeof(storage) - 8) / 8];
+    uint16_t ofs = 4;
+    for (uint16_t i=0; i<count; i++) {
+        // key, AP_PARAM_FLOAT, and an element of a group
+        headers[i] = (i % 256) | (4U << 8) | (uint32_t(i / 256 + 1) << 14);
+        memcpy(&storage[ofs], &headers[i], sizeof(headers[i]));
+        ofs += 8;
+    }
+    memcpy(&storage[ofs], &sentinel, sizeof(sentinel));
+    return headers;
+}
+
+static bool scan(uint32_t target, uint16_t &pofs)
+{
+    uint16_t ofs = 4;
+    while (ofs < sizeof(storage)) {
+        uint32_t header;
+        memcpy(&header, &storage[ofs], sizeof(header));
+        if (header == target) {
+            pofs = ofs;
+            return true;
+        }
+        if (header == sentinel) {
+            pofs = ofs;
+            return false;
+        }
+        ofs += 8;
+    }
+    return false;
+}
+
+static void build(AP_Param_StorageIndex &index)
+{
+    index.clear();
+    uint16_t ofs = 4;
+    while (ofs < sizeof(storage)) {
+        uint32_t header;
+        memcpy(&header, &storage[ofs], sizeof(header));
+        if (header == sentinel) {
+            break;
+        }
+        index.add(header, ofs);
+        ofs += 8;
+    }
+}
+
+static void BM_SaveBurstScan(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    const uint32_t *headers = fill_storage(count);
+    uint32_t found = 0;
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<BURST_SIZE; i++) {
+            uint16_t ofs;
+            found += scan(headers[rand_u32() % count], ofs);
+        }
+    }
+    benchmark::DoNotOptimize(found);
+}
+
+static void BM_SaveBurstIndex(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    const uint32_t *headers = fill_storage(count);
+    static AP_Param_StorageIndex index;
+    build(index);
+    uint32_t found = 0;
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<BURST_SIZE; i++) {
+            uint16_t ofs;
+            found += index.find(headers[rand_u32() % count], ofs);
+        }
+    }
+    benchmark::DoNotOptimize(found);
+}
+
+// the pass through the storage made on the first scan after boot
+static void BM_BuildIndex(benchmark::State& state)
+{
+    fill_storage(state.range(0));
+    static AP_Param_StorageIndex index;
+    while (state.KeepRunning()) {
+        build(index);
+    }
+}
+
+BENCHMARK(BM_SaveBurstScan)->Arg(200)->Arg(800)->Arg(1800);
+BENCHMARK(BM_SaveBurstIndex)->Arg(200)->Arg(800)->Arg(1800);
+BENCHMARK(BM_BuildIndex)->Arg(200)->Arg(800)->Arg(1800);
+
+#endif  // AP_PARAM_STORAGE_INDEX_ENABLED
+
+BENCHMARK_MAIN();
@@ -0,0 +1,65 @@
+#include <AP_gtest.h>
+
+#include <AP_Param/AP_Param_StorageIndex.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_PARAM_STORAGE_INDEX_ENABLED
+
+static uint32_t seed = 1;
+static uint32_t rand_header()
+{
+    seed = seed * 1103515245U + 12345U;
+    // keys and group elements are small, so many headers share most bits
+    return ((seed >> 8) & 0x1FF) | (((seed >> 20) & 0x3F) << 14);
+}
+
+TEST(AP_Param_StorageIndex, Empty)
+{
+    AP_Param_StorageIndex index;
+    uint16_t ofs;
+    EXPECT_FALSE(index.find(0x1234, ofs));
+    EXPECT_EQ(index.count(), 0);
+}
+
+// the index finds the first offset stored for each header, as
+// AP_Param::scan() does reading through the storage
+TEST(AP_Param_StorageIndex, MatchesScan)
+{
+    static uint32_t headers[3000];
+    AP_Param_StorageIndex index;
+    uint16_t ofs = 4;
+    for (uint16_t i=0; i<ARRAY_SIZE(headers); i++) {
+        headers[i] = rand_header();
+        ASSERT_TRUE(index.add(headers[i], ofs));
+        ofs += 8;
+    }
+    uint16_t unique = 0;
+    for (uint16_t i=0; i<ARRAY_SIZE(headers); i++) {
+        uint16_t first = 0;
+        for (uint16_t j=0; j<=i; j++) {
+            if (headers[j] == headers[i]) {
+                first = 4 + j*8;
+                break;
+            }
+        }
+        if (first == 4 + i*8) {
+            unique++;
+        }
+        uint16_t found;
+        ASSERT_TRUE(index.find(headers[i], found));
+        EXPECT_EQ(found, first);
+    }
+    EXPECT_EQ(index.count(), unique);
+
+    uint16_t found;
+    EXPECT_FALSE(index.find(0xFFFFFFFF, found));
+
+    index.clear();
+    EXPECT_FALSE(index.find(headers[0], found));
+    EXPECT_EQ(index.count(), 0);
+}
+
+#endif  // AP_PARAM_STORAGE_INDEX_ENABLED
+
+AP_GTEST_MAIN()
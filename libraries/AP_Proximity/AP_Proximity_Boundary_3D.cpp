@@ -32,9 +32,9 @@ AP_Proximity_Boundary_3D::AP_Proximity_Boundary_3D()
 void AP_Proximity_Boundary_3D::init()
 {
     for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        const float pitch = ((float)_pitch_middle_deg[layer]);
+        const float pitch = pitch_middle_deg(layer);
         for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            const float angle_rad = ((float)_sector_middle_deg[sector]+(PROXIMITY_SECTOR_WIDTH_DEG/2.0f));
+            const float angle_rad = sector_middle_deg(sector) + (PROXIMITY_SECTOR_WIDTH_DEG/2.0f);
             _sector_edge_vector[layer][sector].offset_bearing(angle_rad, pitch, 100.0f);
             _boundary_points[layer][sector] = _sector_edge_vector[layer][sector] * PROXIMITY_BOUNDARY_DIST_DEFAULT;
         }
@@ -46,7 +46,7 @@ void AP_Proximity_Boundary_3D::init()
 // yaw is the horizontal body-frame angle (in degrees) to the obstacle (0=directly ahead of the vehicle, 90 is to the right of the vehicle)
 AP_Proximity_Boundary_3D::Face AP_Proximity_Boundary_3D::get_face(float pitch, float yaw) const
 {
-    const uint8_t sector = wrap_360(yaw + (PROXIMITY_SECTOR_WIDTH_DEG * 0.5f)) / 45.0f;
+    const uint8_t sector = MIN(wrap_360(yaw + (PROXIMITY_SECTOR_WIDTH_DEG * 0.5f)) / PROXIMITY_SECTOR_WIDTH_DEG, PROXIMITY_NUM_SECTORS - 1);
     const float pitch_limited = constrain_float(pitch, -75.0f, 74.9f);
     const uint8_t layer = (pitch_limited + 75.0f)/PROXIMITY_PITCH_WIDTH_DEG;
     return Face{layer, sector};
@@ -63,20 +63,22 @@ void AP_Proximity_Boundary_3D::set_face_attributes(const Face &face, float pitch
         return;
     }
 
+    FaceState &f = state(face);
+
     // ignore update if another instance has provided a shorter distance within the last 0.2 seconds
-    if ((prx_instance != _prx_instance[face.layer][face.sector]) && _distance_valid[face.layer][face.sector] && (_filtered_distance[face.layer][face.sector].get() < distance)) {
+    if ((prx_instance != f.prx_instance) && f.valid && (f.filtered_distance.get() < distance)) {
         // check if recent
         const uint32_t now_ms = AP_HAL::millis();
-        if (now_ms - _last_update_ms[face.layer][face.sector] < PROXIMITY_FACE_RESET_MS) {
+        if (now_ms - f.last_update_ms < PROXIMITY_FACE_RESET_MS) {
             return;
         }
     }
 
-    _angle_deg[face.layer][face.sector] = angle;
-    _pitch_deg[face.layer][face.sector] = pitch;
-    _distance[face.layer][face.sector] = distance;
-    _distance_valid[face.layer][face.sector] = true;
-    _prx_instance[face.layer][face.sector] = prx_instance;
+    f.angle_deg = angle;
+    f.pitch_deg = pitch;
+    f.distance = distance;
+    f.valid = true;
+    f.prx_instance = prx_instance;
 
     // apply filter
     set_filtered_distance(face, distance);
@@ -88,10 +90,8 @@ void AP_Proximity_Boundary_3D::set_face_attributes(const Face &face, float pitch
 // apply a new cutoff_freq to low-pass filter
 void AP_Proximity_Boundary_3D::apply_filter_freq(float cutoff_freq)
 {
-    for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            _filtered_distance[layer][sector].set_cutoff_frequency(cutoff_freq);
-        }
+    for (FaceState &f : _faces) {
+        f.filtered_distance.set_cutoff_frequency(cutoff_freq);
     }
 }
 
@@ -101,20 +101,21 @@ void AP_Proximity_Boundary_3D::set_filtered_distance(const Face &face, float dis
     if (!face.valid()) {
         return;
     }
-    if (!is_equal(_filtered_distance[face.layer][face.sector].get_cutoff_freq(), _filter_freq)) {
+    FaceState &f = state(face);
+    if (!is_equal(f.filtered_distance.get_cutoff_freq(), _filter_freq)) {
         // cutoff freq has changed
         apply_filter_freq(_filter_freq);
     }
 
     const uint32_t now_ms = AP_HAL::millis();
-    const uint32_t dt = now_ms - _last_update_ms[face.layer][face.sector];
+    const uint32_t dt = now_ms - f.last_update_ms;
     if (dt < PROXIMITY_FILT_RESET_TIME) {
-        _filtered_distance[face.layer][face.sector].apply(distance, dt* 0.001f);
+        f.filtered_distance.apply(distance, dt* 0.001f);
     } else {
         // reset filter since last distance was passed a long time back
-        _filtered_distance[face.layer][face.sector].reset(distance);
+        f.filtered_distance.reset(distance);
     }
-    _last_update_ms[face.layer][face.sector] = now_ms;
+    f.last_update_ms = now_ms;
 }
 
 // update boundary points used for object avoidance based on a single sector and pitch distance changing
@@ -135,12 +136,12 @@ void AP_Proximity_Boundary_3D::update_boundary(const Face &face)
 
     // boundary point lies on the line between the two sectors at the shorter distance found in the two sectors
     float shortest_distance = PROXIMITY_BOUNDARY_DIST_DEFAULT;
-    if (_distance_valid[layer][sector] && _distance_valid[layer][next_sector]) {
-        shortest_distance = MIN(_filtered_distance[layer][sector].get(), _filtered_distance[layer][next_sector].get());
-    } else if (_distance_valid[layer][sector]) {
-        shortest_distance = _filtered_distance[layer][sector].get();
-    } else if (_distance_valid[layer][next_sector]) {
-        shortest_distance = _filtered_distance[layer][next_sector].get();
+    if (state(layer, sector).valid && state(layer, next_sector).valid) {
+        shortest_distance = MIN(state(layer, sector).filtered_distance.get(), state(layer, next_sector).filtered_distance.get());
+    } else if (state(layer, sector).valid) {
+        shortest_distance = state(layer, sector).filtered_distance.get();
+    } else if (state(layer, next_sector).valid) {
+        shortest_distance = state(layer, next_sector).filtered_distance.get();
     }
     if (shortest_distance < PROXIMITY_BOUNDARY_DIST_MIN) {
         shortest_distance = PROXIMITY_BOUNDARY_DIST_MIN;
@@ -148,25 +149,25 @@ void AP_Proximity_Boundary_3D::update_boundary(const Face &face)
     _boundary_points[layer][sector] = _sector_edge_vector[layer][sector] * shortest_distance;
 
     // if the next sector (clockwise) has an invalid distance, set boundary to create a cup like boundary
-    if (!_distance_valid[layer][next_sector]) {
+    if (!state(layer, next_sector).valid) {
         _boundary_points[layer][next_sector] = _sector_edge_vector[layer][next_sector] * shortest_distance;
     }
 
     // repeat for edge between sector and previous sector
     const uint8_t prev_sector = get_prev_sector(sector);
     shortest_distance = PROXIMITY_BOUNDARY_DIST_DEFAULT;
-    if (_distance_valid[layer][prev_sector] && _distance_valid[layer][sector]) {
-        shortest_distance = MIN(_filtered_distance[layer][prev_sector].get(), _filtered_distance[layer][sector].get());
-    } else if (_distance_valid[layer][prev_sector]) {
-        shortest_distance = _filtered_distance[layer][prev_sector].get();
-    } else if (_distance_valid[layer][sector]) {
-        shortest_distance = _filtered_distance[layer][sector].get();
+    if (state(layer, prev_sector).valid && state(layer, sector).valid) {
+        shortest_distance = MIN(state(layer, prev_sector).filtered_distance.get(), state(layer, sector).filtered_distance.get());
+    } else if (state(layer, prev_sector).valid) {
+        shortest_distance = state(layer, prev_sector).filtered_distance.get();
+    } else if (state(layer, sector).valid) {
+        shortest_distance = state(layer, sector).filtered_distance.get();
     }
     _boundary_points[layer][prev_sector] = _sector_edge_vector[layer][prev_sector] * shortest_distance;
 
     // if the sector counter-clockwise from the previous sector has an invalid distance, set boundary to create a cup-like boundary
     const uint8_t prev_sector_ccw = get_prev_sector(prev_sector);
-    if (!_distance_valid[layer][prev_sector_ccw]) {
+    if (!state(layer, prev_sector_ccw).valid) {
         _boundary_points[layer][prev_sector_ccw] = _sector_edge_vector[layer][prev_sector_ccw] * shortest_distance;
     }
 }
@@ -174,10 +175,8 @@ void AP_Proximity_Boundary_3D::update_boundary(const Face &face)
 // reset boundary.  marks all distances as invalid
 void AP_Proximity_Boundary_3D::reset()
 {
-    for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
-        for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            _distance_valid[layer][sector] = false;
-        }
+    for (FaceState &f : _faces) {
+        f.valid = false;
     }
 }
 
@@ -190,20 +189,22 @@ void AP_Proximity_Boundary_3D::reset_face(const Face &face, uint8_t prx_instance
         return;
     }
 
+    FaceState &f = state(face);
+
     // return immediately if face already has no valid distance
-    if (!_distance_valid[face.layer][face.sector]) {
+    if (!f.valid) {
         return;
     }
 
     // ignore reset if another instance provided this face's distance within the last 0.2 seconds
-    if (prx_instance != _prx_instance[face.layer][face.sector]) {
+    if (prx_instance != f.prx_instance) {
         const uint32_t now_ms = AP_HAL::millis();
-        if (now_ms - _last_update_ms[face.layer][face.sector] < 200) {
+        if (now_ms - f.last_update_ms < 200) {
             return;
         }
     }
 
-    _distance_valid[face.layer][face.sector] = false;
+    f.valid = false;
 
     // update simple avoidance boundary
     update_boundary(face);
@@ -221,10 +222,11 @@ void AP_Proximity_Boundary_3D::check_face_timeout()
 
     for (uint8_t layer=0; layer < PROXIMITY_NUM_LAYERS; layer++) {
         for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
-            if (_distance_valid[layer][sector]) {
-                if ((now_ms - _last_update_ms[layer][sector]) > PROXIMITY_FACE_RESET_MS) {
+            FaceState &f = state(layer, sector);
+            if (f.valid) {
+                if ((now_ms - f.last_update_ms) > PROXIMITY_FACE_RESET_MS) {
                     // this face has a valid distance but wasn't updated for a long time, reset it
-                    _distance_valid[layer][sector] = false;
+                    f.valid = false;
                     update_boundary(AP_Proximity_Boundary_3D::Face{layer, sector});
                 }
             }
@@ -238,8 +240,8 @@ bool AP_Proximity_Boundary_3D::get_distance(const Face &face, float &distance) c
     if (!face.valid()) {
         return false;
     }
-    if (_distance_valid[face.layer][face.sector]) {
-        distance = _distance[face.layer][face.sector];
+    if (state(face).valid) {
+        distance = state(face).distance;
         return true;
     }
 
@@ -247,9 +249,9 @@ bool AP_Proximity_Boundary_3D::get_distance(const Face &face, float &distance) c
 }
 
 // get the total number of obstacles 
-uint8_t AP_Proximity_Boundary_3D::get_obstacle_count() const
+uint16_t AP_Proximity_Boundary_3D::get_obstacle_count() const
 {
-    return PROXIMITY_NUM_LAYERS * PROXIMITY_NUM_SECTORS;
+    return PROXIMITY_NUM_FACES;
 }
 
 // Converts obstacle_num passed from avoidance library into appropriate face of the boundary
@@ -257,7 +259,7 @@ uint8_t AP_Proximity_Boundary_3D::get_obstacle_count() const
 // "update_boundary" method manipulates two sectors ccw and one sector cw from any valid face.
 // Any boundary that does not fall into these manipulated faces are useless, and will be marked as false
 // The resultant is packed into a Boundary Location object and returned by reference as "face"
-bool AP_Proximity_Boundary_3D::convert_obstacle_num_to_face(uint8_t obstacle_num, Face& face) const
+bool AP_Proximity_Boundary_3D::convert_obstacle_num_to_face(uint16_t obstacle_num, Face& face) const
 {
     // obstacle num is just "flattened layers, and sectors"
     const uint8_t layer = obstacle_num / PROXIMITY_NUM_SECTORS;
@@ -268,7 +270,7 @@ bool AP_Proximity_Boundary_3D::convert_obstacle_num_to_face(uint8_t obstacle_num
     uint8_t valid_sector = sector;
     // check for 3 adjacent sectors
     for (uint8_t i=0; i < 3; i++) {
-        if (_distance_valid[layer][valid_sector]) {
+        if (state(layer, valid_sector).valid) {
             // update boundary has manipulated this face
             return true;
         }
@@ -284,7 +286,7 @@ bool AP_Proximity_Boundary_3D::convert_obstacle_num_to_face(uint8_t obstacle_num
 // Then returns the closest point on this line from vehicle, in body-frame. 
 // Used by GPS based Simple Avoidance  
 // False is returned if the obstacle_num provided does not produce a valid obstacle 
-bool AP_Proximity_Boundary_3D::get_obstacle(uint8_t obstacle_num, Vector3f& vec_to_obstacle) const
+bool AP_Proximity_Boundary_3D::get_obstacle(uint16_t obstacle_num, Vector3f& vec_to_obstacle) const
 {
     Face face;
     if (!convert_obstacle_num_to_face(obstacle_num, face)) {
@@ -308,7 +310,7 @@ bool AP_Proximity_Boundary_3D::get_obstacle(uint8_t obstacle_num, Vector3f& vec_
 // This helps us know if the passed line segment was in the direction of the boundary, or going in a different direction.
 // Used by GPS based Simple Avoidance  - for "brake mode"
 // False is returned if the obstacle_num provided does not produce a valid obstacle
-bool AP_Proximity_Boundary_3D::closest_point_from_segment_to_obstacle(uint8_t obstacle_num, const Vector3f& seg_start, const Vector3f& seg_end, Vector3f& closest_point) const
+bool AP_Proximity_Boundary_3D::closest_point_from_segment_to_obstacle(uint16_t obstacle_num, const Vector3f& seg_start, const Vector3f& seg_end, Vector3f& closest_point) const
 {
     Face face;
     if (!convert_obstacle_num_to_face(obstacle_num, face)) {
@@ -344,8 +346,8 @@ bool AP_Proximity_Boundary_3D::get_closest_object(float& angle_deg, float &dista
     // lower layers might contain ground, which will give false pre-arm failure
     for (uint8_t layer=PROXIMITY_MIDDLE_LAYER; layer<PROXIMITY_NUM_LAYERS; layer++) {
         for (uint8_t sector=0; sector<PROXIMITY_NUM_SECTORS; sector++) {
-            if (_distance_valid[layer][sector]) {
-                if (!closest_found || (_distance[layer][sector] < _distance[closest_layer][closest_sector])) {
+            if (state(layer, sector).valid) {
+                if (!closest_found || (state(layer, sector).distance < state(closest_layer, closest_sector).distance)) {
                     closest_layer = layer;
                     closest_sector = sector;
                     closest_found = true;
@@ -355,8 +357,8 @@ bool AP_Proximity_Boundary_3D::get_closest_object(float& angle_deg, float &dista
     }
 
     if (closest_found) {
-        angle_deg = _angle_deg[closest_layer][closest_sector];
-        distance = _distance[closest_layer][closest_sector];
+        angle_deg = state(closest_layer, closest_sector).angle_deg;
+        distance = state(closest_layer, closest_sector).distance;
     }
     return closest_found;
 }
@@ -371,9 +373,9 @@ uint8_t AP_Proximity_Boundary_3D::get_horizontal_object_count() const
 // returns false if no angle or distance could be returned for some reason
 bool AP_Proximity_Boundary_3D::get_horizontal_object_angle_and_distance(uint8_t object_number, float &angle_deg, float &distance) const
 {
-    if ((object_number < PROXIMITY_NUM_SECTORS) && _distance_valid[PROXIMITY_MIDDLE_LAYER][object_number]) {
-        angle_deg = _angle_deg[PROXIMITY_MIDDLE_LAYER][object_number];
-        distance = _filtered_distance[PROXIMITY_MIDDLE_LAYER][object_number].get();
+    if ((object_number < PROXIMITY_NUM_SECTORS) && state(PROXIMITY_MIDDLE_LAYER, object_number).valid) {
+        angle_deg = state(PROXIMITY_MIDDLE_LAYER, object_number).angle_deg;
+        distance = state(PROXIMITY_MIDDLE_LAYER, object_number).filtered_distance.get();
         return true;
     }
     return false;
@@ -381,21 +383,46 @@ bool AP_Proximity_Boundary_3D::get_horizontal_object_angle_and_distance(uint8_t
 
 // get an obstacle info for AP_Periph
 // returns false if no angle or distance could be returned for some reason
-bool AP_Proximity_Boundary_3D::get_obstacle_info(uint8_t obstacle_num, float &angle_deg, float &pitch_deg, float &distance) const
+bool AP_Proximity_Boundary_3D::get_obstacle_info(uint16_t obstacle_num, float &angle_deg, float &pitch_deg, float &distance) const
 {
     // obstacle num is just "flattened layers, and sectors"
-    const uint8_t layer = obstacle_num / PROXIMITY_NUM_SECTORS;
-    const uint8_t sector = obstacle_num % PROXIMITY_NUM_SECTORS;
-    if (_distance_valid[layer][sector]) {
-        angle_deg = _angle_deg[layer][sector];
-        pitch_deg = _pitch_deg[layer][sector];
-        distance = _filtered_distance[layer][sector].get();
+    if (obstacle_num >= PROXIMITY_NUM_FACES) {
+        return false;
+    }
+    const FaceState &f = _faces[obstacle_num];
+    if (f.valid) {
+        angle_deg = f.angle_deg;
+        pitch_deg = f.pitch_deg;
+        distance = f.filtered_distance.get();
         return true;
     }
 
     return false;
 }
 
+// find the valid face with the shortest distance among count sectors
+// of a layer, clockwise from first_sector (which may be negative)
+// returns false if none are valid
+bool AP_Proximity_Boundary_3D::get_closest_face(uint8_t layer, int16_t first_sector, uint8_t count, Face &face) const
+{
+    if (layer >= PROXIMITY_NUM_LAYERS) {
+        return false;
+    }
+    bool found = false;
+    float shortest_distance = FLT_MAX;
+    uint8_t sector = (first_sector % PROXIMITY_NUM_SECTORS + PROXIMITY_NUM_SECTORS) % PROXIMITY_NUM_SECTORS;
+    for (uint8_t i=0; i<count; i++) {
+        const FaceState &f = state(layer, sector);
+        if (f.valid && (!found || f.distance < shortest_distance)) {
+            shortest_distance = f.distance;
+            face = Face{layer, sector};
+            found = true;
+        }
+        sector = get_next_sector(sector);
+    }
+    return found;
+}
+
 // Return filtered distance for the passed in face
 bool AP_Proximity_Boundary_3D::get_filtered_distance(const Face &face, float &distance) const
 {
@@ -403,16 +430,16 @@ bool AP_Proximity_Boundary_3D::get_filtered_distance(const Face &face, float &di
         return false;
     }
 
-    if (!_distance_valid[face.layer][face.sector]) {
+    if (!state(face).valid) {
         // invalid distace
         return false;
     }
 
-    distance = _filtered_distance[face.layer][face.sector].get();
+    distance = state(face).filtered_distance.get();
     return true;
 }
 
-// Get raw and filtered distances in 8 directions per layer
+// Get raw and filtered distances in 8 directions per layer, the shortest of the sectors in each direction
 bool AP_Proximity_Boundary_3D::get_layer_distances(uint8_t layer_number, float dist_max, Proximity_Distance_Array &prx_dist_array, Proximity_Distance_Array &prx_filt_dist_array) const
 {
     // cycle through all sectors filling in distances and orientations
@@ -420,13 +447,17 @@ bool AP_Proximity_Boundary_3D::get_layer_distances(uint8_t layer_number, float d
     bool valid_distances = false;
     prx_dist_array.offset_valid = 0;
     prx_filt_dist_array.offset_valid = 0;
+    if (layer_number >= PROXIMITY_NUM_LAYERS) {
+        return false;
+    }
+    // each direction covers the sectors whose middle is within 22.5 degrees of it
+    const uint8_t sectors_per_direction = PROXIMITY_NUM_SECTORS / PROXIMITY_MAX_DIRECTION;
     for (uint8_t i=0; i<PROXIMITY_MAX_DIRECTION; i++) {
         prx_dist_array.orientation[i] = i;
-        const AP_Proximity_Boundary_3D::Face face(layer_number, i);
-        if (!face.valid()) {
-            return false;
-        }
-        if (get_distance(face, prx_dist_array.distance[i]) && get_filtered_distance(face, prx_filt_dist_array.distance[i])) {
+        const int16_t first_sector = i * sectors_per_direction - sectors_per_direction / 2;
+        AP_Proximity_Boundary_3D::Face face;
+        if (get_closest_face(layer_number, first_sector, sectors_per_direction, face) &&
+            get_distance(face, prx_dist_array.distance[i]) && get_filtered_distance(face, prx_filt_dist_array.distance[i])) {
             valid_distances = true;
             prx_dist_array.offset_valid |= (1U << i);
             prx_filt_dist_array.offset_valid |= (1U << i);
@@ -15,14 +15,17 @@
 
 #pragma once
 
+#include "AP_Proximity_config.h"
+
 #include <AP_Common/AP_Common.h>
 #include <AP_Math/AP_Math.h>
 #include <Filter/LowPassFilter.h>
 
-#define PROXIMITY_NUM_SECTORS         8       // number of sectors
-#define PROXIMITY_NUM_LAYERS          5       // num of layers in a sector
-#define PROXIMITY_MIDDLE_LAYER        2       // middle layer
-#define PROXIMITY_PITCH_WIDTH_DEG     30      // width between each layer in degrees
+#define PROXIMITY_NUM_SECTORS         AP_PROXIMITY_BOUNDARY_NUM_SECTORS    // number of sectors
+#define PROXIMITY_NUM_LAYERS          AP_PROXIMITY_BOUNDARY_NUM_LAYERS     // num of layers in a sector
+#define PROXIMITY_NUM_FACES           (PROXIMITY_NUM_LAYERS * PROXIMITY_NUM_SECTORS)
+#define PROXIMITY_MIDDLE_LAYER        (PROXIMITY_NUM_LAYERS / 2)           // middle layer
+#define PROXIMITY_PITCH_WIDTH_DEG     (150.0f/PROXIMITY_NUM_LAYERS)        // width between each layer in degrees
 #define PROXIMITY_SECTOR_WIDTH_DEG    (360.0f/PROXIMITY_NUM_SECTORS)   // width of sectors in degrees
 #define PROXIMITY_BOUNDARY_DIST_MIN   0.6f    // minimum distance for a boundary point.  This ensures the object avoidance code doesn't think we are outside the boundary.
 #define PROXIMITY_BOUNDARY_DIST_DEFAULT 100   // if we have no data for a sector, boundary is placed 100m out
@@ -66,7 +69,7 @@ public:
 	    bool operator !=(const Face &other) const { return ((layer != other.layer) || (sector != other.sector)); }
 
         uint8_t layer;  // vertical "steps" on the 3D Boundary. 0th layer is the bottom most layer, 1st layer is 30 degrees above (in body frame) and so on
-        uint8_t sector; // horizontal "steps" on the 3D Boundary. 0th sector is directly in front of the vehicle. Each sector is 45 degrees wide.
+        uint8_t sector; // horizontal "steps" on the 3D Boundary. 0th sector is directly in front of the vehicle. Each sector is PROXIMITY_SECTOR_WIDTH_DEG wide.
     };
 
     // returns face corresponding to the provided yaw and (optionally) pitch
@@ -103,15 +106,15 @@ public:
     bool get_distance(const Face &face, float &distance) const;
 
     // Get the total number of obstacles
-    uint8_t get_obstacle_count() const;
+    uint16_t get_obstacle_count() const;
 
     // Returns a body frame vector (in cm) to an obstacle
     // False is returned if the obstacle_num provided does not produce a valid obstacle
-    bool get_obstacle(uint8_t obstacle_num, Vector3f& vec_to_boundary) const;
+    bool get_obstacle(uint16_t obstacle_num, Vector3f& vec_to_boundary) const;
 
     // Returns a body frame vector (in cm) nearest to obstacle, in betwen seg_start and seg_end
     // True is returned if the segment intersects a plane formed by considering the "closest point" as normal vector to the plane.
-    bool closest_point_from_segment_to_obstacle(uint8_t obstacle_num, const Vector3f& seg_start, const Vector3f& seg_end, Vector3f& closest_point) const;
+    bool closest_point_from_segment_to_obstacle(uint16_t obstacle_num, const Vector3f& seg_start, const Vector3f& seg_end, Vector3f& closest_point) const;
 
     // get distance and angle to closest object (used for pre-arm check)
     //   returns true on success, false if no valid readings
@@ -122,23 +125,31 @@ public:
     bool get_horizontal_object_angle_and_distance(uint8_t object_number, float& angle_deg, float &distance) const;
 
     // get obstacle info for AP_Periph
-    bool get_obstacle_info(uint8_t obstacle_num, float &angle_deg, float &pitch_deg, float &distance) const;
+    bool get_obstacle_info(uint16_t obstacle_num, float &angle_deg, float &pitch_deg, float &distance) const;
+
+    // find the valid face with the shortest distance among count
+    // sectors of a layer, clockwise from first_sector (which may be
+    // negative). Returns false if none are valid
+    bool get_closest_face(uint8_t layer, int16_t first_sector, uint8_t count, Face &face) const;
 
     // get number of layers
     uint8_t get_num_layers() const { return PROXIMITY_NUM_LAYERS; }
 
-    // get raw and filtered distances in 8 directions per layer.
+    // get raw and filtered distances in 8 directions per layer, the shortest of the sectors in each direction
     bool get_layer_distances(uint8_t layer_number, float dist_max, Proximity_Distance_Array &prx_dist_array, Proximity_Distance_Array &prx_filt_dist_array) const;
 
     // pass down filter cut-off freq from params
     void set_filter_freq(float filt_freq) { _filter_freq = filt_freq; }
 
     // sectors
-    static_assert(PROXIMITY_NUM_SECTORS == 8, "PROXIMITY_NUM_SECTOR must be 8");
-    const uint16_t _sector_middle_deg[PROXIMITY_NUM_SECTORS] {0, 45, 90, 135, 180, 225, 270, 315};    // middle angle of each sector
+    static_assert(PROXIMITY_NUM_SECTORS % PROXIMITY_MAX_DIRECTION == 0 && PROXIMITY_NUM_SECTORS <= 128,
+                  "PROXIMITY_NUM_SECTORS must be a multiple of 8, up to 128");
+    // middle angle of each sector
+    static float sector_middle_deg(uint8_t sector) { return sector * PROXIMITY_SECTOR_WIDTH_DEG; }
     // layers
-    static_assert(PROXIMITY_NUM_LAYERS == 5, "PROXIMITY_NUM_LAYERS must be 5");
-    const int16_t _pitch_middle_deg[PROXIMITY_NUM_LAYERS] {-60, -30, 0, 30, 60};
+    static_assert(PROXIMITY_NUM_LAYERS % 2 == 1 && PROXIMITY_NUM_LAYERS < 16, "PROXIMITY_NUM_LAYERS must be odd");
+    // middle pitch of each layer, between -75 and 75 degrees
+    static float pitch_middle_deg(uint8_t layer) { return (layer + 0.5f) * PROXIMITY_PITCH_WIDTH_DEG - 75.0f; }
 
 private:
 
@@ -156,7 +167,7 @@ private:
     // "update_boundary" method manipulates two sectors ccw and one sector cw from any valid face.
     // Any boundary that does not fall into these manipulated faces are useless, and will be marked as false
     // The resultant is packed into a Boundary Location object and returned by reference as "face"
-    bool convert_obstacle_num_to_face(uint8_t obstacle_num, Face& face) const WARN_IF_UNUSED;
+    bool convert_obstacle_num_to_face(uint16_t obstacle_num, Face& face) const WARN_IF_UNUSED;
 
     // Apply a new cutoff_freq to low-pass filter
     void apply_filter_freq(float cutoff_freq);
@@ -167,16 +178,28 @@ private:
     // Return filtered distance for the passed in face
     bool get_filtered_distance(const Face &face, float &distance) const;
 
+    // state of each face. Everything updated with a new distance is
+    // kept together, rather than spread over an array per field
+    struct FaceState {
+        float distance;                         // distance to closest object within the face
+        float angle_deg;                        // yaw angle in degrees to closest object within the face
+        float pitch_deg;                        // pitch angle in degrees to the closest object within the face
+        uint32_t last_update_ms;                // time when distance was last updated
+        LowPassFilterFloat filtered_distance;   // low pass filter
+        uint8_t prx_instance;                   // proximity sensor backend instance that provided the distance
+        bool valid;                             // true if a valid distance has been received
+    };
+
+    // faces are stored layer by layer, sectors clockwise from the front
+    FaceState &state(uint8_t layer, uint8_t sector) { return _faces[layer * PROXIMITY_NUM_SECTORS + sector]; }
+    const FaceState &state(uint8_t layer, uint8_t sector) const { return _faces[layer * PROXIMITY_NUM_SECTORS + sector]; }
+    FaceState &state(const Face &face) { return state(face.layer, face.sector); }
+    const FaceState &state(const Face &face) const { return state(face.layer, face.sector); }
+
     Vector3f _sector_edge_vector[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];
     Vector3f _boundary_points[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];
 
-    float _angle_deg[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];          // yaw angle in degrees to closest object within each sector and layer
-    float _pitch_deg[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];          // pitch angle in degrees to the closest object within each sector and layer
-    float _distance[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];       // distance to closest object within each sector and layer
-    bool _distance_valid[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];  // true if a valid distance received for each sector and layer
-    uint32_t _last_update_ms[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS]; // time when distance was last updated
-    uint8_t _prx_instance[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS]; // proximity sensor backend instance that provided the distance
-    LowPassFilterFloat _filtered_distance[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS]; // low pass filter
+    FaceState _faces[PROXIMITY_NUM_FACES];
     float _filter_freq;                                                 // cutoff freq of low pass filter
     uint32_t _last_check_face_timeout_ms;                               // system time to throttle check_face_timeout method
 };
@@ -8,6 +8,17 @@
 #define HAL_PROXIMITY_ENABLED HAL_PROGRAM_SIZE_LIMIT_KB > 1024
 #endif
 
+// resolution of the 3D boundary used for avoidance. Sectors must be a
+// multiple of 8 and layers an odd number, dense 360 degree lidars
+// benefit from more sectors at the cost of memory and CPU
+#ifndef AP_PROXIMITY_BOUNDARY_NUM_SECTORS
+#define AP_PROXIMITY_BOUNDARY_NUM_SECTORS 8
+#endif
+
+#ifndef AP_PROXIMITY_BOUNDARY_NUM_LAYERS
+#define AP_PROXIMITY_BOUNDARY_NUM_LAYERS 5
+#endif
+
 #ifndef AP_PROXIMITY_BACKEND_DEFAULT_ENABLED
 #define AP_PROXIMITY_BACKEND_DEFAULT_ENABLED HAL_PROXIMITY_ENABLED
 #endif
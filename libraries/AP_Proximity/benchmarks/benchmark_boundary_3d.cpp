@@ -0,0 +1,101 @@
+#include <AP_gbenchmark.h>
+
+/*
+  cost of the 3D proximity boundary at the resolution it was built
+  with, see AP_PROXIMITY_BOUNDARY_NUM_SECTORS and _LAYERS
+ */
+
+#include <AP_Proximity/AP_Proximity_Boundary_3D.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// returns per revolution of a 3D lidar with a 0.5 degree step in yaw
+// and 16 beams spread over +-15 degrees of pitch
+static const uint16_t scan_steps = 720;
+static const uint8_t scan_beams = 16;
+
+static uint32_t seed = 1;
+static float rand_float(float min, float max)
+{
+    seed = seed * 1103515245U + 12345U;
+    return min + (max - min) * ((seed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+static AP_Proximity_Boundary_3D &get_boundary()
+{
+    static AP_Proximity_Boundary_3D boundary;
+    static bool initialised;
+    if (!initialised) {
+        initialised = true;
+        boundary.set_filter_freq(0.25);
+    }
+    return boundary;
+}
+
+// a revolution of the lidar sorted into a temp boundary and copied
+// into the boundary, as the serial lidar drivers do
+static void BM_Boundary3DScan(benchmark::State& state)
+{
+    AP_Proximity_Boundary_3D &boundary = get_boundary();
+    static AP_Proximity_Temp_Boundary temp_boundary;
+
+    while (state.KeepRunning()) {
+        temp_boundary.reset();
+        for (uint16_t s = 0; s < scan_steps; s++) {
+            const float yaw = s * (360.0f / scan_steps);
+            for (uint8_t b = 0; b < scan_beams; b++) {
+                const float pitch = -15.0f + b * (30.0f / (scan_beams - 1));
+                const AP_Proximity_Boundary_3D::Face face = boundary.get_face(pitch, yaw);
+                temp_boundary.add_distance(face, pitch, yaw, rand_float(1, 30));
+            }
+        }
+        temp_boundary.update_3D_boundary(0, boundary);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * scan_steps * scan_beams);
+    state.counters["bytes"] = sizeof(AP_Proximity_Boundary_3D) + sizeof(AP_Proximity_Temp_Boundary);
+}
+
+// simple avoidance visiting every obstacle
+static void BM_Boundary3DObstacles(benchmark::State& state)
+{
+    AP_Proximity_Boundary_3D &boundary = get_boundary();
+
+    while (state.KeepRunning()) {
+        const Vector3f stopping_point{rand_float(-500, 500), rand_float(-500, 500), 0};
+        uint16_t count = 0;
+        for (uint16_t i = 0; i < boundary.get_obstacle_count(); i++) {
+            Vector3f vec;
+            if (!boundary.get_obstacle(i, vec)) {
+                continue;
+            }
+            Vector3f closest;
+            if (boundary.closest_point_from_segment_to_obstacle(i, Vector3f{}, stopping_point, closest)) {
+                count++;
+            }
+        }
+        gbenchmark_escape(&count);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * boundary.get_obstacle_count());
+}
+
+// distances in the 8 directions of every layer, as logged and sent
+// to the ground station
+static void BM_Boundary3DLayerDistances(benchmark::State& state)
+{
+    AP_Proximity_Boundary_3D &boundary = get_boundary();
+
+    while (state.KeepRunning()) {
+        for (uint8_t layer = 0; layer < boundary.get_num_layers(); layer++) {
+            Proximity_Distance_Array dist_array, filt_dist_array;
+            bool ret = boundary.get_layer_distances(layer, 50, dist_array, filt_dist_array);
+            gbenchmark_escape(&ret);
+            gbenchmark_escape(&dist_array);
+        }
+    }
+}
+
+BENCHMARK(BM_Boundary3DScan);
+BENCHMARK(BM_Boundary3DObstacles);
+BENCHMARK(BM_Boundary3DLayerDistances);
+
+BENCHMARK_MAIN();
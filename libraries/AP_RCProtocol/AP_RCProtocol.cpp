@@ -42,6 +42,7 @@
 #include "AP_RCProtocol_FDM.h"
 #include "AP_RCProtocol_Radio.h"
 #include <AP_Math/AP_Math.h>
+#include <AP_HAL/utility/UARTSpanReader.h>
 #include <RC_Channel/RC_Channel.h>
 
 #include <AP_Vehicle/AP_Vehicle_Type.h>
@@ -378,14 +379,11 @@ void AP_RCProtocol::check_added_uart(void)
     const uint32_t current_baud = serial_configs[added.config_num].baud;
     process_handshake(current_baud);
 
-    uint32_t n = added.uart->available();
-    n = MIN(n, 255U);
-    for (uint8_t i=0; i<n; i++) {
-        int16_t b = added.uart->read();
-        if (b >= 0) {
-            process_byte(uint8_t(b), current_baud);
+    UARTSpanReader::read_all(*added.uart, 255U, [&](const uint8_t *span, uint16_t len) {
+        for (uint16_t i=0; i<len; i++) {
+            process_byte(span[i], current_baud);
         }
-    }
+    });
     if (searching) {
         if (now - added.last_config_change_ms > 1000) {
             // change configs if not detected once a second
@@ -17,6 +17,7 @@
  */
 
 #include "AP_ROMFS.h"
+#include "AP_ROMFS_Stream.h"
 #include "tinf.h"
 #include <AP_Math/crc.h>
 
@@ -55,18 +56,22 @@ const uint8_t *AP_ROMFS::find_decompress(const char *name, uint32_t &size)
     if (f == nullptr) {
         return nullptr;
     }
+    return decompress(*f, size);
+}
 
+const uint8_t *AP_ROMFS::decompress(const embedded_file &f, uint32_t &size)
+{
 #ifdef HAL_ROMFS_UNCOMPRESSED
-    size = f->decompressed_size;
-    return f->contents;
+    size = f.decompressed_size;
+    return f.contents;
 #else
     // add one byte for null termination; ArduPilot's malloc will zero it.
-    uint8_t *decompressed_data = (uint8_t *)malloc(f->decompressed_size+1);
+    uint8_t *decompressed_data = (uint8_t *)malloc(f.decompressed_size+1);
     if (!decompressed_data) {
         return nullptr;
     }
 
-    if (f->decompressed_size == 0) {
+    if (f.decompressed_size == 0) {
         // empty file, avoid decompression problems
         size = 0;
         return decompressed_data;
@@ -79,10 +84,10 @@ const uint8_t *AP_ROMFS::find_decompress(const char *name, uint32_t &size)
     }
     uzlib_uncompress_init(d, NULL, 0);
 
-    d->source = f->contents;
-    d->source_limit = f->contents + f->compressed_size;
+    d->source = f.contents;
+    d->source_limit = f.contents + f.compressed_size;
     d->dest = decompressed_data;
-    d->destSize = f->decompressed_size;
+    d->destSize = f.decompressed_size;
 
     int res = uzlib_uncompress(d);
 
@@ -93,12 +98,12 @@ const uint8_t *AP_ROMFS::find_decompress(const char *name, uint32_t &size)
         return nullptr;
     }
 
-    if (crc32_small(0, decompressed_data, f->decompressed_size) != f->crc) {
+    if (crc32_small(0, decompressed_data, f.decompressed_size) != f.crc) {
         ::free(decompressed_data);
         return nullptr;
     }
     
-    size = f->decompressed_size;
+    size = f.decompressed_size;
     return decompressed_data;
 #endif
 }
@@ -111,6 +116,28 @@ void AP_ROMFS::free(const uint8_t *data)
 #endif
 }
 
+/*
+  Find the named file and open it to be decompressed as it is read
+*/
+AP_ROMFS_Stream *AP_ROMFS::open_stream(const char *name, bool use_cache)
+{
+    const struct embedded_file *f = find_file(name);
+    if (f == nullptr) {
+        return nullptr;
+    }
+    return open_stream(*f, use_cache);
+}
+
+AP_ROMFS_Stream *AP_ROMFS::open_stream(const embedded_file &f, bool use_cache)
+{
+    AP_ROMFS_Stream *stream = NEW_NOTHROW AP_ROMFS_Stream(f, use_cache);
+    if (stream != nullptr && !stream->init()) {
+        delete stream;
+        return nullptr;
+    }
+    return stream;
+}
+
 /*
   directory listing interface. Start with ofs=0. Returns pathnames
   that match dirname prefix. Ends with nullptr return when no more
@@ -5,6 +5,8 @@
 
 #include <stdint.h>
 
+class AP_ROMFS_Stream;
+
 class AP_ROMFS {
 public:
     //  Find the named file and return its decompressed data and size. Caller
@@ -16,6 +18,13 @@ public:
     // free decompressed file data
     static void free(const uint8_t *data);
 
+    //  Find the named file and open it to be decompressed as it is
+    //  read, which needs memory for a window of up to 32k rather than
+    //  for the whole file. With use_cache the decompressed data is
+    //  kept in a page cache shared with the other streams, for files
+    //  which are read more than once. Use delete to close the stream.
+    static AP_ROMFS_Stream *open_stream(const char *name, bool use_cache=false);
+
     // get the size of a file without decompressing
     static bool find_size(const char *name, uint32_t &size);
 
@@ -27,6 +36,10 @@ public:
     static const char *dir_list(const char *dirname, uint16_t &ofs);
 
 private:
+    friend class AP_ROMFS_Stream;
+    friend class AP_ROMFS_Test;
+    friend class AP_ROMFS_Benchmark;
+
     struct embedded_file {
         const char *filename;
         uint32_t compressed_size;
@@ -38,5 +51,8 @@ private:
     // find an embedded file
     static const AP_ROMFS::embedded_file *find_file(const char *name);
 
+    static const uint8_t *decompress(const embedded_file &f, uint32_t &size);
+    static AP_ROMFS_Stream *open_stream(const embedded_file &f, bool use_cache);
+
     static const struct embedded_file files[];
 };
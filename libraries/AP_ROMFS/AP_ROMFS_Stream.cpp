@@ -0,0 +1,245 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+  read an embedded file, decompressing it as it is read.
+
+  The decompressor keeps the data it has decompressed in a ring, which
+  it needs for the back references in the compressed data. Reads are
+  served from that window where they can be, so reading a file in
+  order decompresses it once using memory for the window rather than
+  the whole file. The crc of the file is checked when decompression
+  reaches its end.
+ */
+
+#include "AP_ROMFS_Stream.h"
+#include "tinf.h"
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/crc.h>
+
+#include <string.h>
+
+#if AP_ROMFS_PAGE_CACHE_SIZE > 0
+AP_ROMFS_Stream::cache_entry AP_ROMFS_Stream::cache[cache_pages];
+uint8_t *AP_ROMFS_Stream::cache_data;
+uint32_t AP_ROMFS_Stream::cache_use_counter;
+HAL_Semaphore AP_ROMFS_Stream::cache_sem;
+#endif
+
+AP_ROMFS_Stream::AP_ROMFS_Stream(const AP_ROMFS::embedded_file &_file, bool _use_cache) :
+    file(_file),
+    use_cache(_use_cache)
+{
+}
+
+AP_ROMFS_Stream::~AP_ROMFS_Stream()
+{
+    free(window);
+    free(tinf);
+}
+
+bool AP_ROMFS_Stream::init()
+{
+#ifndef HAL_ROMFS_UNCOMPRESSED
+    // back references can't go further than the start of the file
+    window_size = MIN(file.decompressed_size, uint32_t(AP_ROMFS_WINDOW_SIZE));
+    if (window_size == 0) {
+        return true;
+    }
+    window = (uint8_t *)malloc(window_size);
+    tinf = (TINF_DATA *)malloc(sizeof(TINF_DATA));
+    if (window == nullptr || tinf == nullptr) {
+        return false;
+    }
+    restart();
+#endif
+    return true;
+}
+
+/*
+  start decompressing from the start of the file
+ */
+void AP_ROMFS_Stream::restart()
+{
+    uzlib_uncompress_init(tinf, window, window_size);
+    tinf->source = file.contents;
+    tinf->source_limit = file.contents + file.compressed_size;
+    inflate_ofs = 0;
+    crc = 0;
+}
+
+/*
+  decompress the next count bytes into buf
+ */
+bool AP_ROMFS_Stream::inflate(uint8_t *buf, uint32_t count)
+{
+    tinf->dest = buf;
+    tinf->destSize = count;
+    if (uzlib_uncompress(tinf) != TINF_OK || tinf->dest != buf + count) {
+        return false;
+    }
+    inflate_ofs += count;
+    crc = crc32_small(crc, buf, count);
+    if (inflate_ofs == file.decompressed_size && crc != file.crc) {
+        return false;
+    }
+    return true;
+}
+
+/*
+  copy data which is still in the window
+ */
+void AP_ROMFS_Stream::copy_from_window(uint8_t *buf, uint32_t pos, uint32_t count) const
+{
+    // the window is a ring starting at the start of the file
+    const uint32_t wofs = pos % window_size;
+    const uint32_t n = MIN(count, window_size - wofs);
+    memcpy(buf, &window[wofs], n);
+    memcpy(&buf[n], window, count - n);
+}
+
+int32_t AP_ROMFS_Stream::read(void *buf, uint32_t count)
+{
+    if (failed) {
+        return -1;
+    }
+    count = MIN(count, file.decompressed_size - ofs);
+#ifdef HAL_ROMFS_UNCOMPRESSED
+    memcpy(buf, &file.contents[ofs], count);
+    ofs += count;
+#else
+    uint32_t done = 0;
+    while (done < count) {
+        const uint32_t n = read_some((uint8_t *)buf + done, count - done);
+        if (n == 0) {
+            failed = true;
+            return -1;
+        }
+        done += n;
+        ofs += n;
+    }
+#endif
+    return count;
+}
+
+/*
+  read up to count bytes from ofs, from wherever they are quickest to
+  get. Returns zero if the file is corrupt
+ */
+uint32_t AP_ROMFS_Stream::read_some(uint8_t *buf, uint32_t count)
+{
+    if (ofs < inflate_ofs && inflate_ofs - ofs <= window_size) {
+        const uint32_t n = MIN(count, inflate_ofs - ofs);
+        copy_from_window(buf, ofs, n);
+        return n;
+    }
+
+#if AP_ROMFS_PAGE_CACHE_SIZE > 0
+    if (use_cache) {
+        const uint32_t n = cache_read(buf, count);
+        if (n > 0) {
+            return n;
+        }
+    }
+#endif
+
+    if (ofs < inflate_ofs) {
+        restart();
+    }
+
+    // decompress a page at a time, so that each page is still in the
+    // window to be cached when it is complete. Data before ofs is
+    // decompressed into buf and discarded
+    while (true) {
+        const uint32_t page_end = MIN((inflate_ofs / AP_ROMFS_PAGE_SIZE + 1) * AP_ROMFS_PAGE_SIZE,
+                                      file.decompressed_size);
+        const bool skipping = inflate_ofs < ofs;
+        const uint32_t n = MIN(count, page_end - inflate_ofs);
+        if (!inflate(buf, n)) {
+            return 0;
+        }
+#if AP_ROMFS_PAGE_CACHE_SIZE > 0
+        if (use_cache && inflate_ofs == page_end) {
+            cache_add((page_end - 1) / AP_ROMFS_PAGE_SIZE);
+        }
+#endif
+        if (!skipping) {
+            return n;
+        }
+        if (inflate_ofs > ofs) {
+            // the last part of what was skipped is wanted
+            const uint32_t wanted = MIN(count, inflate_ofs - ofs);
+            copy_from_window(buf, ofs, wanted);
+            return wanted;
+        }
+    }
+}
+
+void AP_ROMFS_Stream::seek(uint32_t _ofs)
+{
+    ofs = MIN(_ofs, file.decompressed_size);
+}
+
+#if AP_ROMFS_PAGE_CACHE_SIZE > 0
+/*
+  read up to count bytes from ofs if its page is cached
+ */
+uint32_t AP_ROMFS_Stream::cache_read(uint8_t *buf, uint32_t count)
+{
+    WITH_SEMAPHORE(cache_sem);
+    const uint32_t page = ofs / AP_ROMFS_PAGE_SIZE;
+    for (uint16_t i=0; i<cache_pages; i++) {
+        if (cache[i].file == &file && cache[i].page == page) {
+            const uint32_t page_ofs = ofs % AP_ROMFS_PAGE_SIZE;
+            const uint32_t page_len = MIN(uint32_t(AP_ROMFS_PAGE_SIZE), file.decompressed_size - page * AP_ROMFS_PAGE_SIZE);
+            const uint32_t n = MIN(count, page_len - page_ofs);
+            memcpy(buf, &cache_data[i * AP_ROMFS_PAGE_SIZE + page_ofs], n);
+            cache[i].last_use = ++cache_use_counter;
+            return n;
+        }
+    }
+    return 0;
+}
+
+/*
+  add a page which has just been decompressed to the cache, replacing
+  the least recently used page
+ */
+void AP_ROMFS_Stream::cache_add(uint32_t page)
+{
+    WITH_SEMAPHORE(cache_sem);
+    if (cache_data == nullptr) {
+        cache_data = (uint8_t *)malloc(cache_pages * AP_ROMFS_PAGE_SIZE);
+        if (cache_data == nullptr) {
+            return;
+        }
+    }
+    uint16_t idx = 0;
+    for (uint16_t i=0; i<cache_pages; i++) {
+        if (cache[i].file == &file && cache[i].page == page) {
+            return;
+        }
+        if (cache[i].file == nullptr ||
+            (cache[idx].file != nullptr && cache[i].last_use < cache[idx].last_use)) {
+            idx = i;
+        }
+    }
+    const uint32_t page_start = page * AP_ROMFS_PAGE_SIZE;
+    cache[idx].file = &file;
+    cache[idx].page = page;
+    cache[idx].last_use = ++cache_use_counter;
+    copy_from_window(&cache_data[idx * AP_ROMFS_PAGE_SIZE], page_start, inflate_ofs - page_start);
+}
+#endif  // AP_ROMFS_PAGE_CACHE_SIZE > 0
@@ -0,0 +1,87 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+  read an embedded file, decompressing it as it is read
+ */
+#pragma once
+
+#include "AP_ROMFS.h"
+#include "AP_ROMFS_config.h"
+
+#include <AP_Common/AP_Common.h>
+#if AP_ROMFS_PAGE_CACHE_SIZE > 0
+#include <AP_HAL/Semaphores.h>
+#endif
+
+struct TINF_DATA;
+
+class AP_ROMFS_Stream {
+public:
+    ~AP_ROMFS_Stream();
+
+    CLASS_NO_COPY(AP_ROMFS_Stream);
+
+    uint32_t size() const { return file.decompressed_size; }
+
+    // read from the current offset, returning the number of bytes
+    // read, or -1 if the file is corrupt
+    int32_t read(void *buf, uint32_t count);
+
+    // set the offset for the next read. Reads before the data last
+    // decompressed which are not in the page cache start decompressing
+    // again from the start of the file
+    void seek(uint32_t ofs);
+    uint32_t tell() const { return ofs; }
+
+private:
+    friend class AP_ROMFS;
+
+    AP_ROMFS_Stream(const AP_ROMFS::embedded_file &file, bool use_cache);
+    bool init();
+
+    uint32_t read_some(uint8_t *buf, uint32_t count);
+    void restart();
+    bool inflate(uint8_t *buf, uint32_t count);
+    void copy_from_window(uint8_t *buf, uint32_t pos, uint32_t count) const;
+
+    const AP_ROMFS::embedded_file &file;
+    const bool use_cache;
+    bool failed = false;
+    uint32_t ofs = 0;
+
+    // decompression state, with the most recently decompressed data
+    // in the window
+    TINF_DATA *tinf = nullptr;
+    uint8_t *window = nullptr;
+    uint32_t window_size = 0;
+    uint32_t inflate_ofs = 0;
+    uint32_t crc = 0;
+
+#if AP_ROMFS_PAGE_CACHE_SIZE > 0
+    static constexpr uint16_t cache_pages = AP_ROMFS_PAGE_CACHE_SIZE / AP_ROMFS_PAGE_SIZE;
+    struct cache_entry {
+        const AP_ROMFS::embedded_file *file;
+        uint32_t page;
+        uint32_t last_use;
+    };
+    static cache_entry cache[cache_pages];
+    static uint8_t *cache_data;
+    static uint32_t cache_use_counter;
+    static HAL_Semaphore cache_sem;
+
+    uint32_t cache_read(uint8_t *buf, uint32_t count);
+    void cache_add(uint32_t page);
+#endif
+};
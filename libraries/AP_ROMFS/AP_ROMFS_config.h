@@ -0,0 +1,24 @@
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+
+// files are compressed with a 32k window (see Tools/ardupilotwaf/embed.py)
+// so a stream needs to keep up to this much decompressed data
+#ifndef AP_ROMFS_WINDOW_SIZE
+#define AP_ROMFS_WINDOW_SIZE 32768
+#endif
+
+// streams decompress and cache files in pages of this size
+#ifndef AP_ROMFS_PAGE_SIZE
+#define AP_ROMFS_PAGE_SIZE 1024
+#endif
+
+// size of the cache of decompressed pages shared by the streams opened
+// with caching, zero to disable it
+#ifndef AP_ROMFS_PAGE_CACHE_SIZE
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_1000 && !defined(HAL_BOOTLOADER_BUILD)
+#define AP_ROMFS_PAGE_CACHE_SIZE 32768
+#else
+#define AP_ROMFS_PAGE_CACHE_SIZE 0
+#endif
+#endif
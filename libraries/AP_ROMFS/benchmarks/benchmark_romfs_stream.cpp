@@ -0,0 +1,191 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  reading a ROMFS file in 512 byte blocks, as AP_Filesystem_ROMFS
+  does, by decompressing it all with find_decompress() and by
+  streaming it, with and without the page cache. The argument is the
+  size of the file.
+
+  peak_heap is the most memory allocated at once while reading the
+  file, counted by replacing malloc and friends with versions which
+  track the glibc allocations.
+ */
+#include <AP_gbenchmark.h>
+
+#include <malloc.h>
+
+#include <AP_ROMFS/AP_ROMFS.h>
+#include <AP_ROMFS/AP_ROMFS_Stream.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/crc.h>
+
+#include "../tests/romfs_test_file.h"
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+}
+
+static size_t heap_used;
+static size_t heap_peak;
+
+static void *track_alloc(void *ptr)
+{
+    if (ptr != nullptr) {
+        heap_used += malloc_usable_size(ptr);
+        heap_peak = MAX(heap_peak, heap_used);
+    }
+    return ptr;
+}
+
+void *malloc(size_t size)
+{
+    return track_alloc(__libc_malloc(size));
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    return track_alloc(__libc_calloc(nmemb, size));
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    const size_t old_size = ptr != nullptr ? malloc_usable_size(ptr) : 0;
+    void *ret = __libc_realloc(ptr, size);
+    if (ret != nullptr || size == 0) {
+        heap_used -= old_size;
+        track_alloc(ret);
+    }
+    return ret;
+}
+
+void free(void *ptr)
+{
+    if (ptr != nullptr) {
+        heap_used -= malloc_usable_size(ptr);
+    }
+    __libc_free(ptr);
+}
+
+class AP_ROMFS_Benchmark
+{
+public:
+    AP_ROMFS_Benchmark(uint32_t size) :
+        text(make_text(size, size)),
+        compressed(DeflateFixed::compress(text))
+    {
+        file.filename = "benchmark";
+        file.compressed_size = compressed.size();
+        file.decompressed_size = text.size();
+        file.crc = crc32_small(0, text.data(), text.size());
+        file.contents = compressed.data();
+    }
+
+    // read the file as AP_Filesystem_ROMFS did before streaming
+    bool read_decompressed() {
+        uint32_t size;
+        const uint8_t *data = AP_ROMFS::decompress(file, size);
+        if (data == nullptr) {
+            return false;
+        }
+        for (uint32_t ofs = 0; ofs < size; ofs += sizeof(block)) {
+            memcpy(block, &data[ofs], MIN(uint32_t(sizeof(block)), size - ofs));
+            benchmark::DoNotOptimize(block);
+        }
+        AP_ROMFS::free(data);
+        return true;
+    }
+
+    bool read_stream(bool use_cache) {
+        AP_ROMFS_Stream *stream = AP_ROMFS::open_stream(file, use_cache);
+        if (stream == nullptr) {
+            return false;
+        }
+        int32_t n;
+        while ((n = stream->read(block, sizeof(block))) > 0) {
+            benchmark::DoNotOptimize(block);
+        }
+        delete stream;
+        return n == 0;
+    }
+
+private:
+    std::vector<uint8_t> text;
+    std::vector<uint8_t> compressed;
+    AP_ROMFS::embedded_file file;
+    uint8_t block[512];
+};
+
+/*
+  the files are kept for the whole run, as the page cache knows them
+  by their address like the embedded files
+ */
+static AP_ROMFS_Benchmark &get_file(uint32_t size)
+{
+    static std::vector<std::pair<uint32_t, AP_ROMFS_Benchmark*>> files;
+    for (auto &f : files) {
+        if (f.first == size) {
+            return *f.second;
+        }
+    }
+    files.push_back(std::make_pair(size, new AP_ROMFS_Benchmark(size)));
+    return *files.back().second;
+}
+
+static void run(benchmark::State &state, bool stream, bool use_cache)
+{
+    AP_ROMFS_Benchmark &bench = get_file(state.range(0));
+    if (use_cache) {
+        // fill the cache with what it can hold of the file
+        bench.read_stream(true);
+    }
+    size_t peak = 0;
+    for (auto _ : state) {
+        const size_t base = heap_used;
+        heap_peak = base;
+        if (!(stream ? bench.read_stream(use_cache) : bench.read_decompressed())) {
+            state.SkipWithError("read failed");
+            return;
+        }
+        peak = MAX(peak, heap_peak - base);
+    }
+    state.counters["peak_heap"] = peak;
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_FindDecompress(benchmark::State &state)
+{
+    run(state, false, false);
+}
+
+static void BM_Stream(benchmark::State &state)
+{
+    run(state, true, false);
+}
+
+static void BM_StreamCached(benchmark::State &state)
+{
+    run(state, true, true);
+}
+
+BENCHMARK(BM_FindDecompress)->RangeMultiplier(4)->Range(8<<10, 512<<10);
+BENCHMARK(BM_Stream)->RangeMultiplier(4)->Range(8<<10, 512<<10);
+BENCHMARK(BM_StreamCached)->RangeMultiplier(4)->Range(8<<10, 512<<10);
+
+BENCHMARK_MAIN();
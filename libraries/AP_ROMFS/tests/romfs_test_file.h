@@ -0,0 +1,156 @@
+#pragma once
+
+/*
+  files for the AP_ROMFS tests and benchmarks. ROMFS files are
+  compressed by Tools/ardupilotwaf/embed.py, so this makes compressed
+  files the decompressor will accept at run time: a raw deflate stream
+  using the fixed Huffman codes, with back references up to the full
+  32k window
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+class DeflateFixed {
+public:
+    static std::vector<uint8_t> compress(const std::vector<uint8_t> &data) {
+        DeflateFixed d;
+        d.bits(1, 1);   // final block
+        d.bits(1, 2);   // fixed Huffman codes
+
+        std::vector<int32_t> head(1U<<15, -1);
+        std::vector<int32_t> prev(data.size(), -1);
+        uint32_t i = 0;
+        while (i < data.size()) {
+            uint32_t best_len = 0, best_dist = 0;
+            if (i + 3 <= data.size()) {
+                // try the last few places these three bytes were seen
+                uint8_t tries = 0;
+                for (int32_t j = head[hash(&data[i])]; j >= 0 && i - j <= 32768 && tries < 16; j = prev[j], tries++) {
+                    uint32_t len = 0;
+                    while (len < 258 && i + len < data.size() && data[j+len] == data[i+len]) {
+                        len++;
+                    }
+                    if (len > best_len) {
+                        best_len = len;
+                        best_dist = i - j;
+                    }
+                }
+            }
+            const uint32_t n = best_len >= 3 ? best_len : 1;
+            if (n == 1) {
+                d.symbol(data[i]);
+            } else {
+                d.length(best_len);
+                d.distance(best_dist);
+            }
+            for (uint32_t k = 0; k < n; k++, i++) {
+                if (i + 3 <= data.size()) {
+                    const uint32_t h = hash(&data[i]);
+                    prev[i] = head[h];
+                    head[h] = i;
+                }
+            }
+        }
+        d.symbol(256);  // end of block
+        d.bits(0, 7);   // flush
+        return d.out;
+    }
+
+private:
+    std::vector<uint8_t> out;
+    uint32_t bitbuf = 0;
+    uint8_t bitcount = 0;
+
+    static uint32_t hash(const uint8_t *p) {
+        return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & 0x7FFF;
+    }
+
+    void bits(uint32_t value, uint8_t n) {
+        bitbuf |= value << bitcount;
+        bitcount += n;
+        while (bitcount >= 8) {
+            out.push_back(bitbuf & 0xFF);
+            bitbuf >>= 8;
+            bitcount -= 8;
+        }
+    }
+
+    // Huffman codes are sent most significant bit first
+    void code(uint32_t value, uint8_t n) {
+        uint32_t r = 0;
+        for (uint8_t b = 0; b < n; b++) {
+            r = (r << 1) | ((value >> b) & 1);
+        }
+        bits(r, n);
+    }
+
+    void symbol(uint16_t sym) {
+        if (sym < 144) {
+            code(0x30 + sym, 8);
+        } else if (sym < 256) {
+            code(0x190 + sym - 144, 9);
+        } else if (sym < 280) {
+            code(sym - 256, 7);
+        } else {
+            code(0xC0 + sym - 280, 8);
+        }
+    }
+
+    void length(uint32_t len) {
+        static const uint16_t base[29] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+        static const uint8_t extra[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+        uint8_t c = 28;
+        while (base[c] > len) {
+            c--;
+        }
+        symbol(257 + c);
+        bits(len - base[c], extra[c]);
+    }
+
+    void distance(uint32_t dist) {
+        static const uint16_t base[30] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+        static const uint8_t extra[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+        uint8_t c = 29;
+        while (base[c] > dist) {
+            c--;
+        }
+        code(c, 5);
+        bits(dist - base[c], extra[c]);
+    }
+};
+
+/*
+  text made of words, with lines copied from up to 32k back like the
+  repeated parts of scripts and web pages
+ */
+static inline std::vector<uint8_t> make_text(uint32_t size, uint32_t seed)
+{
+    static const char *words[] = { "local", "function", "end", "return", "if", "then", "else",
+                                   "param", "gcs:send_text", "vehicle", "for", "in", "ipairs",
+                                   "<div", "class=", "</div>", "\n", "  ", "=", "(", ")", "," };
+    std::vector<uint8_t> text;
+    while (text.size() < size) {
+        seed = seed * 1103515245U + 12345U;
+        const uint32_t r = seed >> 8;
+        if (r % 8 == 0 && text.size() > 100) {
+            const uint32_t back = 1 + (r >> 3) % (text.size() < 32768 ? text.size() : 32768);
+            const uint32_t len = 20 + (r >> 18) % 80;
+            const size_t start = text.size() - back;
+            for (uint32_t k = 0; k < len; k++) {
+                text.push_back(text[start + k]);
+            }
+        } else {
+            const char *w = words[r % (sizeof(words)/sizeof(words[0]))];
+            text.insert(text.end(), w, w + strlen(w));
+            text.push_back(' ');
+            // some numbers, so not everything repeats
+            if (r % 3 == 0) {
+                text.push_back('0' + (r >> 4) % 10);
+            }
+        }
+    }
+    text.resize(size);
+    return text;
+}
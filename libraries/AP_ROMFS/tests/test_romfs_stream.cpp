@@ -0,0 +1,183 @@
+#include <AP_gtest.h>
+
+/*
+  tests for reading ROMFS files as a stream, comparing what is read
+  with the original file and with AP_ROMFS::find_decompress()
+ */
+
+#include <AP_ROMFS/AP_ROMFS.h>
+#include <AP_ROMFS/AP_ROMFS_Stream.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/crc.h>
+
+#include "romfs_test_file.h"
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+class AP_ROMFS_Test
+{
+public:
+    AP_ROMFS_Test(uint32_t size, uint32_t seed) :
+        text(make_text(size, seed)),
+        compressed(DeflateFixed::compress(text))
+    {
+        file.filename = "test";
+        file.compressed_size = compressed.size();
+        file.decompressed_size = text.size();
+        file.crc = crc32_small(0, text.data(), text.size());
+        file.contents = compressed.data();
+    }
+
+    AP_ROMFS_Stream *open(bool use_cache) {
+        return AP_ROMFS::open_stream(file, use_cache);
+    }
+
+    const uint8_t *decompress(uint32_t &size) {
+        return AP_ROMFS::decompress(file, size);
+    }
+
+    void corrupt() {
+        file.crc ^= 1;
+    }
+
+    // read from ofs and compare with the file
+    void check_read(AP_ROMFS_Stream *stream, uint32_t ofs, uint32_t count) {
+        std::vector<uint8_t> buf(count + 1);
+        stream->seek(ofs);
+        const uint32_t size = text.size();
+        const uint32_t expected = ofs < size ? MIN(count, size - ofs) : 0;
+        ASSERT_EQ(int32_t(expected), stream->read(buf.data(), count));
+        if (expected > 0) {
+            ASSERT_EQ(0, memcmp(buf.data(), &text[ofs], expected));
+        }
+        ASSERT_EQ(MIN(ofs + expected, size), stream->tell());
+    }
+
+    std::vector<uint8_t> text;
+    std::vector<uint8_t> compressed;
+
+private:
+    AP_ROMFS::embedded_file file;
+};
+
+static uint32_t seed = 1;
+static uint32_t rand_u32(uint32_t max)
+{
+    seed = seed * 1103515245U + 12345U;
+    return (seed >> 8) % max;
+}
+
+TEST(AP_ROMFS, Decompress)
+{
+    static AP_ROMFS_Test test{100000, 1};
+    // the test file needs back references across the whole window
+    EXPECT_LT(test.compressed.size(), test.text.size() / 3);
+
+    uint32_t size;
+    const uint8_t *data = test.decompress(size);
+    ASSERT_NE(nullptr, data);
+    ASSERT_EQ(test.text.size(), size);
+    EXPECT_EQ(0, memcmp(data, test.text.data(), size));
+    AP_ROMFS::free(data);
+}
+
+TEST(AP_ROMFS, ReadInOrder)
+{
+    static AP_ROMFS_Test test{200000, 2};
+    AP_ROMFS_Stream *stream = test.open(false);
+    ASSERT_NE(nullptr, stream);
+    EXPECT_EQ(test.text.size(), stream->size());
+    uint32_t ofs = 0;
+    while (ofs < test.text.size()) {
+        const uint32_t count = 1 + rand_u32(3000);
+        test.check_read(stream, ofs, count);
+        ofs += count;
+    }
+    uint8_t b;
+    EXPECT_EQ(0, stream->read(&b, 1));
+    delete stream;
+}
+
+/*
+  seek around the file, within the window, before it and after it
+ */
+TEST(AP_ROMFS, ReadSeeking)
+{
+    static AP_ROMFS_Test test{150000, 3};
+    for (uint8_t use_cache=0; use_cache<2; use_cache++) {
+        AP_ROMFS_Stream *stream = test.open(use_cache);
+        ASSERT_NE(nullptr, stream);
+        uint32_t ofs = 0;
+        for (uint16_t i=0; i<300; i++) {
+            switch (rand_u32(4)) {
+            case 0:
+                ofs = rand_u32(test.text.size() + 10);
+                break;
+            case 1:
+                ofs = ofs > 40000 ? ofs - rand_u32(40000) : 0;
+                break;
+            default:
+                ofs += rand_u32(5000);
+                break;
+            }
+            const uint32_t count = 1 + rand_u32(5000);
+            test.check_read(stream, ofs, count);
+            ofs += count;
+        }
+        delete stream;
+    }
+}
+
+/*
+  a second stream for a file reads the pages cached by the first
+ */
+TEST(AP_ROMFS, ReadCached)
+{
+    static AP_ROMFS_Test test{20000, 4};
+    for (uint8_t i=0; i<3; i++) {
+        AP_ROMFS_Stream *stream = test.open(true);
+        ASSERT_NE(nullptr, stream);
+        test.check_read(stream, 0, test.text.size());
+        test.check_read(stream, 1000, 1000);
+        test.check_read(stream, 0, 10);
+        delete stream;
+    }
+}
+
+TEST(AP_ROMFS, SmallFiles)
+{
+    static AP_ROMFS_Test test{100, 5};
+    AP_ROMFS_Stream *stream = test.open(true);
+    ASSERT_NE(nullptr, stream);
+    test.check_read(stream, 50, 100);
+    test.check_read(stream, 0, 100);
+    test.check_read(stream, 99, 1);
+    delete stream;
+
+    static AP_ROMFS_Test empty{0, 6};
+    stream = empty.open(true);
+    ASSERT_NE(nullptr, stream);
+    EXPECT_EQ(0U, stream->size());
+    empty.check_read(stream, 0, 10);
+    delete stream;
+}
+
+TEST(AP_ROMFS, CorruptFile)
+{
+    static AP_ROMFS_Test test{50000, 7};
+    test.corrupt();
+
+    uint32_t size;
+    EXPECT_EQ(nullptr, test.decompress(size));
+
+    // the crc is checked when the stream reaches the end of the file
+    AP_ROMFS_Stream *stream = test.open(false);
+    ASSERT_NE(nullptr, stream);
+    std::vector<uint8_t> buf(test.text.size());
+    EXPECT_EQ(1000, stream->read(buf.data(), 1000));
+    EXPECT_EQ(-1, stream->read(buf.data(), buf.size()));
+    EXPECT_EQ(-1, stream->read(buf.data(), 1));
+    delete stream;
+}
+
+AP_GTEST_MAIN()
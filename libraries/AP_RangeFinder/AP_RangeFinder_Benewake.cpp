@@ -19,6 +19,7 @@
 
 #include <AP_HAL/AP_HAL.h>
 #include <AP_HAL/utility/sparse-endian.h>
+#include <AP_HAL/utility/UARTSpanReader.h>
 
 #include <ctype.h>
 
@@ -74,66 +75,65 @@ bool AP_RangeFinder_Benewake::get_reading(float &reading_m)
     uint16_t count_out_of_range = 0;
 
     // read any available lines from the lidar
-    for (auto j=0; j<8192; j++) {
-        uint8_t c;
-        if (!uart->read(c)) {
-            break;
-        }
-        // if buffer is empty and this byte is 0x59, add to buffer
-        if (linebuf_len == 0) {
-            if (c == BENEWAKE_FRAME_HEADER) {
-                linebuf[linebuf_len++] = c;
-            }
-        } else if (linebuf_len == 1) {
-            // if buffer has 1 element and this byte is 0x59, add it to buffer
-            // if not clear the buffer
-            if (c == BENEWAKE_FRAME_HEADER) {
-                linebuf[linebuf_len++] = c;
-            } else {
-                linebuf_len = 0;
-            }
-        } else {
-            // add character to buffer
-            linebuf[linebuf_len++] = c;
-            // if buffer now has 9 items try to decode it
-            if (linebuf_len == BENEWAKE_FRAME_LENGTH) {
-                // calculate checksum
-                uint8_t checksum = 0;
-                for (uint8_t i=0; i<BENEWAKE_FRAME_LENGTH-1; i++) {
-                    checksum += linebuf[i];
+    UARTSpanReader::read_all(*uart, 8192U, [&](const uint8_t *span, uint16_t len) {
+        for (uint16_t j=0; j<len; j++) {
+            const uint8_t c = span[j];
+            // if buffer is empty and this byte is 0x59, add to buffer
+            if (linebuf_len == 0) {
+                if (c == BENEWAKE_FRAME_HEADER) {
+                    linebuf[linebuf_len++] = c;
+                }
+            } else if (linebuf_len == 1) {
+                // if buffer has 1 element and this byte is 0x59, add it to buffer
+                // if not clear the buffer
+                if (c == BENEWAKE_FRAME_HEADER) {
+                    linebuf[linebuf_len++] = c;
+                } else {
+                    linebuf_len = 0;
                 }
-                // if checksum matches extract contents
-                if (checksum == linebuf[BENEWAKE_FRAME_LENGTH-1]) {
-                    // calculate distance
-                    uint16_t dist = ((uint16_t)linebuf[3] << 8) | linebuf[2];
-                    if (dist >= BENEWAKE_DIST_MAX_CM || dist == uint16_t(model_dist_max_cm())) {
-                        // this reading is out of range. Note that we
-                        // consider getting exactly the model dist max
-                        // is out of range. This fixes an issue with
-                        // the TF03 which can give exactly 18000 cm
-                        // when out of range
-                        count_out_of_range++;
-                    } else if (!has_signal_byte()) {
-                        // no signal byte so can immediately add distance to sum
-                        sum_cm += dist;
-                        count++;
-                    } else {
-                        // TF02 provides signal reliability (good = 7 or 8)
-                        if (linebuf[6] >= 7) {
-                            // add distance to sum
+            } else {
+                // add character to buffer
+                linebuf[linebuf_len++] = c;
+                // if buffer now has 9 items try to decode it
+                if (linebuf_len == BENEWAKE_FRAME_LENGTH) {
+                    // calculate checksum
+                    uint8_t checksum = 0;
+                    for (uint8_t i=0; i<BENEWAKE_FRAME_LENGTH-1; i++) {
+                        checksum += linebuf[i];
+                    }
+                    // if checksum matches extract contents
+                    if (checksum == linebuf[BENEWAKE_FRAME_LENGTH-1]) {
+                        // calculate distance
+                        uint16_t dist = ((uint16_t)linebuf[3] << 8) | linebuf[2];
+                        if (dist >= BENEWAKE_DIST_MAX_CM || dist == uint16_t(model_dist_max_cm())) {
+                            // this reading is out of range. Note that we
+                            // consider getting exactly the model dist max
+                            // is out of range. This fixes an issue with
+                            // the TF03 which can give exactly 18000 cm
+                            // when out of range
+                            count_out_of_range++;
+                        } else if (!has_signal_byte()) {
+                            // no signal byte so can immediately add distance to sum
                             sum_cm += dist;
                             count++;
                         } else {
-                            // this reading is out of range
-                            count_out_of_range++;
+                            // TF02 provides signal reliability (good = 7 or 8)
+                            if (linebuf[6] >= 7) {
+                                // add distance to sum
+                                sum_cm += dist;
+                                count++;
+                            } else {
+                                // this reading is out of range
+                                count_out_of_range++;
+                            }
                         }
                     }
+                    // clear buffer
+                    linebuf_len = 0;
                 }
-                // clear buffer
-                linebuf_len = 0;
             }
         }
-    }
+    });
 
     if (count > 0) {
         // return average distance of readings
@@ -165,6 +165,25 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("THD_PRIORITY", 14, AP_Scripting, _thd_priority, uint8_t(ThreadPriority::NORMAL)),
 
+#if AP_SCRIPTING_PROFILE_ENABLED
+    // @Param: PROF_RATE
+    // @DisplayName: Scripting profiler sample interval
+    // @Description: Number of Lua VM instructions between profiler samples, 0 disables the profiler. Each sample charges the instructions, time and allocations since the previous sample to the line of the script being executed. Results are available in @SYS/scripting_profile.txt and the SCRP log message. Smaller values give more detail at the cost of more CPU time.
+    // @Range: 0 10000
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("PROF_RATE", 19, AP_Scripting, _profile_rate, 0),
+#endif
+
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    // @Param: BC_CACHE
+    // @DisplayName: Scripting bytecode cache
+    // @Description: Cache compiled scripts in the cache sub-directory of the scripts directory, so they do not need to be compiled again on the next boot while the script is unchanged. Stripping debug information makes the cache smaller and faster to load, but errors will no longer report line numbers. Cached chunks are checked for corruption and are only used by the firmware that wrote them, but they are not validated by Lua: only enable the cache if nothing untrusted can write to the scripts directory, including scripts using the io library and MAVLink FTP.
+    // @Values: 0:Disabled, 1:Enabled, 2:Enabled and strip debug information
+    // @User: Advanced
+    AP_GROUPINFO("BC_CACHE", 20, AP_Scripting, _bytecode_cache, uint8_t(BytecodeCache::DISABLED)),
+#endif
+
 #if AP_SCRIPTING_SERIALDEVICE_ENABLED
     // @Param: SDEV_EN
     // @DisplayName: Scripting serial device enable
@@ -301,7 +320,11 @@ void AP_Scripting::thread(void) {
         _restart = false;
         _init_failed = false;
 
-        lua_scripts *lua = NEW_NOTHROW lua_scripts(_script_vm_exec_count, _script_heap_size, _debug_options);
+        lua_scripts *lua = NEW_NOTHROW lua_scripts(_script_vm_exec_count, _script_heap_size, _debug_options
+#if AP_SCRIPTING_PROFILE_ENABLED
+                                                   , _profile_rate
+#endif
+                                                   );
         if (lua == nullptr || !lua->heap_allocated()) {
             GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Scripting: %s", "Unable to allocate memory");
             _init_failed = true;
@@ -536,6 +559,14 @@ void AP_Scripting::save_checksum() {
 
 }
 
+#if AP_SCRIPTING_PROFILE_ENABLED
+// report for @SYS/scripting_profile.txt
+void AP_Scripting::profile_info(ExpandingString &str)
+{
+    lua_scripts::profile_info(str);
+}
+#endif
+
 AP_Scripting *AP_Scripting::_singleton = nullptr;
 
 namespace AP {
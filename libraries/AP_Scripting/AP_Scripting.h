@@ -20,6 +20,7 @@
 
 #include <GCS_MAVLink/GCS_config.h>
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/ExpandingString.h>
 #include <AP_Param/AP_Param.h>
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Mission/AP_Mission.h>
@@ -82,6 +83,11 @@ public:
     void handle_mission_command(const class AP_Mission::Mission_Command& cmd);
 
     bool arming_checks(size_t buflen, char *buffer) const;
+
+#if AP_SCRIPTING_PROFILE_ENABLED
+    // report of the hottest script lines, see SCR_PROF_RATE
+    void profile_info(ExpandingString &str);
+#endif
     
     void restart_all(void);
     void stop(void) { _stop = true; }
@@ -95,6 +101,15 @@ public:
     };
     uint16_t get_disabled_dir() { return uint16_t(_dir_disable.get());}
 
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    enum class BytecodeCache : uint8_t {
+        DISABLED = 0,
+        ENABLED = 1,
+        ENABLED_STRIP = 2,
+    };
+    BytecodeCache get_bytecode_cache() const { return _bytecode_cache; }
+#endif
+
     // the number of and storage for i2c devices
     uint8_t num_i2c_devices;
     AP_HAL::I2CDevice *_i2c_dev[SCRIPTING_MAX_NUM_I2C_DEVICE];
@@ -193,6 +208,12 @@ private:
     AP_Int16 _dir_disable;
     AP_Int32 _required_loaded_checksum;
     AP_Int32 _required_running_checksum;
+#if AP_SCRIPTING_PROFILE_ENABLED
+    AP_Int32 _profile_rate;
+#endif
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    AP_Enum<BytecodeCache> _bytecode_cache;
+#endif
 
     AP_Enum<ThreadPriority> _thd_priority;
 
@@ -28,3 +28,13 @@
 #ifndef AP_SCRIPTING_BINDING_VEHICLE_ENABLED
 #define AP_SCRIPTING_BINDING_VEHICLE_ENABLED 1
 #endif  // AP_SCRIPTING_BINDING_VEHICLE_ENABLED
+
+// sampling profiler for scripts, see SCR_PROF_RATE
+#ifndef AP_SCRIPTING_PROFILE_ENABLED
+#define AP_SCRIPTING_PROFILE_ENABLED AP_SCRIPTING_ENABLED
+#endif
+
+// cache of compiled scripts on the filesystem, see SCR_BC_CACHE
+#ifndef AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+#define AP_SCRIPTING_BYTECODE_CACHE_ENABLED (AP_SCRIPTING_ENABLED && AP_FILESYSTEM_FILE_WRITING_ENABLED)
+#endif
@@ -12,6 +12,19 @@ int binding_argcheck(lua_State *L, int expected_arg_count) {
     return 0;
 }
 
+// allows up to max_out_args optional trailing userdata arguments that
+// results are written into in place of allocating a new userdata,
+// returns the number of out arguments provided
+int binding_argcheck_out(lua_State *L, int expected_arg_count, int max_out_args) {
+    const int args = lua_gettop(L);
+    if (args > expected_arg_count + max_out_args) {
+        return luaL_argerror(L, args, "too many arguments");
+    } else if (args < expected_arg_count) {
+        return luaL_argerror(L, args, "too few arguments");
+    }
+    return args - expected_arg_count;
+}
+
 int field_argerror(lua_State *L) {
     return binding_argcheck(L, -1); // force too many args error
 }
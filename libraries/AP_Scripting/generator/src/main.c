@@ -1918,8 +1918,24 @@ void emit_ap_object_fields() {
   }
 }
 
+// emit the result for a userdata, either copied into the caller supplied out
+// argument out_index or into a newly allocated userdata
+void emit_userdata_result(const struct type *t, const char *data_name, int out_index, const char * tab) {
+  if (out_index < 0) {
+    fprintf(source, "%s*new_%s(L) = %s;\n", tab, t->data.ud.sanitized_name, data_name);
+    return;
+  }
+  fprintf(source, "%sif (out_%d != nullptr) {\n", tab, out_index);
+  fprintf(source, "%s    *out_%d = %s;\n", tab, out_index, data_name);
+  fprintf(source, "%s    lua_pushvalue(L, out_arg_base + %d);\n", tab, out_index);
+  fprintf(source, "%s} else {\n", tab);
+  fprintf(source, "%s    *new_%s(L) = %s;\n", tab, t->data.ud.sanitized_name, data_name);
+  fprintf(source, "%s}\n", tab);
+}
+
 // emit references functions for a call, return the number of arguments added
-int emit_references(const struct argument *arg, const char * tab) {
+// out_index is the index of the first out argument for userdata results, or -1 if not supported
+int emit_references(const struct argument *arg, const char * tab, int out_index) {
   int arg_index = NULLABLE_ARG_COUNT_BASE + 2;
   int return_count = 0;
   // count arguments to return so we know if we need to check the stack
@@ -1958,7 +1974,14 @@ int emit_references(const struct argument *arg, const char * tab) {
           fprintf(source, "%slua_pushstring(L, data_%d);\n", tab, arg_index);
           break;
         case TYPE_USERDATA:
-          fprintf(source, "%s*new_%s(L) = data_%d;\n", tab, arg->type.data.ud.sanitized_name, arg_index);
+          {
+            char data_name[32];
+            snprintf(data_name, sizeof(data_name), "data_%d", arg_index);
+            emit_userdata_result(&arg->type, data_name, out_index, tab);
+            if (out_index >= 0) {
+              out_index++;
+            }
+          }
           break;
         case TYPE_NONE:
           error(ERROR_INTERNAL, "Attempted to emit a nullable or reference argument of type none");
@@ -1977,6 +2000,20 @@ int emit_references(const struct argument *arg, const char * tab) {
   return return_count;
 }
 
+// returns the number of optional out arguments a method takes, one for
+// each userdata result, whether returned or through a 'Null/'Ref argument
+int count_out_args(const struct method *method) {
+  int out_count = (method->return_type.type == TYPE_USERDATA) ? 1 : 0;
+  const struct argument *arg = method->arguments;
+  while (arg != NULL) {
+    if ((arg->type.flags & (TYPE_FLAGS_NULLABLE | TYPE_FLAGS_REFERENCE)) && (arg->type.type == TYPE_USERDATA)) {
+      out_count++;
+    }
+    arg = arg->next;
+  }
+  return out_count;
+}
+
 void emit_userdata_method(const struct userdata *data, const struct method *method) {
   int arg_count = 1;
 
@@ -2006,7 +2043,32 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
     }
     arg = arg->next;
   }
-  fprintf(source, "    binding_argcheck(L, %d);\n", arg_count);
+  // userdata results may optionally be written into caller supplied
+  // userdata passed after the normal arguments, which saves allocating
+  // a new userdata on every call
+  const int out_count = count_out_args(method);
+  if (out_count > 0) {
+    fprintf(source, "    const int out_arg_base = %d;\n", arg_count + 1);
+    fprintf(source, "    const int out_args = binding_argcheck_out(L, %d, %d);\n", arg_count, out_count);
+    // check the out arguments before doing any work, so we don't fail after side effects
+    int out_index = 0;
+    if (method->return_type.type == TYPE_USERDATA) {
+      fprintf(source, "    %s * out_%d = ((out_args > %d) && !lua_isnil(L, out_arg_base + %d)) ? check_%s(L, out_arg_base + %d) : nullptr;\n",
+              method->return_type.data.ud.name, out_index, out_index, out_index, method->return_type.data.ud.sanitized_name, out_index);
+      out_index++;
+    }
+    arg = method->arguments;
+    while (arg != NULL) {
+      if ((arg->type.flags & (TYPE_FLAGS_NULLABLE | TYPE_FLAGS_REFERENCE)) && (arg->type.type == TYPE_USERDATA)) {
+        fprintf(source, "    %s * out_%d = ((out_args > %d) && !lua_isnil(L, out_arg_base + %d)) ? check_%s(L, out_arg_base + %d) : nullptr;\n",
+                arg->type.data.ud.name, out_index, out_index, out_index, arg->type.data.ud.sanitized_name, out_index);
+        out_index++;
+      }
+      arg = arg->next;
+    }
+  } else {
+    fprintf(source, "    binding_argcheck(L, %d);\n", arg_count);
+  }
 
   switch (data->ud_type) {
     case UD_USERDATA:
@@ -2196,7 +2258,7 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
   if (method->flags & TYPE_FLAGS_REFERENCE) {
     arg = method->arguments;
     // number of arguments to return
-    return_count += emit_references(arg,"    ");
+    return_count += emit_references(arg,"    ", out_count > 0 ? (method->return_type.type == TYPE_USERDATA ? 1 : 0) : -1);
   }
 
   switch (method->return_type.type) {
@@ -2205,7 +2267,7 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
         fprintf(source, "    if (data) {\n");
         // we need to emit out nullable arguments, iterate the args again, creating and copying objects, while keeping a new count
         arg = method->arguments;
-        return_count = emit_references(arg,"        ");
+        return_count = emit_references(arg,"        ", out_count > 0 ? 0 : -1);
         fprintf(source, "        return %d;\n", return_count);
         fprintf(source, "    }\n");
         fprintf(source, "    return 0;\n");
@@ -2231,7 +2293,7 @@ void emit_userdata_method(const struct userdata *data, const struct method *meth
       fprintf(source, "    lua_pushstring(L, data);\n");
       break;
     case TYPE_USERDATA:
-      fprintf(source, "    *new_%s(L) = data;\n", method->return_type.data.ud.sanitized_name);
+      emit_userdata_result(&method->return_type, "data", 0, "    ");
       break;
     case TYPE_AP_OBJECT:
       fprintf(source, "    if (data == NULL) {\n");
@@ -2696,6 +2758,26 @@ void emit_docs_method(const char *name, const char *method_name, struct method *
     arg = arg->next;
   }
 
+  // optional out arguments the userdata results are written into
+  const int out_count = count_out_args(method);
+  int out_index = 1;
+  if (method->return_type.type == TYPE_USERDATA) {
+    char *param_name = (char *)allocate(20);
+    sprintf(param_name, "---@param out%i?", out_index++);
+    emit_docs_type(method->return_type, param_name, "\n");
+    free(param_name);
+  }
+  arg = method->arguments;
+  while (arg != NULL) {
+    if ((arg->type.flags & (TYPE_FLAGS_NULLABLE | TYPE_FLAGS_REFERENCE)) && (arg->type.type == TYPE_USERDATA)) {
+      char *param_name = (char *)allocate(20);
+      sprintf(param_name, "---@param out%i?", out_index++);
+      emit_docs_type(arg->type, param_name, "\n");
+      free(param_name);
+    }
+    arg = arg->next;
+  }
+
   // return type
   if ((method->flags & TYPE_FLAGS_NULLABLE) == 0) {
     emit_docs_return_type(method->return_type, FALSE);
@@ -2714,7 +2796,13 @@ void emit_docs_method(const char *name, const char *method_name, struct method *
   fprintf(docs, "function %s:%s(", name, method_name);
   for (int i = 1; i < count; ++i) {
     fprintf(docs, "param%i", i);
-    if (i < count-1) {
+    if (i < count-1 || out_count > 0) {
+      fprintf(docs, ", ");
+    }
+  }
+  for (int i = 1; i <= out_count; ++i) {
+    fprintf(docs, "out%i", i);
+    if (i < out_count) {
       fprintf(docs, ", ");
     }
   }
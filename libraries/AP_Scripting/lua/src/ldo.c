@@ -775,6 +775,13 @@ static void f_parser (lua_State *L, void *ud) {
     cl = luaU_undump(L, p->z, p->name);
   }
   else
+#else
+  // binary chunks are only accepted when explicitly asked for with
+  // mode "b", which only the ArduPilot bytecode cache does
+  if (c == LUA_SIGNATURE[0] && p->mode != NULL && strcmp(p->mode, "b") == 0) {
+    cl = luaU_undump(L, p->z, p->name);
+  }
+  else
 #endif
   {
     checkmode(L, p->mode, "text");
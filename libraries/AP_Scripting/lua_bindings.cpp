@@ -1257,4 +1257,58 @@ int lua_AP_Vehicle_set_target_velocity_NED(lua_State *L)
 }
 #endif // AP_SCRIPTING_BINDING_VEHICLE_ENABLED
 
+/*
+  in-place vector arithmetic. The + and - operators and scale() return
+  a new userdata for every result, these modify the vector they are
+  called on and return it, so a script doing vector maths in its
+  update loop need not allocate at all
+ */
+int lua_Vector3f_add_in_place(lua_State *L)
+{
+    binding_argcheck(L, 2);
+    *check_Vector3f(L, 1) += *check_Vector3f(L, 2);
+    lua_settop(L, 1);
+    return 1;
+}
+
+int lua_Vector3f_sub_in_place(lua_State *L)
+{
+    binding_argcheck(L, 2);
+    *check_Vector3f(L, 1) -= *check_Vector3f(L, 2);
+    lua_settop(L, 1);
+    return 1;
+}
+
+int lua_Vector3f_scale_in_place(lua_State *L)
+{
+    binding_argcheck(L, 2);
+    *check_Vector3f(L, 1) *= float(luaL_checknumber(L, 2));
+    lua_settop(L, 1);
+    return 1;
+}
+
+int lua_Vector2f_add_in_place(lua_State *L)
+{
+    binding_argcheck(L, 2);
+    *check_Vector2f(L, 1) += *check_Vector2f(L, 2);
+    lua_settop(L, 1);
+    return 1;
+}
+
+int lua_Vector2f_sub_in_place(lua_State *L)
+{
+    binding_argcheck(L, 2);
+    *check_Vector2f(L, 1) -= *check_Vector2f(L, 2);
+    lua_settop(L, 1);
+    return 1;
+}
+
+int lua_Vector2f_scale_in_place(lua_State *L)
+{
+    binding_argcheck(L, 2);
+    *check_Vector2f(L, 1) *= float(luaL_checknumber(L, 2));
+    lua_settop(L, 1);
+    return 1;
+}
+
 #endif  // AP_SCRIPTING_ENABLED
@@ -38,3 +38,9 @@ int lua_GCS_command_int(lua_State *L);
 int lua_DroneCAN_get_FlexDebug(lua_State *L);
 int lua_gps_inject_data(lua_State *L);
 int lua_AP_Vehicle_set_target_velocity_NED(lua_State *L);
+int lua_Vector3f_add_in_place(lua_State *L);
+int lua_Vector3f_sub_in_place(lua_State *L);
+int lua_Vector3f_scale_in_place(lua_State *L);
+int lua_Vector2f_add_in_place(lua_State *L);
+int lua_Vector2f_sub_in_place(lua_State *L);
+int lua_Vector2f_scale_in_place(lua_State *L);
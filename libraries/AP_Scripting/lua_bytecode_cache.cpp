@@ -0,0 +1,205 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lua_bytecode_cache.h"
+
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Common/AP_FWVersion.h>
+#include <AP_Math/AP_Math.h>
+#include "lua_common_defs.h"
+
+extern const AP_HAL::HAL& hal;
+
+#define CACHE_DIRECTORY SCRIPTING_DIRECTORY "/cache"
+
+/*
+  the cache file is named after the script, scripts embedded in ROMFS
+  get a prefix so they can't collide with a script of the same name
+  on the SD card
+ */
+bool lua_bytecode_cache::cache_name(const char *filename, char *buf, uint8_t buflen)
+{
+    const char *base = strrchr(filename, '/');
+    base = (base != nullptr) ? base + 1 : filename;
+    const char *prefix = (strncmp(filename, "@ROMFS/", 7) == 0) ? "romfs_" : "";
+    const int n = hal.util->snprintf(buf, buflen, CACHE_DIRECTORY "/%s%sc", prefix, base);
+    return n > 0 && n < buflen;
+}
+
+/*
+  chunks depend on the bindings and the lua build, so only a chunk
+  written by this exact firmware is accepted. Builds without a git
+  hash can't be told apart and don't use the cache at all
+ */
+uint32_t lua_bytecode_cache::build_id()
+{
+    const AP_FWVersion &fw = AP::fwversion();
+    if (fw.fw_hash == 0) {
+        return 0;
+    }
+    const struct PACKED {
+        uint32_t fw_hash;
+        uint8_t major, minor, patch;
+        uint8_t board_type;
+        uint16_t board_subtype;
+        uint16_t lua_version;
+    } id {
+        fw.fw_hash,
+        fw.major, fw.minor, fw.patch,
+        fw.board_type,
+        fw.board_subtype,
+        LUA_VERSION_NUM,
+    };
+    // never zero, so a missing id can't match
+    return crc_crc32(0, (const uint8_t *)&id, sizeof(id)) | 1U;
+}
+
+struct cache_reader {
+    int fd;
+    uint32_t remaining;
+    char buf[128];
+};
+
+static const char *read_chunk(lua_State *, void *ud, size_t *size)
+{
+    cache_reader *r = (cache_reader *)ud;
+    const int32_t n = AP::FS().read(r->fd, r->buf, MIN(r->remaining, uint32_t(sizeof(r->buf))));
+    if (n <= 0) {
+        *size = 0;
+        return nullptr;
+    }
+    r->remaining -= n;
+    *size = n;
+    return r->buf;
+}
+
+/*
+  Lua trusts bytecode completely, so the whole chunk is checked
+  before lua_load sees any of it. Leaves the file positioned at the
+  start of the chunk
+ */
+bool lua_bytecode_cache::chunk_valid(int fd, const header &h)
+{
+    uint8_t buf[128];
+    uint32_t crc = 0;
+    uint32_t size = 0;
+    int32_t n;
+    while ((n = AP::FS().read(fd, buf, sizeof(buf))) > 0) {
+        crc = crc_crc32(crc, buf, n);
+        size += n;
+    }
+    return n == 0 && size == h.chunk_size && crc == h.chunk_crc &&
+           AP::FS().lseek(fd, sizeof(h), SEEK_SET) == int32_t(sizeof(h));
+}
+
+bool lua_bytecode_cache::load(lua_State *L, const char *filename, uint32_t crc, bool strip)
+{
+    const uint32_t build = build_id();
+    char name[128];
+    if (build == 0 || !cache_name(filename, name, sizeof(name))) {
+        return false;
+    }
+    cache_reader r;
+    r.fd = AP::FS().open(name, O_RDONLY);
+    if (r.fd == -1) {
+        return false;
+    }
+    header h;
+    if (AP::FS().read(r.fd, &h, sizeof(h)) != sizeof(h) ||
+        h.magic != MAGIC || h.build != build ||
+        h.crc != crc || h.strip != uint8_t(strip) ||
+        !chunk_valid(r.fd, h)) {
+        // missing, stale, from another firmware, built with other options or corrupt
+        AP::FS().close(r.fd);
+        return false;
+    }
+    r.remaining = h.chunk_size;
+
+    // the chunk name is only used if the source was stripped from the chunk
+    lua_pushfstring(L, "@%s", filename);
+    const int status = lua_load(L, read_chunk, &r, lua_tostring(L, -1), "b");
+    AP::FS().close(r.fd);
+    lua_remove(L, -2); // chunk name
+    if (status != LUA_OK) {
+        // truncated since it was checked, fall back to the source
+        lua_pop(L, 1);
+        return false;
+    }
+    return true;
+}
+
+struct cache_writer {
+    int fd;
+    uint32_t crc;
+    uint32_t size;
+};
+
+static int write_chunk(lua_State *, const void *p, size_t sz, void *ud)
+{
+    cache_writer *w = (cache_writer *)ud;
+    w->crc = crc_crc32(w->crc, (const uint8_t *)p, sz);
+    w->size += sz;
+    return AP::FS().write(w->fd, p, sz) == int32_t(sz) ? 0 : 1;
+}
+
+void lua_bytecode_cache::save(lua_State *L, const char *filename, uint32_t crc, bool strip)
+{
+    const uint32_t build = build_id();
+    char name[128];
+    char tmp_name[132];
+    if (build == 0 || !cache_name(filename, name, sizeof(name))) {
+        return;
+    }
+    hal.util->snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", name);
+
+    if (AP::FS().mkdir(CACHE_DIRECTORY) != 0 && errno != EEXIST) {
+        return;
+    }
+
+    // write to a temporary file so a power loss can't leave a partial chunk
+    cache_writer w {};
+    w.fd = AP::FS().open(tmp_name, O_WRONLY|O_CREAT|O_TRUNC);
+    if (w.fd == -1) {
+        return;
+    }
+    header h {
+        magic : MAGIC,
+        build : build,
+        crc : crc,
+        chunk_crc : 0,
+        chunk_size : 0,
+        strip : uint8_t(strip),
+    };
+    // the header is written again once the chunk CRC is known
+    bool ok = AP::FS().write(w.fd, &h, sizeof(h)) == sizeof(h);
+    ok = ok && lua_dump(L, write_chunk, &w, strip) == 0;
+    h.chunk_crc = w.crc;
+    h.chunk_size = w.size;
+    ok = ok && AP::FS().lseek(w.fd, 0, SEEK_SET) == 0;
+    ok = ok && AP::FS().write(w.fd, &h, sizeof(h)) == sizeof(h);
+    ok = (AP::FS().close(w.fd) == 0) && ok;
+    if (ok) {
+        AP::FS().unlink(name);
+        ok = AP::FS().rename(tmp_name, name) == 0;
+    }
+    if (!ok) {
+        AP::FS().unlink(tmp_name);
+    }
+}
+
+#endif  // AP_SCRIPTING_BYTECODE_CACHE_ENABLED
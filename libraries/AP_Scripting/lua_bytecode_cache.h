@@ -0,0 +1,73 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  cache of compiled lua scripts
+
+  Parsing a script is slow and needs a lot of heap for the parser
+  state. The first time a script is loaded its compiled chunk is
+  written to SCRIPTING_DIRECTORY/cache, tagged with the CRC of the
+  source and the firmware build. Later loads with a matching CRC
+  skip the parser and load the bytecode directly.
+
+  Lua does not verify bytecode, so a damaged chunk can corrupt
+  memory. The whole chunk is checked against a CRC before it is
+  handed to lua_load. That catches corruption, not tampering: the
+  cache must only be enabled where nothing untrusted can write to
+  the scripts directory.
+ */
+#pragma once
+
+#include "AP_Scripting_config.h"
+
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+
+#include <AP_Common/AP_Common.h>
+#include "lua/src/lua.hpp"
+
+class lua_bytecode_cache {
+public:
+    /*
+      push the cached chunk for filename if there is one compiled
+      from source with the given CRC and strip setting, returns false
+      with nothing pushed otherwise
+     */
+    static bool load(lua_State *L, const char *filename, uint32_t crc, bool strip);
+
+    // write the chunk on the top of the stack to the cache
+    static void save(lua_State *L, const char *filename, uint32_t crc, bool strip);
+
+private:
+    struct PACKED header {
+        uint32_t magic;
+        uint32_t build;      // firmware build that wrote the chunk
+        uint32_t crc;        // crc32 of the script source
+        uint32_t chunk_crc;  // crc32 of the chunk following the header
+        uint32_t chunk_size;
+        uint8_t strip;       // 1 if debug information was stripped
+    };
+
+    static constexpr uint32_t MAGIC = 0x4c424332; // "LBC2"
+
+    // identifier of this firmware build, zero if it has none
+    static uint32_t build_id();
+
+    // check the chunk after the header against its CRC and size
+    static bool chunk_valid(int fd, const header &h);
+
+    // name of the cache file for a script
+    static bool cache_name(const char *filename, char *buf, uint8_t buflen);
+};
+
+#endif  // AP_SCRIPTING_BYTECODE_CACHE_ENABLED
@@ -0,0 +1,143 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lua_pool_allocator.h"
+
+#if AP_SCRIPTING_ENABLED
+
+#include <AP_Math/AP_Math.h>
+#include <string.h>
+
+void lua_pool_allocator::destroy(MultiHeap &heap)
+{
+    while (chunks != nullptr) {
+        chunk *next = chunks->next;
+        heap.deallocate(chunks);
+        chunks = next;
+    }
+    unused = nullptr;
+    unused_size = 0;
+    pool_size = 0;
+    memset(free_list, 0, sizeof(free_list));
+}
+
+bool lua_pool_allocator::grow(MultiHeap &heap, uint8_t cls)
+{
+    // when the heap is nearly full settle for a chunk holding just
+    // the one block, so the pool never fails where the heap would not
+    const uint32_t min_size = granule + class_size(cls);
+    uint32_t size = chunk_size;
+    chunk *c = (chunk *)heap.allocate(size);
+    if (c == nullptr) {
+        size = min_size;
+        c = (chunk *)heap.allocate(size);
+        if (c == nullptr) {
+            return false;
+        }
+    }
+
+    // hand the tail of the previous chunk out as free blocks so it
+    // is not wasted
+    while (unused_size >= granule) {
+        const uint8_t tail_cls = size_class(MIN(unused_size, uint32_t(max_block_size)));
+        free_block *blk = (free_block *)unused;
+        blk->next = free_list[tail_cls];
+        free_list[tail_cls] = blk;
+        unused += class_size(tail_cls);
+        unused_size -= class_size(tail_cls);
+    }
+
+    c->next = chunks;
+    chunks = c;
+    unused = (uint8_t *)c + granule;
+    unused_size = size - granule;
+    pool_size += size;
+    return true;
+}
+
+void *lua_pool_allocator::allocate(MultiHeap &heap, uint32_t size)
+{
+    alloc_count++;
+    if (!pooled(size)) {
+        return heap.allocate(size);
+    }
+    const uint8_t cls = size_class(size);
+    free_block *blk = free_list[cls];
+    if (blk != nullptr) {
+        free_list[cls] = blk->next;
+        return blk;
+    }
+    const uint32_t csize = class_size(cls);
+    if (unused_size < csize && !grow(heap, cls)) {
+        return nullptr;
+    }
+    void *ret = unused;
+    unused += csize;
+    unused_size -= csize;
+    return ret;
+}
+
+void lua_pool_allocator::release(MultiHeap &heap, void *ptr, uint32_t size)
+{
+    if (!pooled(size)) {
+        heap.deallocate(ptr);
+        return;
+    }
+    free_block *blk = (free_block *)ptr;
+    const uint8_t cls = size_class(size);
+    blk->next = free_list[cls];
+    free_list[cls] = blk;
+}
+
+void *lua_pool_allocator::change_size(MultiHeap &heap, void *ptr, uint32_t old_size, uint32_t new_size)
+{
+    if (new_size == 0) {
+        if (ptr != nullptr) {
+            release(heap, ptr, old_size);
+        }
+        return nullptr;
+    }
+    if (ptr == nullptr) {
+        // old_size is the lua type tag, not a size
+        return allocate(heap, new_size);
+    }
+
+    if (pooled(old_size) && pooled(new_size) && size_class(new_size) == size_class(old_size)) {
+        // still fits in the same block
+        return ptr;
+    }
+    if (!pooled(old_size) && !pooled(new_size)) {
+        alloc_count++;
+        return heap.change_size(ptr, old_size, new_size);
+    }
+
+    // moving between size classes, or between the pool and the heap
+    void *newp = allocate(heap, new_size);
+    if (newp == nullptr) {
+        if (pooled(old_size) && new_size < old_size) {
+            // keep the larger block, it is reused in the smaller
+            // class once freed
+            return ptr;
+        }
+        // when shrinking from the heap into the pool lua collects
+        // garbage and tries again before raising a memory error
+        return nullptr;
+    }
+    memcpy(newp, ptr, MIN(old_size, new_size));
+    release(heap, ptr, old_size);
+    return newp;
+}
+
+#endif  // AP_SCRIPTING_ENABLED
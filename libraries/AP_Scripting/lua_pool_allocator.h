@@ -0,0 +1,91 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  size-class free-list allocator for small lua objects
+
+  Boxed userdata (Vector3f, Location, uint32_t etc), strings, tables
+  and closures are almost all small, short lived allocations. Serving
+  them from chunks taken from the scripting heap with a free list per
+  size class makes allocation O(1) and keeps them from fragmenting the
+  heap used for larger allocations.
+
+  The pool grows a chunk at a time as it is needed, so it only ever
+  holds as much of the heap as the peak use of small objects. Lua
+  gives the exact size of a block when changing or freeing it, which
+  is what tells us whether the block came from the pool or the heap.
+ */
+#pragma once
+
+#include "AP_Scripting_config.h"
+
+#if AP_SCRIPTING_ENABLED
+
+#include <AP_MultiHeap/AP_MultiHeap.h>
+
+class lua_pool_allocator {
+public:
+    // allocations up to this size are served from the pool
+    static constexpr uint32_t max_block_size = 64;
+
+    // size of the chunks the pool takes from the heap as it grows
+    static constexpr uint32_t chunk_size = 2048;
+
+    // return all chunks to the heap, lua must have freed all objects
+    void destroy(MultiHeap &heap);
+
+    // lua_Alloc semantics, with old_size the exact size of ptr
+    void *change_size(MultiHeap &heap, void *ptr, uint32_t old_size, uint32_t new_size);
+
+    // number of new blocks handed out, used for per-script accounting
+    uint32_t get_alloc_count() const { return alloc_count; }
+
+    // heap memory currently held by the pool
+    uint32_t get_pool_size() const { return pool_size; }
+
+private:
+    // must satisfy the alignment lua requires for all of its objects
+    static constexpr uint32_t granule = 8;
+    static constexpr uint8_t num_classes = max_block_size / granule;
+
+    struct free_block {
+        free_block *next;
+    };
+
+    // chunks are linked through a header of one granule so they can
+    // be returned to the heap
+    struct chunk {
+        chunk *next;
+    };
+
+    static bool pooled(uint32_t size) { return size <= max_block_size; }
+    static uint8_t size_class(uint32_t size) { return (size - 1) / granule; }
+    static uint32_t class_size(uint8_t cls) { return (cls + 1) * granule; }
+
+    void *allocate(MultiHeap &heap, uint32_t size);
+    void release(MultiHeap &heap, void *ptr, uint32_t size);
+
+    // take a new chunk from the heap with room for at least one block
+    // of the given class, returns false if the heap is exhausted
+    bool grow(MultiHeap &heap, uint8_t cls);
+
+    chunk *chunks;
+    uint8_t *unused;            // never-used memory in the newest chunk
+    uint32_t unused_size;
+    uint32_t pool_size;
+    free_block *free_list[num_classes];
+    uint32_t alloc_count;
+};
+
+#endif  // AP_SCRIPTING_ENABLED
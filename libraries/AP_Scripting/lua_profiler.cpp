@@ -0,0 +1,179 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lua_profiler.h"
+
+#if AP_SCRIPTING_PROFILE_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Logger/AP_Logger.h>
+#include <AP_Math/AP_Math.h>
+
+bool lua_profiler::init(void)
+{
+    destroy();
+    entry *new_entries = NEW_NOTHROW entry[max_entries];
+    WITH_SEMAPHORE(sem);
+    entries = new_entries;
+    return entries != nullptr;
+}
+
+void lua_profiler::destroy(void)
+{
+    WITH_SEMAPHORE(sem);
+    delete[] entries;
+    entries = nullptr;
+    num_entries = 0;
+    dropped_samples = 0;
+}
+
+void lua_profiler::begin(uint32_t alloc_count)
+{
+    last_sample_us = AP_HAL::micros();
+    last_alloc_count = alloc_count;
+}
+
+lua_profiler::entry *lua_profiler::find_entry(const char *script, uint16_t func_line, uint16_t line)
+{
+    for (uint8_t i=0; i<num_entries; i++) {
+        entry &e = entries[i];
+        if (e.line == line && e.func_line == func_line &&
+            strncmp(e.script, script, sizeof(e.script)) == 0) {
+            return &e;
+        }
+    }
+    if (num_entries >= max_entries) {
+        return nullptr;
+    }
+    entry &e = entries[num_entries++];
+    strncpy_noterm(e.script, script, sizeof(e.script));
+    e.func_line = func_line;
+    e.line = line;
+    return &e;
+}
+
+void lua_profiler::sample(lua_State *L, lua_Debug *ar, uint32_t instructions, uint32_t alloc_count)
+{
+    const uint32_t now_us = AP_HAL::micros();
+    const uint32_t dt_us = now_us - last_sample_us;
+    const uint32_t allocs = alloc_count - last_alloc_count;
+    last_sample_us = now_us;
+    last_alloc_count = alloc_count;
+
+    if (lua_getinfo(L, "Sl", ar) == 0) {
+        return;
+    }
+    // source is "@path/to/script.lua" for scripts loaded from file
+    const char *script = ar->source;
+    const char *slash = strrchr(script, '/');
+    if (slash != nullptr) {
+        script = slash + 1;
+    } else if (script[0] == '@' || script[0] == '=') {
+        script++;
+    }
+
+    WITH_SEMAPHORE(sem);
+    if (entries == nullptr) {
+        return;
+    }
+    entry *e = find_entry(script, MAX(ar->linedefined, 0), MAX(ar->currentline, 0));
+    if (e == nullptr) {
+        dropped_samples++;
+        return;
+    }
+    e->samples++;
+    e->instructions += instructions;
+    e->time_us += dt_us;
+    e->allocs += allocs;
+}
+
+void lua_profiler::write_log(void)
+{
+#if HAL_LOGGING_ENABLED
+    WITH_SEMAPHORE(sem);
+    if (entries == nullptr) {
+        return;
+    }
+    const uint64_t now_us = AP_HAL::micros64();
+    for (uint8_t i=0; i<num_entries; i++) {
+        entry &e = entries[i];
+        if (e.samples == e.logged_samples) {
+            // nothing new since the last log
+            continue;
+        }
+        e.logged_samples = e.samples;
+        struct log_ScriptingProfile pkt {
+            LOG_PACKET_HEADER_INIT(LOG_SCRIPTING_PROFILE_MSG),
+            time_us      : now_us,
+            name         : {},
+            func_line    : e.func_line,
+            line         : e.line,
+            samples      : e.samples,
+            instructions : e.instructions,
+            run_time     : e.time_us,
+            allocs       : e.allocs
+        };
+        memcpy(pkt.name, e.script, sizeof(pkt.name));
+        AP::logger().WriteBlock(&pkt, sizeof(pkt));
+    }
+#endif // HAL_LOGGING_ENABLED
+}
+
+void lua_profiler::info(ExpandingString &str)
+{
+    // a header to allow for machine parsers to determine format
+    str.printf("ScriptProfileV1\n");
+
+    WITH_SEMAPHORE(sem);
+    if (entries == nullptr) {
+        return;
+    }
+
+    // order by instructions executed, hottest first
+    uint8_t order[max_entries];
+    for (uint8_t i=0; i<num_entries; i++) {
+        uint8_t j = i;
+        while (j > 0 && entries[order[j-1]].instructions < entries[i].instructions) {
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    uint64_t total_instructions = 0;
+    for (uint8_t i=0; i<num_entries; i++) {
+        total_instructions += entries[i].instructions;
+    }
+    total_instructions = MAX(total_instructions, 1U);
+
+    str.printf("%-16s %5s %5s %10s %5s %10s %8s\n",
+               "Script", "Func", "Line", "Insn", "%", "TimeUS", "Allocs");
+    for (uint8_t i=0; i<num_entries; i++) {
+        const entry &e = entries[order[i]];
+        str.printf("%-16.16s %5u %5u %10u %5.1f %10u %8u\n",
+                   e.script,
+                   unsigned(e.func_line),
+                   unsigned(e.line),
+                   unsigned(e.instructions),
+                   double(100.0f * e.instructions / total_instructions),
+                   unsigned(e.time_us),
+                   unsigned(e.allocs));
+    }
+    if (dropped_samples != 0) {
+        str.printf("Dropped samples: %u\n", unsigned(dropped_samples));
+    }
+}
+
+#endif  // AP_SCRIPTING_PROFILE_ENABLED
@@ -0,0 +1,83 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  sampling profiler for lua scripts
+
+  Driven by the same count hook that enforces SCR_VM_I_COUNT. Every
+  SCR_PROF_RATE VM instructions the hook records the currently
+  executing function and line, and charges the instructions, wall
+  time and allocations since the previous sample to it. Results are
+  available from @SYS/scripting_profile.txt and the SCRP log message.
+ */
+#pragma once
+
+#include "AP_Scripting_config.h"
+
+#if AP_SCRIPTING_PROFILE_ENABLED
+
+#include <AP_HAL/Semaphores.h>
+#include <AP_Common/ExpandingString.h>
+
+#include "lua/src/lua.hpp"
+
+class lua_profiler {
+public:
+    // allocate the sample table, returns false on allocation failure
+    bool init(void);
+
+    // free the sample table, discarding all results
+    void destroy(void);
+
+    bool enabled(void) const { return entries != nullptr; }
+
+    // start of a script run, resets the sample baseline
+    void begin(uint32_t alloc_count);
+
+    // called from the count hook, ar must be the hook's lua_Debug
+    void sample(lua_State *L, lua_Debug *ar, uint32_t instructions, uint32_t alloc_count);
+
+    // write hot spots which have been sampled since the last call
+    void write_log(void);
+
+    // text report, hottest lines first
+    void info(ExpandingString &str);
+
+private:
+    static constexpr uint8_t max_entries = 64;
+
+    struct entry {
+        char script[16];        // script file name, no directory
+        uint16_t func_line;     // line the function was defined on, 0 for the main chunk
+        uint16_t line;          // line being executed when sampled
+        uint32_t samples;
+        uint32_t instructions;
+        uint32_t time_us;
+        uint32_t allocs;
+        uint32_t logged_samples; // value of samples when last logged
+    };
+
+    entry *find_entry(const char *script, uint16_t func_line, uint16_t line);
+
+    entry *entries;
+    uint8_t num_entries;
+    uint32_t dropped_samples; // samples lost because the table was full
+
+    uint32_t last_sample_us;
+    uint32_t last_alloc_count;
+
+    HAL_Semaphore sem;
+};
+
+#endif  // AP_SCRIPTING_PROFILE_ENABLED
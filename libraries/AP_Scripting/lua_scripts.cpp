@@ -18,6 +18,7 @@
 #if AP_SCRIPTING_ENABLED
 
 #include "lua_scripts.h"
+#include "lua_bytecode_cache.h"
 #include <AP_HAL/AP_HAL.h>
 #include "AP_Scripting.h"
 #include <AP_Logger/AP_Logger.h>
@@ -48,19 +49,54 @@ static const char *get_error_object_message(lua_State *L) {
     return m;
 }
 
-lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options)
+lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options
+#if AP_SCRIPTING_PROFILE_ENABLED
+                         , const AP_Int32 &profile_rate
+#endif
+                         )
     : _vm_steps(vm_steps),
       _debug_options(debug_options)
+#if AP_SCRIPTING_PROFILE_ENABLED
+      , _profile_rate(profile_rate)
+#endif
 {
     const bool allow_heap_expansion = !option_is_set(AP_Scripting::DebugOption::DISABLE_HEAP_EXPANSION);
     _heap.create(heap_size, 10, allow_heap_expansion, 20*1024);
+    mem_in_use = 0;
+    mem_peak = 0;
+#if AP_SCRIPTING_PROFILE_ENABLED
+    if (profile_rate > 0 && !_profiler.init()) {
+        GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "Lua: Unable to allocate profiler");
+    }
+#endif
 }
 
 lua_scripts::~lua_scripts() {
+#if AP_SCRIPTING_PROFILE_ENABLED
+    _profiler.destroy();
+#endif
+    _pool.destroy(_heap);
     _heap.destroy();
 }
 
 void lua_scripts::hook(lua_State *L, lua_Debug *ar) {
+#if AP_SCRIPTING_PROFILE_ENABLED
+    if (!overtime && _profiler.enabled()) {
+        // the hook is running more often than the CPU limit to
+        // take profile samples, only bail out once the whole slot
+        // has been used
+        _profiler.sample(L, ar, hook_interval, _pool.get_alloc_count());
+        hook_steps_remaining -= hook_interval;
+        if (hook_steps_remaining > 0) {
+            if (hook_steps_remaining < hook_interval) {
+                hook_interval = hook_steps_remaining;
+                lua_sethook(L, hook, LUA_MASKCOUNT, hook_interval);
+            }
+            return;
+        }
+    }
+#endif
+
     lua_scripts::overtime = true;
 
     // we need to aggressively bail out as we are over time
@@ -130,13 +166,14 @@ void lua_scripts::set_and_print_new_error_message(MAV_SEVERITY severity, const c
 }
 
 // helper for print and log of runtime stats
-void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem)
+void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem, uint32_t allocs)
 {
     if (option_is_set(AP_Scripting::DebugOption::RUNTIME_MSG)) {
-        GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Time: %u Mem: %d + %d",
+        GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Time: %u Mem: %d + %d Allocs: %u",
                                             (unsigned int)run_time,
                                             (int)total_mem,
-                                            (int)run_mem);
+                                            (int)run_mem,
+                                            (unsigned int)allocs);
     }
 #if HAL_LOGGING_ENABLED
     if (option_is_set(AP_Scripting::DebugOption::LOG_RUNTIME)) {
@@ -146,7 +183,8 @@ void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_me
             name         : {},
             run_time     : run_time,
             total_mem    : total_mem,
-            run_mem      : run_mem
+            run_mem      : run_mem,
+            allocs       : allocs
         };
         const char * name_short = strrchr(name, '/');
         if ((strlen(name) > sizeof(pkt.name)) && (name_short != nullptr)) {
@@ -161,8 +199,31 @@ void lua_scripts::update_stats(const char *name, uint32_t run_time, int total_me
 
 bool lua_scripts::load_script(lua_State *L, script_info *new_script) {
     const char *filename = new_script->name;
+    const uint32_t startAllocs = _pool.get_alloc_count();
+    const uint32_t loadStart = AP_HAL::micros();
 
-    if (int error = luaL_loadfile(L, filename)) {
+    // Get checksum of file
+    uint32_t crc = 0;
+    const bool have_crc = AP::FS().crc32(filename, crc);
+
+    int error;
+#if AP_SCRIPTING_BYTECODE_CACHE_ENABLED
+    const auto cache_mode = AP_Scripting::get_singleton()->get_bytecode_cache();
+    const bool use_cache = have_crc && (cache_mode != AP_Scripting::BytecodeCache::DISABLED);
+    const bool strip = cache_mode == AP_Scripting::BytecodeCache::ENABLED_STRIP;
+    if (use_cache && lua_bytecode_cache::load(L, filename, crc, strip)) {
+        load_stats.cached++;
+        error = LUA_OK;
+    } else {
+        error = luaL_loadfile(L, filename);
+        if (error == LUA_OK && use_cache) {
+            lua_bytecode_cache::save(L, filename, crc, strip);
+        }
+    }
+#else
+    error = luaL_loadfile(L, filename);
+#endif
+    if (error != LUA_OK) {
         switch (error) {
             case LUA_ERRSYNTAX:
                 set_and_print_new_error_message(MAV_SEVERITY_CRITICAL, "Error: %s", get_error_object_message(L));
@@ -184,7 +245,6 @@ bool lua_scripts::load_script(lua_State *L, script_info *new_script) {
     }
 
     const int loadMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
-    const uint32_t loadStart = AP_HAL::micros();
 
     create_sandbox(L);
     lua_pushvalue(L, -1); // duplicate environment for reference below
@@ -193,15 +253,15 @@ bool lua_scripts::load_script(lua_State *L, script_info *new_script) {
     const uint32_t loadEnd = AP_HAL::micros();
     const int endMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
 
-    update_stats(filename, loadEnd-loadStart, endMem, loadMem);
+    update_stats(filename, loadEnd-loadStart, endMem, loadMem, _pool.get_alloc_count() - startAllocs);
+    load_stats.count++;
+    load_stats.time_us += loadEnd - loadStart;
 
     new_script->env_ref = luaL_ref(L, LUA_REGISTRYINDEX); // store reference to script's environment
     new_script->run_ref = luaL_ref(L, LUA_REGISTRYINDEX); // store reference to function to run
     new_script->next_run_ms = AP_HAL::millis64() - 1; // force the script to be stale
 
-    // Get checksum of file
-    uint32_t crc = 0;
-    if (AP::FS().crc32(filename, crc)) {
+    if (have_crc) {
         // Record crc of this script
         new_script->crc = crc;
         {
@@ -317,6 +377,15 @@ void lua_scripts::reset_loop_overtime(lua_State *L) {
     overtime = false;
     // reset the hook to clear the counter
     const int32_t vm_steps = MAX(_vm_steps, 1000);
+#if AP_SCRIPTING_PROFILE_ENABLED
+    if (_profiler.enabled()) {
+        hook_steps_remaining = vm_steps;
+        hook_interval = constrain_int32(_profile_rate, 10, vm_steps);
+        _profiler.begin(_pool.get_alloc_count());
+        lua_sethook(L, hook, LUA_MASKCOUNT, hook_interval);
+        return;
+    }
+#endif
     lua_sethook(L, hook, LUA_MASKCOUNT, vm_steps);
 }
 
@@ -469,10 +538,24 @@ void lua_scripts::reschedule_script(script_info *script) {
 }
 
 MultiHeap lua_scripts::_heap;
+lua_pool_allocator lua_scripts::_pool;
+uint32_t lua_scripts::mem_in_use;
+uint32_t lua_scripts::mem_peak;
+#if AP_SCRIPTING_PROFILE_ENABLED
+lua_profiler lua_scripts::_profiler;
+int32_t lua_scripts::hook_steps_remaining;
+int32_t lua_scripts::hook_interval;
+#endif
 
 void *lua_scripts::alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
     (void)ud; /* not used */
-    return _heap.change_size(ptr, osize, nsize);
+    void *ret = _pool.change_size(_heap, ptr, osize, nsize);
+    if (ret != nullptr || nsize == 0) {
+        // when ptr is null osize is the object type, not a size
+        mem_in_use += nsize - ((ptr != nullptr) ? osize : 0);
+        mem_peak = MAX(mem_peak, mem_in_use);
+    }
+    return ret;
 }
 
 void lua_scripts::run(void) {
@@ -515,6 +598,9 @@ void lua_scripts::run(void) {
     }
     error_msg_buf_sem.give();
 
+    // all lua objects are gone, so the pool can go back to the heap
+    _pool.destroy(_heap);
+
     // heap is now empty
 }
 
@@ -555,6 +641,14 @@ int lua_scripts::run_engine(lua_State *L) {
         GCS_SEND_TEXT(MAV_SEVERITY_CRITICAL, "Lua: All directory's disabled see SCR_DIR_DISABLE");
     }
 
+    if (option_is_set(AP_Scripting::DebugOption::RUNTIME_MSG)) {
+        GCS_SEND_TEXT(MAV_SEVERITY_DEBUG, "Lua: Loaded %u scripts (%u cached) in %u ms, peak mem %u",
+                      unsigned(load_stats.count),
+                      unsigned(load_stats.cached),
+                      unsigned(load_stats.time_us / 1000),
+                      unsigned(mem_peak));
+    }
+
     uint32_t expansion_size = 0;
 
     while (AP_Scripting::get_singleton()->should_run()) {
@@ -597,6 +691,7 @@ int lua_scripts::run_engine(lua_State *L) {
 
             const int startMem = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
             const uint32_t loadEnd = AP_HAL::micros();
+            const uint32_t startAllocs = _pool.get_alloc_count();
 
             // NOTE!  the base pointer of our scripts linked list,
             // *and all its contents* may become invalid as part of
@@ -611,8 +706,14 @@ int lua_scripts::run_engine(lua_State *L) {
             hal.scheduler->restore_interrupts(istate);
 #endif
 
-            update_stats(script_name, runEnd - loadEnd, endMem, endMem - startMem);
+            update_stats(script_name, runEnd - loadEnd, endMem, endMem - startMem, _pool.get_alloc_count() - startAllocs);
 
+#if AP_SCRIPTING_PROFILE_ENABLED
+            if (_profiler.enabled() && AP_HAL::millis() - last_profile_log_ms > 5000) {
+                last_profile_log_ms = AP_HAL::millis();
+                _profiler.write_log();
+            }
+#endif
 
             // garbage collect after each script, this shouldn't matter, but seems to resolve a memory leak
             lua_gc(L, LUA_GCCOLLECT, 0);
@@ -28,6 +28,8 @@
 #include <AP_HAL/Semaphores.h>
 #include <AP_MultiHeap/AP_MultiHeap.h>
 #include "lua_common_defs.h"
+#include "lua_pool_allocator.h"
+#include "lua_profiler.h"
 
 #include "lua/src/lua.hpp"
 
@@ -42,7 +44,11 @@ static inline lua_scripts* ls_object_from_state(lua_State *L) {
 class lua_scripts
 {
 public:
-    lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options);
+    lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size, AP_Int8 &debug_options
+#if AP_SCRIPTING_PROFILE_ENABLED
+                , const AP_Int32 &profile_rate
+#endif
+                );
 
     ~lua_scripts();
 
@@ -95,6 +101,9 @@ private:
 
     const AP_Int32 & _vm_steps;
     AP_Int8 & _debug_options;
+#if AP_SCRIPTING_PROFILE_ENABLED
+    const AP_Int32 & _profile_rate;
+#endif
 
     bool option_is_set(AP_Scripting::DebugOption option) const {
         return (uint8_t(_debug_options.get()) & uint8_t(option)) != 0;
@@ -104,8 +113,30 @@ private:
 
     static MultiHeap _heap;
 
+    // pool for small allocations, grown from _heap
+    static lua_pool_allocator _pool;
+
+    // bytes allocated by lua and the most ever allocated at once
+    static uint32_t mem_in_use;
+    static uint32_t mem_peak;
+
+    // totals for loading all scripts, for boot time reporting
+    struct {
+        uint16_t count;
+        uint16_t cached;   // loaded from the bytecode cache
+        uint32_t time_us;
+    } load_stats;
+
+#if AP_SCRIPTING_PROFILE_ENABLED
+    // must be static for the hook
+    static lua_profiler _profiler;
+    static int32_t hook_steps_remaining; // VM instructions left in this run's slot
+    static int32_t hook_interval;        // VM instructions between hook calls
+    uint32_t last_profile_log_ms;
+#endif
+
     // helper for print and log of runtime stats
-    void update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem);
+    void update_stats(const char *name, uint32_t run_time, int total_mem, int run_mem, uint32_t allocs);
 
     // must be static for bindings
     static void print_error(MAV_SEVERITY severity);
@@ -133,6 +164,11 @@ public:
     static uint32_t get_loaded_checksum();
     static uint32_t get_running_checksum();
 
+#if AP_SCRIPTING_PROFILE_ENABLED
+    // report of sampled hot spots for @SYS/scripting_profile.txt
+    static void profile_info(ExpandingString &str) { _profiler.info(str); }
+#endif
+
 };
 
 #endif  // AP_SCRIPTING_ENABLED
@@ -63,6 +63,59 @@ function test_uint64()
   return pass
 end
 
+function test_out_args()
+  local pass = true
+
+  -- a result written into a supplied object is that same object
+  local v = Vector3f()
+  v:x(1)
+  v:y(2)
+  v:z(3)
+  local out = Vector3f()
+  local ret = v:copy(out)
+  pass = pass and rawequal(ret, out) and out:x() == 1 and out:y() == 2 and out:z() == 3
+
+  -- without it a new object is returned
+  ret = v:copy()
+  pass = pass and not rawequal(ret, out) and ret:z() == 3
+
+  local ofs = Location()
+  ofs:offset(30, 40)
+  local ned = Vector3f()
+  ret = Location():get_distance_NED(ofs, ned)
+  pass = pass and rawequal(ret, ned) and is_equal(ned:x(), 30, 0.01) and is_equal(ned:y(), 40, 0.01)
+
+  -- nil in place of the object allocates as before
+  ret = v:cross(Vector3f(), nil)
+  pass = pass and ret:is_zero()
+
+  -- only userdata of the right type can be written into
+  pass = pass and not pcall(v.copy, v, Vector2f())
+  pass = pass and not pcall(v.copy, v, out, out)
+
+  return pass
+end
+
+function test_in_place()
+  local pass = true
+
+  local v = Vector3f()
+  v:x(1)
+  local w = Vector3f()
+  w:y(2)
+  local ret = v:add_in_place(w)
+  pass = pass and rawequal(ret, v) and v:x() == 1 and v:y() == 2
+  v:sub_in_place(w):scale_in_place(3)
+  pass = pass and v:x() == 3 and v:y() == 0
+
+  local v2 = Vector2f()
+  v2:x(2)
+  v2:add_in_place(v2):scale_in_place(0.5):sub_in_place(Vector2f())
+  pass = pass and v2:x() == 2 and v2:y() == 0
+
+  return pass
+end
+
 function update()
   local all_tests_passed = true
   local require_test_local = require('test/nested')
@@ -82,6 +135,8 @@ function update()
   -- each test should run then and it's result with the previous ones
   all_tests_passed = test_offset(500, 200) and all_tests_passed
   all_tests_passed = test_uint64() and all_tests_passed
+  all_tests_passed = test_out_args() and all_tests_passed
+  all_tests_passed = test_in_place() and all_tests_passed
 
   if all_tests_passed then
     gcs:send_text(3, "Internal tests passed")
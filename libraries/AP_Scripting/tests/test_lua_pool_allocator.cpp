@@ -0,0 +1,145 @@
+#include <AP_gtest.h>
+
+#include <AP_Scripting/lua_pool_allocator.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_SCRIPTING_ENABLED
+
+static const uint32_t chunk_size = lua_pool_allocator::chunk_size;
+
+class PoolTest : public testing::Test
+{
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(heap.create(256*1024, 1, false, 0));
+    }
+
+    void TearDown() override {
+        pool.destroy(heap);
+        heap.destroy();
+    }
+
+    void *alloc(uint32_t size) {
+        // lua passes the object type as the old size of a new block
+        return pool.change_size(heap, nullptr, 5, size);
+    }
+
+    void release(void *ptr, uint32_t size) {
+        pool.change_size(heap, ptr, size, 0);
+    }
+
+    MultiHeap heap {};
+    lua_pool_allocator pool {};
+};
+
+TEST_F(PoolTest, Reuse)
+{
+    EXPECT_EQ(0U, pool.get_pool_size());
+
+    void *p = alloc(24);
+    ASSERT_NE(nullptr, p);
+    EXPECT_EQ(0U, uintptr_t(p) % 8);
+    EXPECT_EQ(chunk_size, pool.get_pool_size());
+
+    // a freed block is reused by the next allocation in its class
+    release(p, 24);
+    EXPECT_EQ(p, alloc(17));
+    EXPECT_NE(p, alloc(24));
+    EXPECT_EQ(3U, pool.get_alloc_count());
+}
+
+/*
+  the pool takes memory from the heap only as it is needed, and large
+  allocations never go through it
+ */
+TEST_F(PoolTest, Grow)
+{
+    void *big = alloc(200);
+    ASSERT_NE(nullptr, big);
+    EXPECT_EQ(0U, pool.get_pool_size());
+
+    const uint32_t per_chunk = (chunk_size - 8) / 64;
+    for (uint32_t i=0; i<per_chunk; i++) {
+        ASSERT_NE(nullptr, alloc(64));
+    }
+    EXPECT_EQ(chunk_size, pool.get_pool_size());
+    ASSERT_NE(nullptr, alloc(64));
+    EXPECT_EQ(2 * chunk_size, pool.get_pool_size());
+
+    release(big, 200);
+}
+
+/*
+  contents survive moving between classes and between the pool and
+  the heap
+ */
+TEST_F(PoolTest, ChangeSize)
+{
+    uint8_t *p = (uint8_t *)alloc(20);
+    ASSERT_NE(nullptr, p);
+    for (uint8_t i=0; i<20; i++) {
+        p[i] = i;
+    }
+
+    // same class, no move
+    EXPECT_EQ(p, pool.change_size(heap, p, 20, 24));
+
+    // to the heap and back
+    p = (uint8_t *)pool.change_size(heap, p, 24, 300);
+    ASSERT_NE(nullptr, p);
+    for (uint16_t i=20; i<300; i++) {
+        p[i] = i;
+    }
+    p = (uint8_t *)pool.change_size(heap, p, 300, 40);
+    ASSERT_NE(nullptr, p);
+    p = (uint8_t *)pool.change_size(heap, p, 40, 8);
+    ASSERT_NE(nullptr, p);
+    for (uint8_t i=0; i<8; i++) {
+        EXPECT_EQ(i, p[i]);
+    }
+    release(p, 8);
+}
+
+/*
+  random churn must never hand out a block which is still in use
+ */
+TEST_F(PoolTest, Churn)
+{
+    const uint16_t max_allocs = 500;
+    struct {
+        uint8_t *ptr;
+        uint16_t size;
+    } allocs[max_allocs] {};
+
+    for (uint32_t n=0; n<20000; n++) {
+        auto &a = allocs[get_random16() % max_allocs];
+        if (a.ptr != nullptr) {
+            for (uint16_t i=0; i<a.size; i++) {
+                ASSERT_EQ(uint8_t(uintptr_t(&a) + i), a.ptr[i]);
+            }
+        }
+        // mostly small objects, as from lua
+        const uint16_t size = (get_random16() % 8) == 0 ? get_random16() % 150 : get_random16() % 65;
+        a.ptr = (uint8_t *)pool.change_size(heap, a.ptr, a.ptr != nullptr ? a.size : 0, size);
+        a.size = size;
+        if (size == 0) {
+            EXPECT_EQ(nullptr, a.ptr);
+            continue;
+        }
+        ASSERT_NE(nullptr, a.ptr);
+        for (uint16_t i=0; i<size; i++) {
+            a.ptr[i] = uint8_t(uintptr_t(&a) + i);
+        }
+    }
+    for (auto &a : allocs) {
+        if (a.ptr != nullptr) {
+            release(a.ptr, a.size);
+        }
+    }
+}
+
+AP_GTEST_MAIN()
+
+#endif  // AP_SCRIPTING_ENABLED
@@ -30,8 +30,8 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 
     // @Param: POINTS
     // @DisplayName: SmartRTL maximum number of points on path
-    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory.
-    // @Range: 0 500
+    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory. Boards with less than 500k of RAM are limited to 500 points.
+    // @Range: 0 2000
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("POINTS", 1, AP_SmartRTL, _points_max, SMARTRTL_POINTS_DEFAULT),
@@ -72,6 +72,9 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 *    SMARTRTL_PRUNING_LOOP_TIME_US are used to limit how long each algorithm will
 *    be run before they save their state and return.
 *
+*    To avoid comparing every pair of segments, pruning finds the segments close
+*    to each new segment with a spatial index (see AP_SmartRTL_SegmentIndex).
+*
 *    Both algorithms are "anytime algorithms" meaning they can be interrupted
 *    before they complete which is helpful when memory is filling up and we just
 *    need to quickly identify a handful of points which can be deleted.
@@ -115,8 +118,10 @@ void AP_SmartRTL::init()
     _simplify.stack_max = _points_max * SMARTRTL_SIMPLIFY_STACK_LEN_MULT;
     _simplify.stack = (simplify_start_finish_t*)calloc(_simplify.stack_max, sizeof(simplify_start_finish_t));
 
+    const bool index_ok = _prune.index.init(_points_max, SMARTRTL_PRUNING_INDEX_CELL_SIZE);
+
     // check if memory allocation failed
-    if (_path == nullptr || _prune.loops == nullptr || _simplify.stack == nullptr) {
+    if (_path == nullptr || _prune.loops == nullptr || _simplify.stack == nullptr || !index_ok) {
         log_action(Action::DEACTIVATED_INIT_FAILED);
         GCS_SEND_TEXT(MAV_SEVERITY_WARNING, "SmartRTL deactivated: init failed");
         free(_path);
@@ -367,6 +372,11 @@ void AP_SmartRTL::run_background_cleanup()
     _path_points_completed_limit = SMARTRTL_POINTS_MAX;
     _path_sem.give();
 
+    // remove any segments popped from the path from the pruning index
+    if (path_points_completed_limit > 0) {
+        _prune.index.truncate(path_points_completed_limit - 1);
+    }
+
     // check if thorough cleanup is required
     if (_thorough_clean_request_ms > 0) {
         // check if we have already completed the request
@@ -562,6 +572,7 @@ void AP_SmartRTL::detect_simplifications()
 *   This method runs for the allotted time, and detects loops in a path. Any detected loops are added to _prune.loops,
 *   this function does not alter the path in memory. It works by comparing the line segment between any two sequential points
 *   to the line segment between any other two sequential points. If they get close enough, anything between them could be pruned.
+*   Only the segments found near each new segment by the spatial index are compared with it.
 *
 *   reset_pruning should have been called at least once before this function is called to setup the indexes (_prune.i, etc)
 */
@@ -576,34 +587,50 @@ void AP_SmartRTL::detect_loops()
     // capture start time
     const uint32_t start_time_us = AP_HAL::micros();
 
+    // add any segments not yet in the index
+    while (_prune.index.count() < _prune.path_points_count - 1) {
+        if (AP_HAL::micros() - start_time_us > SMARTRTL_PRUNING_LOOP_TIME_US) {
+            return;
+        }
+        const uint16_t seg = _prune.index.count();
+        _prune.index.add(_path[seg], _path[seg+1]);
+    }
+
     // run for defined amount of time
     while (AP_HAL::micros() - start_time_us < SMARTRTL_PRUNING_LOOP_TIME_US) {
 
-        // advance inner loop
-        _prune.j++;
-        if (_prune.j > _prune.i - 2) {
-            // set inner loop back to first point
-            _prune.j = 1;
-            // reduce outer loop
-            _prune.i--;
-            // complete when outer loop has run out of new points to check
-            if (_prune.i < 4 || _prune.i < _prune.path_points_completed) {
-                _prune.complete = true;
-                _prune.path_points_completed = _prune.path_points_count;
+        // find the first segment (ending at point j) which comes close to the segment ending at point i,
+        // ignoring the segment next to it
+        const uint16_t i = _prune.i;
+        uint16_t loop_j = 0;
+        dist_point loop_dp {};
+        _prune.index.foreach_near(_path[i-1], _path[i], SMARTRTL_PRUNING_DELTA, [&](uint16_t seg) {
+            const uint16_t j = seg + 1;
+            if (j > i - 2 || (loop_j != 0 && j >= loop_j)) {
                 return;
             }
-        }
-
-        // find the closest distance between two line segments and the mid-point
-        dist_point dp = segment_segment_dist(_path[_prune.i], _path[_prune.i-1], _path[_prune.j-1], _path[_prune.j]);
-        if (dp.distance < SMARTRTL_PRUNING_DELTA) {
+            const dist_point dp = segment_segment_dist(_path[i], _path[i-1], _path[j-1], _path[j]);
+            if (dp.distance < SMARTRTL_PRUNING_DELTA) {
+                loop_j = j;
+                loop_dp = dp;
+            }
+        });
+        if (loop_j != 0) {
             // if there is a loop here, add to loop array
-            if (!add_loop(_prune.j, _prune.i-1, dp.midpoint)) {
+            if (!add_loop(loop_j, i-1, loop_dp.midpoint)) {
                 // if the buffer is full, stop trying to prune
                 _prune.complete = true;
+                return;
             }
-            // set inner loop forward to trigger outer loop move to next segment
-            _prune.j = _prune.i;
+        }
+
+        // move on to the previous segment
+        _prune.i--;
+        // complete when outer loop has run out of new points to check
+        if (_prune.i < 4 || _prune.i < _prune.path_points_completed) {
+            _prune.complete = true;
+            _prune.path_points_completed = _prune.path_points_count;
+            return;
         }
     }
 }
@@ -649,7 +676,6 @@ void AP_SmartRTL::restart_pruning(uint16_t path_points_count)
 {
     _prune.complete = false;
     _prune.i = (path_points_count > 0) ? path_points_count - 1 : 0;
-    _prune.j = 0;
     _prune.path_points_count = path_points_count;
 }
 
@@ -657,6 +683,7 @@ void AP_SmartRTL::restart_pruning(uint16_t path_points_count)
 void AP_SmartRTL::reset_pruning()
 {
     restart_pruning(0);
+    _prune.index.reset();
     _prune.loops_count = 0; // clear the loops that we've recorded
     _prune.path_points_completed = 0;
 }
@@ -673,6 +700,10 @@ void AP_SmartRTL::remove_points_by_simplify_bitmask()
     for (uint16_t src = 1; src < _path_points_count; src++) {
         if (!_simplify.bitmask.get(src)) {
             log_action(Action::POINT_SIMPLIFY, _path[src]);
+            if (removed == 0) {
+                // segments in the pruning index from the one ending at this point onwards have moved
+                _prune.index.truncate(src - 1);
+            }
             removed++;
         } else {
             _path[dest] = _path[src];
@@ -721,6 +752,9 @@ bool AP_SmartRTL::remove_points_by_loops(uint16_t num_points_to_remove)
         // midpoint goes into start_index (this is the end point of the first segment)
         _path[loop.start_index] = loop.midpoint;
 
+        // segments in the pruning index from the one ending at start_index onwards have moved
+        _prune.index.truncate(loop.start_index - 1);
+
         // shift points after the end of the loop down by the number of points in the loop
         uint16_t loop_num_points_to_remove = loop.end_index - loop.start_index;
         for (uint16_t dest = loop.start_index + 1; dest < _path_points_count - loop_num_points_to_remove; dest++) {
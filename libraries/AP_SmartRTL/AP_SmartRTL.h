@@ -5,10 +5,16 @@
 #include <AP_Math/AP_Math.h>
 #include <AP_Logger/AP_Logger_config.h>
 
+#include "AP_SmartRTL_SegmentIndex.h"
+
 // definitions and macros
 #define SMARTRTL_ACCURACY_DEFAULT        2.0f   // default _ACCURACY parameter value.  Points will be no closer than this distance (in meters) together.
-#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 20bytes * this number.
-#define SMARTRTL_POINTS_MAX              500    // the absolute maximum number of points this library can support.
+#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 25bytes * this number.
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define SMARTRTL_POINTS_MAX              2000   // the absolute maximum number of points this library can support.
+#else
+#define SMARTRTL_POINTS_MAX              500
+#endif
 #define SMARTRTL_TIMEOUT                 15000  // the time in milliseconds with no points saved to the path (for whatever reason), before SmartRTL is disabled for the flight
 #define SMARTRTL_CLEANUP_POINT_TRIGGER   50     // simplification will trigger when this many points are added to the path
 #define SMARTRTL_CLEANUP_START_MARGIN    10     // routine cleanup algorithms begin when the path array has only this many empty slots remaining
@@ -21,6 +27,7 @@
 #define SMARTRTL_PRUNING_DELTA (_accuracy * 0.99)   // How many meters apart must two points be, such that we can assume that there is no obstacle between them.  must be smaller than _ACCURACY parameter
 #define SMARTRTL_PRUNING_LOOP_BUFFER_LEN_MULT 0.25f // pruning loop buffer size as compared to maximum number of points
 #define SMARTRTL_PRUNING_LOOP_TIME_US    200    // maximum time (in microseconds) that the loop finding algorithm will run before returning
+#define SMARTRTL_PRUNING_INDEX_CELL_SIZE (_accuracy * 4.0f) // size (in meters) of the grid cells used to find path segments close to each other
 
 class AP_SmartRTL {
 
@@ -89,6 +96,7 @@ public:
     static const struct AP_Param::GroupInfo var_info[];
 
 private:
+    friend class AP_SmartRTL_Test;
 
     // enums for logging latest actions
     enum Action : uint8_t {
@@ -231,8 +239,8 @@ private:
         bool complete;
         uint16_t path_points_count;  // copy of _path_points_count taken when the prune algorithm started
         uint16_t path_points_completed; // number of points in that path that have already been checked for loops and should be ignored
-        uint16_t i;     // loop search's outer loop index
-        uint16_t j;     // loop search's inner loop index
+        uint16_t i;     // index of the last point of the segment the loop search will check next
+        AP_SmartRTL_SegmentIndex index; // the segments of the path checked against
         prune_loop_t* loops;// the result of the pruning algorithm
         uint16_t loops_max; // maximum number of elements in the _prunable_loops array
         uint16_t loops_count;   // number of elements in the _prunable_loops array
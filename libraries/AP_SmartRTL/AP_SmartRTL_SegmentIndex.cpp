@@ -0,0 +1,97 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_SmartRTL_SegmentIndex.h"
+
+#include <AP_Common/AP_Common.h>
+
+AP_SmartRTL_SegmentIndex::~AP_SmartRTL_SegmentIndex()
+{
+    delete[] _next;
+    delete[] _heads;
+}
+
+bool AP_SmartRTL_SegmentIndex::init(uint16_t num_points, float cell_size_m)
+{
+    if (num_points == 0 || !is_positive(cell_size_m)) {
+        return false;
+    }
+    const uint16_t max_segments = MAX(num_points - 1, 1);
+
+    // about two segments per bucket when full
+    uint16_t num_buckets = 16;
+    while (num_buckets < max_segments / 2) {
+        num_buckets *= 2;
+    }
+
+    uint16_t *next = NEW_NOTHROW uint16_t[max_segments];
+    uint16_t *heads = NEW_NOTHROW uint16_t[num_buckets + 1];
+    if (next == nullptr || heads == nullptr) {
+        delete[] next;
+        delete[] heads;
+        return false;
+    }
+
+    _next = next;
+    _heads = heads;
+    _max_segments = max_segments;
+    _num_buckets = num_buckets;
+    _cell_size_inv = 1.0f / cell_size_m;
+    reset();
+    return true;
+}
+
+void AP_SmartRTL_SegmentIndex::reset()
+{
+    if (_heads == nullptr) {
+        return;
+    }
+    for (uint16_t i = 0; i <= _num_buckets; i++) {
+        _heads[i] = NONE;
+    }
+    _count = 0;
+    _max_half_length = 0;
+}
+
+void AP_SmartRTL_SegmentIndex::truncate(uint16_t count)
+{
+    if (count >= _count) {
+        return;
+    }
+    // segments are added in order, so each bucket's list starts with the highest numbered
+    for (uint16_t i = 0; i <= _num_buckets; i++) {
+        while (_heads[i] != NONE && _heads[i] >= count) {
+            _heads[i] = _next[_heads[i]];
+        }
+    }
+    _count = count;
+}
+
+void AP_SmartRTL_SegmentIndex::add(const Vector3f &p1, const Vector3f &p2)
+{
+    if (_count >= _max_segments) {
+        return;
+    }
+    const float half_length = (p2 - p1).length() * 0.5f;
+    uint16_t b = _num_buckets;
+    if (half_length * _cell_size_inv <= max_half_length_cells) {
+        const Vector3f mid = (p1 + p2) * 0.5f;
+        b = bucket(cell(mid.x), cell(mid.y));
+        _max_half_length = MAX(_max_half_length, half_length);
+    }
+    _next[_count] = _heads[b];
+    _heads[b] = _count;
+    _count++;
+}
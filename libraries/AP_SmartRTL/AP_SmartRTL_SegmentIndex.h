@@ -0,0 +1,101 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  spatial index over the segments of the SmartRTL path, used by the
+  loop detection to find the segments which may come close to a new
+  segment without comparing it against the whole path.
+
+  Segment n joins path points n and n+1, and segments are added in
+  order. Each is hashed on the horizontal grid cell of its midpoint,
+  and a search covers the cells within the requested distance plus the
+  longest half-length of any indexed segment. Segments too long for
+  that to be useful are kept on a separate list which is always
+  searched.
+
+  Segments must be removed from the index, with truncate(), when their
+  points are moved or removed from the path.
+ */
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+
+class AP_SmartRTL_SegmentIndex {
+public:
+    static constexpr uint16_t NONE = UINT16_MAX;
+
+    ~AP_SmartRTL_SegmentIndex();
+
+    // allocate for a path of up to num_points points, returns false on failure
+    bool init(uint16_t num_points, float cell_size_m);
+
+    // remove all segments
+    void reset();
+
+    // remove the segments numbered count and above
+    void truncate(uint16_t count);
+
+    // number of segments in the index, the next segment added is this number
+    uint16_t count() const { return _count; }
+
+    // add the segment from p1 to p2 as the next segment
+    void add(const Vector3f &p1, const Vector3f &p2);
+
+    // call fn(segment) for every indexed segment which may be within
+    // dist of the segment from p1 to p2. A segment may be visited more
+    // than once
+    template <typename F>
+    void foreach_near(const Vector3f &p1, const Vector3f &p2, float dist, F fn) const {
+        // with a little extra to allow for rounding of the midpoints
+        const float expand = (dist + _max_half_length) * 1.01f;
+        const int32_t x0 = cell(MIN(p1.x, p2.x) - expand), x1 = cell(MAX(p1.x, p2.x) + expand);
+        const int32_t y0 = cell(MIN(p1.y, p2.y) - expand), y1 = cell(MAX(p1.y, p2.y) + expand);
+        if (uint64_t(x1 - x0 + 1) * uint64_t(y1 - y0 + 1) >= _count) {
+            // searching the grid would take longer than checking everything
+            for (uint16_t i = 0; i < _count; i++) {
+                fn(i);
+            }
+            return;
+        }
+        for (int32_t x = x0; x <= x1; x++) {
+            for (int32_t y = y0; y <= y1; y++) {
+                for (uint16_t i = _heads[bucket(x, y)]; i != NONE; i = _next[i]) {
+                    fn(i);
+                }
+            }
+        }
+        for (uint16_t i = _heads[_num_buckets]; i != NONE; i = _next[i]) {
+            fn(i);
+        }
+    }
+
+private:
+    // segments with a half-length of more than this many cells go on the long list
+    static constexpr float max_half_length_cells = 4;
+
+    int32_t cell(float pos) const {
+        return int32_t(floorf(constrain_float(pos * _cell_size_inv, -1.0e6, 1.0e6)));
+    }
+    uint16_t bucket(int32_t x, int32_t y) const {
+        return ((uint32_t(x) * 73856093U) ^ (uint32_t(y) * 19349663U)) & (_num_buckets - 1);
+    }
+
+    uint16_t *_next = nullptr;  // next segment in the same bucket, per segment
+    uint16_t *_heads = nullptr; // first segment in each bucket, then the head of the long list
+    uint16_t _max_segments = 0;
+    uint16_t _num_buckets = 0;
+    uint16_t _count = 0;
+    float _cell_size_inv = 1;
+    float _max_half_length = 0; // longest half-length of the segments on the grid
+};
@@ -0,0 +1,175 @@
+#include <AP_gtest.h>
+
+/*
+  tests for the SmartRTL path cleanup. The path recorded for the
+  example sketch is replayed, and the loops found in long flights with
+  the segment index are compared against those found by comparing
+  every pair of segments, as pruning did before it was indexed
+ */
+
+#include <AP_SmartRTL/AP_SmartRTL.h>
+#include "../examples/SmartRTL_test/SmartRTL_test.h"
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+class AP_SmartRTL_Test
+{
+public:
+    AP_SmartRTL_Test(uint16_t points_max) {
+        srtl._points_max.set(points_max);
+        srtl.init();
+    }
+
+    // clear the path and fly along points, running the background
+    // cleanup after each as the IO thread would. Returns the number of
+    // points flown before the path first filled up
+    uint32_t fly(const Vector3p *points, uint32_t count, uint8_t cleanup_calls) {
+        srtl.set_home(true, Vector3p{});
+        uint32_t flown = count;
+        for (uint32_t i=0; i<count; i++) {
+            if (srtl._path_points_count >= srtl._path_points_max && flown == count) {
+                flown = i;
+            }
+            srtl.update(true, points[i]);
+            for (uint8_t c=0; c<cleanup_calls; c++) {
+                srtl.run_background_cleanup();
+            }
+        }
+        return flown;
+    }
+
+    void thorough_cleanup(AP_SmartRTL::ThoroughCleanupType clean_type) {
+        while (!srtl.thorough_cleanup(srtl._path_points_count, clean_type)) {}
+    }
+
+    void check_path(const std::vector<Vector3p> &expected) const {
+        ASSERT_EQ(expected.size(), srtl.get_num_points());
+        for (uint16_t i=0; i<expected.size(); i++) {
+            ASSERT_EQ(expected[i].tofloat(), srtl.get_point(i));
+        }
+    }
+
+    // find all the loops in the path with the index and by comparing
+    // every pair of segments
+    void check_loops() {
+        const uint16_t count = srtl._path_points_count;
+        srtl.reset_pruning();
+        srtl.restart_pruning(count);
+        while (!srtl._prune.complete) {
+            srtl.detect_loops();
+        }
+        const uint16_t loops_count = srtl._prune.loops_count;
+        AP_SmartRTL::prune_loop_t *loops = new AP_SmartRTL::prune_loop_t[loops_count];
+        memcpy(loops, srtl._prune.loops, loops_count * sizeof(loops[0]));
+
+        srtl.reset_pruning();
+        const float delta = srtl._accuracy * 0.99;  // SMARTRTL_PRUNING_DELTA
+        for (uint16_t i = count-1; i >= 4 || i == count-1; i--) {
+            for (uint16_t j = 1; j <= i - 2; j++) {
+                const AP_SmartRTL::dist_point dp = AP_SmartRTL::segment_segment_dist(srtl._path[i], srtl._path[i-1], srtl._path[j-1], srtl._path[j]);
+                if (dp.distance < delta) {
+                    ASSERT_TRUE(srtl.add_loop(j, i-1, dp.midpoint));
+                    break;
+                }
+            }
+        }
+
+        EXPECT_GT(loops_count, 10);
+        ASSERT_EQ(srtl._prune.loops_count, loops_count);
+        for (uint16_t l=0; l<loops_count; l++) {
+            ASSERT_EQ(srtl._prune.loops[l].start_index, loops[l].start_index);
+            ASSERT_EQ(srtl._prune.loops[l].end_index, loops[l].end_index);
+            ASSERT_EQ(srtl._prune.loops[l].midpoint, loops[l].midpoint);
+        }
+        delete[] loops;
+    }
+
+    bool active() const { return srtl.is_active(); }
+    uint16_t num_points() const { return srtl.get_num_points(); }
+
+private:
+    AP_SmartRTL srtl{true};
+};
+
+TEST(AP_SmartRTL, ExamplePath)
+{
+    static AP_SmartRTL_Test test{SMARTRTL_POINTS_DEFAULT};
+
+    test.fly(test_path_before.data(), test_path_before.size(), 0);
+    test.check_path(test_path_after_adding);
+    test.thorough_cleanup(AP_SmartRTL::THOROUGH_CLEAN_SIMPLIFY_ONLY);
+    test.check_path(test_path_after_simplifying);
+
+    test.fly(test_path_before.data(), test_path_before.size(), 0);
+    test.thorough_cleanup(AP_SmartRTL::THOROUGH_CLEAN_ALL);
+    test.check_path(test_path_complete);
+}
+
+static uint32_t seed = 1;
+static float rand_float(float min, float max)
+{
+    seed = seed * 1103515245U + 12345U;
+    return min + (max - min) * ((seed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+/*
+  a vehicle wandering within radius of the start with a turn rate that
+  changes every few seconds, and circling every so often, so it often
+  crosses its own path. A point is added every accuracy meters
+ */
+static Vector3p *wander(uint32_t count, float radius)
+{
+    Vector3p *points = new Vector3p[count];
+    Vector3p pos;
+    float heading = 0;
+    float wander_rate = 0;
+    for (uint32_t i=0; i<count; i++) {
+        if (i % 20 == 0) {
+            wander_rate = rand_float(-0.02, 0.02);
+        }
+        // one full circle with a radius of about 10m every 100 points
+        const float turn_rate = (i % 100 < 30) ? M_2PI / 30 : wander_rate;
+        heading += turn_rate + rand_float(-0.02, 0.02);
+        if (pos.xy().length() > radius) {
+            // head back towards the middle
+            heading = atan2f(-pos.y, -pos.x) + rand_float(-1, 1);
+        }
+        pos.x += cosf(heading) * SMARTRTL_ACCURACY_DEFAULT * 1.1;
+        pos.y += sinf(heading) * SMARTRTL_ACCURACY_DEFAULT * 1.1;
+        pos.z = -10 + rand_float(-0.5, 0.5);
+        points[i] = pos;
+    }
+    return points;
+}
+
+TEST(AP_SmartRTL, LoopsMatchAllPairs)
+{
+    static AP_SmartRTL_Test test{SMARTRTL_POINTS_MAX};
+    const uint16_t count = SMARTRTL_POINTS_MAX - 1;
+    Vector3p *points = wander(count, 2000);
+
+    test.fly(points, count, 0);
+    ASSERT_EQ(count + 1, test.num_points());
+    test.check_loops();
+    delete[] points;
+}
+
+/*
+  a flight many times longer than the path over a small area, which
+  must be cleaned up as it goes
+ */
+TEST(AP_SmartRTL, LongFlight)
+{
+    static AP_SmartRTL_Test test{SMARTRTL_POINTS_MAX};
+    const uint32_t count = SMARTRTL_POINTS_MAX * 10;
+    Vector3p *points = wander(count, 200);
+
+    EXPECT_GT(test.fly(points, count, 5), SMARTRTL_POINTS_MAX * 5U);
+    EXPECT_TRUE(test.active());
+    test.thorough_cleanup(AP_SmartRTL::THOROUGH_CLEAN_ALL);
+    EXPECT_TRUE(test.active());
+    EXPECT_LT(test.num_points(), SMARTRTL_POINTS_MAX);
+    delete[] points;
+}
+
+AP_GTEST_MAIN()
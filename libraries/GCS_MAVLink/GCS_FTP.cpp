@@ -40,6 +40,8 @@ GCS_FTP *GCS_FTP::ftp;
 // timeout for session inactivity, when we will kill an idle session
 #define FTP_SESSION_KILL_TIMEOUT 20000
 
+static_assert(AP_MAVLINK_FTP_READ_BUFFER_SIZE <= UINT16_MAX, "FTP read buffer too large");
+
 bool GCS_FTP::init(void)
 {
     if (initialised) {
@@ -99,6 +101,15 @@ void GCS_FTP::handle_file_transfer_protocol(const mavlink_message_t &msg, mavlin
     }
 }
 
+/*
+  check if a reply could be sent on a channel now
+ */
+bool GCS_FTP::have_reply_space(mavlink_channel_t chan)
+{
+    return GCS_MAVLINK::last_txbuf_is_greater(33) &&
+        comm_get_txspace(chan) >= PAYLOAD_SIZE(chan, FILE_TRANSFER_PROTOCOL);
+}
+
 bool GCS_FTP::send_reply(const Transaction &reply)
 {
     if (!GCS_MAVLINK::last_txbuf_is_greater(33)) { // It helps avoid GCS timeout if this is less than the threshold where we slow down normal streams (<=49)
@@ -298,6 +309,15 @@ int GCS_FTP::Session::close(void)
         fd = -1;
     }
     last_send_ms = 0;
+    burst.active = false;
+#if AP_MAVLINK_FTP_READ_BUFFER_SIZE > 0
+    if (read_buf != nullptr) {
+        delete[] read_buf;
+        read_buf = nullptr;
+        read_bufs_allocated--;
+    }
+    read_buf_len = 0;
+#endif
 
     return result;
 }
@@ -374,6 +394,16 @@ bool GCS_FTP::Session::handle_request(Transaction &request, Transaction &reply)
             break;
         }
         mode = FTP_FILE_MODE::Read;
+#if AP_MAVLINK_FTP_READ_BUFFER_SIZE > 0
+        // if there is no buffer the file is read a packet at a time
+        if (read_bufs_allocated < AP_MAVLINK_FTP_READ_BUFFERS) {
+            read_buf = NEW_NOTHROW uint8_t[AP_MAVLINK_FTP_READ_BUFFER_SIZE];
+            if (read_buf != nullptr) {
+                read_bufs_allocated++;
+            }
+        }
+        read_buf_len = 0;
+#endif
 
         reply.opcode = FTP_OP::Ack;
         reply.size = sizeof(uint32_t);
@@ -402,14 +432,8 @@ bool GCS_FTP::Session::handle_request(Transaction &request, Transaction &reply)
             break;
         }
 
-        // seek to requested offset
-        if (AP::FS().lseek(fd, request.offset, SEEK_SET) == -1) {
-            GCS_FTP::error(reply, FTP_ERROR::FailErrno);
-            break;
-        }
-
         // fill the buffer
-        const ssize_t read_bytes = AP::FS().read(fd, reply.data, MIN(sizeof(reply.data),request.size));
+        const ssize_t read_bytes = read(request.offset, reply.data, MIN(sizeof(reply.data),request.size));
         if (read_bytes == -1) {
             GCS_FTP::error(reply, FTP_ERROR::FailErrno);
             break;
@@ -552,91 +576,11 @@ bool GCS_FTP::Session::handle_request(Transaction &request, Transaction &reply)
         break;
     }
     case FTP_OP::BurstReadFile:
-    {
-        const uint16_t max_read = (request.size == 0?sizeof(reply.data):request.size);
-        // must actually be working on a file
-        if (fd == -1) {
-            GCS_FTP::error(reply, FTP_ERROR::FileNotFound);
-            break;
-        }
-
-        // must have the file in read mode
-        if ((mode != FTP_FILE_MODE::Read)) {
-            GCS_FTP::error(reply, FTP_ERROR::Fail);
-            break;
-        }
-
-        // seek to requested offset
-        if (AP::FS().lseek(fd, request.offset, SEEK_SET) == -1) {
-            GCS_FTP::error(reply, FTP_ERROR::FailErrno);
-            break;
-        }
-
-        /*
-          calculate a burst delay so that FTP burst
-          transfer doesn't use more than 1/3 of
-          available bandwidth on links that don't have
-          flow control. This reduces the chance of
-          lost packets a lot, which results in overall
-          faster transfers
-        */
-        uint32_t burst_delay_ms = 0;
-        if (valid_channel(request.chan)) {
-            auto *port = mavlink_comm_port[request.chan];
-            if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
-                const uint32_t bw = port->bw_in_bytes_per_second();
-                const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
-                burst_delay_ms = 3000 * pkt_size / bw;
-            }
-        }
-
-        // this transfer size is enough for a full parameter file with max parameters
-        const uint32_t transfer_size = 2000;
-        for (uint32_t i = 0; (i < transfer_size); i++) {
-            // fill the buffer
-            const ssize_t read_bytes = AP::FS().read(fd, reply.data, MIN(sizeof(reply.data), max_read));
-            if (read_bytes == -1) {
-                GCS_FTP::error(reply, FTP_ERROR::FailErrno);
-                break;
-            }
-
-            if (read_bytes != sizeof(reply.data)) {
-                // don't send any old data
-                memset(reply.data + read_bytes, 0, sizeof(reply.data) - read_bytes);
-            }
-
-            if (read_bytes == 0) {
-                GCS_FTP::error(reply, FTP_ERROR::EndOfFile);
-                break;
-            }
-
-            reply.opcode = FTP_OP::Ack;
-            reply.offset = request.offset + i * max_read;
-            reply.burst_complete = ((read_bytes < max_read) || (i == (transfer_size - 1)));
-            reply.size = (uint8_t)read_bytes;
-
-            push_reply(reply);
-
-            if (read_bytes < max_read) {
-                // ensure the NACK which we send next is at the right offset
-                reply.offset += read_bytes;
-            }
-
-            // prep the reply to be used again
-            reply.seq_number++;
-
-            if (burst_delay_ms > 0) {
-                hal.scheduler->delay(burst_delay_ms);
-            }
-        }
-
-        if (reply.opcode != FTP_OP::Nack) {
-            // prevent a duplicate packet send for
-            // normal replies of burst reads
-            skip_push_reply = true;
-        }
+    case FTP_OP::BurstReadFileWindow:
+        start_burst(request, reply);
+        // the burst sends its own replies, or an error now
+        skip_push_reply = (reply.opcode != FTP_OP::Nack);
         break;
-    }
 
     case FTP_OP::Rename: {
         // sanity check that the request looks well formed
@@ -671,6 +615,248 @@ bool GCS_FTP::Session::handle_request(Transaction &request, Transaction &reply)
     return skip_push_reply;
 }
 
+/*
+  read from the open file at offset
+ */
+ssize_t GCS_FTP::Session::read(uint32_t offset, uint8_t *buf, uint8_t count)
+{
+#if AP_MAVLINK_FTP_READ_BUFFER_SIZE > 0
+    if (read_buf != nullptr) {
+        if ((offset < read_buf_ofs || offset + count > read_buf_ofs + read_buf_len) &&
+            !fill_read_buf(offset)) {
+            return -1;
+        }
+        if (offset >= read_buf_ofs + read_buf_len) {
+            // end of file
+            return 0;
+        }
+        const uint32_t n = MIN(uint32_t(count), read_buf_ofs + read_buf_len - offset);
+        memcpy(buf, &read_buf[offset - read_buf_ofs], n);
+        return n;
+    }
+#endif
+    if (AP::FS().lseek(fd, offset, SEEK_SET) == -1) {
+        return -1;
+    }
+    return AP::FS().read(fd, buf, count);
+}
+
+#if AP_MAVLINK_FTP_READ_BUFFER_SIZE > 0
+uint8_t GCS_FTP::Session::read_bufs_allocated;
+
+/*
+  read as much of the file from offset as fits in the read
+  buffer. When reading on from the data in the buffer a quarter of
+  the buffer before offset is kept, so that packets a GCS lost and
+  asks for again can be sent without reading them again
+ */
+bool GCS_FTP::Session::fill_read_buf(uint32_t offset)
+{
+    if (offset >= read_buf_ofs && offset <= read_buf_ofs + read_buf_len) {
+        const uint32_t keep = AP_MAVLINK_FTP_READ_BUFFER_SIZE / 4;
+        const uint32_t start = MAX(read_buf_ofs, offset > keep ? offset - keep : 0);
+        const uint32_t discard = start - read_buf_ofs;
+        memmove(read_buf, &read_buf[discard], read_buf_len - discard);
+        read_buf_ofs = start;
+        read_buf_len -= discard;
+    } else {
+        read_buf_ofs = offset;
+        read_buf_len = 0;
+    }
+
+    if (AP::FS().lseek(fd, read_buf_ofs + read_buf_len, SEEK_SET) == -1) {
+        return false;
+    }
+    const ssize_t n = AP::FS().read(fd, &read_buf[read_buf_len], AP_MAVLINK_FTP_READ_BUFFER_SIZE - read_buf_len);
+    if (n == -1) {
+        return false;
+    }
+    read_buf_len += n;
+    return true;
+}
+#endif  // AP_MAVLINK_FTP_READ_BUFFER_SIZE > 0
+
+/*
+  start a burst read. For a windowed burst already in progress the
+  request instead moves the window on and asks for lost packets
+ */
+void GCS_FTP::Session::start_burst(const Transaction &request, Transaction &reply)
+{
+    const bool windowed = (request.opcode == FTP_OP::BurstReadFileWindow);
+    uint32_t window = 0;
+    uint16_t max_read = request.size;
+    if (windowed) {
+        if (request.size < 5) {
+            GCS_FTP::error(reply, FTP_ERROR::InvalidDataSize);
+            return;
+        }
+        window = le32toh_ptr(request.data);
+        max_read = request.data[4];
+    }
+    if (max_read == 0 || max_read > sizeof(reply.data)) {
+        max_read = sizeof(reply.data);
+    }
+
+    // must actually be working on a file
+    if (fd == -1) {
+        GCS_FTP::error(reply, FTP_ERROR::FileNotFound);
+        return;
+    }
+
+    // must have the file in read mode
+    if ((mode != FTP_FILE_MODE::Read)) {
+        GCS_FTP::error(reply, FTP_ERROR::Fail);
+        return;
+    }
+
+    /*
+      calculate a burst delay so that FTP burst
+      transfer doesn't use more than 1/3 of
+      available bandwidth on links that don't have
+      flow control. This reduces the chance of
+      lost packets a lot, which results in overall
+      faster transfers
+    */
+    burst.delay_ms = 0;
+    if (valid_channel(request.chan)) {
+        auto *port = mavlink_comm_port[request.chan];
+        if (port != nullptr && port->get_flow_control() != AP_HAL::UARTDriver::FLOW_CONTROL_ENABLE) {
+            const uint32_t bw = port->bw_in_bytes_per_second();
+            const uint16_t pkt_size = PAYLOAD_SIZE(request.chan, FILE_TRANSFER_PROTOCOL) - (sizeof(reply.data) - max_read);
+            burst.delay_ms = 3000 * pkt_size / bw;
+        }
+    }
+
+    // a windowed burst carries on from the last packet sent if the
+    // GCS has everything before it up to a point it has not
+    // acknowledged before
+    const bool carry_on = windowed && burst.active && burst.windowed &&
+        burst.max_read == max_read &&
+        request.offset >= burst.resend_base && request.offset <= burst.offset;
+    if (!carry_on) {
+        burst.offset = request.offset;
+    }
+    burst.active = true;
+    burst.windowed = windowed;
+    burst.max_read = max_read;
+    burst.seq_number = request.seq_number + 1;
+    burst.resend_base = request.offset;
+    memset(burst.resend, 0, sizeof(burst.resend));
+
+    if (!windowed) {
+        // this transfer size is enough for a full parameter file with max parameters
+        const uint32_t transfer_size = 2000;
+        burst.end = request.offset + transfer_size * max_read;
+        return;
+    }
+
+    burst.end = request.offset + MIN(window, UINT32_MAX - request.offset);
+    memcpy(burst.resend, &request.data[5], MIN(sizeof(burst.resend), size_t(request.size - 5)));
+    // only packets which have been sent can be lost
+    for (uint16_t i=0; i<sizeof(burst.resend)*8; i++) {
+        if (burst.resend_base + i * max_read >= burst.offset) {
+            burst.resend[i/8] &= ~(1U<<(i%8));
+        }
+    }
+}
+
+/*
+  return true if a burst has a packet to send now
+ */
+bool GCS_FTP::Session::burst_pending(uint32_t now) const
+{
+    return burst_wait_ms(now) == 0;
+}
+
+uint32_t GCS_FTP::Session::burst_wait_ms(uint32_t now) const
+{
+    if (!burst.active) {
+        return UINT32_MAX;
+    }
+    bool have_packet = burst.offset < burst.end;
+    for (const uint8_t r : burst.resend) {
+        have_packet |= (r != 0);
+    }
+    if (!have_packet) {
+        return UINT32_MAX;
+    }
+    const uint32_t since_send_ms = now - last_send_ms;
+    if (since_send_ms < burst.delay_ms) {
+        return burst.delay_ms - since_send_ms;
+    }
+    return 0;
+}
+
+/*
+  send the next packet of a burst read, returning true if one was sent
+ */
+bool GCS_FTP::Session::send_burst(Transaction &reply)
+{
+    const uint32_t now = AP_HAL::millis();
+    if (!burst_pending(now) || !have_reply_space(chan)) {
+        return false;
+    }
+    const int16_t resend_idx = next_burst_packet(reply);
+    if (!send_reply(reply)) {
+        // try again when there is space
+        return false;
+    }
+    burst_packet_sent(reply, resend_idx, now);
+    return true;
+}
+
+int16_t GCS_FTP::Session::next_burst_packet(Transaction &reply)
+{
+    // packets the GCS lost go first
+    uint32_t offset = burst.offset;
+    int16_t resend_idx = -1;
+    for (uint16_t i=0; i<sizeof(burst.resend)*8; i++) {
+        if (burst.resend[i/8] & (1U<<(i%8))) {
+            resend_idx = i;
+            offset = burst.resend_base + i * burst.max_read;
+            break;
+        }
+    }
+
+    memset(&reply, 0, sizeof(reply));
+    reply.req_opcode = burst.windowed ? FTP_OP::BurstReadFileWindow : FTP_OP::BurstReadFile;
+    reply.session = session_id;
+    reply.seq_number = burst.seq_number;
+    reply.chan = chan;
+    reply.sysid = sysid;
+    reply.compid = compid;
+    reply.offset = offset;
+
+    const ssize_t read_bytes = read(offset, reply.data, burst.max_read);
+    if (read_bytes == -1) {
+        GCS_FTP::error(reply, FTP_ERROR::FailErrno);
+    } else if (read_bytes == 0) {
+        GCS_FTP::error(reply, FTP_ERROR::EndOfFile);
+    } else {
+        reply.opcode = FTP_OP::Ack;
+        reply.burst_complete = (read_bytes < burst.max_read) || (offset + read_bytes >= burst.end);
+        reply.size = (uint8_t)read_bytes;
+    }
+    return resend_idx;
+}
+
+void GCS_FTP::Session::burst_packet_sent(const Transaction &reply, int16_t resend_idx, uint32_t now)
+{
+    last_send_ms = now;
+    burst.seq_number++;
+
+    if (resend_idx >= 0) {
+        burst.resend[resend_idx/8] &= ~(1U<<(resend_idx%8));
+    } else if (reply.opcode == FTP_OP::Nack) {
+        // a windowed burst waits for the GCS to ask again
+        burst.active = burst.windowed;
+        burst.end = burst.offset;
+    } else {
+        burst.offset += reply.size;
+        burst.active = burst.windowed || burst.offset < burst.end;
+    }
+}
+
 /*
   get the time of the last send for a channel
  */
@@ -742,98 +928,143 @@ void GCS_FTP::worker(void)
     reply.session = -1; // flag the reply as invalid for any reuse
 
     while (true) {
-        while (!requests.pop(request)) {
-            // nothing to handle, delay ourselves a bit then check again. Ideally we'd use conditional waits here
-            hal.scheduler->delay(2);
-
-            // kill any dead sessions
-            const uint32_t now = AP_HAL::millis();
-            for (auto &s : sessions) {
-                if (s.last_send_ms != 0 &&
-                    now - s.last_send_ms > FTP_SESSION_KILL_TIMEOUT) {
-                    s.close();   // error code ignored
-                }
-            }
+        reap_sessions(AP_HAL::millis());
+
+        bool busy = false;
+        if (requests.pop(request)) {
+            handle_request(request, reply);
+            busy = true;
         }
 
-        if (request.opcode == FTP_OP::ResetSessions) {
-            /*
-              close all sessions for this channel, compid and sysid
-             */
-            for (auto &s : sessions) {
-                if (request.sysid == s.sysid &&
-                    request.compid == s.compid &&
-                    request.chan == s.chan) {
-                    // close this session
-                    s.close();   // error code ignored
-                }
+        // sessions with a burst read in progress take turns to send a
+        // packet, so one long transfer doesn't hold up the others
+        for (auto &s : sessions) {
+            if (s.send_burst(burst_reply)) {
+                busy = true;
             }
-            // always ACK, even if no sessions were closed
-            setup_reply(request, reply);
-            reply.opcode = FTP_OP::Ack;
-            send_reply(reply);
+        }
+        if (busy) {
             continue;
         }
 
-        Session *session = nullptr;
-        for (uint8_t i=0; i<ARRAY_SIZE(sessions); i++) {
-            auto &s = sessions[i];
+        // bursts waiting for their next packet to be due or for space
+        // in the link sleep until the soonest is due, but no longer
+        // than the idle delay so new requests are still handled promptly
+        uint32_t wait_ms = UINT32_MAX;
+        const uint32_t now_ms = AP_HAL::millis();
+        for (const auto &s : sessions) {
+            wait_ms = MIN(wait_ms, s.burst_wait_ms(now_ms));
+        }
+        if (wait_ms != UINT32_MAX) {
+            hal.scheduler->delay(constrain_uint32(wait_ms, 1, 2));
+            continue;
+        }
+
+        // nothing to handle, delay ourselves a bit then check again. Ideally we'd use conditional waits here
+        hal.scheduler->delay(2);
+    }
+}
+
+/*
+  kill any dead sessions. A session with a burst in progress is
+  sending, so is only killed if its burst has stalled, for example
+  waiting on a GCS which has gone away
+ */
+void GCS_FTP::reap_sessions(uint32_t now)
+{
+    for (auto &s : sessions) {
+        if (s.last_send_ms != 0 &&
+            now - s.last_send_ms > FTP_SESSION_KILL_TIMEOUT) {
+            s.close();   // error code ignored
+        }
+    }
+}
+
+/*
+  handle one request from the queue
+ */
+void GCS_FTP::handle_request(Transaction &request, Transaction &reply)
+{
+    if (request.opcode == FTP_OP::ResetSessions) {
+        /*
+          close all sessions for this channel, compid and sysid
+         */
+        for (auto &s : sessions) {
             if (request.sysid == s.sysid &&
                 request.compid == s.compid &&
-                request.chan == s.chan &&
-                request.session == s.session_id) {
-                // found the session
-                session = &s;
-                break;
+                request.chan == s.chan) {
+                // close this session
+                s.close();   // error code ignored
             }
         }
+        // always ACK, even if no sessions were closed
+        setup_reply(request, reply);
+        reply.opcode = FTP_OP::Ack;
+        send_reply(reply);
+        return;
+    }
 
-        if (session == nullptr) {
-            /*
-              find the oldest session to possibly reuse
-             */
-            const uint32_t now = AP_HAL::millis();
-            session = &sessions[0];
-            for (uint8_t i=1; i<ARRAY_SIZE(sessions); i++) {
-                auto &s = sessions[i];
-                if ((now - s.last_send_ms) > (now - session->last_send_ms)) {
-                    session = &s;
-                }
-            }
+    Session *session = nullptr;
+    for (uint8_t i=0; i<ARRAY_SIZE(sessions); i++) {
+        auto &s = sessions[i];
+        if (request.sysid == s.sysid &&
+            request.compid == s.compid &&
+            request.chan == s.chan &&
+            request.session == s.session_id) {
+            // found the session
+            session = &s;
+            break;
+        }
+    }
 
-            // only reuse the session if it is not active
-            auto &s = *session;
-            if (s.last_send_ms != 0 &&
-                now - s.last_send_ms < FTP_SESSION_TIMEOUT) {
-                // the oldest session is still active, reject the request
-                setup_reply(request, reply);
-                error(reply, FTP_ERROR::NoSessionsAvailable);
-                send_reply(reply);
-                continue;
+    if (session == nullptr) {
+        /*
+          find the oldest session to possibly reuse
+         */
+        const uint32_t now = AP_HAL::millis();
+        session = &sessions[0];
+        for (uint8_t i=1; i<ARRAY_SIZE(sessions); i++) {
+            auto &s = sessions[i];
+            if ((now - s.last_send_ms) > (now - session->last_send_ms)) {
+                session = &s;
             }
-            // claim the session
-            s.close();   // error code ignored
-            s.session_id = request.session;
-            s.sysid = request.sysid;
-            s.compid = request.compid;
-            s.chan = request.chan;
         }
 
-        // if it's a rerequest and we still have the last response then send it
-        if ((request.sysid == reply.sysid) && (request.compid == reply.compid) &&
-            (request.session == reply.session) && (request.seq_number + 1 == reply.seq_number) &&
-            reply.data[0] != uint8_t(FTP_ERROR::NoSessionsAvailable)) {
-            session->push_reply(reply);
-            continue;
+        // only reuse the session if it is not active
+        auto &s = *session;
+        if (s.last_send_ms != 0 &&
+            now - s.last_send_ms < FTP_SESSION_TIMEOUT) {
+            // the oldest session is still active, reject the request
+            setup_reply(request, reply);
+            error(reply, FTP_ERROR::NoSessionsAvailable);
+            send_reply(reply);
+            return;
         }
+        // claim the session
+        s.close();   // error code ignored
+        s.session_id = request.session;
+        s.sysid = request.sysid;
+        s.compid = request.compid;
+        s.chan = request.chan;
+    }
 
-        setup_reply(request, reply);
+    // if it's a rerequest and we still have the last response then send it
+    if ((request.sysid == reply.sysid) && (request.compid == reply.compid) &&
+        (request.session == reply.session) && (request.seq_number + 1 == reply.seq_number) &&
+        reply.data[0] != uint8_t(FTP_ERROR::NoSessionsAvailable)) {
+        session->push_reply(reply);
+        return;
+    }
 
-        bool skip_push_reply = session->handle_request(request, reply);
+    setup_reply(request, reply);
 
-        if (!skip_push_reply) {
-            session->push_reply(reply);
-        }
+    bool skip_push_reply = session->handle_request(request, reply);
+
+    if (!skip_push_reply) {
+        session->push_reply(reply);
+    } else {
+        // there is no reply to send again
+        reply.session = -1;
     }
 }
 
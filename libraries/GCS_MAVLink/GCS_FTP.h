@@ -14,7 +14,28 @@
 #define AP_MAVLINK_FTP_MAX_SESSIONS 5
 #endif
 
+/*
+  size of the buffer a session reading a file uses to read it from
+  AP_Filesystem in large blocks rather than a packet at a time, and
+  how many sessions may have one at once. Sessions opening a file
+  when they are all in use read it a packet at a time
+ */
+#ifndef AP_MAVLINK_FTP_READ_BUFFER_SIZE
+#if HAL_MEM_CLASS >= HAL_MEM_CLASS_1000
+#define AP_MAVLINK_FTP_READ_BUFFER_SIZE 16384
+#elif HAL_MEM_CLASS >= HAL_MEM_CLASS_500
+#define AP_MAVLINK_FTP_READ_BUFFER_SIZE 4096
+#else
+#define AP_MAVLINK_FTP_READ_BUFFER_SIZE 0
+#endif
+#endif
+
+#ifndef AP_MAVLINK_FTP_READ_BUFFERS
+#define AP_MAVLINK_FTP_READ_BUFFERS 1
+#endif
+
 class GCS_FTP {
+    friend class GCS_FTP_Test;
 public:
     static void handle_file_transfer_protocol(const mavlink_message_t &msg, mavlink_channel_t chan);
     static uint32_t get_last_send_ms(mavlink_channel_t chan);
@@ -39,6 +60,24 @@ private:
         BurstReadFile = 15,
         Ack = 128,
         Nack = 129,
+        /*
+          ArduPilot extensions are numbered down from 255, clear of
+          opcodes the protocol adds after BurstReadFile and of Ack
+          and Nack
+
+          BurstReadFileWindow: burst read with a sliding window. The
+          request acknowledges everything before offset, and carries
+            data[0..3]  window: bytes after offset which may be sent
+            data[4]     bytes per packet, 0 for the most that fit
+            data[5...]  bitmap of the packets after offset which were
+                        lost and should be sent again, least
+                        significant bit first
+          Packets are sent until the window is full, so the GCS keeps
+          the transfer going by sending this request again as data
+          arrives. Firmware without the extension Nacks it, and the
+          GCS should then use BurstReadFile
+         */
+        BurstReadFileWindow = 255,
     };
 
     enum class FTP_ERROR : uint8_t {
@@ -80,6 +119,7 @@ private:
 
     // session specific info
     class Session {
+        friend class GCS_FTP_Test;
     public:
         int fd = -1;
         uint32_t last_send_ms;
@@ -95,12 +135,60 @@ private:
         void push_reply(Transaction &reply);
         bool handle_request(Transaction &request, Transaction &reply);
 
+        // read from the open file, returning the number of bytes read or -1
+        ssize_t read(uint32_t offset, uint8_t *buf, uint8_t count);
+
+        void start_burst(const Transaction &request, Transaction &reply);
+        bool send_burst(Transaction &reply);
+        bool burst_pending(uint32_t now) const;
+
+        // milliseconds until a burst is due to send its next packet,
+        // UINT32_MAX if it has nothing to send
+        uint32_t burst_wait_ms(uint32_t now) const;
+
         int close(void);
+
+    private:
+        /*
+          burst read in progress. The worker sends bursts a packet at a
+          time, taking turns with the other sessions and with new
+          requests
+         */
+        struct {
+            bool active;
+            bool windowed;
+            uint8_t max_read;
+            uint16_t seq_number;
+            uint32_t offset;        // offset of the next new packet
+            uint32_t end;           // no new packets are sent from here
+            uint32_t delay_ms;
+            // windowed bursts: lost packets after resend_base
+            uint32_t resend_base;
+            uint8_t resend[32];
+        } burst {};
+
+        // fill in the next packet of a burst read, returning the
+        // index in burst.resend of a packet being sent again, or -1
+        int16_t next_burst_packet(Transaction &reply);
+        // move the burst on once the packet has been sent
+        void burst_packet_sent(const Transaction &reply, int16_t resend_idx, uint32_t now);
+
+#if AP_MAVLINK_FTP_READ_BUFFER_SIZE > 0
+        bool fill_read_buf(uint32_t offset);
+
+        uint8_t *read_buf = nullptr;
+        uint32_t read_buf_ofs;      // file offset of read_buf[0]
+        uint16_t read_buf_len;
+
+        // read buffers allocated across all sessions
+        static uint8_t read_bufs_allocated;
+#endif
     };
     Session sessions[AP_MAVLINK_FTP_MAX_SESSIONS];
 
     bool init(void);
 
+    static bool have_reply_space(mavlink_channel_t chan);
     static bool send_reply(const Transaction &reply);
     static void error(Transaction &response, FTP_ERROR error);
 
@@ -111,6 +199,13 @@ private:
 
     void worker(void);
 
+    // close sessions which have not sent anything for a long time
+    void reap_sessions(uint32_t now);
+    void handle_request(Transaction &request, Transaction &reply);
+
+    // packet being sent by a burst read
+    Transaction burst_reply;
+
     // GCS_FTP instance created by static handle_file_transfer_protocol()
     static GCS_FTP *ftp;
 };
@@ -0,0 +1,342 @@
+#include <AP_gtest.h>
+
+/*
+  tests for MAVLink FTP burst reads: windowing and selective
+  retransmit of BurstReadFileWindow, the legacy BurstReadFile, pacing
+  of packets on links without flow control, the read buffers and
+  closing dead sessions. Packets are taken from the session as the
+  worker would send them when the link has space
+ */
+
+#include <GCS_MAVLink/GCS_FTP.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_HAL/utility/sparse-endian.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_MAVLINK_FTP_ENABLED
+
+#include <vector>
+
+GCS_Dummy _gcs;
+
+class GCS_FTP_Test
+{
+public:
+    // a packet of a burst as the GCS sees it
+    struct Packet {
+        bool ack;
+        uint8_t error;
+        uint32_t offset;
+        uint8_t size;
+        bool burst_complete;
+        uint16_t seq_number;
+    };
+
+    GCS_FTP_Test(uint32_t file_size) :
+        content(file_size),
+        ftp(NEW_NOTHROW GCS_FTP),
+        session(ftp->sessions[0]),
+        seq_number(0)
+    {
+        for (uint32_t i=0; i<file_size; i++) {
+            content[i] = uint8_t(i*7 + i/251);
+        }
+        const int fd = AP::FS().open(filename, O_WRONLY|O_CREAT|O_TRUNC);
+        EXPECT_NE(fd, -1);
+        EXPECT_EQ(AP::FS().write(fd, content.data(), file_size), ssize_t(file_size));
+        AP::FS().close(fd);
+
+        EXPECT_TRUE(open(0));
+    }
+
+    ~GCS_FTP_Test() {
+        for (auto &s : ftp->sessions) {
+            s.close();
+        }
+        AP::FS().unlink(filename);
+        delete ftp;
+    }
+
+    // open the file for reading on session i
+    bool open(uint8_t i) {
+        GCS_FTP::Transaction request {}, reply {};
+        request.opcode = GCS_FTP::FTP_OP::OpenFileRO;
+        request.size = strlen(filename);
+        memcpy(request.data, filename, request.size);
+        ftp->sessions[i].handle_request(request, reply);
+        return reply.opcode == GCS_FTP::FTP_OP::Ack;
+    }
+
+    bool is_open(uint8_t i) const { return ftp->sessions[i].fd != -1; }
+    void close(uint8_t i) { ftp->sessions[i].close(); }
+    void set_last_send_ms(uint8_t i, uint32_t ms) { ftp->sessions[i].last_send_ms = ms; }
+    void reap_sessions(uint32_t now_ms) { ftp->reap_sessions(now_ms); }
+
+    // request a BurstReadFile from offset, returning false if it was
+    // rejected
+    bool burst(uint32_t offset, uint8_t packet_size) {
+        GCS_FTP::Transaction request {}, reply {};
+        request.opcode = GCS_FTP::FTP_OP::BurstReadFile;
+        request.seq_number = seq_number++;
+        request.offset = offset;
+        request.size = packet_size;
+        session.handle_request(request, reply);
+        return reply.opcode != GCS_FTP::FTP_OP::Nack;
+    }
+
+    // request a BurstReadFileWindow acknowledging everything before
+    // offset, with the packets after it in lost to be sent again
+    bool burst_window(uint32_t offset, uint32_t window, uint8_t packet_size, std::initializer_list<uint8_t> lost = {}) {
+        GCS_FTP::Transaction request {}, reply {};
+        request.opcode = GCS_FTP::FTP_OP::BurstReadFileWindow;
+        request.seq_number = seq_number++;
+        request.offset = offset;
+        put_le32_ptr(request.data, window);
+        request.data[4] = packet_size;
+        request.size = 5;
+        for (const uint8_t i : lost) {
+            request.data[5 + i/8] |= 1U<<(i%8);
+            request.size = MAX(request.size, uint8_t(6 + i/8));
+        }
+        session.handle_request(request, reply);
+        return reply.opcode != GCS_FTP::FTP_OP::Nack;
+    }
+
+    // take the next packet of the burst at time now_ms, returning
+    // false if there is none due
+    bool send_burst(uint32_t now_ms, Packet &pkt) {
+        if (!session.burst_pending(now_ms)) {
+            return false;
+        }
+        GCS_FTP::Transaction reply;
+        const int16_t resend_idx = session.next_burst_packet(reply);
+        session.burst_packet_sent(reply, resend_idx, now_ms);
+
+        pkt.ack = (reply.opcode == GCS_FTP::FTP_OP::Ack);
+        pkt.error = pkt.ack ? 0 : reply.data[0];
+        pkt.offset = reply.offset;
+        pkt.size = pkt.ack ? reply.size : 0;
+        pkt.burst_complete = reply.burst_complete;
+        pkt.seq_number = reply.seq_number;
+        if (pkt.ack) {
+            EXPECT_LE(pkt.offset + pkt.size, content.size());
+            EXPECT_EQ(memcmp(reply.data, &content[pkt.offset], pkt.size), 0);
+        }
+        return true;
+    }
+
+    // offsets of the packets sent until the burst has nothing due
+    std::vector<uint32_t> send_all(uint32_t now_ms=0) {
+        std::vector<uint32_t> offsets;
+        Packet pkt;
+        while (send_burst(now_ms, pkt)) {
+            EXPECT_TRUE(pkt.ack);
+            offsets.push_back(pkt.offset);
+        }
+        return offsets;
+    }
+
+    uint32_t burst_wait_ms(uint32_t now_ms) const { return session.burst_wait_ms(now_ms); }
+    void set_burst_delay(uint32_t delay_ms) { session.burst.delay_ms = delay_ms; }
+
+    // read through the session, checking the data
+    void read(uint32_t offset, uint8_t count) {
+        uint8_t buf[239];
+        const ssize_t n = session.read(offset, buf, count);
+        EXPECT_EQ(n, ssize_t(MIN(uint32_t(count), content.size() - offset)));
+        EXPECT_EQ(memcmp(buf, &content[offset], n), 0);
+    }
+
+#if AP_MAVLINK_FTP_READ_BUFFER_SIZE > 0
+    uint32_t read_buf_ofs() const { return session.read_buf_ofs; }
+    uint16_t read_buf_len() const { return session.read_buf_len; }
+    bool has_read_buf(uint8_t i) const { return ftp->sessions[i].read_buf != nullptr; }
+#endif
+
+private:
+    static constexpr const char *filename = "test_gcs_ftp.bin";
+    std::vector<uint8_t> content;
+    GCS_FTP *ftp;
+    GCS_FTP::Session &session;
+    uint16_t seq_number;
+};
+
+static std::vector<uint32_t> offsets(uint32_t first, uint32_t count, uint32_t step)
+{
+    std::vector<uint32_t> ret;
+    for (uint32_t i=0; i<count; i++) {
+        ret.push_back(first + i*step);
+    }
+    return ret;
+}
+
+TEST(GCS_FTP, burst)
+{
+    // a legacy burst sends the rest of the file in one go
+    GCS_FTP_Test t(5000);
+    ASSERT_TRUE(t.burst(1000, 200));
+    GCS_FTP_Test::Packet pkt;
+    uint32_t offset = 1000;
+    uint16_t seq_number = 0;
+    while (offset < 5000) {
+        ASSERT_TRUE(t.send_burst(0, pkt));
+        EXPECT_TRUE(pkt.ack);
+        EXPECT_EQ(pkt.offset, offset);
+        EXPECT_EQ(pkt.size, 200);
+        if (offset > 1000) {
+            EXPECT_EQ(pkt.seq_number, seq_number + 1);
+        }
+        seq_number = pkt.seq_number;
+        offset += pkt.size;
+    }
+
+    // then ends with end of file
+    ASSERT_TRUE(t.send_burst(0, pkt));
+    EXPECT_FALSE(pkt.ack);
+    EXPECT_EQ(pkt.error, 6);
+    EXPECT_FALSE(t.send_burst(0, pkt));
+}
+
+TEST(GCS_FTP, window)
+{
+    GCS_FTP_Test t(10000);
+
+    // only the window is sent, then the burst waits for the GCS
+    ASSERT_TRUE(t.burst_window(0, 2000, 200));
+    EXPECT_EQ(t.send_all(), offsets(0, 10, 200));
+    EXPECT_EQ(t.burst_wait_ms(0), UINT32_MAX);
+
+    // acknowledging part of the window carries on from the last
+    // packet sent rather than starting again
+    ASSERT_TRUE(t.burst_window(1000, 2000, 200));
+    EXPECT_EQ(t.send_all(), offsets(2000, 5, 200));
+
+    // acknowledging everything moves the window on
+    ASSERT_TRUE(t.burst_window(3000, 400, 200));
+    EXPECT_EQ(t.send_all(), offsets(3000, 2, 200));
+
+    // the end of the file is sent short and flagged complete
+    ASSERT_TRUE(t.burst_window(9900, 2000, 200));
+    GCS_FTP_Test::Packet pkt;
+    ASSERT_TRUE(t.send_burst(0, pkt));
+    EXPECT_TRUE(pkt.ack);
+    EXPECT_EQ(pkt.offset, 9900U);
+    EXPECT_EQ(pkt.size, 100);
+    EXPECT_TRUE(pkt.burst_complete);
+}
+
+TEST(GCS_FTP, retransmit)
+{
+    GCS_FTP_Test t(10000);
+    ASSERT_TRUE(t.burst_window(0, 2000, 200));
+    EXPECT_EQ(t.send_all(), offsets(0, 10, 200));
+
+    // the GCS got packets 0, 1, 3, 4, 6-9 and lost 2 and 5. Lost
+    // packets go first, then new ones up to the end of the window.
+    // Packets which have not been sent yet can't have been lost
+    ASSERT_TRUE(t.burst_window(400, 2000, 200, { 0, 3, 20 }));
+    EXPECT_EQ(t.send_all(), std::vector<uint32_t>({ 400, 1000, 2000, 2200 }));
+
+    // a different packet size starts the burst again from the offset
+    ASSERT_TRUE(t.burst_window(2400, 500, 100));
+    EXPECT_EQ(t.send_all(), offsets(2400, 5, 100));
+}
+
+TEST(GCS_FTP, pacing)
+{
+    // on links without flow control packets are spaced out, and the
+    // worker sleeps until the next is due
+    GCS_FTP_Test t(10000);
+    ASSERT_TRUE(t.burst_window(0, 2000, 200));
+    t.set_burst_delay(20);
+    GCS_FTP_Test::Packet pkt;
+    ASSERT_TRUE(t.send_burst(1000, pkt));
+    EXPECT_FALSE(t.send_burst(1005, pkt));
+    EXPECT_EQ(t.burst_wait_ms(1005), 15U);
+    EXPECT_EQ(t.burst_wait_ms(1019), 1U);
+    EXPECT_EQ(t.burst_wait_ms(1020), 0U);
+    ASSERT_TRUE(t.send_burst(1020, pkt));
+    EXPECT_EQ(pkt.offset, 200U);
+}
+
+#if AP_MAVLINK_FTP_READ_BUFFER_SIZE > 0
+TEST(GCS_FTP, read_buffer)
+{
+    const uint32_t size = AP_MAVLINK_FTP_READ_BUFFER_SIZE;
+    GCS_FTP_Test t(3*size + 100);
+
+    // the file is read a buffer at a time
+    t.read(0, 200);
+    EXPECT_EQ(t.read_buf_ofs(), 0U);
+    EXPECT_EQ(t.read_buf_len(), size);
+    t.read(size - 200, 200);
+    EXPECT_EQ(t.read_buf_ofs(), 0U);
+
+    // reading on keeps a quarter of the buffer behind for packets
+    // to be sent again
+    const uint32_t ofs = size - 100;
+    t.read(ofs, 200);
+    EXPECT_EQ(t.read_buf_ofs(), ofs - size/4);
+    EXPECT_EQ(t.read_buf_len(), size);
+    t.read(ofs - size/4, 200);
+    EXPECT_EQ(t.read_buf_ofs(), ofs - size/4);
+
+    // reading from elsewhere starts the buffer again
+    t.read(2*size + 50, 200);
+    EXPECT_EQ(t.read_buf_ofs(), 2*size + 50);
+    EXPECT_EQ(t.read_buf_len(), size);
+
+    // the end of the file fills part of the buffer
+    t.read(3*size, 200);
+    EXPECT_EQ(t.read_buf_ofs(), 3*size - size/4);
+    EXPECT_EQ(t.read_buf_len(), size/4 + 100);
+
+    t.read(100, 200);
+    EXPECT_EQ(t.read_buf_ofs(), 100U);
+    EXPECT_EQ(t.read_buf_len(), size);
+}
+
+TEST(GCS_FTP, read_buffers_shared)
+{
+    // only AP_MAVLINK_FTP_READ_BUFFERS sessions get a buffer, the
+    // others read a packet at a time
+    GCS_FTP_Test t(1000);
+    EXPECT_TRUE(t.has_read_buf(0));
+    for (uint8_t i=1; i<AP_MAVLINK_FTP_MAX_SESSIONS; i++) {
+        ASSERT_TRUE(t.open(i));
+        EXPECT_EQ(t.has_read_buf(i), i < AP_MAVLINK_FTP_READ_BUFFERS);
+    }
+    t.read(100, 200);
+
+    // closing a session frees its buffer for the next
+    t.close(0);
+    t.close(AP_MAVLINK_FTP_MAX_SESSIONS-1);
+    ASSERT_TRUE(t.open(AP_MAVLINK_FTP_MAX_SESSIONS-1));
+    EXPECT_TRUE(t.has_read_buf(AP_MAVLINK_FTP_MAX_SESSIONS-1));
+}
+#endif  // AP_MAVLINK_FTP_READ_BUFFER_SIZE > 0
+
+TEST(GCS_FTP, reap_sessions)
+{
+    // a session whose burst has stalled, waiting for a GCS which has
+    // gone, is closed without waiting for other sessions to go idle
+    GCS_FTP_Test t(10000);
+    ASSERT_TRUE(t.open(1));
+    ASSERT_TRUE(t.burst_window(0, 2000, 200));
+    EXPECT_EQ(t.send_all(1000), offsets(0, 10, 200));
+    t.set_last_send_ms(1, 15000);
+
+    t.reap_sessions(20000);
+    EXPECT_TRUE(t.is_open(0));
+    EXPECT_TRUE(t.is_open(1));
+
+    t.reap_sessions(21001);
+    EXPECT_FALSE(t.is_open(0));
+    EXPECT_TRUE(t.is_open(1));
+}
+
+#endif  // AP_MAVLINK_FTP_ENABLED
+
+AP_GTEST_MAIN()
@@ -141,9 +141,51 @@ void ADSB::update_simulated_vehicles(const class Aircraft &aircraft)
     }
 }
 
+#if AP_SIM_SWARM_ENABLED
+/*
+  report the other vehicles in the swarm world as UAVs
+*/
+void ADSB::update_swarm_vehicles(const class Aircraft &aircraft)
+{
+    num_swarm_vehicles = 0;
+    const Swarm *swarm = aircraft.get_swarm();
+    if (swarm == nullptr || !swarm->enabled()) {
+        return;
+    }
+
+    const Location &origin { aircraft.get_origin() };
+    const uint64_t now_us = AP_HAL::micros64();
+
+    for (uint8_t i=0; i<swarm->num_vehicles(); i++) {
+        if (num_vehicles + num_swarm_vehicles >= num_vehicles_MAX) {
+            break;
+        }
+        Swarm::Vehicle v;
+        if (i == swarm->get_instance() || !swarm->get_vehicle(i, now_us, v)) {
+            continue;
+        }
+        ADSB_Vehicle &vehicle = vehicles[num_vehicles + num_swarm_vehicles++];
+        vehicle.initialised = true;
+        vehicle.stationary_object_created_ms = 0;
+        vehicle.type = ADSB_EMITTER_TYPE_UAV;
+        // fixed addresses so a vehicle keeps its identity across runs
+        vehicle.ICAO_address = 0x5A0000 + i;
+        snprintf(vehicle.callsign, sizeof(vehicle.callsign), "SWARM%u", unsigned(v.sysid));
+        vehicle.location = v.location;
+        const Vector2f ofs_ne = origin.get_distance_NE(v.location);
+        // reports give altitude as -position.z
+        vehicle.position = Vector3p{ofs_ne.x, ofs_ne.y, -v.location.alt * 0.01};
+        vehicle.velocity_ef = v.velocity_ef.toftype();
+    }
+}
+#endif  // AP_SIM_SWARM_ENABLED
+
 void ADSB::update(const class Aircraft &aircraft)
 {
     update_simulated_vehicles(aircraft);
+#if AP_SIM_SWARM_ENABLED
+    update_swarm_vehicles(aircraft);
+#endif
 
     // see if we should do a report.
     if ((_sitl->adsb_types & (1U << (uint8_t)SIM::ADSBType::Shortcut)) == 0) {
@@ -227,7 +269,7 @@ void ADSB::send_report(const class Aircraft &aircraft)
      */
     uint32_t now_us = AP_HAL::micros();
     if (now_us - last_report_us >= reporting_period_ms*1000UL) {
-        for (uint8_t i=0; i<num_vehicles; i++) {
+        for (uint8_t i=0; i<num_reported_vehicles(); i++) {
             const ADSB_Vehicle &vehicle = vehicles[i];
             if (!vehicle.initialised) {
                 continue;
@@ -65,8 +65,17 @@ public:
     static const uint8_t num_vehicles_MAX = 200;
     ADSB_Vehicle vehicles[num_vehicles_MAX];
 
+    // vehicles from the swarm world, which follow the simulated ones
+    uint8_t num_swarm_vehicles;
+
+    // number of vehicles to report, simulated and from the swarm
+    uint8_t num_reported_vehicles() const { return num_vehicles + num_swarm_vehicles; }
+
 private:
     void update_simulated_vehicles(const class Aircraft &aircraft);
+#if AP_SIM_SWARM_ENABLED
+    void update_swarm_vehicles(const class Aircraft &aircraft);
+#endif
 
     // reporting period in ms
     const float reporting_period_ms = 1000;
@@ -276,7 +276,7 @@ void ADSB_Sagetech_MXS::update_serial_output_vehicles(const SITL::Aircraft *sitl
     if (sitl_model->adsb == nullptr) {
         return;
     }
-    for (uint8_t i=0; i<sitl_model->adsb->num_vehicles; i++) {
+    for (uint8_t i=0; i<sitl_model->adsb->num_reported_vehicles(); i++) {
         const ADSB_Vehicle &vehicle = sitl_model->adsb->vehicles[i];
         if (!vehicle.initialised) {
             continue;
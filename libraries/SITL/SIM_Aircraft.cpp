@@ -254,11 +254,39 @@ void Aircraft::time_advance()
         time_now_us += frame_time_us;
     }
     last_time_us = time_now_us;
+#if AP_SIM_LOCKSTEP_ENABLED
+    if (lockstep != nullptr && lockstep->enabled()) {
+        // only the master paces against wall clock time, everyone
+        // else is paced by the master through the shared clock
+        if (use_time_sync && lockstep->is_master()) {
+            sync_frame_time();
+        }
+#if AP_SIM_SWARM_ENABLED
+        if (swarm != nullptr) {
+            // peers may read our state as soon as we reach the new
+            // time, so it must be published first
+            publish_to_swarm();
+        }
+#endif
+        lockstep->advance(time_now_us);
+        return;
+    }
+#endif
     if (use_time_sync) {
         sync_frame_time();
     }
 }
 
+#if AP_SIM_SWARM_ENABLED
+void Aircraft::publish_to_swarm(void)
+{
+    float r, p, y;
+    dcm.to_euler(&r, &p, &y);
+    swarm->publish(time_now_us, mavlink_system.sysid, location,
+                   location.alt - home.alt, velocity_ef, wrap_360(degrees(y)));
+}
+#endif
+
 /* setup the frame step time */
 void Aircraft::setup_frame_time(float new_rate, float new_speedup)
 {
@@ -281,6 +309,7 @@ void Aircraft::adjust_frame_time(float new_rate)
    into account desired speedup
    This tries to take account of possible granularity of
    get_wall_time_us() so it works reasonably well on windows
+   A speedup of zero runs the simulation as fast as the CPU allows
 */
 void Aircraft::sync_frame_time(void)
 {
@@ -288,6 +317,14 @@ void Aircraft::sync_frame_time(void)
     uint64_t now = get_wall_time_us();
     uint64_t dt_us = now - last_wall_time_us;
 
+    if (!is_positive(target_speedup)) {
+        // never sleep, and don't carry a debt into a later speedup
+        sleep_debt_us = 0;
+        last_wall_time_us = now;
+        update_rate_stats();
+        return;
+    }
+
     const float target_dt_us = 1.0e6/(rate_hz*target_speedup);
 
     // accumulate sleep debt if we're running too fast
@@ -310,6 +347,17 @@ void Aircraft::sync_frame_time(void)
     }
     last_wall_time_us = get_wall_time_us();
 
+    update_rate_stats();
+}
+
+/*
+  update the achieved frame rate, and the simulated time we get for
+  each second of CPU time used by this process. The latter is what
+  limits how fast we can run with no sleeps, so it is reported on the
+  console when running as fast as possible
+*/
+void Aircraft::update_rate_stats(void)
+{
     uint32_t now_ms = last_wall_time_us / 1000ULL;
     float dt_wall = (now_ms - last_fps_report_ms) * 0.001;
     if (dt_wall > 0.01) {  // 0.01s average
@@ -322,6 +370,22 @@ void Aircraft::sync_frame_time(void)
         last_frame_count = frame_counter;
         last_fps_report_ms = now_ms;
     }
+
+    if (now_ms - cpu_stats.last_ms < 1000) {
+        return;
+    }
+    const uint64_t cpu_us = get_cpu_time_us();
+    if (cpu_stats.last_ms != 0 && cpu_us > cpu_stats.last_cpu_us) {
+        sim_per_cpu = float(time_now_us - cpu_stats.last_sim_us) / float(cpu_us - cpu_stats.last_cpu_us);
+        if (!is_positive(target_speedup) && now_ms - cpu_stats.last_print_ms >= 10000) {
+            ::printf("Sim: speedup %.1f, %.1f sim s per CPU s\n",
+                     achieved_rate_hz/rate_hz, sim_per_cpu);
+            cpu_stats.last_print_ms = now_ms;
+        }
+    }
+    cpu_stats.last_ms = now_ms;
+    cpu_stats.last_cpu_us = cpu_us;
+    cpu_stats.last_sim_us = time_now_us;
 }
 
 /* add noise based on throttle level (from 0..1) */
@@ -472,7 +536,7 @@ void Aircraft::fill_fdm(struct sitl_fdm &fdm)
         sitl->speedup.set(get_speedup());
     }
     
-    if (!is_equal(last_speedup, float(sitl->speedup)) && sitl->speedup > 0) {
+    if (!is_equal(last_speedup, float(sitl->speedup)) && sitl->speedup >= 0) {
         set_speedup(sitl->speedup);
         last_speedup = sitl->speedup;
     }
@@ -509,18 +573,20 @@ void Aircraft::fill_fdm(struct sitl_fdm &fdm)
 // @Field: As: Airspeed
 // @Field: ASpdU: Achieved simulation speedup value
 // @Field: UFC: Number of times simulation paused for serial0 output
+// @Field: SpCPU: Simulated time per CPU time used
         Vector3d pos = get_position_relhome();
         Vector3f vel = get_velocity_ef();
         AP::logger().WriteStreaming(
             "SIM2",
-            "TimeUS,PN,PE,PD,VN,VE,VD,As,ASpdU,UFC",
-            "QdddfffffI",
+            "TimeUS,PN,PE,PD,VN,VE,VD,As,ASpdU,UFC,SpCPU",
+            "QdddfffffIf",
             AP_HAL::micros64(),
             pos.x, pos.y, pos.z,
             vel.x, vel.y, vel.z,
             airspeed_pitot,
             achieved_rate_hz/rate_hz,
-            full_count
+            full_count,
+            sim_per_cpu
         );
     }
 #endif
@@ -669,6 +735,21 @@ uint64_t Aircraft::get_wall_time_us() const
 #endif
 }
 
+/*
+  return the CPU time used by this process in microseconds, or the
+  wall clock time where that is not available
+ */
+uint64_t Aircraft::get_cpu_time_us() const
+{
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !defined(__CYGWIN__) && !defined(__CYGWIN64__)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0) {
+        return uint64_t(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000ULL);
+    }
+#endif
+    return get_wall_time_us();
+}
+
 /*
   set simulation speedup
  */
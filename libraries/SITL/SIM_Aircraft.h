@@ -38,6 +38,8 @@
 #include "SIM_Battery.h"
 #include <Filter/Filter.h>
 #include "SIM_JSON_Master.h"
+#include "SIM_Lockstep.h"
+#include "SIM_Swarm.h"
 #include "ServoModel.h"
 #include "SIM_GPIO_LED_1.h"
 #include "SIM_GPIO_LED_2.h"
@@ -74,6 +76,25 @@ public:
         }
     }
 
+#if AP_SIM_LOCKSTEP_ENABLED
+    /*
+      step time in lock-step with other SITL instances
+     */
+    void set_lockstep(Lockstep *_lockstep) {
+        lockstep = _lockstep;
+    }
+#endif
+
+#if AP_SIM_SWARM_ENABLED
+    /*
+      share our state with the other vehicles in the world
+     */
+    void set_swarm(Swarm *_swarm) {
+        swarm = _swarm;
+    }
+    const Swarm *get_swarm() const { return swarm; }
+#endif
+
     /*
       set directory for additional files such as aircraft models
      */
@@ -270,12 +291,19 @@ protected:
     uint64_t last_wall_time_us;
     uint32_t last_fps_report_ms;
     float achieved_rate_hz;  // achieved speedup rate
+    float sim_per_cpu;       // simulated seconds per CPU second
     int64_t sleep_debt_us;
     uint32_t last_frame_count;
     uint8_t instance;
     const char *autotest_dir;
     const char *frame;
     bool use_time_sync = true;
+#if AP_SIM_LOCKSTEP_ENABLED
+    Lockstep *lockstep;
+#endif
+#if AP_SIM_SWARM_ENABLED
+    Swarm *swarm;
+#endif
     float last_speedup = -1.0f;
     const char *config_ = "";
     float eas2tas = 1.0;
@@ -314,6 +342,11 @@ protected:
     /* advance time by deltat in seconds */
     void time_advance();
 
+#if AP_SIM_SWARM_ENABLED
+    /* publish our state at the new time to the shared world */
+    void publish_to_swarm(void);
+#endif
+
     /* setup the frame step time */
     void setup_frame_time(float rate, float speedup);
 
@@ -323,6 +356,7 @@ protected:
     /* try to synchronise simulation time with wall clock time, taking
        into account desired speedup */
     void sync_frame_time(void);
+    void update_rate_stats(void);
 
     /* add noise based on throttle level (from 0..1) */
     void add_noise(float throttle);
@@ -330,6 +364,9 @@ protected:
     /* return a monotonic wall clock time in microseconds */
     uint64_t get_wall_time_us(void) const;
 
+    /* return the CPU time used by this process in microseconds */
+    uint64_t get_cpu_time_us(void) const;
+
     // update attitude and relative position
     void update_dynamics(const Vector3f &rot_accel);
 
@@ -372,6 +409,13 @@ private:
     uint64_t last_time_us;
     uint32_t frame_counter;
     uint32_t last_ground_contact_ms;
+
+    struct {
+        uint32_t last_ms;
+        uint32_t last_print_ms;
+        uint64_t last_cpu_us;
+        uint64_t last_sim_us;
+    } cpu_stats;
 #if defined(__CYGWIN__) || defined(__CYGWIN64__)
     const uint32_t min_sleep_time{20000};
 #else
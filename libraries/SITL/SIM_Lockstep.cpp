@@ -0,0 +1,236 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  lock-step simulation clock shared between many SITL instances
+*/
+
+#include "SIM_Lockstep.h"
+
+#if AP_SIM_LOCKSTEP_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace SITL;
+
+static uint64_t wall_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000ULL);
+}
+
+bool Lockstep::init(const char *name, uint8_t num_instances, uint8_t instance)
+{
+    if (num_instances == 0 || instance >= num_instances) {
+        ::fprintf(stderr, "Lockstep: instance %u outside 0..%u\n",
+                  unsigned(instance), unsigned(num_instances));
+        return false;
+    }
+    snprintf(shm_name, sizeof(shm_name), "/ap-lockstep-%s", name);
+
+    const int fd = shm_open(shm_name, O_RDWR | O_CREAT, 0600);
+    if (fd == -1) {
+        ::fprintf(stderr, "Lockstep: shm_open(%s) failed: %s\n", shm_name, strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, sizeof(shared_state)) != 0) {
+        ::fprintf(stderr, "Lockstep: ftruncate failed: %s\n", strerror(errno));
+        close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, sizeof(shared_state), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        ::fprintf(stderr, "Lockstep: mmap failed: %s\n", strerror(errno));
+        return false;
+    }
+    shm = (shared_state *)p;
+
+    _instance = instance;
+    _num_instances = num_instances;
+
+    /*
+      the master (re)initialises the segment so a stale segment from a
+      previous run does not hold the new run back. A master restarting
+      (e.g. on reboot) while its peers are still running must keep
+      their slots, it starts again from time zero and the peers wait
+      for it to catch up. Other instances wait for a live master to
+      appear before joining.
+     */
+    if (instance == 0) {
+        if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != MAGIC ||
+            shm->num_instances != num_instances ||
+            !peers_active()) {
+            memset(shm, 0, sizeof(*shm));
+            shm->num_instances = num_instances;
+            __atomic_store_n(&shm->magic, MAGIC, __ATOMIC_RELEASE);
+        }
+    } else {
+        slot &master = shm->slots[0];
+        while (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != MAGIC ||
+               __atomic_load_n(&master.state, __ATOMIC_ACQUIRE) != SLOT_ACTIVE ||
+               kill(__atomic_load_n(&master.pid, __ATOMIC_RELAXED), 0) != 0) {
+            usleep(1000);
+        }
+        if (shm->num_instances != num_instances) {
+            ::fprintf(stderr, "Lockstep: master expects %u instances, not %u\n",
+                      unsigned(shm->num_instances), unsigned(num_instances));
+            munmap(shm, sizeof(*shm));
+            shm = nullptr;
+            return false;
+        }
+    }
+
+    publish(0);
+
+    ::printf("Lockstep: instance %u of %u on %s\n",
+             unsigned(_instance), unsigned(_num_instances), shm_name);
+    return true;
+}
+
+void Lockstep::publish(uint64_t time_us)
+{
+    slot &s = shm->slots[_instance];
+    __atomic_store_n(&s.time_us, time_us, __ATOMIC_RELAXED);
+    __atomic_store_n(&s.pid, int32_t(getpid()), __ATOMIC_RELAXED);
+    __atomic_store_n(&s.state, uint8_t(SLOT_ACTIVE), __ATOMIC_RELEASE);
+}
+
+bool Lockstep::peers_active(void)
+{
+    for (uint8_t i=0; i<_num_instances; i++) {
+        if (i != _instance &&
+            __atomic_load_n(&shm->slots[i].state, __ATOMIC_ACQUIRE) == SLOT_ACTIVE &&
+            !peer_departed(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  a peer which has crashed, or exited without detaching, must not
+  stall the whole farm
+ */
+bool Lockstep::peer_departed(uint8_t i)
+{
+    slot &s = shm->slots[i];
+    if (__atomic_load_n(&s.state, __ATOMIC_ACQUIRE) == SLOT_DEPARTED) {
+        return true;
+    }
+    const int32_t pid = __atomic_load_n(&s.pid, __ATOMIC_RELAXED);
+    if (pid != 0 && kill(pid, 0) != 0 && errno == ESRCH) {
+        __atomic_store_n(&s.state, uint8_t(SLOT_DEPARTED), __ATOMIC_RELEASE);
+        return true;
+    }
+    return false;
+}
+
+void Lockstep::advance(uint64_t time_us)
+{
+    if (shm == nullptr) {
+        return;
+    }
+    slot &self = shm->slots[_instance];
+    if (__atomic_load_n(&self.state, __ATOMIC_ACQUIRE) != SLOT_ACTIVE) {
+        // our slot has been cleared by a master which did not know
+        // we were running, so join again
+        publish(time_us);
+    } else {
+        __atomic_store_n(&self.time_us, time_us, __ATOMIC_RELEASE);
+    }
+
+    for (uint8_t i=0; i<_num_instances; i++) {
+        if (i == _instance) {
+            continue;
+        }
+        slot &s = shm->slots[i];
+        while (true) {
+            const uint8_t state = __atomic_load_n(&s.state, __ATOMIC_ACQUIRE);
+            if (state == SLOT_DEPARTED) {
+                break;
+            }
+            if (state == SLOT_ACTIVE &&
+                __atomic_load_n(&s.time_us, __ATOMIC_ACQUIRE) >= time_us) {
+                break;
+            }
+            // checking for a dead process is a syscall, so only do
+            // it occasionally
+            if ((++spin_count & 0x3FF) == 0 && peer_departed(i)) {
+                break;
+            }
+            // yield rather than sleep: a sleep is far longer than a
+            // typical frame and would dominate the step time
+            sched_yield();
+        }
+    }
+
+    update_stats(time_us);
+}
+
+void Lockstep::update_stats(uint64_t time_us)
+{
+    const uint64_t now_us = wall_time_us();
+    if (stats_start_wall_us == 0) {
+        stats_start_wall_us = now_us;
+        stats_start_sim_us = time_us;
+        return;
+    }
+    const uint64_t dt_wall_us = now_us - stats_start_wall_us;
+    if (dt_wall_us < 10000000ULL) {
+        return;
+    }
+    uint8_t active = 0;
+    for (uint8_t i=0; i<_num_instances; i++) {
+        if (__atomic_load_n(&shm->slots[i].state, __ATOMIC_ACQUIRE) == SLOT_ACTIVE) {
+            active++;
+        }
+    }
+    // all instances advance in lock-step, so the aggregate rate is
+    // our own rate times the number of live participants
+    aggregate_rate = active * float(time_us - stats_start_sim_us) / float(dt_wall_us);
+    if (is_master()) {
+        ::printf("Lockstep: %u instances, %.1f simulated s per wall s\n",
+                 unsigned(active), aggregate_rate);
+    }
+    stats_start_wall_us = now_us;
+    stats_start_sim_us = time_us;
+}
+
+void Lockstep::detach(void)
+{
+    if (shm == nullptr) {
+        return;
+    }
+    __atomic_store_n(&shm->slots[_instance].state, uint8_t(SLOT_DEPARTED), __ATOMIC_RELEASE);
+    if (!peers_active()) {
+        // the last instance out removes the segment
+        shm_unlink(shm_name);
+    }
+    munmap(shm, sizeof(*shm));
+    shm = nullptr;
+}
+
+#endif  // AP_SIM_LOCKSTEP_ENABLED
@@ -0,0 +1,120 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  lock-step simulation clock shared between many SITL instances
+
+  Each participating instance publishes its simulation time into a
+  POSIX shared memory segment. An instance may only advance to a new
+  frame once every other live participant has reached the frame it is
+  leaving, so all vehicles share one deterministic time base
+  regardless of OS scheduling. Instance 0 is the master: it is the
+  only participant which paces against the wall clock (honouring
+  SIM_SPEEDUP), all other instances run as fast as the master allows.
+
+  A master which restarts, for example on reboot, rejoins with the
+  peers still running and they wait for it to catch up. The last
+  instance to leave removes the segment.
+
+  Usage: start each instance with --lockstep NUM[:NAME] where NUM is
+  the total number of instances taking part.
+*/
+
+#pragma once
+
+#include "SIM_config.h"
+
+#if AP_SIM_LOCKSTEP_ENABLED
+
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace SITL {
+
+class Lockstep {
+    friend class LockstepTest;
+public:
+    static constexpr uint8_t MAX_INSTANCES = 255;
+
+    // attach to (creating if required) the shared clock segment
+    bool init(const char *name, uint8_t num_instances, uint8_t instance);
+
+    bool enabled() const { return shm != nullptr; }
+
+    // the master instance is the only one that paces against wall time
+    bool is_master() const { return _instance == 0; }
+
+    /*
+      publish that this instance has finished the frame ending at
+      time_us and block until it is allowed to start the next frame,
+      which is when all other live instances have reached time_us
+     */
+    void advance(uint64_t time_us);
+
+    // mark this instance as departed so peers stop waiting for it
+    void detach(void);
+
+    // simulated seconds per wall clock second across all instances
+    float get_aggregate_rate() const { return aggregate_rate; }
+
+private:
+    // all slot fields are accessed with __atomic builtins as they
+    // are shared between processes
+    struct slot {
+        uint64_t time_us;
+        int32_t pid;
+        uint8_t state;
+    };
+
+    enum SlotState : uint8_t {
+        SLOT_EMPTY = 0,
+        SLOT_ACTIVE = 1,
+        SLOT_DEPARTED = 2,
+    };
+
+    struct shared_state {
+        uint32_t magic;
+        uint8_t num_instances;
+        slot slots[MAX_INSTANCES];
+    };
+
+    static constexpr uint32_t MAGIC = 0x4c4f434b; // "LOCK"
+
+    // true if the peer in slot i has died or left the simulation
+    bool peer_departed(uint8_t i);
+
+    // true if any instance other than us is still taking part
+    bool peers_active(void);
+
+    // publish our pid and time, and that we are taking part
+    void publish(uint64_t time_us);
+
+    void update_stats(uint64_t time_us);
+
+    shared_state *shm;
+    char shm_name[64];
+    uint8_t _instance;
+    uint8_t _num_instances;
+
+    // how often to check for dead peers while waiting
+    uint32_t spin_count;
+
+    uint64_t stats_start_wall_us;
+    uint64_t stats_start_sim_us;
+    float aggregate_rate;
+};
+
+}  // namespace SITL
+
+#endif  // AP_SIM_LOCKSTEP_ENABLED
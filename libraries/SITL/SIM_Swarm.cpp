@@ -0,0 +1,264 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  shared world for SITL instances running in lock-step
+*/
+
+#include "SIM_Swarm.h"
+
+#if AP_SIM_SWARM_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "SIM_Aircraft.h"
+
+using namespace SITL;
+
+bool Swarm::init(const char *name, uint8_t num_vehicles, uint8_t instance)
+{
+    if (num_vehicles == 0 || instance >= num_vehicles) {
+        ::fprintf(stderr, "Swarm: instance %u outside 0..%u\n",
+                  unsigned(instance), unsigned(num_vehicles));
+        return false;
+    }
+    char shm_name[64];
+    snprintf(shm_name, sizeof(shm_name), "/ap-swarm-%s", name);
+
+    const int fd = shm_open(shm_name, O_RDWR | O_CREAT, 0600);
+    if (fd == -1) {
+        ::fprintf(stderr, "Swarm: shm_open(%s) failed: %s\n", shm_name, strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, sizeof(shared_world)) != 0) {
+        ::fprintf(stderr, "Swarm: ftruncate failed: %s\n", strerror(errno));
+        close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, sizeof(shared_world), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        ::fprintf(stderr, "Swarm: mmap failed: %s\n", strerror(errno));
+        return false;
+    }
+    shm = (shared_world *)p;
+
+    _instance = instance;
+    _num_vehicles = num_vehicles;
+
+    /*
+      each vehicle only ever writes its own slot, so there is no need
+      for a master to initialise the segment. Anything left in our
+      slot from a previous run is cleared before we become active
+     */
+    slot &s = shm->slots[_instance];
+    __atomic_store_n(&s.state, uint8_t(SLOT_EMPTY), __ATOMIC_RELEASE);
+    memset(s.states, 0, sizeof(s.states));
+    __atomic_store_n(&s.count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s.pid, int32_t(getpid()), __ATOMIC_RELAXED);
+    __atomic_store_n(&s.state, uint8_t(SLOT_ACTIVE), __ATOMIC_RELEASE);
+
+    ::printf("Swarm: vehicle %u of %u on %s\n",
+             unsigned(_instance), unsigned(_num_vehicles), shm_name);
+    return true;
+}
+
+void Swarm::publish(uint64_t time_us, uint8_t sysid, const Location &loc,
+                    int32_t relative_alt_cm, const Vector3f &velocity_ef, float yaw_deg)
+{
+    if (shm == nullptr) {
+        return;
+    }
+    slot &s = shm->slots[_instance];
+    const uint32_t count = s.count;
+    vehicle_state &v = s.states[count % NUM_STATES];
+
+    __atomic_store_n(&v.seq, v.seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    v.time_us = time_us;
+    v.lat = loc.lat;
+    v.lng = loc.lng;
+    v.alt_cm = loc.alt;
+    v.relative_alt_cm = relative_alt_cm;
+    v.velocity_ef[0] = velocity_ef.x;
+    v.velocity_ef[1] = velocity_ef.y;
+    v.velocity_ef[2] = velocity_ef.z;
+    v.yaw_deg = yaw_deg;
+    __atomic_store_n(&v.seq, v.seq + 1, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&s.sysid, sysid, __ATOMIC_RELAXED);
+    __atomic_store_n(&s.count, count + 1, __ATOMIC_RELEASE);
+}
+
+bool Swarm::get_vehicle(uint8_t instance, uint64_t time_us, Vehicle &vehicle) const
+{
+    if (shm == nullptr || instance >= _num_vehicles) {
+        return false;
+    }
+    const slot &s = shm->slots[instance];
+    if (__atomic_load_n(&s.state, __ATOMIC_ACQUIRE) != SLOT_ACTIVE) {
+        return false;
+    }
+
+    /*
+      choose the latest state at or before our time. Peers run in
+      lock-step, so which state that is does not depend on how the
+      processes happen to be scheduled
+     */
+    vehicle_state best {};
+    for (uint8_t i=0; i<NUM_STATES; i++) {
+        vehicle_state copy;
+        if (!read_state(s, s.states[i], copy)) {
+            continue;
+        }
+        if (copy.seq != 0 && copy.time_us <= time_us && copy.time_us > best.time_us) {
+            best = copy;
+        }
+    }
+    if (best.time_us == 0 || time_us - best.time_us > STALE_US) {
+        return false;
+    }
+
+    vehicle.time_us = best.time_us;
+    vehicle.sysid = __atomic_load_n(&s.sysid, __ATOMIC_RELAXED);
+    vehicle.location = Location{best.lat, best.lng, best.alt_cm, Location::AltFrame::ABSOLUTE};
+    vehicle.relative_alt_cm = best.relative_alt_cm;
+    vehicle.velocity_ef = Vector3f{best.velocity_ef[0], best.velocity_ef[1], best.velocity_ef[2]};
+    vehicle.yaw_deg = best.yaw_deg;
+    return true;
+}
+
+bool Swarm::read_state(const slot &s, const vehicle_state &v, vehicle_state &copy)
+{
+    uint64_t start_us = 0;
+    while (true) {
+        const uint32_t seq = __atomic_load_n(&v.seq, __ATOMIC_ACQUIRE);
+        memcpy(&copy, &v, sizeof(copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if ((seq & 1U) == 0 && seq == __atomic_load_n(&v.seq, __ATOMIC_RELAXED)) {
+            copy.seq = seq;
+            return true;
+        }
+
+        // the peer is part way through writing the state. This is
+        // host time, as the lock-step clock may be waiting for the peer
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        const uint64_t now_us = uint64_t(ts.tv_sec) * 1000000ULL + ts.tv_nsec / 1000U;
+        if (start_us == 0) {
+            start_us = now_us;
+            const int32_t pid = __atomic_load_n(&s.pid, __ATOMIC_RELAXED);
+            if (pid != 0 && kill(pid, 0) != 0 && errno == ESRCH) {
+                // died while publishing
+                return false;
+            }
+        } else if (now_us - start_us > READ_TIMEOUT_US) {
+            return false;
+        }
+        sched_yield();
+    }
+}
+
+void Swarm::detach(void)
+{
+    if (shm == nullptr) {
+        return;
+    }
+    __atomic_store_n(&shm->slots[_instance].state, uint8_t(SLOT_DEPARTED), __ATOMIC_RELEASE);
+    munmap(shm, sizeof(*shm));
+    shm = nullptr;
+}
+
+/*
+  send the position of each peer as it would arrive from the peer
+  itself, so the firmware sees it exactly as it would MAVLink
+  forwarded from another vehicle
+ */
+void SwarmLink::update(const Aircraft &aircraft)
+{
+    const Swarm *swarm = aircraft.get_swarm();
+    if (swarm == nullptr || !swarm->enabled()) {
+        return;
+    }
+
+    // discard anything the autopilot sends us
+    char buf[64];
+    while (read_from_autopilot(buf, sizeof(buf)) > 0) {
+    }
+
+    const uint64_t now_us = AP_HAL::micros64();
+    const bool send_heartbeat = now_us - last_heartbeat_us >= 1000000ULL;
+    const bool send_position = now_us - last_position_us >= POSITION_PERIOD_US;
+    if (!send_heartbeat && !send_position) {
+        return;
+    }
+    if (send_heartbeat) {
+        last_heartbeat_us = now_us;
+    }
+    if (send_position) {
+        last_position_us = now_us;
+    }
+
+    for (uint8_t i=0; i<swarm->num_vehicles(); i++) {
+        Swarm::Vehicle v;
+        if (i == swarm->get_instance() || !swarm->get_vehicle(i, now_us, v)) {
+            continue;
+        }
+        mavlink_message_t msg;
+        if (send_heartbeat) {
+            mavlink_heartbeat_t heartbeat {};
+            heartbeat.type = MAV_TYPE_GENERIC;
+            heartbeat.autopilot = MAV_AUTOPILOT_ARDUPILOTMEGA;
+            heartbeat.system_status = MAV_STATE_ACTIVE;
+            heartbeat.mavlink_version = 3;
+            mavlink_msg_heartbeat_encode_status(v.sysid, MAV_COMP_ID_AUTOPILOT1,
+                                                &status, &msg, &heartbeat);
+            send_message(msg);
+        }
+        if (send_position) {
+            mavlink_global_position_int_t pos {};
+            pos.time_boot_ms = uint32_t(v.time_us / 1000U);
+            pos.lat = v.location.lat;
+            pos.lon = v.location.lng;
+            pos.alt = v.location.alt * 10;
+            pos.relative_alt = v.relative_alt_cm * 10;
+            pos.vx = v.velocity_ef.x * 100;
+            pos.vy = v.velocity_ef.y * 100;
+            pos.vz = v.velocity_ef.z * 100;
+            pos.hdg = wrap_360_cd(v.yaw_deg * 100);
+            mavlink_msg_global_position_int_encode_status(v.sysid, MAV_COMP_ID_AUTOPILOT1,
+                                                          &status, &msg, &pos);
+            send_message(msg);
+        }
+    }
+}
+
+void SwarmLink::send_message(const mavlink_message_t &msg)
+{
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    const uint16_t len = mavlink_msg_to_send_buffer(buf, &msg);
+    write_to_autopilot((const char*)buf, len);
+}
+
+#endif  // AP_SIM_SWARM_ENABLED
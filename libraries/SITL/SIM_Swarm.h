@@ -0,0 +1,174 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  shared world for SITL instances running in lock-step
+
+  Each instance publishes the state of its simulated vehicle into a
+  POSIX shared memory segment at the end of every physics frame. Other
+  instances look up the state of their peers at their own simulation
+  time, so with the lock-step clock every instance sees exactly the
+  same traffic on every run, without forwarding MAVLink between
+  processes.
+
+  The world is attached by --lockstep NUM[:NAME]. Peers are made
+  visible to the firmware through the simulated ADSB receiver and the
+  "swarm" serial device, which sends the HEARTBEAT and
+  GLOBAL_POSITION_INT of each peer, for example for AP_Follow:
+
+    --serial5=sim:swarm
+
+  This is not a swarm physics host: every vehicle still runs its own
+  Aircraft model in its own SITL process and gets its FDM state as it
+  always has. The world only carries each vehicle's published state
+  to its peers.
+*/
+
+#pragma once
+
+#include "SIM_config.h"
+
+#if AP_SIM_SWARM_ENABLED
+
+#include <AP_Common/Location.h>
+#include <AP_Math/AP_Math.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+
+#include "SIM_SerialDevice.h"
+
+namespace SITL {
+
+class Swarm {
+    friend class SwarmTest;
+public:
+    static constexpr uint8_t MAX_VEHICLES = 255;
+
+    // attach to (creating if required) the shared world segment
+    bool init(const char *name, uint8_t num_vehicles, uint8_t instance);
+
+    bool enabled() const { return shm != nullptr; }
+
+    uint8_t num_vehicles() const { return _num_vehicles; }
+    uint8_t get_instance() const { return _instance; }
+
+    /*
+      publish the state of our vehicle at the end of the frame
+      ending at time_us, with loc's altitude above mean sea level
+     */
+    void publish(uint64_t time_us, uint8_t sysid, const Location &loc,
+                 int32_t relative_alt_cm, const Vector3f &velocity_ef, float yaw_deg);
+
+    struct Vehicle {
+        uint64_t time_us;
+        uint8_t sysid;
+        Location location;      // altitude is above mean sea level
+        int32_t relative_alt_cm; // altitude above the vehicle's home
+        Vector3f velocity_ef;   // m/s, NED
+        float yaw_deg;
+    };
+
+    /*
+      get the latest state published by another vehicle at or before
+      time_us. Returns false if the vehicle has no such state or has
+      left the world. States a peer died part way through writing are
+      skipped
+     */
+    bool get_vehicle(uint8_t instance, uint64_t time_us, Vehicle &vehicle) const;
+
+    // mark our vehicle as departed so peers stop showing it
+    void detach(void);
+
+private:
+    /*
+      a vehicle state is guarded by a sequence number which is odd
+      while the state is being written, so readers never see a
+      partially written state
+     */
+    struct vehicle_state {
+        uint32_t seq;
+        uint64_t time_us;
+        int32_t lat;
+        int32_t lng;
+        int32_t alt_cm;
+        int32_t relative_alt_cm;
+        float velocity_ef[3];
+        float yaw_deg;
+    };
+
+    /*
+      peers are at most one of their frames ahead of us in lock-step,
+      so a short history always holds the state at our time
+     */
+    static constexpr uint8_t NUM_STATES = 8;
+
+    struct slot {
+        uint8_t state;
+        uint8_t sysid;
+        int32_t pid;            // process of the vehicle using the slot
+        uint32_t count;
+        vehicle_state states[NUM_STATES];
+    };
+
+    enum SlotState : uint8_t {
+        SLOT_EMPTY = 0,
+        SLOT_ACTIVE = 1,
+        SLOT_DEPARTED = 2,
+    };
+
+    struct shared_world {
+        slot slots[MAX_VEHICLES];
+    };
+
+    // states older than this are from a peer which has stopped
+    static constexpr uint64_t STALE_US = 2000000ULL;
+
+    /*
+      a peer writes a state in well under a microsecond unless it is
+      descheduled part way through, so a state still being written
+      after this long is from a peer which has died or hung
+     */
+    static constexpr uint32_t READ_TIMEOUT_US = 100000;
+
+    // copy a state written by a peer, returning false if the peer
+    // never finished writing it
+    static bool read_state(const slot &s, const vehicle_state &v, vehicle_state &copy);
+
+    shared_world *shm;
+    uint8_t _instance;
+    uint8_t _num_vehicles;
+};
+
+/*
+  serial device sending the MAVLink position of each peer in the
+  swarm, as if the peers were sending it over a shared radio link
+ */
+class SwarmLink : public SerialDevice {
+public:
+    void update(const class Aircraft &aircraft);
+
+private:
+    // rate at which the position of each peer is sent
+    static constexpr uint32_t POSITION_PERIOD_US = 100000;
+
+    uint64_t last_position_us;
+    uint64_t last_heartbeat_us;
+
+    mavlink_status_t status;
+
+    void send_message(const mavlink_message_t &msg);
+};
+
+}  // namespace SITL
+
+#endif  // AP_SIM_SWARM_ENABLED
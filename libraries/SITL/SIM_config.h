@@ -317,6 +317,14 @@
 #define AP_SIM_JSON_MASTER_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL)
 #endif  // AP_SIM_JSON_MASTER_ENABLED
 
+#ifndef AP_SIM_LOCKSTEP_ENABLED
+#define AP_SIM_LOCKSTEP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif  // AP_SIM_LOCKSTEP_ENABLED
+
+#ifndef AP_SIM_SWARM_ENABLED
+#define AP_SIM_SWARM_ENABLED AP_SIM_LOCKSTEP_ENABLED
+#endif  // AP_SIM_SWARM_ENABLED
+
 #ifndef AP_SIM_LAST_LETTER_ENABLED
 #define AP_SIM_LAST_LETTER_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL)
 #endif  // AP_SIM_LAST_LETTER_ENABLED
@@ -0,0 +1,224 @@
+#include <AP_gtest.h>
+
+#include <SITL/SIM_Lockstep.h>
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_SIM_LOCKSTEP_ENABLED
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace SITL;
+
+static const uint64_t FRAME_US = 1000;
+static const uint64_t END_US = 20 * FRAME_US;
+
+namespace SITL {
+
+/*
+  a master in this process and a peer in a child process, as if they
+  were separate SITL instances
+ */
+class LockstepTest : public testing::Test
+{
+protected:
+    void SetUp() override {
+        snprintf(name, sizeof(name), "test-%d", int(getpid()));
+        snprintf(shm_name, sizeof(shm_name), "/ap-lockstep-%s", name);
+        ASSERT_EQ(0, pipe(release));
+        // a deadlock fails the test rather than hanging it
+        alarm(30);
+    }
+
+    void TearDown() override {
+        alarm(0);
+        if (world != nullptr) {
+            munmap(world, sizeof(*world));
+        }
+        close(release[0]);
+        close(release[1]);
+        shm_unlink(shm_name);
+    }
+
+    /*
+      start a peer which runs to END_US, then stays attached until
+      released so the master can restart while it is running
+     */
+    pid_t start_peer() {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            // exit if the test dies rather than waiting for ever
+            close(release[1]);
+            Lockstep peer {};
+            if (!peer.init(name, 2, 1)) {
+                _exit(1);
+            }
+            for (uint64_t t=FRAME_US; t<=END_US; t+=FRAME_US) {
+                peer.advance(t);
+            }
+            char c;
+            if (read(release[0], &c, 1) != 1) {
+                _exit(2);
+            }
+            peer.detach();
+            _exit(0);
+        }
+        return pid;
+    }
+
+    // release the peer and return true if it exited cleanly
+    bool stop_peer(pid_t pid) {
+        if (write(release[1], "x", 1) != 1) {
+            return false;
+        }
+        int status;
+        return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    // look at the segment independently of any instance
+    void map_world() {
+        const int fd = shm_open(shm_name, O_RDWR, 0600);
+        ASSERT_NE(-1, fd);
+        void *p = mmap(nullptr, sizeof(*world), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        ASSERT_NE(MAP_FAILED, p);
+        world = (Lockstep::shared_state *)p;
+    }
+
+    bool slot_active(uint8_t i) const {
+        return __atomic_load_n(&world->slots[i].state, __ATOMIC_ACQUIRE) == Lockstep::SLOT_ACTIVE;
+    }
+    int32_t slot_pid(uint8_t i) const {
+        return __atomic_load_n(&world->slots[i].pid, __ATOMIC_ACQUIRE);
+    }
+    uint64_t slot_time(uint8_t i) const {
+        return __atomic_load_n(&world->slots[i].time_us, __ATOMIC_ACQUIRE);
+    }
+
+    // wait for the peer to get to time_us
+    void wait_peer(uint64_t time_us) {
+        while (!slot_active(1) || slot_time(1) < time_us) {
+            usleep(1000);
+        }
+    }
+
+    // clear a slot as a master which did not know about it would
+    void clear_slot(uint8_t i) {
+        memset(&world->slots[i], 0, sizeof(world->slots[i]));
+    }
+
+    char name[32];
+    char shm_name[64];
+    int release[2];
+    Lockstep::shared_state *world = nullptr;
+};
+
+}  // namespace SITL
+
+TEST_F(LockstepTest, LockStep)
+{
+    Lockstep master {};
+    ASSERT_TRUE(master.init(name, 2, 0));
+    map_world();
+    const pid_t pid = start_peer();
+    ASSERT_GT(pid, 0);
+
+    // the peer can't get ahead of the master
+    master.advance(5 * FRAME_US);
+    wait_peer(5 * FRAME_US);
+    usleep(10000);
+    EXPECT_LE(slot_time(1), 6 * FRAME_US);
+
+    for (uint64_t t=6*FRAME_US; t<=END_US; t+=FRAME_US) {
+        master.advance(t);
+    }
+    EXPECT_TRUE(stop_peer(pid));
+    master.detach();
+}
+
+/*
+  a master which restarts, as it does on reboot, while its peer is
+  still running must keep the peer's slot and carry on in lock-step
+  with it
+ */
+TEST_F(LockstepTest, MasterRestart)
+{
+    Lockstep master {};
+    ASSERT_TRUE(master.init(name, 2, 0));
+    map_world();
+    const pid_t pid = start_peer();
+    ASSERT_GT(pid, 0);
+
+    for (uint64_t t=FRAME_US; t<=5*FRAME_US; t+=FRAME_US) {
+        master.advance(t);
+    }
+    // with the master gone the peer runs to the end
+    master.detach();
+
+    wait_peer(END_US);
+    Lockstep restarted {};
+    ASSERT_TRUE(restarted.init(name, 2, 0));
+    EXPECT_TRUE(slot_active(1));
+    EXPECT_EQ(pid, slot_pid(1));
+    EXPECT_EQ(END_US, slot_time(1));
+
+    // the restarted master starts again from zero
+    for (uint64_t t=FRAME_US; t<=END_US; t+=FRAME_US) {
+        restarted.advance(t);
+    }
+    EXPECT_TRUE(stop_peer(pid));
+    restarted.detach();
+}
+
+/*
+  an instance whose slot has been cleared under it joins again on its
+  next frame rather than leaving the master waiting for ever
+ */
+TEST_F(LockstepTest, SlotCleared)
+{
+    Lockstep master {};
+    ASSERT_TRUE(master.init(name, 2, 0));
+    map_world();
+    const pid_t pid = start_peer();
+    ASSERT_GT(pid, 0);
+
+    for (uint64_t t=FRAME_US; t<=5*FRAME_US; t+=FRAME_US) {
+        master.advance(t);
+    }
+    clear_slot(1);
+    for (uint64_t t=6*FRAME_US; t<=END_US; t+=FRAME_US) {
+        master.advance(t);
+    }
+    EXPECT_TRUE(slot_active(1));
+    EXPECT_EQ(pid, slot_pid(1));
+    EXPECT_TRUE(stop_peer(pid));
+    master.detach();
+}
+
+TEST_F(LockstepTest, Unlink)
+{
+    Lockstep master {};
+    Lockstep peer {};
+    ASSERT_TRUE(master.init(name, 2, 0));
+    ASSERT_TRUE(peer.init(name, 2, 1));
+
+    // the segment stays while anyone is using it
+    master.detach();
+    int fd = shm_open(shm_name, O_RDWR, 0600);
+    EXPECT_NE(-1, fd);
+    close(fd);
+
+    // and is removed by the last instance out
+    peer.detach();
+    fd = shm_open(shm_name, O_RDWR, 0600);
+    EXPECT_EQ(-1, fd);
+    EXPECT_EQ(ENOENT, errno);
+}
+
+AP_GTEST_MAIN()
+
+#endif  // AP_SIM_LOCKSTEP_ENABLED
@@ -0,0 +1,158 @@
+#include <AP_gtest.h>
+
+#include <SITL/SIM_Swarm.h>
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#if AP_SIM_SWARM_ENABLED
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace SITL;
+
+namespace SITL {
+
+/*
+  two vehicles attached to the same world, as if they were separate
+  SITL instances
+ */
+class SwarmTest : public testing::Test
+{
+protected:
+    void SetUp() override {
+        snprintf(name, sizeof(name), "test-%d", int(getpid()));
+        ASSERT_TRUE(vehicle0.init(name, 2, 0));
+        ASSERT_TRUE(vehicle1.init(name, 2, 1));
+    }
+
+    void TearDown() override {
+        vehicle0.detach();
+        vehicle1.detach();
+        char shm_name[64];
+        snprintf(shm_name, sizeof(shm_name), "/ap-swarm-%s", name);
+        shm_unlink(shm_name);
+    }
+
+    // publish vehicle 1 at time_us, with its latitude set from the time
+    void publish1(uint64_t time_us) {
+        const Location loc{int32_t(time_us / 1000), 1490000000, 58400, Location::AltFrame::ABSOLUTE};
+        vehicle1.publish(time_us, 2, loc, 1000, Vector3f{1, 2, -3}, 90);
+    }
+
+    // leave vehicle 1's state at time_us part written, as if it
+    // stopped while publishing it
+    void interrupt1(uint64_t time_us) {
+        for (auto &v : vehicle1.shm->slots[1].states) {
+            if (v.time_us == time_us) {
+                v.seq++;
+            }
+        }
+    }
+
+    void set_pid1(int32_t pid) {
+        vehicle1.shm->slots[1].pid = pid;
+    }
+
+    char name[32];
+    Swarm vehicle0;
+    Swarm vehicle1;
+};
+
+}  // namespace SITL
+
+TEST_F(SwarmTest, Publish)
+{
+    Swarm::Vehicle v;
+    EXPECT_FALSE(vehicle0.get_vehicle(1, 2500, v));
+
+    publish1(2500);
+    ASSERT_TRUE(vehicle0.get_vehicle(1, 2500, v));
+    EXPECT_EQ(2500U, v.time_us);
+    EXPECT_EQ(2, v.sysid);
+    EXPECT_EQ(2, v.location.lat);
+    EXPECT_EQ(1490000000, v.location.lng);
+    EXPECT_EQ(58400, v.location.alt);
+    EXPECT_EQ(1000, v.relative_alt_cm);
+    EXPECT_FLOAT_EQ(2, v.velocity_ef.y);
+    EXPECT_FLOAT_EQ(90, v.yaw_deg);
+
+    // nothing has been published by vehicle 0, and instances outside
+    // the world do not exist
+    EXPECT_FALSE(vehicle1.get_vehicle(0, 2500, v));
+    EXPECT_FALSE(vehicle0.get_vehicle(2, 2500, v));
+}
+
+/*
+  a peer ahead of us in time must be seen as it was at our time
+ */
+TEST_F(SwarmTest, PeerAhead)
+{
+    for (uint64_t t=2500; t<=20000; t+=2500) {
+        publish1(t);
+    }
+    Swarm::Vehicle v;
+    ASSERT_TRUE(vehicle0.get_vehicle(1, 10000, v));
+    EXPECT_EQ(10000U, v.time_us);
+    EXPECT_EQ(10, v.location.lat);
+
+    // between frames we get the earlier state
+    ASSERT_TRUE(vehicle0.get_vehicle(1, 11000, v));
+    EXPECT_EQ(10000U, v.time_us);
+
+    // before the oldest state in the history
+    EXPECT_FALSE(vehicle0.get_vehicle(1, 2000, v));
+}
+
+TEST_F(SwarmTest, Stale)
+{
+    publish1(2500);
+    Swarm::Vehicle v;
+    EXPECT_TRUE(vehicle0.get_vehicle(1, 1000000, v));
+    EXPECT_FALSE(vehicle0.get_vehicle(1, 3000000, v));
+}
+
+TEST_F(SwarmTest, Departed)
+{
+    publish1(2500);
+    vehicle1.detach();
+    Swarm::Vehicle v;
+    EXPECT_FALSE(vehicle0.get_vehicle(1, 2500, v));
+
+    // a vehicle which rejoins starts with no state
+    ASSERT_TRUE(vehicle1.init(name, 2, 1));
+    EXPECT_FALSE(vehicle0.get_vehicle(1, 2500, v));
+    publish1(5000);
+    EXPECT_TRUE(vehicle0.get_vehicle(1, 5000, v));
+}
+
+/*
+  a peer which stops part way through publishing a state must not
+  hang the vehicles reading it
+ */
+TEST_F(SwarmTest, InterruptedPublish)
+{
+    publish1(2500);
+    publish1(5000);
+    interrupt1(5000);
+
+    // a peer which is still running is given time to finish
+    Swarm::Vehicle v;
+    ASSERT_TRUE(vehicle0.get_vehicle(1, 5000, v));
+    EXPECT_EQ(2500U, v.time_us);
+
+    // a peer which has died is skipped straight away
+    const pid_t pid = fork();
+    if (pid == 0) {
+        _exit(0);
+    }
+    ASSERT_GT(pid, 0);
+    waitpid(pid, nullptr, 0);
+    set_pid1(pid);
+    ASSERT_TRUE(vehicle0.get_vehicle(1, 5000, v));
+    EXPECT_EQ(2500U, v.time_us);
+}
+
+AP_GTEST_MAIN()
+
+#endif  // AP_SIM_SWARM_ENABLED